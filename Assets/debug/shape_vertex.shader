@@ -4,10 +4,6 @@
 
 #include "../shaders.inc"
 
-uniform float4x4 local_to_world;
-uniform float4x4 world_to_view;
-uniform float4x4 view_to_screen;
-
 ////////////////////////////////////////////////////////////////////////////////////////
 #if defined( EAE6320_PLATFORM_D3D )
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,94 @@
+
+#include "shaders.inc"
+
+// local_to_world comes from the per-instance stream instead of the object constants
+
+////////////////////////////////////////////////////////////////////////////////////////
+#if defined( EAE6320_PLATFORM_D3D )
+////////////////////////////////////////////////////////////////////////////////////////
+
+// Entry Point
+//============
+
+void main(
+	in const float3 i_position : POSITION,
+	in const float4 i_color : COLOR,
+	in const float2 i_texcoords : TEXCOORD0,
+
+	// The rows of this instance's local_to_world
+	in const float4 i_local_to_world_0 : TEXCOORD1,
+	in const float4 i_local_to_world_1 : TEXCOORD2,
+	in const float4 i_local_to_world_2 : TEXCOORD3,
+	in const float4 i_local_to_world_3 : TEXCOORD4,
+	// This instance's tint
+	in const float4 i_instance_color : COLOR1,
+
+	out float4 o_position : POSITION,
+	out float4 o_color : COLOR,
+	out float2 o_texcoords : TEXCOORD0
+	)
+	
+////////////////////////////////////////////////////////////////////////////////////////
+#elif defined( EAE6320_PLATFORM_GL )
+////////////////////////////////////////////////////////////////////////////////////////
+
+#define o_position gl_Position
+
+// The locations assigned are arbitrary
+// but must match the C calls to glVertexAttribPointer()
+
+// These values come from one of the sVertex that we filled the vertex buffer with in C code
+layout( location = 0 ) in float3 i_position;
+layout( location = 1 ) in float2 i_texcoords;
+layout( location = 2 ) in float4 i_color;
+
+// The rows of this instance's local_to_world
+layout( location = 3 ) in float4 i_local_to_world_0;
+layout( location = 4 ) in float4 i_local_to_world_1;
+layout( location = 5 ) in float4 i_local_to_world_2;
+layout( location = 6 ) in float4 i_local_to_world_3;
+// This instance's tint
+layout( location = 7 ) in float4 i_instance_color;
+
+// Output
+//=======
+
+// The vertex shader must always output a position value,
+// but unlike HLSL where the value is explicit
+// GLSL has an implicit required variable called "gl_Position"
+
+// Any other data is optional; the GPU doesn't know or care what it is,
+// and will merely interpolate it across the triangle
+// and give us the resulting interpolated value in a fragment shader.
+// It is then up to us to use it however we want to.
+// The locations are used to match the vertex shader outputs
+// with the fragment shader inputs
+// (note that Direct3D uses arbitrarily assignable "semantics").
+layout( location = 0 ) out float4 o_color;
+
+layout( location = 1 ) out float2 o_texcoords;
+
+// Entry Point
+//============
+
+void main()
+
+////////////////////////////////////////////////////////////////////////////////////////
+#endif
+////////////////////////////////////////////////////////////////////////////////////////
+{
+	// Calculate the position of this vertex on screen
+	{
+	    float4 position_local = float4( i_position, 1.0 );
+	    float4 position_world = float4( dot( i_local_to_world_0, position_local ), dot( i_local_to_world_1, position_local ),
+	        dot( i_local_to_world_2, position_local ), dot( i_local_to_world_3, position_local ) );
+	    float4 position_view = Transform( position_world, world_to_view );
+	    o_position = Transform( position_view, view_to_screen );
+	}
+
+	// Tint the input color by the instance, and pass the texture coordinates to the fragment shader unchanged:
+	{
+		o_color = i_color * i_instance_color;
+		o_texcoords = i_texcoords;
+	}
+}
@@ -1,7 +1,6 @@
 
 #include "shaders.inc"
 
-uniform float4 color;
 uniform sampler2D base_texture;
 
 ////////////////////////////////////////////////////////////////////////////////////////
@@ -32,5 +31,4 @@ void main()
 {
 	o_color = SampleFromTexture(base_texture, i_texcoords);
 	o_color *= i_color;
-	o_color *= color;
 }
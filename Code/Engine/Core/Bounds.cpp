@@ -0,0 +1,53 @@
+#include "Bounds.h"
+
+#include <algorithm>
+#include <limits>
+
+#include "Matrix4x4.h"
+#include "Vertex.h"
+
+namespace Lame
+{
+	Bounds::Bounds() :
+		min_(std::numeric_limits<float>::max(), std::numeric_limits<float>::max(), std::numeric_limits<float>::max()),
+		max_(-std::numeric_limits<float>::max(), -std::numeric_limits<float>::max(), -std::numeric_limits<float>::max())
+	{
+	}
+
+	Bounds Bounds::Create(const Vertex* i_vertices, const size_t i_vertex_count)
+	{
+		Bounds bounds;
+		for (size_t x = 0; x < i_vertex_count; x++)
+			bounds.Encapsulate(i_vertices[x].position);
+		return bounds;
+	}
+
+	void Bounds::Encapsulate(const Vector3& i_point)
+	{
+		min_.set(std::min(min_.x(), i_point.x()), std::min(min_.y(), i_point.y()), std::min(min_.z(), i_point.z()));
+		max_.set(std::max(max_.x(), i_point.x()), std::max(max_.y(), i_point.y()), std::max(max_.z(), i_point.z()));
+	}
+
+	void Bounds::Encapsulate(const Bounds& i_other)
+	{
+		if (!i_other.IsValid())
+			return;
+		Encapsulate(i_other.min());
+		Encapsulate(i_other.max());
+	}
+
+	Bounds Bounds::Transformed(const Matrix4x4& i_matrix) const
+	{
+		if (!IsValid())
+			return *this;
+
+		//transform the center, then find the extents along each world axis from the absolute rotation/scale
+		const Vector3 c = i_matrix.Multiply(center());
+		const Vector3 e = extents();
+		const float ex = std::abs(i_matrix.Get(0, 0)) * e.x() + std::abs(i_matrix.Get(0, 1)) * e.y() + std::abs(i_matrix.Get(0, 2)) * e.z();
+		const float ey = std::abs(i_matrix.Get(1, 0)) * e.x() + std::abs(i_matrix.Get(1, 1)) * e.y() + std::abs(i_matrix.Get(1, 2)) * e.z();
+		const float ez = std::abs(i_matrix.Get(2, 0)) * e.x() + std::abs(i_matrix.Get(2, 1)) * e.y() + std::abs(i_matrix.Get(2, 2)) * e.z();
+		const Vector3 worldExtents(ex, ey, ez);
+		return Bounds(c - worldExtents, c + worldExtents);
+	}
+}
@@ -0,0 +1,42 @@
+#ifndef _ENGINE_CORE_BOUNDS_H
+#define _ENGINE_CORE_BOUNDS_H
+
+#include <cstddef>
+
+#include "Vector3.h"
+
+namespace Lame
+{
+	class Matrix4x4;
+	struct Vertex;
+
+	//Axis aligned bounding box.  A default constructed Bounds is empty, and encapsulating a point makes it valid.
+	class Bounds
+	{
+	public:
+		Bounds();
+		Bounds(const Vector3& i_min, const Vector3& i_max) : min_(i_min), max_(i_max) {}
+
+		static Bounds Create(const Vertex* i_vertices, const size_t i_vertex_count);
+
+		inline bool IsValid() const { return min_.x() <= max_.x() && min_.y() <= max_.y() && min_.z() <= max_.z(); }
+
+		void Encapsulate(const Vector3& i_point);
+		void Encapsulate(const Bounds& i_other);
+
+		//the bounds of this box after being transformed by i_matrix
+		Bounds Transformed(const Matrix4x4& i_matrix) const;
+
+		inline const Vector3& min() const { return min_; }
+		inline const Vector3& max() const { return max_; }
+		inline Vector3 center() const { return (min_ + max_) * 0.5f; }
+		inline Vector3 size() const { return max_ - min_; }
+		inline Vector3 extents() const { return (max_ - min_) * 0.5f; }
+
+	private:
+		Vector3 min_;
+		Vector3 max_;
+	};
+}
+
+#endif //_ENGINE_CORE_BOUNDS_H
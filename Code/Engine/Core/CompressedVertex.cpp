@@ -0,0 +1,155 @@
+
+#include "CompressedVertex.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#include "Bounds.h"
+#include "Vertex.h"
+
+namespace
+{
+	inline float SignNotZero(const float i_value) { return i_value >= 0.0f ? 1.0f : -1.0f; }
+
+	inline uint8_t ToUnorm8(const float i_snorm)
+	{
+		return static_cast<uint8_t>(std::floor((std::min(std::max(i_snorm, -1.0f), 1.0f) * 0.5f + 0.5f) * 255.0f + 0.5f));
+	}
+
+	inline int16_t Quantize(const float i_position, const float i_offset, const float i_scale)
+	{
+		if (i_scale <= 0.0f)
+			return 0;
+		const float quantized = std::floor((i_position - i_offset) / i_scale + 0.5f);
+		const float limit = static_cast<float>(Lame::VertexCompression::MaxPosition);
+		return static_cast<int16_t>(std::min(std::max(quantized, -limit), limit));
+	}
+}
+
+namespace Lame
+{
+	namespace VertexCompression
+	{
+		uint16_t FloatToHalf(const float i_value)
+		{
+			uint32_t bits;
+			memcpy(&bits, &i_value, sizeof(bits));
+			const uint16_t sign = static_cast<uint16_t>((bits >> 16) & 0x8000);
+			const int32_t exponent = static_cast<int32_t>((bits >> 23) & 0xFF) - 127 + 15;
+			uint32_t mantissa = bits & 0x7FFFFF;
+
+			if ((bits & 0x7FFFFFFF) > 0x7F800000)		//NaN
+				return sign | 0x7E00;
+			if (exponent >= 31)							//too large, or infinite
+				return sign | 0x7C00;
+			if (exponent <= 0)
+			{
+				//too small for a normalized half, so it keeps what it can as a denormal
+				if (exponent < -10)
+					return sign;
+				mantissa |= 0x800000;
+				const uint32_t shift = static_cast<uint32_t>(14 - exponent);
+				uint32_t half = mantissa >> shift;
+				const uint32_t remainder = mantissa & ((1u << shift) - 1);
+				const uint32_t halfway = 1u << (shift - 1);
+				if (remainder > halfway || (remainder == halfway && (half & 1)))
+					half++;
+				return sign | static_cast<uint16_t>(half);
+			}
+
+			//rounds to nearest even, a carry out of the mantissa correctly bumps the exponent
+			uint32_t half = (static_cast<uint32_t>(exponent) << 10) | (mantissa >> 13);
+			const uint32_t remainder = mantissa & 0x1FFF;
+			if (remainder > 0x1000 || (remainder == 0x1000 && (half & 1)))
+				half++;
+			return sign | static_cast<uint16_t>(half);
+		}
+
+		float HalfToFloat(const uint16_t i_value)
+		{
+			const uint32_t sign = static_cast<uint32_t>(i_value & 0x8000) << 16;
+			const uint32_t exponent = (i_value >> 10) & 0x1F;
+			const uint32_t mantissa = i_value & 0x3FF;
+
+			if (exponent == 0)
+			{
+				const float denormal = std::ldexp(static_cast<float>(mantissa), -24);
+				return sign ? -denormal : denormal;
+			}
+
+			const uint32_t bits = sign | (exponent == 31 ? 0x7F800000 | (mantissa << 13) : ((exponent + 112) << 23) | (mantissa << 13));
+			float value;
+			memcpy(&value, &bits, sizeof(value));
+			return value;
+		}
+
+		void EncodeOctahedral(const Vector3& i_unit, uint8_t& o_x, uint8_t& o_y)
+		{
+			const float length = std::abs(i_unit.x()) + std::abs(i_unit.y()) + std::abs(i_unit.z());
+			if (length <= 0.0f)
+			{
+				o_x = o_y = ToUnorm8(0.0f);
+				return;
+			}
+
+			float x = i_unit.x() / length;
+			float y = i_unit.y() / length;
+			//the lower half of the octahedron folds out over the corners of the square
+			if (i_unit.z() < 0.0f)
+			{
+				const float foldedX = (1.0f - std::abs(y)) * SignNotZero(x);
+				y = (1.0f - std::abs(x)) * SignNotZero(y);
+				x = foldedX;
+			}
+			o_x = ToUnorm8(x);
+			o_y = ToUnorm8(y);
+		}
+
+		void GetPositionDecode(const Bounds& i_bounds, Vector3& o_offset, Vector3& o_scale)
+		{
+			if (!i_bounds.IsValid())
+			{
+				o_offset = Vector3::zero;
+				o_scale = Vector3::one / static_cast<float>(MaxPosition);
+				return;
+			}
+			o_offset = i_bounds.center();
+			o_scale = i_bounds.extents() / static_cast<float>(MaxPosition);
+		}
+
+		CompressedVertex Compress(const Vertex& i_vertex, const Vector3& i_normal, const Vector3& i_tangent, const Vector3& i_bitangent,
+			const Vector3& i_offset, const Vector3& i_scale)
+		{
+			CompressedVertex compressed;
+			compressed.position[0] = Quantize(i_vertex.position.x(), i_offset.x(), i_scale.x());
+			compressed.position[1] = Quantize(i_vertex.position.y(), i_offset.y(), i_scale.y());
+			compressed.position[2] = Quantize(i_vertex.position.z(), i_offset.z(), i_scale.z());
+			compressed.position[3] = i_normal.cross(i_tangent).dot(i_bitangent) < 0.0f ? -1 : 1;
+
+			compressed.texcoord[0] = FloatToHalf(i_vertex.texcoord.x());
+			compressed.texcoord[1] = FloatToHalf(i_vertex.texcoord.y());
+
+			uint8_t normalX, normalY, tangentX, tangentY;
+			EncodeOctahedral(i_normal, normalX, normalY);
+			EncodeOctahedral(i_tangent, tangentX, tangentY);
+			compressed.normal_tangent = Color32(normalX, normalY, tangentX, tangentY);
+			compressed.color = i_vertex.color;
+			return compressed;
+		}
+
+		void Decompress(const CompressedVertex* i_vertices, const size_t i_vertex_count, const Vector3& i_offset, const Vector3& i_scale, Vertex* o_vertices)
+		{
+			for (size_t x = 0; x < i_vertex_count; x++)
+			{
+				const CompressedVertex& compressed = i_vertices[x];
+				o_vertices[x].position = Vector3(
+					compressed.position[0] * i_scale.x() + i_offset.x(),
+					compressed.position[1] * i_scale.y() + i_offset.y(),
+					compressed.position[2] * i_scale.z() + i_offset.z());
+				o_vertices[x].texcoord = Vector2(HalfToFloat(compressed.texcoord[0]), HalfToFloat(compressed.texcoord[1]));
+				o_vertices[x].color = compressed.color;
+			}
+		}
+	}
+}
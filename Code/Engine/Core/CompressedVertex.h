@@ -0,0 +1,54 @@
+#ifndef _ENGINE_CORE_COMPRESSEDVERTEX_H
+#define _ENGINE_CORE_COMPRESSEDVERTEX_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "Color.h"
+#include "Vector3.h"
+
+namespace Lame
+{
+	struct Vertex;
+	class Bounds;
+
+	//The layouts a mesh's vertices can be stored with
+	enum class VertexFormat : uint32_t
+	{
+		Full = 0,			//Lame::Vertex
+		Compressed = 1,		//Lame::CompressedVertex
+		Position = 2,		//a Lame::Vector3, for meshes that are only read on the CPU (like occluders)
+	};
+
+	//A 20 byte vertex that also carries the tangent frame.  Positions are quantized inside the mesh's bounds,
+	// and are decoded with position * scale + offset (see GetPositionDecode).
+	struct CompressedVertex
+	{
+		int16_t position[4];		// POSITION, 4 shorts == 8 bytes, Offset = 0 (w is the bitangent's sign)
+		uint16_t texcoord[2];		// TEXCOORD0, 2 half floats == 4 bytes, Offset = 8
+		Color32 normal_tangent;		// NORMAL0, octahedral normal in rg and tangent in ba == 4 bytes, Offset = 12
+		Color32 color;				// COLOR0, 4 uint8_ts == 4 bytes, Offset = 16
+	};
+
+	namespace VertexCompression
+	{
+		//the largest quantized position component, so positions at the edge of the bounds are exact
+		const int16_t MaxPosition = 32767;
+
+		uint16_t FloatToHalf(const float i_value);
+		float HalfToFloat(const uint16_t i_value);
+
+		//maps a unit vector onto an octahedron unfolded into a square, stored as two unsigned bytes
+		void EncodeOctahedral(const Vector3& i_unit, uint8_t& o_x, uint8_t& o_y);
+
+		//the scale and offset that turn quantized positions back into positions inside i_bounds
+		void GetPositionDecode(const Bounds& i_bounds, Vector3& o_offset, Vector3& o_scale);
+
+		//i_bitangent only contributes its handedness, it is rebuilt from the normal and tangent
+		CompressedVertex Compress(const Vertex& i_vertex, const Vector3& i_normal, const Vector3& i_tangent, const Vector3& i_bitangent,
+			const Vector3& i_offset, const Vector3& i_scale);
+		void Decompress(const CompressedVertex* i_vertices, const size_t i_vertex_count, const Vector3& i_offset, const Vector3& i_scale, Vertex* o_vertices);
+	}
+}
+
+#endif //_ENGINE_CORE_COMPRESSEDVERTEX_H
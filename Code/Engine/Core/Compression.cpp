@@ -0,0 +1,156 @@
+
+#include "Compression.h"
+
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+namespace
+{
+	const size_t HashBits = 14;
+
+	inline uint32_t Read32(const char* i_data)
+	{
+		uint32_t value;
+		memcpy(&value, i_data, sizeof(value));
+		return value;
+	}
+
+	inline size_t Hash(const uint32_t i_sequence) { return static_cast<size_t>((i_sequence * 2654435761u) >> (32 - HashBits)); }
+
+	//the bytes of a length that didn't fit in its token's 4 bits
+	inline char* WriteExtraLength(char* o_out, size_t i_length)
+	{
+		for (; i_length >= 255; i_length -= 255)
+			*o_out++ = static_cast<char>(255);
+		*o_out++ = static_cast<char>(i_length);
+		return o_out;
+	}
+
+	//returns false if the length runs off the end of the data
+	inline bool ReadExtraLength(const char*& io_in, const char* i_end, size_t& io_length)
+	{
+		uint8_t byte;
+		do
+		{
+			if (io_in == i_end)
+				return false;
+			byte = static_cast<uint8_t>(*io_in++);
+			io_length += byte;
+		} while (byte == 255);
+		return true;
+	}
+
+	//a match length of 0 writes the last sequence, which only has literals
+	char* WriteSequence(char* o_out, const char* i_literals, const size_t i_literal_count, const size_t i_offset, const size_t i_match_length)
+	{
+		const size_t matchCode = i_match_length > 0 ? i_match_length - Lame::Compression::MinMatch : 0;
+		*o_out++ = static_cast<char>((std::min<size_t>(i_literal_count, 15) << 4) | std::min<size_t>(matchCode, 15));
+		if (i_literal_count >= 15)
+			o_out = WriteExtraLength(o_out, i_literal_count - 15);
+		if (i_literal_count > 0)
+			memcpy(o_out, i_literals, i_literal_count);
+		o_out += i_literal_count;
+		if (i_match_length == 0)
+			return o_out;
+
+		*o_out++ = static_cast<char>(i_offset & 0xFF);
+		*o_out++ = static_cast<char>(i_offset >> 8);
+		if (matchCode >= 15)
+			o_out = WriteExtraLength(o_out, matchCode - 15);
+		return o_out;
+	}
+}
+
+namespace Lame
+{
+	namespace Compression
+	{
+		size_t Compress(const char* i_data, const size_t i_size, char* o_compressed)
+		{
+			//the last position each hashed 4 bytes were seen at, plus one so 0 can mean none
+			std::vector<size_t> table(static_cast<size_t>(1) << HashBits, 0);
+
+			char *out = o_compressed;
+			size_t literalStart = 0;
+			size_t position = 0;
+			size_t misses = 0;
+			while (i_size >= MinMatch && position <= i_size - MinMatch)
+			{
+				const uint32_t sequence = Read32(i_data + position);
+				size_t& entry = table[Hash(sequence)];
+				const size_t candidate = entry;
+				entry = position + 1;
+				if (candidate > 0 && position - (candidate - 1) <= MaxOffset && Read32(i_data + candidate - 1) == sequence)
+				{
+					const size_t matchStart = candidate - 1;
+					size_t length = MinMatch;
+					while (position + length < i_size && i_data[matchStart + length] == i_data[position + length])
+						length++;
+					out = WriteSequence(out, i_data + literalStart, position - literalStart, position - matchStart, length);
+					position += length;
+					literalStart = position;
+					misses = 0;
+				}
+				else
+				{
+					//data that keeps missing is stepped through faster, so data that doesn't compress is still quick to compress
+					position += 1 + (misses++ >> 5);
+				}
+			}
+			out = WriteSequence(out, i_data + literalStart, i_size - literalStart, 0, 0);
+			return static_cast<size_t>(out - o_compressed);
+		}
+
+		bool Decompress(const char* i_compressed, const size_t i_compressed_size, char* o_data, const size_t i_size)
+		{
+			const char *in = i_compressed;
+			const char *inEnd = i_compressed + i_compressed_size;
+			char *out = o_data;
+			char *outEnd = o_data + i_size;
+			while (in < inEnd)
+			{
+				const uint8_t token = static_cast<uint8_t>(*in++);
+				size_t literalCount = token >> 4;
+				if (literalCount == 15 && !ReadExtraLength(in, inEnd, literalCount))
+					return false;
+				if (literalCount > static_cast<size_t>(inEnd - in) || literalCount > static_cast<size_t>(outEnd - out))
+					return false;
+				if (literalCount > 0)
+					memcpy(out, in, literalCount);
+				in += literalCount;
+				out += literalCount;
+
+				//the last sequence has no match
+				if (in == inEnd)
+					break;
+
+				if (inEnd - in < 2)
+					return false;
+				const size_t offset = static_cast<uint8_t>(in[0]) | (static_cast<size_t>(static_cast<uint8_t>(in[1])) << 8);
+				in += 2;
+				size_t matchLength = token & 0xF;
+				if (matchLength == 15 && !ReadExtraLength(in, inEnd, matchLength))
+					return false;
+				matchLength += MinMatch;
+				if (offset == 0 || offset > static_cast<size_t>(out - o_data) || matchLength > static_cast<size_t>(outEnd - out))
+					return false;
+
+				//matches closer than their length repeat the bytes they are still writing, so they are copied one at a time
+				const char *match = out - offset;
+				if (offset >= matchLength)
+				{
+					memcpy(out, match, matchLength);
+					out += matchLength;
+				}
+				else
+				{
+					for (size_t x = 0; x < matchLength; x++)
+						*out++ = *match++;
+				}
+			}
+			return out == outEnd;
+		}
+	}
+}
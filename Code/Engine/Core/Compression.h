@@ -0,0 +1,29 @@
+#ifndef _ENGINE_CORE_COMPRESSION_H
+#define _ENGINE_CORE_COMPRESSION_H
+
+#include <cstddef>
+
+namespace Lame
+{
+	//A byte oriented LZ codec, built for decompression speed rather than ratio.  Compressed data is a run of sequences, each a token byte
+	// (the literal count in the high 4 bits and the match length minus MinMatch in the low 4), the count's extra bytes when it is 15 or more,
+	// the literals, a 2 byte little endian offset back into the output, and the match length's extra bytes.  The last sequence ends after
+	// its literals.  Matches never reach outside the data being compressed, so separately compressed blocks decompress independently.
+	namespace Compression
+	{
+		const size_t MinMatch = 4;
+		const size_t MaxOffset = 65535;
+
+		//the most i_size bytes can grow to when they don't compress
+		inline size_t GetMaxCompressedSize(const size_t i_size) { return i_size + i_size / 255 + 16; }
+
+		//compresses i_size bytes into o_compressed, which must hold GetMaxCompressedSize(i_size) bytes, and returns the compressed size
+		size_t Compress(const char* i_data, const size_t i_size, char* o_compressed);
+
+		//decompresses into exactly i_size bytes of o_data, returns false if the compressed data is corrupt or doesn't fill o_data.
+		// Corrupt data never reads or writes outside the buffers.
+		bool Decompress(const char* i_compressed, const size_t i_compressed_size, char* o_data, const size_t i_size);
+	}
+}
+
+#endif //_ENGINE_CORE_COMPRESSION_H
@@ -0,0 +1,48 @@
+#include "Frustum.h"
+
+#include <cmath>
+#include <cstddef>
+
+#include "Bounds.h"
+#include "Matrix4x4.h"
+
+namespace Lame
+{
+	Frustum::Frustum(const Matrix4x4& i_world_to_screen)
+	{
+		//Gribb/Hartmann plane extraction, clip = i_world_to_screen * p
+		// the near plane uses -w <= z, which is conservative for Direct3D's 0 <= z
+		const float sign[PlaneCount] = { 1.0f, -1.0f, 1.0f, -1.0f, 1.0f, -1.0f };
+		const size_t row[PlaneCount] = { 0, 0, 1, 1, 2, 2 };
+		for (size_t p = 0; p < PlaneCount; p++)
+		{
+			Plane& plane = planes_[p];
+			plane.a = i_world_to_screen.Get(3, 0) + sign[p] * i_world_to_screen.Get(row[p], 0);
+			plane.b = i_world_to_screen.Get(3, 1) + sign[p] * i_world_to_screen.Get(row[p], 1);
+			plane.c = i_world_to_screen.Get(3, 2) + sign[p] * i_world_to_screen.Get(row[p], 2);
+			plane.d = i_world_to_screen.Get(3, 3) + sign[p] * i_world_to_screen.Get(row[p], 3);
+		}
+	}
+
+	bool Frustum::Intersects(const Bounds& i_bounds) const
+	{
+		//bounds with no size can't be culled
+		if (!i_bounds.IsValid())
+			return true;
+
+		const Vector3& mn = i_bounds.min();
+		const Vector3& mx = i_bounds.max();
+		for (size_t p = 0; p < PlaneCount; p++)
+		{
+			const Plane& plane = planes_[p];
+
+			//test the corner furthest along the plane's normal
+			const float x = plane.a >= 0.0f ? mx.x() : mn.x();
+			const float y = plane.b >= 0.0f ? mx.y() : mn.y();
+			const float z = plane.c >= 0.0f ? mx.z() : mn.z();
+			if (plane.a * x + plane.b * y + plane.c * z + plane.d < 0.0f)
+				return false;
+		}
+		return true;
+	}
+}
@@ -0,0 +1,31 @@
+#ifndef _ENGINE_CORE_FRUSTUM_H
+#define _ENGINE_CORE_FRUSTUM_H
+
+namespace Lame
+{
+	class Matrix4x4;
+	class Bounds;
+
+	//The 6 clipping planes of a camera, in world space
+	class Frustum
+	{
+	public:
+		//extracts the planes from a world to screen (view to screen * world to view) matrix
+		explicit Frustum(const Matrix4x4& i_world_to_screen);
+
+		//does any part of the bounds lie inside the frustum (conservative, may report boxes near corners as visible)
+		bool Intersects(const Bounds& i_bounds) const;
+
+	private:
+		enum { Left, Right, Bottom, Top, Near, Far, PlaneCount };
+
+		//ax + by + cz + d >= 0 for points inside the plane
+		struct Plane
+		{
+			float a, b, c, d;
+		};
+		Plane planes_[PlaneCount];
+	};
+}
+
+#endif //_ENGINE_CORE_FRUSTUM_H
@@ -26,6 +26,9 @@ namespace Lame
 		inline bool operator==(const HashedString & i_other) const;
 		inline bool operator!=(const HashedString & i_other) const;
 
+		//a HashedString of a string that was hashed ahead of time, such as when an asset was built
+		static inline HashedString FromHash(uint32_t i_hash);
+
 		static uint32_t Hash(const char * i_string);
 		static uint32_t Hash(const void * i_bytes, size_t i_count);
 	private:
@@ -47,6 +47,13 @@ namespace Lame
 		return *this;
 	}
 
+	inline HashedString HashedString::FromHash(uint32_t i_hash)
+	{
+		HashedString hashed;
+		hashed.m_Hash = i_hash;
+		return hashed;
+	}
+
 	inline uint32_t HashedString::Get(void) const
 	{
 		return m_Hash;
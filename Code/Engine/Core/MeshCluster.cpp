@@ -0,0 +1,161 @@
+#include "MeshCluster.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Bounds.h"
+#include "Vector3.h"
+#include "Vertex.h"
+
+namespace
+{
+	//spreads the low 10 bits of i_value out to every third bit
+	uint32_t SpreadBits(uint32_t i_value)
+	{
+		i_value &= 0x3FF;
+		i_value = (i_value | (i_value << 16)) & 0x030000FF;
+		i_value = (i_value | (i_value << 8)) & 0x0300F00F;
+		i_value = (i_value | (i_value << 4)) & 0x030C30C3;
+		i_value = (i_value | (i_value << 2)) & 0x09249249;
+		return i_value;
+	}
+
+	uint32_t Quantize(const float i_value, const float i_min, const float i_size)
+	{
+		if (i_size <= 0.0f)
+			return 0;
+		const float t = std::min(std::max((i_value - i_min) / i_size, 0.0f), 1.0f);
+		return static_cast<uint32_t>(t * 1023.0f);
+	}
+
+	//which of the 6 axis directions a normal is closest to
+	uint32_t GetFacing(const Lame::Vector3& i_normal)
+	{
+		const Lame::Vector3 abs = i_normal.AbsoluteValues();
+		if (abs.x() >= abs.y() && abs.x() >= abs.z())
+			return i_normal.x() >= 0.0f ? 0 : 1;
+		if (abs.y() >= abs.z())
+			return i_normal.y() >= 0.0f ? 2 : 3;
+		return i_normal.z() >= 0.0f ? 4 : 5;
+	}
+
+	struct Triangle
+	{
+		uint64_t key;		//facing in the high bits, morton code of the centroid in the low bits
+		uint32_t first_index;
+		Lame::Vector3 normal;
+	};
+}
+
+namespace Lame
+{
+	Bounds MeshCluster::bounds() const
+	{
+		return Bounds(Vector3(bounds_min[0], bounds_min[1], bounds_min[2]), Vector3(bounds_max[0], bounds_max[1], bounds_max[2]));
+	}
+
+	bool MeshCluster::IsBackFacing(const Vector3& i_eye) const
+	{
+		if (cone_cutoff >= 1.0f)
+			return false;
+
+		//every point of the bounding sphere has to be behind every triangle in the cone
+		const Bounds box = bounds();
+		const float radius = box.extents().magnitude();
+		const Vector3 toCenter = box.center() - i_eye;
+		const Vector3 axis(cone_axis[0], cone_axis[1], cone_axis[2]);
+		return toCenter.dot(axis) >= cone_cutoff * toCenter.magnitude() + radius * (1.0f + cone_cutoff);
+	}
+
+	bool BuildMeshClusters(const Vertex* i_vertices, const size_t i_vertex_count, uint32_t* io_indices, const size_t i_index_count,
+		const size_t i_max_triangles, const bool i_left_handed, std::vector<MeshCluster>& o_clusters)
+	{
+		o_clusters.clear();
+		if (!i_vertices || !io_indices || i_index_count % 3 != 0 || i_max_triangles == 0)
+			return false;
+		for (size_t x = 0; x < i_index_count; x++)
+		{
+			if (io_indices[x] >= i_vertex_count)
+				return false;
+		}
+
+		const Bounds meshBounds = Bounds::Create(i_vertices, i_vertex_count);
+		const Vector3 meshSize = meshBounds.size();
+
+		std::vector<Triangle> triangles(i_index_count / 3);
+		for (size_t t = 0; t < triangles.size(); t++)
+		{
+			const uint32_t* tri = io_indices + t * 3;
+			const Vector3& a = i_vertices[tri[0]].position;
+			const Vector3& b = i_vertices[tri[1]].position;
+			const Vector3& c = i_vertices[tri[2]].position;
+
+			//degenerate triangles get no normal, which keeps their cluster from ever being culled
+			Vector3 normal = (b - a).cross(c - a);
+			if (i_left_handed)
+				normal = -normal;
+			const float length = normal.magnitude();
+			normal = length > 0.0f ? normal / length : Vector3::zero;
+
+			const Vector3 centroid = (a + b + c) * (1.0f / 3.0f);
+			const uint32_t morton = SpreadBits(Quantize(centroid.x(), meshBounds.min().x(), meshSize.x())) |
+				(SpreadBits(Quantize(centroid.y(), meshBounds.min().y(), meshSize.y())) << 1) |
+				(SpreadBits(Quantize(centroid.z(), meshBounds.min().z(), meshSize.z())) << 2);
+
+			triangles[t].key = (static_cast<uint64_t>(GetFacing(normal)) << 32) | morton;
+			triangles[t].first_index = static_cast<uint32_t>(t * 3);
+			triangles[t].normal = normal;
+		}
+		std::stable_sort(triangles.begin(), triangles.end(), [](const Triangle& i_lhs, const Triangle& i_rhs) { return i_lhs.key < i_rhs.key; });
+
+		std::vector<uint32_t> sorted(i_index_count);
+		for (size_t begin = 0; begin < triangles.size();)
+		{
+			//clusters never mix facings, so a cluster ends early when the facing changes
+			const uint32_t facing = static_cast<uint32_t>(triangles[begin].key >> 32);
+			size_t end = begin;
+			while (end < triangles.size() && end - begin < i_max_triangles && static_cast<uint32_t>(triangles[end].key >> 32) == facing)
+				end++;
+
+			Bounds bounds;
+			Vector3 axis = Vector3::zero;
+			for (size_t t = begin; t < end; t++)
+			{
+				for (size_t v = 0; v < 3; v++)
+				{
+					const uint32_t index = io_indices[triangles[t].first_index + v];
+					sorted[t * 3 + v] = index;
+					bounds.Encapsulate(i_vertices[index].position);
+				}
+				axis += triangles[t].normal;
+			}
+
+			//the cone holds every normal, and is too wide to use once it reaches about 85 degrees
+			float cutoff = 1.0f;
+			const float axisLength = axis.magnitude();
+			if (axisLength > 0.0f)
+			{
+				axis /= axisLength;
+				float minDot = 1.0f;
+				for (size_t t = begin; t < end; t++)
+					minDot = std::min(minDot, axis.dot(triangles[t].normal));
+				if (minDot > 0.1f)
+					cutoff = std::sqrt(1.0f - minDot * minDot);
+			}
+
+			MeshCluster cluster;
+			cluster.first_index = static_cast<uint32_t>(begin * 3);
+			cluster.index_count = static_cast<uint32_t>((end - begin) * 3);
+			cluster.bounds_min[0] = bounds.min().x(); cluster.bounds_min[1] = bounds.min().y(); cluster.bounds_min[2] = bounds.min().z();
+			cluster.bounds_max[0] = bounds.max().x(); cluster.bounds_max[1] = bounds.max().y(); cluster.bounds_max[2] = bounds.max().z();
+			cluster.cone_axis[0] = axis.x(); cluster.cone_axis[1] = axis.y(); cluster.cone_axis[2] = axis.z();
+			cluster.cone_cutoff = cutoff;
+			o_clusters.push_back(cluster);
+
+			begin = end;
+		}
+
+		std::copy(sorted.begin(), sorted.end(), io_indices);
+		return true;
+	}
+}
@@ -0,0 +1,38 @@
+#ifndef _ENGINE_CORE_MESHCLUSTER_H
+#define _ENGINE_CORE_MESHCLUSTER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+namespace Lame
+{
+	struct Vertex;
+	class Vector3;
+	class Bounds;
+
+	//A small group of neighbouring triangles that face roughly the same way, drawn from a range of a mesh's index buffer.
+	// This is also the layout clusters are stored with in mesh binary files.
+	struct MeshCluster
+	{
+		uint32_t first_index;		//from the start of the index data
+		uint32_t index_count;
+		float bounds_min[3];
+		float bounds_max[3];
+		float cone_axis[3];			//average front facing direction of the triangles
+		float cone_cutoff;			//sine of the cone's spread, 1 or more if the triangles face too many ways to ever be back facing
+
+		Bounds bounds() const;
+
+		//do all the triangles face away from a camera at i_eye (in the same space as the cluster)
+		bool IsBackFacing(const Vector3& i_eye) const;
+	};
+
+	//Reorders the triangles of a triangle list so each run of at most i_max_triangles forms a cluster,
+	// grouping triangles first by the axis they face along and then by position.
+	// i_left_handed is the winding of io_indices, so front faces are known.
+	bool BuildMeshClusters(const Vertex* i_vertices, const size_t i_vertex_count, uint32_t* io_indices, const size_t i_index_count,
+		const size_t i_max_triangles, const bool i_left_handed, std::vector<MeshCluster>& o_clusters);
+}
+
+#endif //_ENGINE_CORE_MESHCLUSTER_H
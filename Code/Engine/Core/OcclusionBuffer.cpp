@@ -0,0 +1,303 @@
+#include "OcclusionBuffer.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2) || defined(__SSE2__)
+#define LAME_OCCLUSION_SSE2
+#include <emmintrin.h>
+#endif
+
+#include "Bounds.h"
+#include "Vector3.h"
+
+namespace
+{
+	const float FarDepth = std::numeric_limits<float>::max();
+
+	//the largest rectangle (in texels) a bounds test will read, the pyramid level is picked to fit it
+	const size_t MaxTestTexels = 4;
+}
+
+namespace Lame
+{
+	OcclusionBuffer::OcclusionBuffer(const size_t i_width, const size_t i_height) :
+		width_(i_width),
+		height_(i_height),
+		depth_(i_width * i_height, FarDepth),
+		world_to_screen_(Matrix4x4::identity),
+		occluder_triangle_count_(0)
+	{
+		//each level halves the one before it, down to a single texel
+		size_t w = width_, h = height_;
+		while (w > 1 || h > 1)
+		{
+			w = (w + 1) / 2;
+			h = (h + 1) / 2;
+			Level level;
+			level.width = w;
+			level.height = h;
+			level.depth.resize(w * h, FarDepth);
+			levels_.push_back(level);
+		}
+	}
+
+	OcclusionBuffer* OcclusionBuffer::Create(const size_t i_width, const size_t i_height)
+	{
+		if (i_width == 0 || i_height == 0)
+			return nullptr;
+		return new OcclusionBuffer((i_width + 3) & ~static_cast<size_t>(3), i_height);
+	}
+
+	void OcclusionBuffer::Clear(const Matrix4x4& i_world_to_screen)
+	{
+		world_to_screen_ = i_world_to_screen;
+		occluder_triangle_count_ = 0;
+		std::fill(depth_.begin(), depth_.end(), FarDepth);
+	}
+
+	OcclusionBuffer::ScreenVertex OcclusionBuffer::Project(const ClipVertex& i_vertex) const
+	{
+		const float invW = 1.0f / i_vertex.w;
+		ScreenVertex screen;
+		screen.x = (i_vertex.x * invW * 0.5f + 0.5f) * static_cast<float>(width_);
+		screen.y = (0.5f - i_vertex.y * invW * 0.5f) * static_cast<float>(height_);
+		screen.z = i_vertex.z * invW;
+		return screen;
+	}
+
+	void OcclusionBuffer::RasterizeOccluder(const Vector3* i_positions, const size_t i_vertex_count, const uint32_t* i_indices, const size_t i_index_count,
+		const Matrix4x4& i_local_to_world)
+	{
+		if (!i_positions || !i_indices)
+			return;
+
+		//move every vertex into clip space once
+		const Matrix4x4 localToScreen = world_to_screen_ * i_local_to_world;
+		clip_vertices_.resize(i_vertex_count);
+		for (size_t v = 0; v < i_vertex_count; v++)
+		{
+			const Vector3& p = i_positions[v];
+			ClipVertex& c = clip_vertices_[v];
+			c.x = localToScreen.Get(0, 0) * p.x() + localToScreen.Get(0, 1) * p.y() + localToScreen.Get(0, 2) * p.z() + localToScreen.Get(0, 3);
+			c.y = localToScreen.Get(1, 0) * p.x() + localToScreen.Get(1, 1) * p.y() + localToScreen.Get(1, 2) * p.z() + localToScreen.Get(1, 3);
+			c.z = localToScreen.Get(2, 0) * p.x() + localToScreen.Get(2, 1) * p.y() + localToScreen.Get(2, 2) * p.z() + localToScreen.Get(2, 3);
+			c.w = localToScreen.Get(3, 0) * p.x() + localToScreen.Get(3, 1) * p.y() + localToScreen.Get(3, 2) * p.z() + localToScreen.Get(3, 3);
+		}
+
+		for (size_t t = 0; t + 2 < i_index_count; t += 3)
+		{
+			if (i_indices[t] >= i_vertex_count || i_indices[t + 1] >= i_vertex_count || i_indices[t + 2] >= i_vertex_count)
+				continue;
+			const ClipVertex tri[3] = { clip_vertices_[i_indices[t]], clip_vertices_[i_indices[t + 1]], clip_vertices_[i_indices[t + 2]] };
+
+			//anything in front of the near plane (z < 0) is clipped away, or it would hide objects the GPU will show.
+			// Direct3D's near plane is z = 0, OpenGL's is z = -w, so this is conservative for both
+			if (tri[0].z >= 0.0f && tri[1].z >= 0.0f && tri[2].z >= 0.0f)
+			{
+				RasterizeTriangle(Project(tri[0]), Project(tri[1]), Project(tri[2]));
+			}
+			else if (tri[0].z >= 0.0f || tri[1].z >= 0.0f || tri[2].z >= 0.0f)
+			{
+				//clipping a triangle against one plane leaves up to 4 vertices
+				ClipVertex clipped[4];
+				size_t clippedCount = 0;
+				for (size_t e = 0; e < 3; e++)
+				{
+					const ClipVertex& a = tri[e];
+					const ClipVertex& b = tri[(e + 1) % 3];
+					if (a.z >= 0.0f)
+						clipped[clippedCount++] = a;
+					if ((a.z >= 0.0f) != (b.z >= 0.0f))
+					{
+						const float s = a.z / (a.z - b.z);
+						ClipVertex& c = clipped[clippedCount++];
+						c.x = a.x + (b.x - a.x) * s;
+						c.y = a.y + (b.y - a.y) * s;
+						c.z = 0.0f;
+						c.w = a.w + (b.w - a.w) * s;
+					}
+				}
+
+				ScreenVertex screen[4];
+				for (size_t v = 0; v < clippedCount; v++)
+					screen[v] = Project(clipped[v]);
+				for (size_t v = 2; v < clippedCount; v++)
+					RasterizeTriangle(screen[0], screen[v - 1], screen[v]);
+			}
+		}
+	}
+
+	void OcclusionBuffer::RasterizeTriangle(ScreenVertex i_a, ScreenVertex i_b, ScreenVertex i_c)
+	{
+		//make the winding consistent, occluders are drawn from both sides
+		float area = (i_b.x - i_a.x) * (i_c.y - i_a.y) - (i_b.y - i_a.y) * (i_c.x - i_a.x);
+		if (area < 0.0f)
+		{
+			std::swap(i_b, i_c);
+			area = -area;
+		}
+		if (!(area > 0.0f))
+			return;
+
+		//the pixels whose centers might be covered, clamped to the buffer
+		const float fMinX = std::max(std::min(std::min(i_a.x, i_b.x), i_c.x) - 0.5f, 0.0f);
+		const float fMaxX = std::min(std::max(std::max(i_a.x, i_b.x), i_c.x) - 0.5f, static_cast<float>(width_ - 1));
+		const float fMinY = std::max(std::min(std::min(i_a.y, i_b.y), i_c.y) - 0.5f, 0.0f);
+		const float fMaxY = std::min(std::max(std::max(i_a.y, i_b.y), i_c.y) - 0.5f, static_cast<float>(height_ - 1));
+		if (fMinX > fMaxX || fMinY > fMaxY)
+			return;
+		const size_t minX = static_cast<size_t>(std::ceil(fMinX)) & ~static_cast<size_t>(3);
+		const size_t maxX = static_cast<size_t>(fMaxX);
+		const size_t minY = static_cast<size_t>(std::ceil(fMinY));
+		const size_t maxY = static_cast<size_t>(fMaxY);
+		if (minY > maxY)
+			return;
+
+		//edge functions e = A * x + B * y + C, positive inside the triangle
+		const float a0 = i_a.y - i_b.y, b0 = i_b.x - i_a.x, c0 = -(a0 * i_a.x + b0 * i_a.y);
+		const float a1 = i_b.y - i_c.y, b1 = i_c.x - i_b.x, c1 = -(a1 * i_b.x + b1 * i_b.y);
+		const float a2 = i_c.y - i_a.y, b2 = i_a.x - i_c.x, c2 = -(a2 * i_c.x + b2 * i_c.y);
+
+		//depth is linear in screen space: z = zA * x + zB * y + zC
+		const float invArea = 1.0f / area;
+		const float zA = (a1 * i_a.z + a2 * i_b.z + a0 * i_c.z) * invArea;
+		const float zB = (b1 * i_a.z + b2 * i_b.z + b0 * i_c.z) * invArea;
+		const float zC = (c1 * i_a.z + c2 * i_b.z + c0 * i_c.z) * invArea;
+
+		++occluder_triangle_count_;
+
+#ifdef LAME_OCCLUSION_SSE2
+		//4 pixels at a time, width_ is a multiple of 4 so a row never runs off the buffer
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 pixelOffsets = _mm_set_ps(3.5f, 2.5f, 1.5f, 0.5f);
+		const __m128 edgeStep0 = _mm_set1_ps(a0 * 4.0f);
+		const __m128 edgeStep1 = _mm_set1_ps(a1 * 4.0f);
+		const __m128 edgeStep2 = _mm_set1_ps(a2 * 4.0f);
+		const __m128 depthStep = _mm_set1_ps(zA * 4.0f);
+		for (size_t y = minY; y <= maxY; y++)
+		{
+			const float py = static_cast<float>(y) + 0.5f;
+			const __m128 px = _mm_add_ps(_mm_set1_ps(static_cast<float>(minX)), pixelOffsets);
+			__m128 e0 = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(a0)), _mm_set1_ps(b0 * py + c0));
+			__m128 e1 = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(a1)), _mm_set1_ps(b1 * py + c1));
+			__m128 e2 = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(a2)), _mm_set1_ps(b2 * py + c2));
+			__m128 z = _mm_add_ps(_mm_mul_ps(px, _mm_set1_ps(zA)), _mm_set1_ps(zB * py + zC));
+
+			float* row = &depth_[y * width_];
+			for (size_t x = minX; x <= maxX; x += 4)
+			{
+				const __m128 inside = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(e0, zero), _mm_cmpge_ps(e1, zero)), _mm_cmpge_ps(e2, zero));
+				if (_mm_movemask_ps(inside))
+				{
+					const __m128 current = _mm_loadu_ps(row + x);
+					const __m128 nearest = _mm_min_ps(current, z);
+					_mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+				}
+				e0 = _mm_add_ps(e0, edgeStep0);
+				e1 = _mm_add_ps(e1, edgeStep1);
+				e2 = _mm_add_ps(e2, edgeStep2);
+				z = _mm_add_ps(z, depthStep);
+			}
+		}
+#else
+		for (size_t y = minY; y <= maxY; y++)
+		{
+			const float py = static_cast<float>(y) + 0.5f;
+			float* row = &depth_[y * width_];
+			for (size_t x = minX; x <= maxX; x++)
+			{
+				const float px = static_cast<float>(x) + 0.5f;
+				if (a0 * px + b0 * py + c0 >= 0.0f && a1 * px + b1 * py + c1 >= 0.0f && a2 * px + b2 * py + c2 >= 0.0f)
+					row[x] = std::min(row[x], zA * px + zB * py + zC);
+			}
+		}
+#endif
+	}
+
+	void OcclusionBuffer::BuildHiZ()
+	{
+		const float* source = depth_.data();
+		size_t sourceWidth = width_, sourceHeight = height_;
+		for (size_t l = 0; l < levels_.size(); l++)
+		{
+			Level& level = levels_[l];
+			for (size_t y = 0; y < level.height; y++)
+			{
+				const float* row0 = source + (y * 2) * sourceWidth;
+				const float* row1 = (y * 2 + 1 < sourceHeight) ? row0 + sourceWidth : row0;
+				for (size_t x = 0; x < level.width; x++)
+				{
+					const size_t x0 = x * 2;
+					const size_t x1 = (x0 + 1 < sourceWidth) ? x0 + 1 : x0;
+					level.depth[y * level.width + x] = std::max(std::max(row0[x0], row0[x1]), std::max(row1[x0], row1[x1]));
+				}
+			}
+			source = level.depth.data();
+			sourceWidth = level.width;
+			sourceHeight = level.height;
+		}
+	}
+
+	bool OcclusionBuffer::IsVisible(const Bounds& i_bounds) const
+	{
+		if (!i_bounds.IsValid() || occluder_triangle_count_ == 0)
+			return true;
+
+		//find the screen rectangle and nearest depth of the box's corners
+		float minX = FarDepth, minY = FarDepth, maxX = -FarDepth, maxY = -FarDepth, minZ = FarDepth;
+		for (size_t c = 0; c < 8; c++)
+		{
+			const Vector3 p((c & 1) ? i_bounds.max().x() : i_bounds.min().x(),
+				(c & 2) ? i_bounds.max().y() : i_bounds.min().y(),
+				(c & 4) ? i_bounds.max().z() : i_bounds.min().z());
+			ClipVertex clip;
+			clip.x = world_to_screen_.Get(0, 0) * p.x() + world_to_screen_.Get(0, 1) * p.y() + world_to_screen_.Get(0, 2) * p.z() + world_to_screen_.Get(0, 3);
+			clip.y = world_to_screen_.Get(1, 0) * p.x() + world_to_screen_.Get(1, 1) * p.y() + world_to_screen_.Get(1, 2) * p.z() + world_to_screen_.Get(1, 3);
+			clip.z = world_to_screen_.Get(2, 0) * p.x() + world_to_screen_.Get(2, 1) * p.y() + world_to_screen_.Get(2, 2) * p.z() + world_to_screen_.Get(2, 3);
+			clip.w = world_to_screen_.Get(3, 0) * p.x() + world_to_screen_.Get(3, 1) * p.y() + world_to_screen_.Get(3, 2) * p.z() + world_to_screen_.Get(3, 3);
+
+			//boxes crossing the near plane are always visible
+			if (clip.z < 0.0f || clip.w <= 0.0f)
+				return true;
+
+			const ScreenVertex screen = Project(clip);
+			minX = std::min(minX, screen.x);
+			maxX = std::max(maxX, screen.x);
+			minY = std::min(minY, screen.y);
+			maxY = std::max(maxY, screen.y);
+			minZ = std::min(minZ, screen.z);
+		}
+
+		//the frustum culling deals with boxes off the screen
+		if (maxX < 0.0f || maxY < 0.0f || minX >= static_cast<float>(width_) || minY >= static_cast<float>(height_))
+			return true;
+		size_t x0 = static_cast<size_t>(std::max(minX, 0.0f));
+		size_t y0 = static_cast<size_t>(std::max(minY, 0.0f));
+		size_t x1 = static_cast<size_t>(std::min(maxX, static_cast<float>(width_ - 1)));
+		size_t y1 = static_cast<size_t>(std::min(maxY, static_cast<float>(height_ - 1)));
+
+		//walk up the pyramid until the rectangle covers only a few texels, level 0 is the full depth buffer
+		size_t level = 0;
+		while (level < levels_.size() && (x1 - x0 >= MaxTestTexels || y1 - y0 >= MaxTestTexels))
+		{
+			x0 /= 2; y0 /= 2;
+			x1 /= 2; y1 /= 2;
+			++level;
+		}
+		const float* depth = level == 0 ? depth_.data() : levels_[level - 1].depth.data();
+		const size_t levelWidth = level == 0 ? width_ : levels_[level - 1].width;
+
+		//visible if the box is in front of the farthest occluder depth anywhere under it
+		for (size_t y = y0; y <= y1; y++)
+		{
+			for (size_t x = x0; x <= x1; x++)
+			{
+				if (minZ <= depth[y * levelWidth + x])
+					return true;
+			}
+		}
+		return false;
+	}
+}
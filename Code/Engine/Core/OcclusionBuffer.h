@@ -0,0 +1,77 @@
+#ifndef _ENGINE_CORE_OCCLUSIONBUFFER_H
+#define _ENGINE_CORE_OCCLUSIONBUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "Matrix4x4.h"
+
+namespace Lame
+{
+	class Vector3;
+	class Bounds;
+
+	//Low resolution software depth buffer for occlusion culling on the CPU.
+	// Occluder triangles are rasterized into it each frame, then a max depth pyramid (hierarchical z) is built
+	// so the screen rectangle of a bounding box can be tested against a handful of texels.
+	class OcclusionBuffer
+	{
+	public:
+		//i_width is rounded up to a multiple of 4, so rows can be rasterized 4 pixels at a time
+		static OcclusionBuffer* Create(const size_t i_width, const size_t i_height);
+
+		//resets the depth to the far plane, and sets the matrix that following calls project with
+		void Clear(const Matrix4x4& i_world_to_screen);
+
+		//rasterizes an indexed triangle list, with positions placed in the world by i_local_to_world
+		void RasterizeOccluder(const Vector3* i_positions, const size_t i_vertex_count, const uint32_t* i_indices, const size_t i_index_count,
+			const Matrix4x4& i_local_to_world = Matrix4x4::identity);
+
+		//builds the depth pyramid, must be called after rasterizing and before testing
+		void BuildHiZ();
+
+		//could any part of the world space bounds be in front of the occluders (safe to call from multiple threads)
+		bool IsVisible(const Bounds& i_bounds) const;
+
+		inline size_t width() const { return width_; }
+		inline size_t height() const { return height_; }
+		inline size_t occluder_triangle_count() const { return occluder_triangle_count_; }
+
+	private:
+		OcclusionBuffer(const size_t i_width, const size_t i_height);
+
+		//Do not allow OcclusionBuffers to be managed without pointers
+		OcclusionBuffer();
+		OcclusionBuffer(const OcclusionBuffer &i_other);
+		OcclusionBuffer& operator=(const OcclusionBuffer &i_other);
+
+		struct ClipVertex
+		{
+			float x, y, z, w;
+		};
+		//x, y in pixels and z in normalized depth
+		struct ScreenVertex
+		{
+			float x, y, z;
+		};
+		ScreenVertex Project(const ClipVertex& i_vertex) const;
+		void RasterizeTriangle(ScreenVertex i_a, ScreenVertex i_b, ScreenVertex i_c);
+
+		struct Level
+		{
+			size_t width, height;
+			std::vector<float> depth;		//farthest depth of the pixels each texel covers
+		};
+
+		size_t width_;
+		size_t height_;
+		std::vector<float> depth_;			//nearest occluder depth of each pixel
+		std::vector<Level> levels_;			//levels_[0] is half the resolution of depth_
+		Matrix4x4 world_to_screen_;
+		std::vector<ClipVertex> clip_vertices_;		//scratch list of the current occluder's transformed vertices
+		size_t occluder_triangle_count_;
+	};
+}
+
+#endif //_ENGINE_CORE_OCCLUSIONBUFFER_H
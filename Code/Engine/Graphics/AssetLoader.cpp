@@ -0,0 +1,282 @@
+
+#include "AssetLoader.h"
+
+#include <algorithm>
+#include <chrono>
+
+#include "Context.h"
+#include "Material.h"
+#include "RenderableMesh.h"
+#include "Texture.h"
+#include "../System/FileLoader.h"
+#include "../System/MappedFile.h"
+#include "../System/ThreadPool.h"
+#include "../System/UserOutput.h"
+
+namespace
+{
+	//reads a byte from every page of the file, so the device thread doesn't wait on the disk when it copies the file
+	void TouchPages(const Lame::File::MappedFile& i_file)
+	{
+		const size_t pageSize = 4096;
+		volatile char touched = 0;
+		for (size_t x = 0; x < i_file.size(); x += pageSize)
+			touched = i_file.data()[x];
+	}
+
+	//a material and the files of its textures, which are read along with it
+	struct MaterialData
+	{
+		Lame::Material::FileData material;
+		std::vector<std::shared_ptr<Lame::File::MappedFile>> texture_files;	//one for each parameter, null for the ones that aren't textures
+	};
+}
+
+namespace Lame
+{
+	AssetLoader* AssetLoader::Create(std::shared_ptr<Assets> i_assets, std::shared_ptr<ThreadPool> i_thread_pool)
+	{
+		if (!i_assets)
+			return nullptr;
+
+		AssetLoader *loader = new AssetLoader(i_assets, i_thread_pool);
+		if (!loader)
+			Lame::UserOutput::Display("Insufficient memory when creating the AssetLoader");
+		return loader;
+	}
+
+	AssetLoader::~AssetLoader()
+	{
+		//the queued jobs point at this loader, so they have to run before it goes away
+		std::unique_lock<std::mutex> lock(mutex_);
+		shutting_down_ = true;
+		while (reading_ > 0)
+		{
+			lock.unlock();
+			const bool ranJob = thread_pool_->RunPendingJob();
+			lock.lock();
+			if (!ranJob)
+				read_.wait_for(lock, std::chrono::milliseconds(1));
+		}
+	}
+
+	std::shared_ptr<AsyncAsset<RenderableMesh>> AssetLoader::mesh(const std::string& i_path, const Priority i_priority, const MeshCallback& i_callback)
+	{
+		std::shared_ptr<Context> context = assets_->get_context();
+		const bool decompress = !context->SupportsVertexFormat(VertexFormat::Compressed);
+		return Queue<RenderableMesh, RenderableMesh::FileData>(i_path, i_priority, i_callback, assets_->meshes(), loading_meshes_, mesh_placeholder_,
+			[i_path, decompress](RenderableMesh::FileData& o_data) { return RenderableMesh::Load(i_path, decompress, o_data); },
+			[context](RenderableMesh::FileData& i_data) { return RenderableMesh::Create(true, context, i_data); });
+	}
+
+	std::shared_ptr<AsyncAsset<Material>> AssetLoader::material(const std::string& i_path, const Priority i_priority, const MaterialCallback& i_callback)
+	{
+		std::shared_ptr<Assets> assets = assets_;
+		return Queue<Material, MaterialData>(i_path, i_priority, i_callback, assets_->materials(), loading_materials_, material_placeholder_,
+			[i_path](MaterialData& o_data)
+			{
+				if (!Material::Load(i_path, o_data.material))
+					return false;
+				for (uint32_t x = 0; x < o_data.material.header->parameter_count; x++)
+				{
+					std::shared_ptr<File::MappedFile> file;
+					const File::MaterialString& texturePath = o_data.material.parameters[x].texture;
+					if (texturePath.length > 0)
+					{
+						file.reset(File::MappedFile::Create(File::GetMaterialString(o_data.material.file->data(), texturePath)));
+						if (!file)
+							return false;
+						TouchPages(*file);
+					}
+					o_data.texture_files.push_back(file);
+				}
+				return true;
+			},
+			[assets](MaterialData& i_data)
+			{
+				//the textures that aren't shared yet are created from the files that were already read
+				for (size_t x = 0; x < i_data.texture_files.size(); x++)
+				{
+					if (!i_data.texture_files[x])
+						continue;
+					const File::MappedFile& file = *i_data.texture_files[x];
+					const File::MaterialString& texturePath = i_data.material.parameters[x].texture;
+					if (!assets->textures().Get(HashedString::FromHash(texturePath.hash), File::GetMaterialString(i_data.material.file->data(), texturePath),
+						[&assets, &file](const std::string& i_texture_path) { return Texture::Create(assets->get_context(), file, i_texture_path); }))
+						return static_cast<Material*>(nullptr);
+				}
+				return Material::Create(*assets, i_data.material);
+			});
+	}
+
+	std::shared_ptr<AsyncAsset<Texture>> AssetLoader::texture(const std::string& i_path, const Priority i_priority, const TextureCallback& i_callback)
+	{
+		std::shared_ptr<Context> context = assets_->get_context();
+		return Queue<Texture, std::shared_ptr<File::MappedFile>>(i_path, i_priority, i_callback, assets_->textures(), loading_textures_, texture_placeholder_,
+			[i_path](std::shared_ptr<File::MappedFile>& o_file)
+			{
+				o_file.reset(File::MappedFile::Create(i_path));
+				if (o_file)
+					TouchPages(*o_file);
+				return o_file != nullptr;
+			},
+			[context, i_path](std::shared_ptr<File::MappedFile>& i_file) { return Texture::Create(context, *i_file, i_path); });
+	}
+
+	template<typename T, typename Data>
+	std::shared_ptr<AsyncAsset<T>> AssetLoader::Queue(const std::string& i_path, const Priority i_priority, const std::function<void(std::shared_ptr<T>)>& i_callback,
+		AssetCache<T>& i_cache, std::unordered_map<HashedString, std::weak_ptr<AsyncAsset<T>>>& i_loading, std::shared_ptr<T> i_placeholder,
+		const std::function<bool(Data&)>& i_load, const std::function<T*(Data&)>& i_create)
+	{
+		const HashedString key(i_path.c_str());
+		std::shared_ptr<T> loaded = i_cache.Find(key);
+		if (loaded)
+		{
+			std::shared_ptr<AsyncAsset<T>> handle(new AsyncAsset<T>(i_path, i_placeholder));
+			handle->asset_ = loaded;
+			handle->state_ = AsyncAsset<T>::State::Ready;
+			if (i_callback)
+				i_callback(loaded);
+			return handle;
+		}
+
+		auto itr = i_loading.find(key);
+		std::shared_ptr<AsyncAsset<T>> handle = itr != i_loading.end() ? itr->second.lock() : nullptr;
+		if (handle && !handle->cancelled_)
+		{
+			if (i_callback)
+				handle->callbacks_.push_back(i_callback);
+			return handle;
+		}
+
+		handle.reset(new AsyncAsset<T>(i_path, i_placeholder));
+		if (i_callback)
+			handle->callbacks_.push_back(i_callback);
+		i_loading[key] = handle;
+
+		//the request keeps the handle alive, so the asset still reaches the cache if nothing is holding on to it
+		std::shared_ptr<Data> data(new Data());
+		std::shared_ptr<Request> request(new Request());
+		request->priority = i_priority;
+		request->sequence = next_sequence_++;
+		request->loaded = false;
+		request->cancelled = [handle]() { return handle->cancelled_.load(); };
+		request->load = [data, i_load]() { return i_load(*data); };
+		request->finish = [handle, data, key, i_create, &i_cache, &i_loading](const bool i_loaded)
+		{
+			auto itr = i_loading.find(key);
+			if (itr != i_loading.end() && itr->second.lock() == handle)
+				i_loading.erase(itr);
+			if (handle->cancelled_)
+			{
+				handle->state_ = AsyncAsset<T>::State::Cancelled;
+				return;
+			}
+
+			//something may have loaded the same asset while this one was reading its file
+			if (i_loaded)
+				handle->asset_ = i_cache.Get(handle->path_, [&data, &i_create](const std::string&) { return i_create(*data); });
+			handle->state_ = handle->asset_ ? AsyncAsset<T>::State::Ready : AsyncAsset<T>::State::Failed;
+
+			std::vector<std::function<void(std::shared_ptr<T>)>> callbacks;
+			callbacks.swap(handle->callbacks_);
+			for (size_t x = 0; x < callbacks.size(); x++)
+				callbacks[x](handle->asset_);
+		};
+		Enqueue(request);
+		return handle;
+	}
+
+	bool AssetLoader::RequestFirst(const std::shared_ptr<Request>& i_left, const std::shared_ptr<Request>& i_right)
+	{
+		if (i_left->priority != i_right->priority)
+			return i_left->priority > i_right->priority;
+		return i_left->sequence < i_right->sequence;
+	}
+
+	void AssetLoader::Enqueue(std::shared_ptr<Request> i_request)
+	{
+		pending_++;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			waiting_.push_back(i_request);
+			std::push_heap(waiting_.begin(), waiting_.end(), RequestLater);
+			if (thread_pool_)
+				reading_++;
+		}
+
+		//every job reads whichever file is most important when it runs, not necessarily this one
+		if (thread_pool_)
+			thread_pool_->Enqueue([this]() { ReadNext(); });
+	}
+
+	bool AssetLoader::ReadNext()
+	{
+		std::shared_ptr<Request> request;
+		bool skip;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (waiting_.empty())
+				return false;
+			std::pop_heap(waiting_.begin(), waiting_.end(), RequestLater);
+			request = waiting_.back();
+			waiting_.pop_back();
+			skip = shutting_down_;
+		}
+
+		request->loaded = !skip && !request->cancelled() && request->load();
+
+		//notified while still locked, as once reading_ is 0 the destructor can return and free read_
+		std::lock_guard<std::mutex> lock(mutex_);
+		read_requests_.push_back(request);
+		if (thread_pool_)
+			reading_--;
+		read_.notify_all();
+		return true;
+	}
+
+	size_t AssetLoader::Update(const size_t i_max_creates)
+	{
+		if (!thread_pool_)
+		{
+			for (size_t x = 0; x < i_max_creates && ReadNext(); x++) {}
+		}
+
+		std::vector<std::shared_ptr<Request>> requests;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			requests.swap(read_requests_);
+		}
+
+		//the highest priority requests are created first, in the order they were made
+		std::sort(requests.begin(), requests.end(), RequestFirst);
+		size_t finished = 0;
+		for (; finished < requests.size() && finished < i_max_creates; finished++)
+		{
+			requests[finished]->finish(requests[finished]->loaded);
+			pending_--;
+		}
+
+		if (finished < requests.size())
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			read_requests_.insert(read_requests_.end(), requests.begin() + finished, requests.end());
+		}
+		return finished;
+	}
+
+	void AssetLoader::Flush()
+	{
+		while (pending_ > 0)
+		{
+			if (Update() > 0)
+				continue;
+
+			//help the workers rather than only waiting on them
+			if (thread_pool_ && thread_pool_->RunPendingJob())
+				continue;
+			std::unique_lock<std::mutex> lock(mutex_);
+			read_.wait_for(lock, std::chrono::milliseconds(1), [this]() { return !read_requests_.empty(); });
+		}
+	}
+}
@@ -0,0 +1,150 @@
+#ifndef _LAME_ASSETLOADER_H
+#define _LAME_ASSETLOADER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "../Core/HashedString.h"
+#include "Assets.h"
+
+namespace Lame
+{
+	class ThreadPool;
+	class AssetLoader;
+
+	//An asset that is being loaded in the background.  Until it is ready get() returns the placeholder it was requested with,
+	// which may be null.  Handles are only updated by AssetLoader::Update, so they should only be read on the context's thread.
+	template<typename T>
+	class AsyncAsset
+	{
+	public:
+		enum class State { Loading, Ready, Failed, Cancelled };
+
+		inline State state() const { return state_; }
+		inline bool ready() const { return state_ == State::Ready; }
+		inline bool done() const { return state_ != State::Loading; }
+		inline std::shared_ptr<T> get() const { return asset_ ? asset_ : placeholder_; }
+		inline const std::string& path() const { return path_; }
+
+		//stops the load for everything waiting on it, if it hasn't finished yet.  None of its callbacks are called.
+		inline void Cancel() { cancelled_ = true; }
+
+	private:
+		AsyncAsset(const std::string& i_path, std::shared_ptr<T> i_placeholder) : path_(i_path), state_(State::Loading), placeholder_(i_placeholder), cancelled_(false) {}
+
+		//Do not allow AsyncAssets to be managed without pointers
+		AsyncAsset(const AsyncAsset &i_other);
+		AsyncAsset& operator=(const AsyncAsset &i_other);
+
+		std::string path_;
+		State state_;
+		std::shared_ptr<T> asset_;
+		std::shared_ptr<T> placeholder_;
+		std::vector<std::function<void(std::shared_ptr<T>)>> callbacks_;
+		std::atomic<bool> cancelled_;
+
+		friend class AssetLoader;
+	};
+
+	//Loads meshes, materials and textures without stalling the thread that renders.  Their files are read and parsed on the thread pool,
+	// and Update creates their device resources on the context's thread, adds them to the Assets caches and calls their callbacks.
+	// Higher priority requests are read and created first.  Requests must be made on the context's thread.
+	class AssetLoader
+	{
+	public:
+		enum Priority { Low, Normal, High };
+
+		//called with the asset, or null if it failed to load
+		typedef std::function<void(std::shared_ptr<RenderableMesh>)> MeshCallback;
+		typedef std::function<void(std::shared_ptr<Material>)> MaterialCallback;
+		typedef std::function<void(std::shared_ptr<Texture>)> TextureCallback;
+
+		//without a thread pool the files are read by Update and Flush instead
+		static AssetLoader* Create(std::shared_ptr<Assets> i_assets, std::shared_ptr<ThreadPool> i_thread_pool);
+		//waits for the files that are being read, the requests that haven't finished are dropped
+		~AssetLoader();
+
+		//Assets that are already loaded are ready straight away, with their callback called before these return.
+		// Asking for an asset that is still loading shares the request that is already running.
+		std::shared_ptr<AsyncAsset<RenderableMesh>> mesh(const std::string& i_path, const Priority i_priority = Normal, const MeshCallback& i_callback = nullptr);
+		std::shared_ptr<AsyncAsset<Material>> material(const std::string& i_path, const Priority i_priority = Normal, const MaterialCallback& i_callback = nullptr);
+		std::shared_ptr<AsyncAsset<Texture>> texture(const std::string& i_path, const Priority i_priority = Normal, const TextureCallback& i_callback = nullptr);
+
+		//finishes at most i_max_creates of the requests whose files have been read, so a burst of them can't stall a frame.
+		// Returns the number finished.
+		size_t Update(const size_t i_max_creates = SIZE_MAX);
+
+		//finishes every request, helping the workers read files while it waits
+		void Flush();
+
+		//the number of requests that haven't finished
+		inline size_t pending() const { return pending_; }
+
+		//what new requests give out until they are ready
+		inline void placeholder(std::shared_ptr<RenderableMesh> i_mesh) { mesh_placeholder_ = i_mesh; }
+		inline void placeholder(std::shared_ptr<Material> i_material) { material_placeholder_ = i_material; }
+		inline void placeholder(std::shared_ptr<Texture> i_texture) { texture_placeholder_ = i_texture; }
+
+	private:
+		AssetLoader(std::shared_ptr<Assets> i_assets, std::shared_ptr<ThreadPool> i_thread_pool) :
+			assets_(i_assets), thread_pool_(i_thread_pool), next_sequence_(0), pending_(0), reading_(0), shutting_down_(false) {}
+
+		//Do not allow AssetLoaders to be managed without pointers
+		AssetLoader(const AssetLoader &i_other);
+		AssetLoader& operator=(const AssetLoader &i_other);
+
+		struct Request
+		{
+			Priority priority;
+			uint64_t sequence;
+			bool loaded;
+			std::function<bool()> cancelled;
+			std::function<bool()> load;				//reads the file, on any thread
+			std::function<void(const bool)> finish;	//creates the asset (if it loaded) and updates the handle, on the context's thread
+		};
+		static bool RequestFirst(const std::shared_ptr<Request>& i_left, const std::shared_ptr<Request>& i_right);
+		static bool RequestLater(const std::shared_ptr<Request>& i_left, const std::shared_ptr<Request>& i_right) { return RequestFirst(i_right, i_left); }
+
+		//shares an asset that is loaded or loading, or queues a new request that loads its file into a Data with i_load and creates it from that with i_create
+		template<typename T, typename Data>
+		std::shared_ptr<AsyncAsset<T>> Queue(const std::string& i_path, const Priority i_priority, const std::function<void(std::shared_ptr<T>)>& i_callback,
+			AssetCache<T>& i_cache, std::unordered_map<HashedString, std::weak_ptr<AsyncAsset<T>>>& i_loading, std::shared_ptr<T> i_placeholder,
+			const std::function<bool(Data&)>& i_load, const std::function<T*(Data&)>& i_create);
+
+		void Enqueue(std::shared_ptr<Request> i_request);
+
+		//reads the file of the highest priority request that is waiting, returns false if none were
+		bool ReadNext();
+
+		std::shared_ptr<Assets> assets_;
+		std::shared_ptr<ThreadPool> thread_pool_;
+		uint64_t next_sequence_;
+		size_t pending_;
+
+		//the assets that are loading, so requests for the same path share them
+		std::unordered_map<HashedString, std::weak_ptr<AsyncAsset<RenderableMesh>>> loading_meshes_;
+		std::unordered_map<HashedString, std::weak_ptr<AsyncAsset<Material>>> loading_materials_;
+		std::unordered_map<HashedString, std::weak_ptr<AsyncAsset<Texture>>> loading_textures_;
+
+		std::shared_ptr<RenderableMesh> mesh_placeholder_;
+		std::shared_ptr<Material> material_placeholder_;
+		std::shared_ptr<Texture> texture_placeholder_;
+
+		//shared with the workers
+		std::mutex mutex_;
+		std::condition_variable read_;
+		std::vector<std::shared_ptr<Request>> waiting_;		//a heap, highest priority first
+		std::vector<std::shared_ptr<Request>> read_requests_;	//files that have been read, waiting for Update
+		size_t reading_;									//jobs queued on the thread pool that haven't finished
+		bool shutting_down_;
+	};
+}
+
+#endif //_LAME_ASSETLOADER_H
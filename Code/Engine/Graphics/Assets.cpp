@@ -0,0 +1,69 @@
+
+#include "Assets.h"
+
+#include "Context.h"
+#include "Effect.h"
+#include "Material.h"
+#include "RenderableMesh.h"
+#include "Texture.h"
+#include "../System/UserOutput.h"
+
+namespace Lame
+{
+	Assets* Assets::Create(std::shared_ptr<Context> i_context)
+	{
+		if (!i_context)
+			return nullptr;
+
+		Assets* assets = new Assets(i_context);
+		if (!assets)
+			Lame::UserOutput::Display("Insufficient memory when creating Assets");
+		return assets;
+	}
+
+	std::shared_ptr<Effect> Assets::effect(const std::string& i_path)
+	{
+		return effects_.Get(i_path, [this](const std::string& i_effect_path) { return Effect::Create(context, i_effect_path); });
+	}
+
+	std::shared_ptr<Texture> Assets::texture(const std::string& i_path)
+	{
+		return textures_.Get(i_path, [this](const std::string& i_texture_path) { return Texture::Create(context, i_texture_path); });
+	}
+
+	std::shared_ptr<Effect> Assets::effect(const HashedString& i_key, const char* i_path)
+	{
+		return effects_.Get(i_key, i_path, [this](const std::string& i_effect_path) { return Effect::Create(context, i_effect_path); });
+	}
+
+	std::shared_ptr<Texture> Assets::texture(const HashedString& i_key, const char* i_path)
+	{
+		return textures_.Get(i_key, i_path, [this](const std::string& i_texture_path) { return Texture::Create(context, i_texture_path); });
+	}
+
+	std::shared_ptr<RenderableMesh> Assets::mesh(const std::string& i_path)
+	{
+		return meshes_.Get(i_path, [this](const std::string& i_mesh_path) { return RenderableMesh::Create(true, context, i_mesh_path); });
+	}
+
+	std::shared_ptr<Material> Assets::material(const std::string& i_path)
+	{
+		return materials_.Get(i_path, [this](const std::string& i_material_path) { return Material::Create(*this, i_material_path); });
+	}
+
+	bool Assets::Unload(const std::string& i_path)
+	{
+		const HashedString key(i_path.c_str());
+		return materials_.Unload(key) || meshes_.Unload(key) || effects_.Unload(key) || textures_.Unload(key);
+	}
+
+	size_t Assets::UnloadUnused()
+	{
+		//materials go first, since they are what keeps most effects and textures in use
+		size_t unloaded = materials_.UnloadUnused();
+		unloaded += meshes_.UnloadUnused();
+		unloaded += effects_.UnloadUnused();
+		unloaded += textures_.UnloadUnused();
+		return unloaded;
+	}
+}
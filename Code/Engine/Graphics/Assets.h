@@ -0,0 +1,129 @@
+#ifndef _LAME_ASSETS_H
+#define _LAME_ASSETS_H
+
+#include <functional>
+#include <memory>
+#include <string>
+#include <unordered_map>
+
+#include "../Core/HashedString.h"
+
+namespace Lame
+{
+	class Context;
+	class Effect;
+	class Texture;
+	class RenderableMesh;
+	class Material;
+
+	//Loaded assets of one type, keyed by their path.  Each asset is loaded once and shared by everything that asks for it,
+	// the shared_ptrs count its users, and the cache keeps its own reference until the asset is unloaded.
+	template<typename T>
+	class AssetCache
+	{
+	public:
+		//finds the asset at i_path, or loads it with i_load.  Assets that fail to load are not cached.
+		std::shared_ptr<T> Get(const std::string& i_path, const std::function<T*(const std::string&)>& i_load)
+		{
+			const HashedString key(i_path.c_str());
+			auto itr = assets_.find(key);
+			if (itr != assets_.end())
+				return itr->second;
+
+			std::shared_ptr<T> asset(i_load(i_path));
+			if (asset)
+				assets_[key] = asset;
+			return asset;
+		}
+
+		//the same, for a path whose key was hashed ahead of time.  i_path is only copied into a string when the asset has to be loaded.
+		std::shared_ptr<T> Get(const HashedString& i_key, const char* i_path, const std::function<T*(const std::string&)>& i_load)
+		{
+			auto itr = assets_.find(i_key);
+			if (itr != assets_.end())
+				return itr->second;
+
+			std::shared_ptr<T> asset(i_load(i_path));
+			if (asset)
+				assets_[i_key] = asset;
+			return asset;
+		}
+
+		//the asset at i_path if it has been loaded, or null
+		std::shared_ptr<T> Find(const HashedString& i_path) const
+		{
+			auto itr = assets_.find(i_path);
+			return itr != assets_.end() ? itr->second : nullptr;
+		}
+
+		//drops the cache's reference, the asset is destroyed once its last user lets go of it
+		bool Unload(const HashedString& i_path) { return assets_.erase(i_path) > 0; }
+
+		//unloads every asset that only the cache is using
+		size_t UnloadUnused()
+		{
+			size_t unloaded = 0;
+			for (auto itr = assets_.begin(); itr != assets_.end(); /**/)
+			{
+				if (itr->second.use_count() == 1)
+				{
+					itr = assets_.erase(itr);
+					unloaded++;
+				}
+				else
+				{
+					++itr;
+				}
+			}
+			return unloaded;
+		}
+
+		inline size_t size() const { return assets_.size(); }
+	private:
+		std::unordered_map<HashedString, std::shared_ptr<T>> assets_;
+	};
+
+	//The shared effects, textures, meshes and materials that have been loaded from files
+	class Assets
+	{
+	public:
+		static Assets* Create(std::shared_ptr<Context> i_context);
+
+		std::shared_ptr<Effect> effect(const std::string& i_path);
+		std::shared_ptr<Texture> texture(const std::string& i_path);
+		std::shared_ptr<RenderableMesh> mesh(const std::string& i_path);
+		std::shared_ptr<Material> material(const std::string& i_path);
+
+		//for paths whose keys were hashed when their asset was built (see File::MaterialString)
+		std::shared_ptr<Effect> effect(const HashedString& i_key, const char* i_path);
+		std::shared_ptr<Texture> texture(const HashedString& i_key, const char* i_path);
+
+		//unloads the asset at i_path from whichever cache holds it
+		bool Unload(const std::string& i_path);
+		//unloads every asset that is no longer used outside of the caches, returns the number unloaded
+		size_t UnloadUnused();
+
+		//the caches themselves, for loaders that create the assets on their own (see AssetLoader)
+		inline AssetCache<Texture>& textures() { return textures_; }
+		inline AssetCache<RenderableMesh>& meshes() { return meshes_; }
+		inline AssetCache<Material>& materials() { return materials_; }
+
+		inline size_t count() const { return effects_.size() + textures_.size() + meshes_.size() + materials_.size(); }
+		inline std::shared_ptr<Context> get_context() const { return context; }
+	private:
+		Assets(std::shared_ptr<Context> i_context) : context(i_context) {}
+
+		//Do not allow Assets to be managed without pointers
+		Assets();
+		Assets(const Assets &i_other);
+		Assets& operator=(const Assets &i_other);
+
+		std::shared_ptr<Context> context;
+		AssetCache<Effect> effects_;
+		AssetCache<Texture> textures_;
+		AssetCache<RenderableMesh> meshes_;
+		AssetCache<Material> materials_;
+	};
+}
+
+#endif //_LAME_ASSETS_H
@@ -0,0 +1,64 @@
+
+#include "CommandBuffer.h"
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+namespace
+{
+	bool KeyLess(const Lame::DrawPacket& i_lhs, const Lame::DrawPacket& i_rhs)
+	{
+		return i_lhs.sort_key < i_rhs.sort_key;
+	}
+}
+
+namespace Lame
+{
+	uint64_t CommandBuffer::OpaqueKey(const Material* i_material, const RenderableMesh* i_mesh, const uint32_t i_lod)
+	{
+		//equal pointers give equal keys, so identical pairs always end up next to each other
+		const uint64_t material = static_cast<uint64_t>(std::hash<const Material*>()(i_material)) & 0x7FFFFFFFull;
+		const uint64_t mesh = static_cast<uint64_t>(std::hash<const RenderableMesh*>()(i_mesh)) & 0xFFFFFFF0ull;
+		return (material << 32) | mesh | std::min<uint64_t>(i_lod, 0xF);
+	}
+
+	uint64_t CommandBuffer::TransparentKey(const float i_view_depth)
+	{
+		//the bits of a positive float sort the same as its value, invert them to draw the furthest first
+		const float depth = std::max(i_view_depth, 0.0f);
+		uint32_t bits;
+		memcpy(&bits, &depth, sizeof(bits));
+		return TransparentBit | static_cast<uint64_t>(~bits);
+	}
+
+	void CommandBuffer::Sort()
+	{
+		std::sort(packets_.begin(), packets_.end(), KeyLess);
+	}
+
+	void CommandBuffer::Merge(const std::vector<CommandBuffer>& i_buffers)
+	{
+		packets_.clear();
+
+		size_t total = 0;
+		for (size_t x = 0; x < i_buffers.size(); x++)
+			total += i_buffers[x].size();
+		packets_.reserve(total);
+
+		//append each sorted buffer and merge it with everything before it
+		for (size_t x = 0; x < i_buffers.size(); x++)
+		{
+			const size_t middle = packets_.size();
+			packets_.insert(packets_.end(), i_buffers[x].packets_.begin(), i_buffers[x].packets_.end());
+			std::inplace_merge(packets_.begin(), packets_.begin() + middle, packets_.end(), KeyLess);
+		}
+	}
+
+	size_t CommandBuffer::FirstTransparent() const
+	{
+		DrawPacket key;
+		key.sort_key = TransparentBit;
+		return std::lower_bound(packets_.begin(), packets_.end(), key, KeyLess) - packets_.begin();
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef _ENGINE_GRAPHICS_COMMANDBUFFER_H
+#define _ENGINE_GRAPHICS_COMMANDBUFFER_H
+
+#include <cstdint>
+#include <vector>
+
+#include "../Core/Matrix4x4.h"
+
+namespace Lame
+{
+	class RenderableComponent;
+	class RenderableMesh;
+	class Material;
+
+	//A single recorded draw.  Holds no API objects, so it can be recorded on any thread and replayed later.
+	struct DrawPacket
+	{
+		uint64_t sort_key;
+		const RenderableComponent* renderable;		//supplies the mesh, material and uniform handles
+		Matrix4x4 local_to_world;
+		uint32_t lod;
+	};
+
+	//List of draw packets recorded by one thread
+	class CommandBuffer
+	{
+	public:
+		//opaque keys group by material, then mesh and LOD, transparent keys sort after every opaque key, back to front
+		static uint64_t OpaqueKey(const Material* i_material, const RenderableMesh* i_mesh, const uint32_t i_lod = 0);
+		static uint64_t TransparentKey(const float i_view_depth);
+		static inline bool IsTransparentKey(const uint64_t i_key) { return (i_key & TransparentBit) != 0; }
+
+		inline void Clear() { packets_.clear(); }
+		inline void Add(const DrawPacket& i_packet) { packets_.push_back(i_packet); }
+
+		void Sort();
+
+		//replaces the contents of this buffer with all the packets from i_buffers, in key order
+		// (each of i_buffers must already be sorted)
+		void Merge(const std::vector<CommandBuffer>& i_buffers);
+
+		//index of the first transparent packet in a sorted buffer
+		size_t FirstTransparent() const;
+
+		inline const std::vector<DrawPacket>& packets() const { return packets_; }
+		inline size_t size() const { return packets_.size(); }
+		inline const DrawPacket& operator[](const size_t i_index) const { return packets_[i_index]; }
+
+	private:
+		static const uint64_t TransparentBit = 1ull << 63;
+
+		std::vector<DrawPacket> packets_;
+	};
+}
+
+#endif //_ENGINE_GRAPHICS_COMMANDBUFFER_H
@@ -0,0 +1,43 @@
+#ifndef _LAME_CONSTANTBLOCKS_H
+#define _LAME_CONSTANTBLOCKS_H
+
+#include <cstdint>
+
+#include "../Core/Matrix4x4.h"
+
+namespace Lame
+{
+	//The constants every vertex shader shares are grouped into blocks that sit at the same place in every shader (see shaders.inc).
+	// Each block is uploaded in one call with Context::SetFrameConstants or Context::SetObjectConstants,
+	// and stays set when the effect changes, so it is only uploaded again when its values change.
+
+	//set once for each camera
+	struct FrameConstants
+	{
+		Matrix4x4 world_to_view;
+		Matrix4x4 view_to_screen;
+	};
+
+	//set once for each draw that isn't instanced
+	struct ObjectConstants
+	{
+		Matrix4x4 local_to_world;
+	};
+
+	//The vertex shader constant registers each block starts at
+	namespace ConstantRegister
+	{
+		const uint32_t Frame = 0;				//c0-c7
+		const uint32_t Object = 8;				//c8-c11
+		const uint32_t FirstFree = 12;			//everything from here on is left to materials
+	}
+
+	//The uniform buffer binding point each block is bound to on OpenGL, where the blocks are std140 uniform blocks
+	namespace ConstantBinding
+	{
+		const uint32_t Frame = 0;
+		const uint32_t Object = 1;
+	}
+}
+
+#endif //_LAME_CONSTANTBLOCKS_H
@@ -5,6 +5,7 @@
 #include <string>
 
 #include "../Core/Color.h"
+#include "../Core/CompressedVertex.h"
 
 #if EAE6320_PLATFORM_D3D
 #include <d3d9.h>
@@ -16,6 +17,8 @@
 namespace Lame
 {
 	class Rectangle2D;
+	struct FrameConstants;
+	struct ObjectConstants;
 
 	class Context
 	{
@@ -47,9 +50,22 @@ namespace Lame
 #endif
 		bool SetVertexFormat(
 #if EAE6320_PLATFORM_D3D
-			IDirect3DVertexDeclaration9 ** o_vertex_declaration			//d3d needs the vertex declaration
+			IDirect3DVertexDeclaration9 ** o_vertex_declaration,			//d3d needs the vertex declaration
 #endif
+			const bool i_instanced = false,									//adds the per-instance stream (see InstanceBuffer)
+			const VertexFormat i_format = VertexFormat::Full				//the layout of the vertex stream
 			);
+		//can the device read i_format's vertices directly, rather than needing them decompressed first
+		bool SupportsVertexFormat(const VertexFormat i_format) const;
+
+		//uploads the constant blocks shared by every shader (see ConstantBlocks.h), each with a single call
+		bool SetFrameConstants(const FrameConstants& i_constants);
+		bool SetObjectConstants(const ObjectConstants& i_constants);
+
+		//number of draw calls submitted since the last BeginFrame
+		inline size_t draw_call_count() const { return draw_call_count_; }
+		inline size_t primitive_count() const { return primitive_count_; }
+		inline void CountDrawCall(const size_t i_primitive_count = 0) { ++draw_call_count_; primitive_count_ += i_primitive_count; }
 
 		Rectangle2D GetPixelCoord(const Rectangle2D& i_virtual_screen_coord);
 		static Rectangle2D GetRealScreenCoord(const Rectangle2D& i_virtual_screen_coord);
@@ -64,6 +80,8 @@ namespace Lame
 
 		Color screen_clear_color;
 		HWND renderingWindow = nullptr;
+		size_t draw_call_count_ = 0;
+		size_t primitive_count_ = 0;
 
 #if EAE6320_PLATFORM_D3D
 		IDirect3D9* direct3dInterface = nullptr;
@@ -71,6 +89,8 @@ namespace Lame
 #elif EAE6320_PLATFORM_GL
 		HDC deviceContext = NULL;
 		HGLRC openGlRenderingContext = NULL;
+		GLuint frameConstantsBuffer = 0;		//the uniform buffers of the shared constant blocks
+		GLuint objectConstantsBuffer = 0;
 #endif
 	};
 }
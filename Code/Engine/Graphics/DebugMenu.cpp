@@ -6,33 +6,34 @@
 #include "../System/UserInput.h"
 #include "../System/Console.h"
 #include "Context.h"
+#include "Effect.h"
+#include "SpriteBatch.h"
 
 namespace Lame
 {
 	namespace Debug
 	{
-		void Widget::stream(std::stringstream& io_stream, const size_t i_width, const bool i_selected) const
+		void Widget::write(std::string& io_text, const size_t i_width, const bool i_selected) const
 		{
-			if (i_selected)
-				io_stream << " -> ";
-			else
-				io_stream << "    ";
-			io_stream << name << " ";
-			if (i_width > 0 && name.size() > 0)
-				io_stream << std::string(i_width - name.size() - 1, '-');
-			io_stream << std::endl << "    ";
+			io_text += i_selected ? " -> " : "    ";
+			io_text += name;
+			io_text += ' ';
+			if (i_width > name.size() && name.size() > 0)
+				io_text.append(i_width - name.size() - 1, '-');
+			io_text += "\n    ";
 		}
 
-		void Text::stream(std::stringstream& io_stream, const size_t i_width, const bool i_selected) const
+		void Text::write(std::string& io_text, const size_t i_width, const bool i_selected) const
 		{
-			Widget::stream(io_stream, i_width, i_selected);
-			io_stream << value << std::endl;
+			Widget::write(io_text, i_width, i_selected);
+			io_text += value;
+			io_text += '\n';
 		}
 
-		void Button::stream(std::stringstream& io_stream, const size_t i_width, const bool i_selected) const
+		void Button::write(std::string& io_text, const size_t i_width, const bool i_selected) const
 		{
-			Widget::stream(io_stream, i_width, i_selected);
-			io_stream << "( Press to activate ) " << std::endl;
+			Widget::write(io_text, i_width, i_selected);
+			io_text += "( Press to activate ) \n";
 		}
 
 		void Button::input(bool isPositive)
@@ -40,10 +41,10 @@ namespace Lame
 			callback();
 		}
 
-		void CheckBox::stream(std::stringstream& io_stream, const size_t i_width, const bool i_selected) const
+		void CheckBox::write(std::string& io_text, const size_t i_width, const bool i_selected) const
 		{
-			Widget::stream(io_stream, i_width, i_selected);
-			io_stream << '[' << (*value ? 'x' : ' ') << ']' << std::endl;
+			Widget::write(io_text, i_width, i_selected);
+			io_text += *value ? "[x]\n" : "[ ]\n";
 		}
 
 		void CheckBox::input(bool isPositive)
@@ -51,20 +52,20 @@ namespace Lame
 			*value = isPositive;
 		}
 
-		void Slider::stream(std::stringstream& io_stream, const size_t i_width, const bool i_selected) const
+		void Slider::write(std::string& io_text, const size_t i_width, const bool i_selected) const
 		{
-			Widget::stream(io_stream, i_width, i_selected);
-			io_stream << '[';
+			Widget::write(io_text, i_width, i_selected);
+			io_text += '[';
 			{
 				size_t max_positions = i_width - 2;
 				size_t current_position = static_cast<size_t>((*value - minimum) / (maximum - minimum) * max_positions);
 				if(current_position > 1)
-					io_stream << std::string(current_position - 1, '=');
-				io_stream << '|';
+					io_text.append(current_position - 1, '=');
+				io_text += '|';
 				if(max_positions > current_position && (max_positions - current_position) > 0)
-					io_stream << std::string(max_positions - current_position, ' ');
+					io_text.append(max_positions - current_position, ' ');
 			}
-			io_stream << ']' << std::endl;
+			io_text += "]\n";
 		}
 
 		void Slider::input(bool isPositive)
@@ -78,16 +79,15 @@ namespace Lame
 				*value = maximum;
 		}
 
-		Menu* Menu::Create(std::shared_ptr<Context> i_context)
+		Menu* Menu::Create(std::shared_ptr<SpriteBatch> i_sprite_batch)
 		{
-			if (!i_context)
+			if (!i_sprite_batch)
 				return nullptr;
 
-			std::shared_ptr<FontRenderer> fr(FontRenderer::Create(i_context, 
-				Vector2(0.01f, 0.03f), 
-				Font::Pitch::Monospace, 
-				Font::Type::Normal, 
-				"Consolas") );
+			std::shared_ptr<Effect> effect(Effect::Create(i_sprite_batch->get_context(), "data/sprite.effect.bin"));
+			if (!effect)
+				return nullptr;
+			std::shared_ptr<FontRenderer> fr(FontRenderer::Create(i_sprite_batch, effect, "data/debug/consolas.font.bin"));
 			if (!fr)
 				return nullptr;
 
@@ -149,16 +149,15 @@ namespace Lame
 			if (widgets.size() == 0 || !enabled_)
 				return true;
 
-			std::stringstream content;
+			content_.clear();
 			for (size_t x = 0; x < widgets.size(); x++)
 			{
-				widgets[x]->stream(content, width_, x == selected_widget_);
+				widgets[x]->write(content_, width_, x == selected_widget_);
 			}
-			font_renderer()->context()->get_direct3dDevice()->SetVertexShader(nullptr);
-			font_renderer()->context()->get_direct3dDevice()->SetPixelShader(nullptr);
 
+			//the text only gets laid out again when a widget changes
 			return font_renderer()->Render(
-				content.str().c_str(),
+				content_.c_str(),
 				Rectangle2D::CreateBLNormalized(),
 				Font::HorizontalAlignment::Left,
 				false,
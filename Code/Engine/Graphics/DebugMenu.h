@@ -2,7 +2,7 @@
 #define _LAME_DEBUGMENU_H
 
 #include <memory>
-#include <sstream>
+#include <string>
 #include <functional>
 #include <vector>
 
@@ -15,13 +15,15 @@
 namespace Lame
 {
 	class Context;
+	class SpriteBatch;
 
 	namespace Debug
 	{
 		struct Widget
 		{
 			std::string name;
-			virtual void stream(std::stringstream& io_stream, const size_t i_width, const bool i_selected) const;
+			//appends the widget's lines to io_text
+			virtual void write(std::string& io_text, const size_t i_width, const bool i_selected) const;
 			virtual void input(bool isPositive) = 0;
 			Widget(std::string i_name) : name(i_name) {}
 		};
@@ -29,7 +31,7 @@ namespace Lame
 		struct Text : Widget
 		{
 			char* value;
-			void stream(std::stringstream& io_stream, const size_t i_width, const bool i_selected) const override;
+			void write(std::string& io_text, const size_t i_width, const bool i_selected) const override;
 			void input(bool isPositive) override {}
 			Text(std::string i_name, char* i_val) :Widget(i_name), value(i_val) {}
 		};
@@ -37,7 +39,7 @@ namespace Lame
 		struct Button : Widget
 		{
 			std::function<void()> callback;
-			void stream(std::stringstream& io_stream, const size_t i_width, const bool i_selected) const override;
+			void write(std::string& io_text, const size_t i_width, const bool i_selected) const override;
 			void input(bool isPositive) override;
 			Button(std::string i_name, std::function<void()> i_callback) : Widget(i_name), callback(i_callback) {}
 		};
@@ -45,7 +47,7 @@ namespace Lame
 		struct CheckBox : Widget
 		{
 			bool* value;
-			void stream(std::stringstream& io_stream, const size_t i_width, const bool i_selected) const override;
+			void write(std::string& io_text, const size_t i_width, const bool i_selected) const override;
 			void input(bool isPositive) override;
 			CheckBox(std::string i_name, bool* i_val) : Widget(i_name), value(i_val) {}
 		};
@@ -55,7 +57,7 @@ namespace Lame
 			float* value;
 			float minimum;
 			float maximum;
-			void stream(std::stringstream& io_stream, const size_t i_width, const bool i_selected) const override;
+			void write(std::string& io_text, const size_t i_width, const bool i_selected) const override;
 			void input(bool isPositive) override;
 			Slider(std::string i_name, float* i_val, float i_min, float i_max) : Widget(i_name), value(i_val), minimum(i_min), maximum(i_max) { }
 		};
@@ -63,7 +65,8 @@ namespace Lame
 		class Menu
 		{
 		public:
-			static Menu* Create(std::shared_ptr<Context> i_context);
+			//the menu's text is queued in i_sprite_batch, and drawn when it is flushed
+			static Menu* Create(std::shared_ptr<SpriteBatch> i_sprite_batch);
 			~Menu();
 
 			void CreateSlider(const char* name, float* value, float min, float max);
@@ -89,6 +92,7 @@ namespace Lame
 			size_t width_;
 			std::vector<Widget*> widgets;
 			std::shared_ptr<FontRenderer> font_renderer_;
+			std::string content_;		//reused every frame, so its memory is only allocated once
 		};
 	}
 }
@@ -6,6 +6,7 @@
 #include "../Core/Vertex.h"
 #include "Effect.h"
 #include "Context.h"
+#include "ConstantBlocks.h"
 #include "RenderableMesh.h"
 #include "../Core/Matrix4x4.h"
 #include "../System/UserOutput.h"
@@ -14,20 +15,30 @@
 #include "../Core/EnumMask.h"
 #include "../Core/Mesh.h"
 
-namespace Lame
+#include <algorithm>
+
+namespace
 {
-	char const * const DebugRenderer::LocalToWorldUniformName = "local_to_world";
-	char const * const DebugRenderer::WorldToViewUniformName = "world_to_view";
-	char const * const DebugRenderer::ViewToScreenUniformName = "view_to_screen";
+	//the line buffer holds this many frames of lines, so it is only discarded every few frames
+	const size_t LineFramesBuffered = 3;
+	//the most shape instances written to the instance buffer for one draw
+	const size_t ShapeInstanceCapacity = 4096;
+
+	const uint32_t BoxShapeKey = 0;
+	const uint32_t SphereShapeKey = 1;
+	//cylinders are cached by the ratio of their radii, rounded to this many steps
+	const uint32_t CylinderRadiusSteps = 16;
+	const uint32_t FirstCylinderShapeKey = 2;
+}
 
+namespace Lame
+{
 	DebugRenderer* DebugRenderer::Create(std::shared_ptr<Lame::Context> i_context, const size_t i_line_count)
 	{
 		if (!i_context)
 			return nullptr;
 
 		std::shared_ptr<Lame::Effect> line_effect;
-		Effect::ConstantHandle line_worldToViewUniformId;
-		Effect::ConstantHandle line_viewToScreenUniformId;
 		{
 			const char * const vertex_shader = "data/debug/line_vertex.shader.bin";
 			const char * const fragment_shader = "data/debug/line_fragment.shader.bin";
@@ -38,9 +49,7 @@ namespace Lame
 			rendermask.set(Lame::RenderState::FaceCull, true);
 			rendermask.set(Lame::RenderState::Wireframe, true);
 			line_effect = std::shared_ptr<Lame::Effect>(Lame::Effect::Create(i_context, vertex_shader, fragment_shader, rendermask));
-			if (!line_effect ||
-				!line_effect->CacheConstant(Lame::Effect::Shader::Vertex, WorldToViewUniformName, line_worldToViewUniformId) ||
-				!line_effect->CacheConstant(Lame::Effect::Shader::Vertex, ViewToScreenUniformName, line_viewToScreenUniformId))
+			if (!line_effect)
 			{
 				Lame::UserOutput::Display("Failed to create debug line effect");
 				return nullptr;
@@ -48,23 +57,18 @@ namespace Lame
 		}
 
 		std::shared_ptr<Lame::Effect> wireframe_shape_effect;
-		Effect::ConstantHandle wire_localToWorldUniformId;
-		Effect::ConstantHandle wire_worldToViewUniformId;
-		Effect::ConstantHandle wire_viewToScreenUniformId;
 		{
 			const char * const vertex_shader = "data/debug/shape_vertex.shader.bin";
 			const char * const fragment_shader = "data/debug/shape_fragment.shader.bin";
+			const char * const instanced_vertex_shader = "data/instanced_vertex.shader.bin";
 			Lame::EnumMask<Lame::RenderState> rendermask;
 			rendermask.set(Lame::RenderState::Transparency, false);
 			rendermask.set(Lame::RenderState::DepthTest, true);
 			rendermask.set(Lame::RenderState::DepthWrite, true);
 			rendermask.set(Lame::RenderState::FaceCull, false);
 			rendermask.set(Lame::RenderState::Wireframe, true);
-			wireframe_shape_effect = std::shared_ptr<Lame::Effect>(Lame::Effect::Create(i_context, vertex_shader, fragment_shader, rendermask));
-			if (!wireframe_shape_effect ||
-				!wireframe_shape_effect->CacheConstant(Lame::Effect::Shader::Vertex, LocalToWorldUniformName, wire_localToWorldUniformId) ||
-				!wireframe_shape_effect->CacheConstant(Lame::Effect::Shader::Vertex, WorldToViewUniformName, wire_worldToViewUniformId) ||
-				!wireframe_shape_effect->CacheConstant(Lame::Effect::Shader::Vertex, ViewToScreenUniformName, wire_viewToScreenUniformId))
+			wireframe_shape_effect = std::shared_ptr<Lame::Effect>(Lame::Effect::Create(i_context, vertex_shader, fragment_shader, rendermask, instanced_vertex_shader));
+			if (!wireframe_shape_effect)
 			{
 				Lame::UserOutput::Display("Failed to create debug wireframe effect");
 				return nullptr;
@@ -72,57 +76,50 @@ namespace Lame
 		}
 
 		std::shared_ptr<Lame::Effect> fill_shape_effect;
-		Effect::ConstantHandle solid_localToWorldUniformId;
-		Effect::ConstantHandle solid_worldToViewUniformId;
-		Effect::ConstantHandle solid_viewToScreenUniformId;
 		{
 			const char * const vertex_shader = "data/debug/shape_vertex.shader.bin";
 			const char * const fragment_shader = "data/debug/shape_fragment.shader.bin";
+			const char * const instanced_vertex_shader = "data/instanced_vertex.shader.bin";
 			Lame::EnumMask<Lame::RenderState> rendermask;
 			rendermask.set(Lame::RenderState::Transparency, true);
 			rendermask.set(Lame::RenderState::DepthTest, true);
 			rendermask.set(Lame::RenderState::DepthWrite, true);
 			rendermask.set(Lame::RenderState::FaceCull, true);
 			rendermask.set(Lame::RenderState::Wireframe, false);
-			fill_shape_effect = std::shared_ptr<Lame::Effect>(Lame::Effect::Create(i_context, vertex_shader, fragment_shader, rendermask));
-			if (!fill_shape_effect ||
-				!fill_shape_effect->CacheConstant(Lame::Effect::Shader::Vertex, LocalToWorldUniformName, solid_localToWorldUniformId) ||
-				!fill_shape_effect->CacheConstant(Lame::Effect::Shader::Vertex, WorldToViewUniformName, solid_worldToViewUniformId) ||
-				!fill_shape_effect->CacheConstant(Lame::Effect::Shader::Vertex, ViewToScreenUniformName, solid_viewToScreenUniformId))
+			fill_shape_effect = std::shared_ptr<Lame::Effect>(Lame::Effect::Create(i_context, vertex_shader, fragment_shader, rendermask, instanced_vertex_shader));
+			if (!fill_shape_effect)
 			{
 				Lame::UserOutput::Display("Failed to create debug filled shape effect");
 				return nullptr;
 			}
 		}
 
-		std::shared_ptr<Lame::RenderableMesh> line_renderer(Lame::RenderableMesh::CreateEmpty(false, i_context, Lame::Mesh::PrimitiveType::LineList, i_line_count * 2, 0));
+		std::shared_ptr<Lame::RenderableMesh> line_renderer(Lame::RenderableMesh::CreateEmpty(false, i_context, Lame::Mesh::PrimitiveType::LineList, i_line_count * 2 * LineFramesBuffered, 0));
 		if (!line_renderer)
 		{
 			Lame::UserOutput::Display("Failed to create debug line mesh");
 			return nullptr;
 		}
 
+		std::shared_ptr<InstanceBuffer> shape_instances(InstanceBuffer::Create(i_context, ShapeInstanceCapacity));
+		if (!shape_instances)
+		{
+			Lame::UserOutput::Display("Failed to create debug shape instance buffer");
+			return nullptr;
+		}
+
 		DebugRenderer* deb = new DebugRenderer();
 		if (deb)
 		{
 			deb->line_effect = line_effect;
-			deb->line_worldToViewUniformId = line_worldToViewUniformId;
-			deb->line_viewToScreenUniformId = line_viewToScreenUniformId;
-
 			deb->solid_shape_effect = fill_shape_effect;
-			deb->wire_localToWorldUniformId = wire_localToWorldUniformId;
-			deb->wire_worldToViewUniformId = wire_worldToViewUniformId;
-			deb->wire_viewToScreenUniformId = wire_viewToScreenUniformId;
-
 			deb->wireframe_shape_effect = wireframe_shape_effect;
-			deb->solid_localToWorldUniformId = solid_localToWorldUniformId;
-			deb->solid_worldToViewUniformId = solid_worldToViewUniformId;
-			deb->solid_viewToScreenUniformId = solid_viewToScreenUniformId;
 
 			deb->context = i_context;
 			deb->line_renderer = line_renderer;
+			deb->shape_instances = shape_instances;
 			deb->max_lines_count = i_line_count;
-			deb->line_vertices.reserve(i_line_count);
+			deb->line_vertices.reserve(i_line_count * 2);
 			return deb;
 		}
 		else
@@ -139,7 +136,7 @@ namespace Lame
 
 	bool DebugRenderer::AddLine(const Lame::Vector3& i_start, const Lame::Vector3& i_end, const Lame::Color32& i_start_color, const Lame::Color32& i_end_color)
 	{
-		if (line_vertices.size() >= max_lines_count)
+		if (line_vertices.size() / 2 >= max_lines_count)
 			return false;
 
 		Lame::Vertex start;
@@ -154,78 +151,115 @@ namespace Lame
 		return true;
 	}
 
-	bool DebugRenderer::Render(const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen)
+	bool DebugRenderer::Render()
 	{
-		const bool lines_rendered = RenderLines(i_worldToView, i_viewToScreen);
-		const bool wireframe_meshes_rendered = RenderWireframeRenderableMeshes(i_worldToView, i_viewToScreen);
-		const bool solid_meshes_rendered = RenderSolidRenderableMeshes(i_worldToView, i_viewToScreen);
+		const bool lines_rendered = RenderLines();
+		const bool wireframe_meshes_rendered = RenderRenderableMeshes(wireframe_shape_effect, wireframe_meshes);
+		const bool solid_meshes_rendered = RenderRenderableMeshes(solid_shape_effect, solid_meshes);
+		const bool wireframe_shapes_rendered = RenderShapes(true);
+		const bool solid_shapes_rendered = RenderShapes(false);
 		line_vertices.clear();
 		wireframe_meshes.clear();
 		solid_meshes.clear();
-		return lines_rendered && wireframe_meshes_rendered && solid_meshes_rendered;
+		for (auto itr = shapes.begin(); itr != shapes.end(); ++itr)
+		{
+			itr->second.wireframe.clear();
+			itr->second.solid.clear();
+		}
+		return lines_rendered && wireframe_meshes_rendered && solid_meshes_rendered && wireframe_shapes_rendered && solid_shapes_rendered;
 	}
 
-	bool DebugRenderer::RenderLines(const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen)
+	bool DebugRenderer::RenderLines()
 	{
 		if (line_vertices.size() / 2 == 0)
 			return true;
 
-		const bool lines_rendered = !line_renderer->UpdateVertices(line_vertices.data(), line_vertices.size()) ||
-			!line_effect->Bind() ||
-			!line_effect->SetConstant(Effect::Shader::Vertex, line_worldToViewUniformId, i_worldToView) ||
-			!line_effect->SetConstant(Effect::Shader::Vertex, line_viewToScreenUniformId, i_viewToScreen) ||
-			!line_renderer->Draw(line_vertices.size() / 2);
-		return lines_rendered;
+		size_t firstVertex;
+		return line_renderer->StreamVertices(line_vertices.data(), line_vertices.size(), firstVertex) &&
+			line_effect->Bind() &&
+			line_renderer->DrawRange(firstVertex, line_vertices.size() / 2);
 	}
 
-	bool DebugRenderer::RenderSolidRenderableMeshes(const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen)
+	bool DebugRenderer::RenderRenderableMeshes(const std::shared_ptr<Effect>& i_effect, const std::vector<DebugRenderableMesh>& i_meshes)
 	{
-		if (solid_meshes.size() == 0)
+		if (i_meshes.size() == 0)
 			return true;
 
-		if (solid_shape_effect->Bind() &&
-			solid_shape_effect->SetConstant(Lame::Effect::Shader::Vertex, solid_worldToViewUniformId, i_worldToView) &&
-			solid_shape_effect->SetConstant(Lame::Effect::Shader::Vertex, solid_viewToScreenUniformId, i_viewToScreen))
-		{
-			bool success = true;
-			for (auto itr = solid_meshes.begin(); itr != solid_meshes.end(); ++itr)
-			{
-				success =
-					solid_shape_effect->SetConstant(Lame::Effect::Shader::Vertex, solid_localToWorldUniformId, itr->transform.LocalToWorld()) &&
-					itr->mesh->Draw() &&
-					success;
-			}
-			return success;
-		}
-		else
-		{
+		if (!i_effect->Bind())
 			return false;
+
+		bool success = true;
+		ObjectConstants object;
+		for (auto itr = i_meshes.begin(); itr != i_meshes.end(); ++itr)
+		{
+			object.local_to_world = itr->transform.LocalToWorld();
+			success =
+				context->SetObjectConstants(object) &&
+				itr->mesh->Draw() &&
+				success;
 		}
+		return success;
 	}
 
-	bool DebugRenderer::RenderWireframeRenderableMeshes(const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen)
+	bool DebugRenderer::RenderShapes(const bool i_wireframe)
 	{
-		if (wireframe_meshes.size() == 0)
-			return true;
+		std::shared_ptr<Effect> effect = i_wireframe ? wireframe_shape_effect : solid_shape_effect;
 
-		if (wireframe_shape_effect->Bind() &&
-			wireframe_shape_effect->SetConstant(Lame::Effect::Shader::Vertex, wire_worldToViewUniformId, i_worldToView) &&
-			wireframe_shape_effect->SetConstant(Lame::Effect::Shader::Vertex, wire_viewToScreenUniformId, i_viewToScreen))
+		bool success = true, bound = false;
+		for (auto itr = shapes.begin(); itr != shapes.end(); ++itr)
 		{
-			bool success = true;
-			for (auto itr = wireframe_meshes.begin(); itr != wireframe_meshes.end(); ++itr)
+			const std::vector<Instance>& instances = i_wireframe ? itr->second.wireframe : itr->second.solid;
+			if (instances.empty())
+				continue;
+
+			if (!bound)
+			{
+				bound = effect->Bind(true);
+				if (!bound)
+					return false;
+			}
+
+			//one draw for every copy of the shape, split when there are more than the instance buffer holds
+			for (size_t start = 0; start < instances.size(); start += shape_instances->capacity())
 			{
-				success =
-					wireframe_shape_effect->SetConstant(Lame::Effect::Shader::Vertex, wire_localToWorldUniformId, itr->transform.LocalToWorld()) &&
-					itr->mesh->Draw() &&
+				const size_t count = std::min(instances.size() - start, shape_instances->capacity());
+				size_t firstInstance;
+				success = shape_instances->Write(instances.data() + start, count, firstInstance) &&
+					itr->second.mesh->DrawInstanced(*shape_instances, firstInstance, count) &&
 					success;
 			}
-			return success;
 		}
-		else
-		{
+		return success;
+	}
+
+	DebugRenderer::ShapeInstances* DebugRenderer::GetShape(const uint32_t i_key, const std::function<void(Mesh&)>& i_tessellate)
+	{
+		auto itr = shapes.find(i_key);
+		if (itr != shapes.end())
+			return &itr->second;
+
+		Mesh mesh;
+		i_tessellate(mesh);
+		ShapeInstances shape;
+		shape.mesh = std::shared_ptr<Lame::RenderableMesh>(Lame::RenderableMesh::Create(true, context, mesh));
+		if (!shape.mesh)
+			return nullptr;
+		return &(shapes[i_key] = shape);
+	}
+
+	bool DebugRenderer::AddShape(ShapeInstances* i_shape, const Lame::Matrix4x4& i_local_to_world, const Color32& i_color, const bool i_render_wireframe)
+	{
+		if (!i_shape)
 			return false;
-		}
+
+		Instance instance;
+		instance.local_to_world = i_local_to_world;
+		instance.color = i_color;
+		if (i_render_wireframe)
+			i_shape->wireframe.push_back(instance);
+		else
+			i_shape->solid.push_back(instance);
+		return true;
 	}
 
 	bool DebugRenderer::AddMesh(const Mesh& i_mesh, const Lame::Transform& i_transform, const bool i_render_as_wireframe)
@@ -245,23 +279,30 @@ namespace Lame
 
 	bool DebugRenderer::AddBox(const bool i_render_wireframe, const Lame::Vector3& i_size, const Lame::Transform& i_transform, const Color32& i_color)
 	{
-		Mesh mesh;
-		mesh.SetBox(i_size, i_color);
-		return AddMesh(mesh, i_transform, i_render_wireframe);
+		ShapeInstances* shape = GetShape(BoxShapeKey, [](Mesh& o_mesh) { o_mesh.SetBox(Vector3::one); });
+		return AddShape(shape, i_transform.LocalToWorld() * Matrix4x4::CreateScale(i_size), i_color, i_render_wireframe);
 	}
 
 	bool DebugRenderer::AddSphere(const bool i_render_wireframe, const float i_radius, const Lame::Transform& i_transform, const Color32& i_color)
 	{
-		Mesh mesh; 
-		mesh.SetSphere(i_radius, 10, 10, i_color);
-		return AddMesh(mesh, i_transform, i_render_wireframe);
+		ShapeInstances* shape = GetShape(SphereShapeKey, [](Mesh& o_mesh) { o_mesh.SetSphere(1.0f, 10, 10); });
+		return AddShape(shape, i_transform.LocalToWorld() * Matrix4x4::CreateScale(i_radius, i_radius, i_radius), i_color, i_render_wireframe);
 	}
 
 	bool DebugRenderer::AddCylinder(const bool i_render_wireframe, const float i_top_radius, const float i_bottom_radius, const float i_height, const Lame::Transform& i_transform, const Color32& i_color)
 	{
-		Mesh mesh;
-		mesh.SetCylinder(i_bottom_radius, i_top_radius, i_height, 10, 10, i_color);
-		return AddMesh(mesh, i_transform, i_render_wireframe);
+		const float radius = std::max(i_top_radius, i_bottom_radius);
+		if (radius <= 0.0f)
+			return false;
+
+		//the wider end has a radius of 1, so only the ratio of the radii picks the unit shape
+		const uint32_t top = static_cast<uint32_t>(std::max(i_top_radius, 0.0f) / radius * CylinderRadiusSteps + 0.5f);
+		const uint32_t bottom = static_cast<uint32_t>(std::max(i_bottom_radius, 0.0f) / radius * CylinderRadiusSteps + 0.5f);
+		const uint32_t key = FirstCylinderShapeKey + top * (CylinderRadiusSteps + 1) + bottom;
+		ShapeInstances* shape = GetShape(key, [top, bottom](Mesh& o_mesh) {
+			o_mesh.SetCylinder(static_cast<float>(bottom) / CylinderRadiusSteps, static_cast<float>(top) / CylinderRadiusSteps, 1.0f, 10, 10);
+		});
+		return AddShape(shape, i_transform.LocalToWorld() * Matrix4x4::CreateScale(radius, i_height, radius), i_color, i_render_wireframe);
 	}
 }
 
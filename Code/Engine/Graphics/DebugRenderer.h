@@ -10,9 +10,12 @@
 #include <vector>
 #include <cstdint>
 #include <memory>
+#include <functional>
+#include <unordered_map>
 
 #include "Effect.h"
 #include "Context.h"
+#include "InstanceBuffer.h"
 #include "../Core/Vertex.h"
 #include "../Component/Transform.h"
 
@@ -32,6 +35,13 @@ namespace Lame
 			Lame::Transform transform;
 			std::shared_ptr<Lame::RenderableMesh> mesh;
 		};
+		//every box, sphere and cylinder is an instance of a unit shape that is only tessellated once
+		struct ShapeInstances
+		{
+			std::shared_ptr<Lame::RenderableMesh> mesh;
+			std::vector<Instance> wireframe;
+			std::vector<Instance> solid;
+		};
 	public:
 		static DebugRenderer* Create(std::shared_ptr<Lame::Context> i_context, const size_t i_line_count);
 
@@ -44,7 +54,8 @@ namespace Lame
 		bool AddSphere(const bool i_render_wireframe, const float i_radius, const Lame::Transform& i_transform, const Color32& i_color = Color32::white);
 		bool AddCylinder(const bool i_render_wireframe, const float i_top_radius, const float i_bottom_radius, const float i_height, const Lame::Transform& i_transform, const Color32& i_color = Color32::white);
 
-		bool Render(const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen);
+		//draws everything added since the last Render, with the frame constants that are already set
+		bool Render();
 
 		std::shared_ptr<Lame::Effect> get_line_effect() const { return line_effect; }
 		std::shared_ptr<Lame::Effect> get_solid_shape_effect() const { return solid_shape_effect; }
@@ -56,9 +67,13 @@ namespace Lame
 		DebugRenderer(const DebugRenderer &i_other);
 		DebugRenderer& operator=(const DebugRenderer &i_other);
 
-		bool RenderLines(const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen);
-		bool RenderSolidRenderableMeshes(const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen);
-		bool RenderWireframeRenderableMeshes(const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen);
+		bool RenderLines();
+		bool RenderRenderableMeshes(const std::shared_ptr<Effect>& i_effect, const std::vector<DebugRenderableMesh>& i_meshes);
+		bool RenderShapes(const bool i_wireframe);
+
+		//finds the unit shape with the key, tessellating it the first time it is used
+		ShapeInstances* GetShape(const uint32_t i_key, const std::function<void(Mesh&)>& i_tessellate);
+		bool AddShape(ShapeInstances* i_shape, const Lame::Matrix4x4& i_local_to_world, const Color32& i_color, const bool i_render_wireframe);
 
 		std::shared_ptr<Effect> line_effect;
 		std::shared_ptr<Effect> solid_shape_effect;
@@ -74,20 +89,8 @@ namespace Lame
 		std::vector<DebugRenderableMesh> wireframe_meshes;
 		std::vector<DebugRenderableMesh> solid_meshes;
 
-		Effect::ConstantHandle line_worldToViewUniformId;
-		Effect::ConstantHandle line_viewToScreenUniformId;
-
-		Effect::ConstantHandle wire_localToWorldUniformId;
-		Effect::ConstantHandle wire_worldToViewUniformId;
-		Effect::ConstantHandle wire_viewToScreenUniformId;
-
-		Effect::ConstantHandle solid_localToWorldUniformId;
-		Effect::ConstantHandle solid_worldToViewUniformId;
-		Effect::ConstantHandle solid_viewToScreenUniformId;
-
-		static char const * const LocalToWorldUniformName;
-		static char const * const WorldToViewUniformName;
-		static char const * const ViewToScreenUniformName;
+		std::unordered_map<uint32_t, ShapeInstances> shapes;
+		std::shared_ptr<InstanceBuffer> shape_instances;
 	};
 }
 
@@ -2,9 +2,12 @@
 #include "../Context.h"
 
 #include <cassert>
+#include <iterator>
+#include <vector>
 #include <d3dx9shader.h>
 #include <d3d9types.h>
 
+#include "../ConstantBlocks.h"
 #include "../../System/UserOutput.h"
 #include "../../Core/Rectangle2D.h"
 
@@ -87,6 +90,8 @@ namespace Lame
 
 	bool Context::BeginFrame()
 	{
+		draw_call_count_ = 0;
+		primitive_count_ = 0;
 		return SUCCEEDED(direct3dDevice->BeginScene());
 	}
 
@@ -121,7 +126,30 @@ namespace Lame
 		return result;
 	}
 
-	bool Context::SetVertexFormat(IDirect3DVertexDeclaration9 ** o_vertex_declaration)
+	bool Context::SupportsVertexFormat(const VertexFormat i_format) const
+	{
+		if (i_format == VertexFormat::Full)
+			return true;
+
+		//the compressed format's half float texture coordinates are the only part that isn't always supported
+		D3DCAPS9 caps;
+		return SUCCEEDED(direct3dDevice->GetDeviceCaps(&caps)) && (caps.DeclTypes & D3DDTCAPS_FLOAT16_2) != 0;
+	}
+
+	//each matrix row fills one register, the same as ID3DXConstantTable::SetMatrixTranspose, since the shaders use column major float4x4s
+	bool Context::SetFrameConstants(const FrameConstants& i_constants)
+	{
+		return SUCCEEDED(direct3dDevice->SetVertexShaderConstantF(ConstantRegister::Frame,
+			reinterpret_cast<const float*>(&i_constants), sizeof(i_constants) / (sizeof(float) * 4)));
+	}
+
+	bool Context::SetObjectConstants(const ObjectConstants& i_constants)
+	{
+		return SUCCEEDED(direct3dDevice->SetVertexShaderConstantF(ConstantRegister::Object,
+			reinterpret_cast<const float*>(&i_constants), sizeof(i_constants) / (sizeof(float) * 4)));
+	}
+
+	bool Context::SetVertexFormat(IDirect3DVertexDeclaration9 ** o_vertex_declaration, const bool i_instanced, const VertexFormat i_format)
 	{
 		// These elements must match the Vertex layout exactly.
 		// They instruct Direct3D how to match the binary data in the vertex buffer
@@ -129,7 +157,7 @@ namespace Lame
 		// (by using D3DDECLUSAGE enums here and semantics in the shader,
 		// so that, for example, D3DDECLUSAGE_POSITION here matches with POSITION in shader code).
 		// Note that OpenGL uses arbitrarily assignable number IDs to do the same thing.
-		D3DVERTEXELEMENT9 vertexElements[] =
+		const D3DVERTEXELEMENT9 vertexElements[] =
 		{
 			// Stream 0
 
@@ -141,11 +169,54 @@ namespace Lame
 
 			// COLOR0,  D3DCOLOR == 4 bytes, Offset = 20
 			{ 0, 20, D3DDECLTYPE_D3DCOLOR, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_COLOR, 0 },
+		};
+
+		// These elements must match the CompressedVertex layout.  The shader sees the quantized positions,
+		// RenderableMesh folds their decoding into local_to_world.
+		const D3DVERTEXELEMENT9 compressedVertexElements[] =
+		{
+			// Stream 0
+
+			// POSITION, 4 shorts == 8 bytes, Offset = 0
+			{ 0, 0, D3DDECLTYPE_SHORT4, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_POSITION, 0 },
+
+			// TEXCOORD0, 2 half floats == 4 bytes, Offset = 8
+			{ 0, 8, D3DDECLTYPE_FLOAT16_2, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 0 },
 
-			// The following marker signals the end of the vertex declaration
-			D3DDECL_END()
+			// NORMAL0, the octahedral normal and tangent, D3DCOLOR == 4 bytes, Offset = 12
+			{ 0, 12, D3DDECLTYPE_D3DCOLOR, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_NORMAL, 0 },
+
+			// COLOR0,  D3DCOLOR == 4 bytes, Offset = 16
+			{ 0, 16, D3DDECLTYPE_D3DCOLOR, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_COLOR, 0 },
 		};
-		HRESULT result = get_direct3dDevice()->CreateVertexDeclaration(vertexElements, o_vertex_declaration);
+
+		// The instanced format adds a second stream with one Instance per drawn copy of the mesh
+		const D3DVERTEXELEMENT9 instanceElements[] =
+		{
+			// Stream 1
+
+			// TEXCOORD1-4, the rows of local_to_world, 4 floats == 16 bytes each, Offset = 0, 16, 32, 48
+			{ 1, 0, D3DDECLTYPE_FLOAT4, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 1 },
+			{ 1, 16, D3DDECLTYPE_FLOAT4, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 2 },
+			{ 1, 32, D3DDECLTYPE_FLOAT4, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 3 },
+			{ 1, 48, D3DDECLTYPE_FLOAT4, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_TEXCOORD, 4 },
+
+			// COLOR1, the instance's tint, D3DCOLOR == 4 bytes, Offset = 64
+			{ 1, 64, D3DDECLTYPE_D3DCOLOR, D3DDECLMETHOD_DEFAULT, D3DDECLUSAGE_COLOR, 1 },
+		};
+
+		std::vector<D3DVERTEXELEMENT9> elements;
+		if (i_format == VertexFormat::Compressed)
+			elements.assign(std::begin(compressedVertexElements), std::end(compressedVertexElements));
+		else
+			elements.assign(std::begin(vertexElements), std::end(vertexElements));
+		if (i_instanced)
+			elements.insert(elements.end(), std::begin(instanceElements), std::end(instanceElements));
+		// The following marker signals the end of the vertex declaration
+		const D3DVERTEXELEMENT9 end = D3DDECL_END();
+		elements.push_back(end);
+
+		HRESULT result = get_direct3dDevice()->CreateVertexDeclaration(elements.data(), o_vertex_declaration);
 		if (SUCCEEDED(result))
 		{
 			result = get_direct3dDevice()->SetVertexDeclaration(*o_vertex_declaration);
@@ -6,15 +6,18 @@
 
 #include <d3dx9shader.h>
 
+#include <array>
 #include <cassert>
 #include <cstdint>
 #include <cstdlib>
+#include <map>
 #include <string>
 #include <sstream>
 #include "../../System/FileLoader.h"
 
 #include "../Texture.h"
 #include "../Context.h"
+#include "../ConstantBlocks.h"
 #include "../../System/UserOutput.h"
 
 namespace
@@ -25,7 +28,7 @@ namespace
 
 namespace Lame
 {
-	Effect* Effect::Create(std::shared_ptr<Context> i_context, const char* i_vertex_path, const char* i_fragment_path, Lame::EnumMask<RenderState> i_renderMask)
+	Effect* Effect::Create(std::shared_ptr<Context> i_context, const char* i_vertex_path, const char* i_fragment_path, Lame::EnumMask<RenderState> i_renderMask, const char* i_instanced_vertex_path)
 	{
 		IDirect3DVertexShader9* vertexShader = nullptr;
 		ID3DXConstantTable *vertexConstantTable = nullptr;
@@ -33,8 +36,12 @@ namespace Lame
 		IDirect3DPixelShader9* fragmentShader = nullptr;
 		ID3DXConstantTable *fragmentConstantTable = nullptr;
 
+		IDirect3DVertexShader9* instancedVertexShader = nullptr;
+		ID3DXConstantTable *instancedVertexConstantTable = nullptr;
+
 		if (!LoadFragmentShader(i_context.get(), i_fragment_path, fragmentShader, fragmentConstantTable) || 
-			!LoadVertexShader(i_context.get(), i_vertex_path, vertexShader, vertexConstantTable))
+			!LoadVertexShader(i_context.get(), i_vertex_path, vertexShader, vertexConstantTable) ||
+			(i_instanced_vertex_path && !LoadVertexShader(i_context.get(), i_instanced_vertex_path, instancedVertexShader, instancedVertexConstantTable)))
 			return nullptr;
 
 		Effect *effect = new Effect(i_context, i_renderMask);
@@ -44,6 +51,8 @@ namespace Lame
 			effect->fragmentShader = fragmentShader;
 			effect->vertexConstantTable = vertexConstantTable;
 			effect->fragmentConstantTable = fragmentConstantTable;
+			effect->instancedVertexShader = instancedVertexShader;
+			effect->instancedVertexConstantTable = instancedVertexConstantTable;
 		}
 		else
 		{
@@ -52,7 +61,7 @@ namespace Lame
 		return effect;
 	}
 
-	bool Effect::Bind()
+	bool Effect::Bind(const bool i_instanced)
 	{
 		if (!context)
 		{
@@ -64,7 +73,7 @@ namespace Lame
 		HRESULT result;
 
 		// Set the vertex and fragment shaders
-		result = context->get_direct3dDevice()->SetVertexShader(vertexShader);
+		result = context->get_direct3dDevice()->SetVertexShader(i_instanced && instancedVertexShader ? instancedVertexShader : vertexShader);
 		success = success && SUCCEEDED(result);
 		result = context->get_direct3dDevice()->SetPixelShader(fragmentShader);
 		success = success && SUCCEEDED(result);
@@ -134,6 +143,11 @@ namespace Lame
 			fragmentConstantTable->Release();
 			fragmentConstantTable = nullptr;
 		}
+		if (instancedVertexConstantTable)
+		{
+			instancedVertexConstantTable->Release();
+			instancedVertexConstantTable = nullptr;
+		}
 
 		if (vertexShader)
 		{
@@ -145,12 +159,19 @@ namespace Lame
 			fragmentShader->Release();
 			fragmentShader = nullptr;
 		}
+		if (instancedVertexShader)
+		{
+			instancedVertexShader->Release();
+			instancedVertexShader = nullptr;
+		}
 	}
 
-	bool Effect::CacheConstant(const Shader &i_shader, const std::string &i_constant, ConstantHandle &o_constantId)
+	bool Effect::CacheConstant(const Shader &i_shader, const char *i_constant, ConstantHandle &o_constantId)
 	{
 		ID3DXConstantTable *constantTable = get_constant_table(i_shader);
-		D3DXHANDLE handle = constantTable->GetConstantByName(nullptr, i_constant.c_str());
+		if (!constantTable)
+			return false;
+		D3DXHANDLE handle = constantTable->GetConstantByName(nullptr, i_constant);
 		if (handle != nullptr)
 		{
 			o_constantId = std::make_tuple(handle, static_cast<DWORD>(constantTable->GetSamplerIndex(handle)));
@@ -192,6 +213,66 @@ namespace Lame
 		}
 		return true;
 	}
+
+	bool Effect::AddToConstantBlock(const ConstantHandle &i_constant, const float *i_val, const size_t i_val_count, ConstantBlock &io_block)
+	{
+		ID3DXConstantTable *constantTable = get_constant_table(io_block.shader);
+		if (!constantTable || !i_val || i_val_count == 0 || i_val_count > 4)
+			return false;
+
+		//only single scalars and vectors are packed, which always fill one register.
+		// Vertex constants also have to stay clear of the registers shared by every shader.
+		D3DXCONSTANT_DESC description;
+		UINT descriptionCount = 1;
+		if (FAILED(constantTable->GetConstantDesc(std::get<0>(i_constant), &description, &descriptionCount)) ||
+			description.RegisterSet != D3DXRS_FLOAT4 || description.Elements != 1 || description.Rows != 1 ||
+			(io_block.shader != Shader::Fragment && description.RegisterIndex < ConstantRegister::FirstFree))
+			return false;
+
+		std::map<uint32_t, std::array<float, 4>> registers;
+		const float *values = io_block.values.data();
+		for (size_t x = 0; x < io_block.runs.size(); x++)
+		{
+			for (uint32_t r = 0; r < io_block.runs[x].register_count; r++, values += 4)
+				std::copy(values, values + 4, registers[io_block.runs[x].first_register + r].begin());
+		}
+		std::array<float, 4>& added = registers[description.RegisterIndex];
+		added.fill(0.0f);
+		std::copy(i_val, i_val + i_val_count, added.begin());
+
+		io_block.runs.clear();
+		io_block.values.clear();
+		for (auto itr = registers.begin(); itr != registers.end(); ++itr)
+		{
+			if (io_block.runs.empty() || io_block.runs.back().first_register + io_block.runs.back().register_count != itr->first)
+			{
+				ConstantBlock::Run run;
+				run.first_register = itr->first;
+				run.register_count = 0;
+				io_block.runs.push_back(run);
+			}
+			io_block.runs.back().register_count++;
+			io_block.values.insert(io_block.values.end(), itr->second.begin(), itr->second.end());
+		}
+		return true;
+	}
+
+	bool Effect::SetConstantBlock(const ConstantBlock &i_block)
+	{
+		IDirect3DDevice9 *device = context->get_direct3dDevice();
+		bool success = true;
+		const float *values = i_block.values.data();
+		for (size_t x = 0; x < i_block.runs.size(); x++)
+		{
+			const ConstantBlock::Run& run = i_block.runs[x];
+			const HRESULT result = i_block.shader == Shader::Fragment ?
+				device->SetPixelShaderConstantF(run.first_register, values, run.register_count) :
+				device->SetVertexShaderConstantF(run.first_register, values, run.register_count);
+			success = SUCCEEDED(result) && success;
+			values += run.register_count * 4;
+		}
+		return success;
+	}
 }
 
 namespace
@@ -0,0 +1,97 @@
+
+#include "../InstanceBuffer.h"
+
+#include <cstring>
+#include <d3d9.h>
+
+#include "../Context.h"
+#include "../../System/UserOutput.h"
+
+namespace Lame
+{
+	InstanceBuffer::InstanceBuffer(std::shared_ptr<Context> i_context, const size_t i_capacity) :
+		context(i_context),
+		capacity_(i_capacity),
+		write_position_(0),
+		vertex_buffer_(nullptr)
+	{
+	}
+
+	InstanceBuffer::~InstanceBuffer()
+	{
+		if (vertex_buffer_)
+		{
+			vertex_buffer_->Release();
+			vertex_buffer_ = nullptr;
+		}
+	}
+
+	InstanceBuffer* InstanceBuffer::Create(std::shared_ptr<Context> i_context, const size_t i_capacity)
+	{
+		if (!i_context || i_capacity == 0)
+			return nullptr;
+
+		InstanceBuffer *buffer = new InstanceBuffer(i_context, i_capacity);
+		if (!buffer)
+		{
+			Lame::UserOutput::Display("Failed to create InstanceBuffer, due to insufficient memory.", "InstanceBuffer Loading Error");
+			return nullptr;
+		}
+
+		DWORD usage = 0;
+		if (FAILED(i_context->GetVertexProcessingUsage(usage)))
+		{
+			Lame::UserOutput::Display("Unable to get vertex processing usage information");
+			delete buffer;
+			return nullptr;
+		}
+		usage |= D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY;
+
+		const UINT bufferSize = static_cast<UINT>(i_capacity * sizeof(Instance));
+		const HRESULT result = i_context->get_direct3dDevice()->CreateVertexBuffer(
+			bufferSize, usage, 0, D3DPOOL_DEFAULT, &buffer->vertex_buffer_, nullptr);
+		if (FAILED(result))
+		{
+			Lame::UserOutput::Display("Direct3D failed to create an instance buffer");
+			delete buffer;
+			return nullptr;
+		}
+		return buffer;
+	}
+
+	bool InstanceBuffer::Write(const Instance* i_instances, const size_t i_count, size_t& o_first_instance)
+	{
+		if (!i_instances || i_count == 0 || i_count > capacity_)
+			return false;
+
+		//append behind the data already in flight, and only discard the buffer once it has wrapped
+		DWORD lockFlags = D3DLOCK_NOOVERWRITE;
+		if (write_position_ + i_count > capacity_)
+		{
+			write_position_ = 0;
+			lockFlags = D3DLOCK_DISCARD;
+		}
+
+		const UINT offset = static_cast<UINT>(write_position_ * sizeof(Instance));
+		const UINT size = static_cast<UINT>(i_count * sizeof(Instance));
+		void *instanceData;
+		if (FAILED(vertex_buffer_->Lock(offset, size, &instanceData, lockFlags)))
+			return false;
+		memcpy(instanceData, i_instances, size);
+		if (FAILED(vertex_buffer_->Unlock()))
+			return false;
+
+		o_first_instance = write_position_;
+		write_position_ += i_count;
+		return true;
+	}
+
+	bool InstanceBuffer::Bind(const size_t i_first_instance) const
+	{
+		//stream 1 is the per-instance stream of the instanced vertex format
+		const unsigned int streamIndex = 1;
+		const unsigned int bufferOffset = static_cast<unsigned int>(i_first_instance * sizeof(Instance));
+		const unsigned int bufferStride = sizeof(Instance);
+		return SUCCEEDED(context->get_direct3dDevice()->SetStreamSource(streamIndex, vertex_buffer_, bufferOffset, bufferStride));
+	}
+}
@@ -8,7 +8,9 @@
 #include <iterator>
 
 #include "../Context.h"
+#include "../InstanceBuffer.h"
 #include "../../Core/Vertex.h"
+#include "../../Core/Frustum.h"
 #include "../Graphics.h"
 #include "../../System/UserOutput.h"
 #include "../../System/Console.h"
@@ -34,11 +36,16 @@ namespace Lame
 	RenderableMesh::RenderableMesh(size_t i_vertex_count, size_t i_index_count, Mesh::PrimitiveType i_prim_type, std::shared_ptr<Context> i_context) :
 		vertex_count_(i_vertex_count),
 		index_count_(i_index_count),
+		index_size_(sizeof(uint32_t)),
+		stream_position_(0),
 		context(i_context),
 		primitive_type_(i_prim_type),
+		vertex_format_(VertexFormat::Full),
+		position_decode_(Matrix4x4::identity),
 		vertex_buffer_(nullptr),
 		index_buffer_(nullptr),
-		vertex_declaration_(nullptr)
+		vertex_declaration_(nullptr),
+		instanced_vertex_declaration_(nullptr)
 	{
 	}
 
@@ -59,16 +66,30 @@ namespace Lame
 			vertex_declaration_->Release();
 			vertex_declaration_ = nullptr;
 		}
+		if (instanced_vertex_declaration_)
+		{
+			instanced_vertex_declaration_->Release();
+			instanced_vertex_declaration_ = nullptr;
+		}
 	}
 
-	RenderableMesh* RenderableMesh::CreateEmpty(const bool i_static, std::shared_ptr<Context> i_context, Mesh::PrimitiveType i_prim_type, const size_t i_vertex_count, const size_t i_index_count)
+	RenderableMesh* RenderableMesh::CreateEmpty(const bool i_static, std::shared_ptr<Context> i_context, Mesh::PrimitiveType i_prim_type, const size_t i_vertex_count, const size_t i_index_count,
+		const VertexFormat i_format, const size_t i_index_size)
 	{
+		if (i_index_size != sizeof(uint16_t) && i_index_size != sizeof(uint32_t))
+		{
+			Lame::UserOutput::Display("Index buffers can only hold 16 or 32 bit indices", "RenderableMesh Loading Error");
+			return nullptr;
+		}
+
 		RenderableMesh *mesh = new RenderableMesh(i_vertex_count, i_index_count, i_prim_type, i_context);
 		if (!mesh)
 		{
 			Lame::UserOutput::Display("Failed to create RenderableMesh, due to insufficient memory.", "RenderableMesh Loading Error");
 			return nullptr;
 		}
+		mesh->vertex_format_ = i_format;
+		mesh->index_size_ = i_index_size;
 
 		// The usage tells Direct3D how this vertex buffer will be used
 		DWORD usage = 0;
@@ -86,15 +107,16 @@ namespace Lame
 
 		//Create the Vertex Buffer
 		{
-			// Initialize the vertex format
-			if (!i_context->SetVertexFormat(&mesh->vertex_declaration_))
+			// Initialize the vertex formats (the regular one last, so it is the one left bound)
+			if (!i_context->SetVertexFormat(&mesh->instanced_vertex_declaration_, true, i_format) ||
+				!i_context->SetVertexFormat(&mesh->vertex_declaration_, false, i_format))
 			{
 				delete mesh;
 				return nullptr;
 			}
 
 			// Create a vertex buffer
-			const UINT bufferSize = static_cast<UINT>(i_vertex_count * sizeof(Vertex));
+			const UINT bufferSize = static_cast<UINT>(i_vertex_count * mesh->vertex_size());
 			const HRESULT result = i_context->get_direct3dDevice()->CreateVertexBuffer(
 				bufferSize, usage, 0, D3DPOOL_DEFAULT, &mesh->vertex_buffer_, nullptr);
 			if (FAILED(result))
@@ -108,9 +130,10 @@ namespace Lame
 		//Create the Index Buffer
 		if (i_index_count > 0)
 		{
-			UINT bufferSize = static_cast<UINT>(i_index_count * sizeof(uint32_t));
+			UINT bufferSize = static_cast<UINT>(i_index_count * i_index_size);
+			const D3DFORMAT format = i_index_size == sizeof(uint16_t) ? D3DFMT_INDEX16 : D3DFMT_INDEX32;
 			const HRESULT result = i_context->get_direct3dDevice()->CreateIndexBuffer(
-				bufferSize, usage, D3DFMT_INDEX32, D3DPOOL_DEFAULT, &mesh->index_buffer_, nullptr);
+				bufferSize, usage, format, D3DPOOL_DEFAULT, &mesh->index_buffer_, nullptr);
 			if (FAILED(result))
 			{
 				Lame::UserOutput::Display("Direct3D failed to create an index buffer");
@@ -168,11 +191,14 @@ namespace Lame
 			delete mesh;
 			return nullptr;
 		}
+		mesh->bounds(Bounds::Create(i_vertices, i_vertex_count));
 		return mesh;
 	}
 
 	bool RenderableMesh::UpdateVertices(const Vertex* i_vertices, const size_t i_amount)
 	{
+		if (vertex_format_ != VertexFormat::Full)
+			return false;
 		Vertex *vertexData;
 		HRESULT result = vertex_buffer_->Lock(0, 0, reinterpret_cast<void**>(&vertexData), 0);
 		if (FAILED(result))
@@ -183,9 +209,49 @@ namespace Lame
 		return SUCCEEDED(vertex_buffer_->Unlock());
 	}
 
+	bool RenderableMesh::UpdateVertices(const CompressedVertex* i_vertices, const size_t i_amount)
+	{
+		if (vertex_format_ != VertexFormat::Compressed)
+			return false;
+		CompressedVertex *vertexData;
+		HRESULT result = vertex_buffer_->Lock(0, 0, reinterpret_cast<void**>(&vertexData), 0);
+		if (FAILED(result))
+			return false;
+
+		const size_t vertsToCopy = i_amount == 0 ? vertex_count_ : i_amount;
+		memcpy(vertexData, i_vertices, vertsToCopy * sizeof(*i_vertices));
+		return SUCCEEDED(vertex_buffer_->Unlock());
+	}
+
+	bool RenderableMesh::StreamVertices(const Vertex* i_vertices, const size_t i_count, size_t& o_first_vertex)
+	{
+		if (!i_vertices || i_count == 0 || i_count > vertex_count_ || vertex_format_ != VertexFormat::Full)
+			return false;
+
+		DWORD lockFlags = D3DLOCK_NOOVERWRITE;
+		if (stream_position_ + i_count > vertex_count_)
+		{
+			stream_position_ = 0;
+			lockFlags = D3DLOCK_DISCARD;
+		}
+
+		Vertex *vertexData;
+		const UINT offset = static_cast<UINT>(stream_position_ * sizeof(Vertex));
+		const UINT size = static_cast<UINT>(i_count * sizeof(Vertex));
+		if (FAILED(vertex_buffer_->Lock(offset, size, reinterpret_cast<void**>(&vertexData), lockFlags)))
+			return false;
+		memcpy(vertexData, i_vertices, size);
+		if (FAILED(vertex_buffer_->Unlock()))
+			return false;
+
+		o_first_vertex = stream_position_;
+		stream_position_ += i_count;
+		return true;
+	}
+
 	bool RenderableMesh::UpdateIndices(const uint32_t* i_indices, const size_t i_amount)
 	{
-		if (!index_buffer_)
+		if (!index_buffer_ || index_size_ != sizeof(*i_indices))
 			return false;
 		// Before the index buffer can be changed it must be "locked"
 		uint32_t *indexData;
@@ -197,9 +263,25 @@ namespace Lame
 		return SUCCEEDED(index_buffer_->Unlock());
 	}
 
-	bool RenderableMesh::Draw(const size_t i_max_primitives) const
+	bool RenderableMesh::UpdateIndices(const uint16_t* i_indices, const size_t i_amount)
+	{
+		if (!index_buffer_ || index_size_ != sizeof(*i_indices))
+			return false;
+		uint16_t *indexData;
+		HRESULT result = index_buffer_->Lock(0, 0, reinterpret_cast<void**>(&indexData), 0);
+		if (FAILED(result))
+			return false;
+		const size_t indsToCopy = i_amount == 0 ? index_count_ : i_amount;
+		memcpy(indexData, i_indices, indsToCopy * sizeof(*i_indices));
+		return SUCCEEDED(index_buffer_->Unlock());
+	}
+
+	bool RenderableMesh::Draw(const size_t i_max_primitives, const size_t i_lod) const
 	{
-		HRESULT result;
+		HRESULT result = context->get_direct3dDevice()->SetVertexDeclaration(vertex_declaration_);
+		if (FAILED(result))
+			return false;
+
 		// Bind a specific vertex buffer to the device as a data source
 		{
 			// There can be multiple streams of data feeding the display adaptor at the same time
@@ -207,7 +289,7 @@ namespace Lame
 			// It's possible to start streaming data in the middle of a vertex buffer
 			const unsigned int bufferOffset = 0;
 			// The "stride" defines how large a single vertex is in the stream of data
-			const unsigned int bufferStride = sizeof(Vertex);
+			const unsigned int bufferStride = static_cast<unsigned int>(vertex_size());
 			result = context->get_direct3dDevice()->SetStreamSource(streamIndex, vertex_buffer_, bufferOffset, bufferStride);
 			if (FAILED(result))
 				return false;
@@ -215,7 +297,9 @@ namespace Lame
 		// Render objects from the current streams
 		{
 			const D3DPRIMITIVETYPE primitiveType = GetD3DPrimitiveType(primitive_type());
-			UINT primitiveCount = static_cast<UINT>(primitive_count());
+			size_t firstIndex, indexCount;
+			GetLodRange(i_lod, firstIndex, indexCount);
+			UINT primitiveCount = static_cast<UINT>(primitive_count(i_lod));
 			if (i_max_primitives > 0 && i_max_primitives < primitiveCount)
 				primitiveCount =  static_cast<UINT>(i_max_primitives);
 
@@ -225,15 +309,144 @@ namespace Lame
 				result = context->get_direct3dDevice()->SetIndices(index_buffer_);
 				if (FAILED(result))
 					return false;
+
+				//sectioned meshes are always triangle lists
+				if (!sections_.empty())
+					return DrawIndexRange(firstIndex, std::min<size_t>(indexCount, primitiveCount * 3));
 				
 				result = context->get_direct3dDevice()->DrawIndexedPrimitive(primitiveType,
-					0, 0, static_cast<UINT>(vertex_count_), 0, primitiveCount);
+					0, 0, static_cast<UINT>(vertex_count_), static_cast<UINT>(firstIndex), primitiveCount);
 			}
 			else
 			{
 				result = context->get_direct3dDevice()->DrawPrimitive(primitiveType, 0, primitiveCount);
 			}
+			context->CountDrawCall(primitiveCount);
+			return SUCCEEDED(result);
+		}
+	}
+
+	bool RenderableMesh::DrawRange(const size_t i_first_vertex, const size_t i_primitive_count) const
+	{
+		if (index_count_ > 0 || i_primitive_count == 0)
+			return false;
+
+		IDirect3DDevice9 *device = context->get_direct3dDevice();
+		if (FAILED(device->SetVertexDeclaration(vertex_declaration_)) ||
+			FAILED(device->SetStreamSource(0, vertex_buffer_, 0, static_cast<UINT>(vertex_size()))))
+			return false;
+
+		const UINT primitiveCount = static_cast<UINT>(i_primitive_count);
+		const HRESULT result = device->DrawPrimitive(GetD3DPrimitiveType(primitive_type()), static_cast<UINT>(i_first_vertex), primitiveCount);
+		context->CountDrawCall(primitiveCount);
+		return SUCCEEDED(result);
+	}
+
+	bool RenderableMesh::DrawClusters(const Frustum& i_local_frustum, const Vector3& i_local_eye, const bool i_cull_back_faces) const
+	{
+		if (clusters_.empty() || index_count_ == 0)
+			return Draw();
+
+		IDirect3DDevice9 *device = context->get_direct3dDevice();
+		if (FAILED(device->SetVertexDeclaration(vertex_declaration_)) ||
+			FAILED(device->SetStreamSource(0, vertex_buffer_, 0, static_cast<UINT>(vertex_size()))) ||
+			FAILED(device->SetIndices(index_buffer_)))
+			return false;
+
+		bool success = true;
+		size_t runFirstIndex = 0, runIndexCount = 0;
+		for (size_t x = 0; x <= clusters_.size(); x++)
+		{
+			bool visible = false;
+			if (x < clusters_.size())
+			{
+				const MeshCluster& cluster = clusters_[x];
+				visible = !(i_cull_back_faces && cluster.IsBackFacing(i_local_eye)) && i_local_frustum.Intersects(cluster.bounds());
+
+				//grow the current run while the visible clusters are back to back in the index buffer
+				if (visible && runIndexCount > 0 && runFirstIndex + runIndexCount == cluster.first_index)
+				{
+					runIndexCount += cluster.index_count;
+					continue;
+				}
+			}
+
+			if (runIndexCount > 0)
+			{
+				success = DrawIndexRange(runFirstIndex, runIndexCount) && success;
+				runIndexCount = 0;
+			}
+			if (visible)
+			{
+				runFirstIndex = clusters_[x].first_index;
+				runIndexCount = clusters_[x].index_count;
+			}
+		}
+		return success;
+	}
+
+	bool RenderableMesh::DrawInstanced(const InstanceBuffer& i_instances, const size_t i_first_instance, const size_t i_instance_count, const size_t i_lod) const
+	{
+		//Direct3D 9 can only instance indexed geometry
+		if (index_count_ == 0 || i_instance_count == 0)
+			return false;
+
+		IDirect3DDevice9 *device = context->get_direct3dDevice();
+		HRESULT result = device->SetVertexDeclaration(instanced_vertex_declaration_);
+		if (FAILED(result))
+			return false;
+
+		// Stream 0 repeats the mesh for every instance, stream 1 steps once per instance
+		if (FAILED(device->SetStreamSource(0, vertex_buffer_, 0, static_cast<UINT>(vertex_size()))) ||
+			FAILED(device->SetStreamSourceFreq(0, D3DSTREAMSOURCE_INDEXEDDATA | static_cast<UINT>(i_instance_count))) ||
+			!i_instances.Bind(i_first_instance) ||
+			FAILED(device->SetStreamSourceFreq(1, D3DSTREAMSOURCE_INSTANCEDATA | 1)) ||
+			FAILED(device->SetIndices(index_buffer_)))
+		{
+			device->SetStreamSourceFreq(0, 1);
+			device->SetStreamSourceFreq(1, 1);
+			return false;
+		}
+
+		size_t firstIndex, indexCount;
+		GetLodRange(i_lod, firstIndex, indexCount);
+		bool success = DrawIndexRange(firstIndex, indexCount, i_instance_count);
+
+		//restore the stream frequencies so regular draws are not repeated
+		success = SUCCEEDED(device->SetStreamSourceFreq(0, 1)) && success;
+		success = SUCCEEDED(device->SetStreamSourceFreq(1, 1)) && success;
+		return success;
+	}
+
+	bool RenderableMesh::DrawIndexRange(const size_t i_first_index, const size_t i_index_count, const size_t i_instance_count) const
+	{
+		IDirect3DDevice9 *device = context->get_direct3dDevice();
+		const D3DPRIMITIVETYPE primitiveType = GetD3DPrimitiveType(primitive_type());
+		if (sections_.empty())
+		{
+			const UINT primitiveCount = static_cast<UINT>(Lame::Mesh::GetPrimitiveCount(primitive_type(), i_index_count));
+			const HRESULT result = device->DrawIndexedPrimitive(primitiveType,
+				0, 0, static_cast<UINT>(vertex_count_), static_cast<UINT>(i_first_index), primitiveCount);
+			context->CountDrawCall(primitiveCount * i_instance_count);
 			return SUCCEEDED(result);
 		}
+
+		//each section's indices are relative to its own base vertex, so a range covering several takes a draw for each
+		bool success = true;
+		const size_t end = i_first_index + i_index_count;
+		for (size_t x = 0; x < sections_.size(); x++)
+		{
+			const Section& section = sections_[x];
+			const size_t first = std::max(i_first_index, section.first_index);
+			const size_t last = std::min(end, section.first_index + section.index_count);
+			if (first >= last)
+				continue;
+
+			const UINT primitiveCount = static_cast<UINT>((last - first) / 3);
+			success = SUCCEEDED(device->DrawIndexedPrimitive(primitiveType, static_cast<INT>(section.base_vertex),
+				0, static_cast<UINT>(section.vertex_count), static_cast<UINT>(first), primitiveCount)) && success;
+			context->CountDrawCall(primitiveCount * i_instance_count);
+		}
+		return success;
 	}
 }
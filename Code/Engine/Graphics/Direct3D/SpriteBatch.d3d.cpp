@@ -0,0 +1,124 @@
+
+#include "../SpriteBatch.h"
+
+#include <cstring>
+#include <d3d9.h>
+
+#include "../Context.h"
+#include "../../System/UserOutput.h"
+
+namespace Lame
+{
+	SpriteBatch::SpriteBatch(std::shared_ptr<Context> i_context, const size_t i_capacity) :
+		context(i_context),
+		capacity_(i_capacity),
+		vertex_buffer_(nullptr),
+		index_buffer_(nullptr),
+		vertex_declaration_(nullptr)
+	{
+	}
+
+	SpriteBatch::~SpriteBatch()
+	{
+		if (vertex_buffer_)
+		{
+			vertex_buffer_->Release();
+			vertex_buffer_ = nullptr;
+		}
+		if (index_buffer_)
+		{
+			index_buffer_->Release();
+			index_buffer_ = nullptr;
+		}
+		if (vertex_declaration_)
+		{
+			vertex_declaration_->Release();
+			vertex_declaration_ = nullptr;
+		}
+	}
+
+	SpriteBatch* SpriteBatch::Create(std::shared_ptr<Context> i_context, const size_t i_capacity)
+	{
+		//every quad's vertices must be reachable from a 32 bit index
+		if (!i_context || i_capacity == 0 || i_capacity > UINT32_MAX / 4)
+			return nullptr;
+
+		SpriteBatch *batch = new SpriteBatch(i_context, i_capacity);
+		if (!batch)
+		{
+			Lame::UserOutput::Display("Failed to create SpriteBatch, due to insufficient memory.", "SpriteBatch Loading Error");
+			return nullptr;
+		}
+
+		DWORD usage = 0;
+		if (FAILED(i_context->GetVertexProcessingUsage(usage)))
+		{
+			Lame::UserOutput::Display("Unable to get vertex processing usage information");
+			delete batch;
+			return nullptr;
+		}
+
+		IDirect3DDevice9 *device = i_context->get_direct3dDevice();
+		if (!i_context->SetVertexFormat(&batch->vertex_declaration_) ||
+			FAILED(device->CreateVertexBuffer(static_cast<UINT>(i_capacity * 4 * sizeof(Vertex)), usage | D3DUSAGE_DYNAMIC | D3DUSAGE_WRITEONLY,
+				0, D3DPOOL_DEFAULT, &batch->vertex_buffer_, nullptr)) ||
+			FAILED(device->CreateIndexBuffer(static_cast<UINT>(i_capacity * 6 * sizeof(uint32_t)), usage | D3DUSAGE_WRITEONLY,
+				D3DFMT_INDEX32, D3DPOOL_DEFAULT, &batch->index_buffer_, nullptr)))
+		{
+			Lame::UserOutput::Display("Direct3D failed to create the sprite batch buffers");
+			delete batch;
+			return nullptr;
+		}
+
+		//the indices never change, two triangles per quad with the same winding as a triangle strip
+		uint32_t *indexData;
+		if (FAILED(batch->index_buffer_->Lock(0, 0, reinterpret_cast<void**>(&indexData), 0)))
+		{
+			delete batch;
+			return nullptr;
+		}
+		for (uint32_t x = 0; x < i_capacity; x++)
+		{
+			const uint32_t vertex = x * 4;
+			uint32_t *quad = indexData + x * 6;
+			quad[0] = vertex;
+			quad[1] = vertex + 1;
+			quad[2] = vertex + 2;
+			quad[3] = vertex + 2;
+			quad[4] = vertex + 1;
+			quad[5] = vertex + 3;
+		}
+		if (FAILED(batch->index_buffer_->Unlock()))
+		{
+			delete batch;
+			return nullptr;
+		}
+		return batch;
+	}
+
+	bool SpriteBatch::Upload(const size_t i_first, const size_t i_last)
+	{
+		//the whole buffer is rewritten, so discarding lets the GPU keep drawing from the old copy
+		Vertex *vertexData;
+		if (FAILED(vertex_buffer_->Lock(0, static_cast<UINT>((i_last - i_first) * 4 * sizeof(Vertex)), reinterpret_cast<void**>(&vertexData), D3DLOCK_DISCARD)))
+			return false;
+		for (size_t x = i_first; x < i_last; x++, vertexData += 4)
+			memcpy(vertexData, quads_[x].vertices, sizeof(quads_[x].vertices));
+		return SUCCEEDED(vertex_buffer_->Unlock());
+	}
+
+	bool SpriteBatch::DrawQuads(const size_t i_first_quad, const size_t i_quad_count) const
+	{
+		IDirect3DDevice9 *device = context->get_direct3dDevice();
+		if (FAILED(device->SetVertexDeclaration(vertex_declaration_)) ||
+			FAILED(device->SetStreamSource(0, vertex_buffer_, 0, sizeof(Vertex))) ||
+			FAILED(device->SetIndices(index_buffer_)))
+			return false;
+
+		const UINT primitiveCount = static_cast<UINT>(i_quad_count * 2);
+		const HRESULT result = device->DrawIndexedPrimitive(D3DPT_TRIANGLELIST, 0,
+			static_cast<UINT>(i_first_quad * 4), static_cast<UINT>(i_quad_count * 4), static_cast<UINT>(i_first_quad * 6), primitiveCount);
+		context->CountDrawCall(primitiveCount);
+		return SUCCEEDED(result);
+	}
+}
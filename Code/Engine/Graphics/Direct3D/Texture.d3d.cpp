@@ -7,10 +7,20 @@
 #include "../Context.h"
 #include "../../Core/Vector2.h"
 #include "../../System/UserOutput.h"
+#include "../../System/MappedFile.h"
 
 namespace Lame
 {
 	Texture* Texture::Create(std::shared_ptr<Context> i_context, const std::string& i_path)
+	{
+		//read through MappedFile, so textures in an asset pack are found too
+		std::shared_ptr<File::MappedFile> file(File::MappedFile::Create(i_path));
+		if (!file)
+			return nullptr;
+		return Create(i_context, *file, i_path);
+	}
+
+	Texture* Texture::Create(std::shared_ptr<Context> i_context, const File::MappedFile& i_file, const std::string& i_path)
 	{
 		const unsigned int useDimensionsFromFile = D3DX_DEFAULT_NONPOW2;
 		const unsigned int useMipMapsFromFile = D3DX_FROM_FILE;
@@ -22,8 +32,8 @@ namespace Lame
 		D3DXIMAGE_INFO sourceInfo;
 		PALETTEENTRY* noColorPalette = nullptr;
 		IDirect3DTexture9 *d3dtexture = nullptr;
-		const HRESULT result = D3DXCreateTextureFromFileEx(i_context->get_direct3dDevice(), i_path.c_str(), useDimensionsFromFile, useDimensionsFromFile, useMipMapsFromFile,
-			staticTexture, useFormatFromFile, letD3dManageMemory, useDefaultFiltering, useDefaultFiltering, noColorKey, &sourceInfo, noColorPalette,
+		const HRESULT result = D3DXCreateTextureFromFileInMemoryEx(i_context->get_direct3dDevice(), i_file.data(), static_cast<UINT>(i_file.size()),
+			useDimensionsFromFile, useDimensionsFromFile, useMipMapsFromFile, staticTexture, useFormatFromFile, letD3dManageMemory, useDefaultFiltering, useDefaultFiltering, noColorKey, &sourceInfo, noColorPalette,
 			&d3dtexture);
 		if (!SUCCEEDED(result))
 		{
@@ -35,13 +45,13 @@ namespace Lame
 				error << "Invalid function call";
 				break;
 			case D3DERR_NOTAVAILABLE:
-				error << "D3DXCreateTextureFromFileEx function not available";
+				error << "D3DXCreateTextureFromFileInMemoryEx function not available";
 				break;
 			case D3DERR_OUTOFVIDEOMEMORY:
 				error << "Out of video memory";
 				break;
 			case D3DXERR_INVALIDDATA:
-				error << "Invalid data passed to D3DXCreateTextureFromFileEx";
+				error << "Invalid data passed to D3DXCreateTextureFromFileInMemoryEx";
 				break;
 			case E_OUTOFMEMORY:
 				error << "Out of memory";
@@ -69,6 +79,48 @@ namespace Lame
 		}
 	}
 
+	Texture* Texture::Create(std::shared_ptr<Context> i_context, const size_t i_width, const size_t i_height, const uint8_t* i_alpha)
+	{
+		if (!i_context || !i_alpha || i_width == 0 || i_height == 0)
+			return nullptr;
+
+		const UINT noMipMaps = 1;
+		const DWORD staticTexture = 0;
+		IDirect3DTexture9 *d3dtexture = nullptr;
+		if (FAILED(i_context->get_direct3dDevice()->CreateTexture(static_cast<UINT>(i_width), static_cast<UINT>(i_height), noMipMaps,
+			staticTexture, D3DFMT_A8R8G8B8, D3DPOOL_MANAGED, &d3dtexture, nullptr)))
+		{
+			Lame::UserOutput::Display("DirectX failed to create a texture", "DirectX Texture Load Error");
+			return nullptr;
+		}
+
+		D3DLOCKED_RECT locked;
+		if (FAILED(d3dtexture->LockRect(0, &locked, nullptr, 0)))
+		{
+			d3dtexture->Release();
+			return nullptr;
+		}
+		for (size_t y = 0; y < i_height; y++)
+		{
+			DWORD *row = reinterpret_cast<DWORD*>(reinterpret_cast<uint8_t*>(locked.pBits) + y * locked.Pitch);
+			for (size_t x = 0; x < i_width; x++)
+				row[x] = D3DCOLOR_ARGB(i_alpha[y * i_width + x], 255, 255, 255);
+		}
+		d3dtexture->UnlockRect(0);
+
+		Texture *texture = new Texture();
+		if (!texture)
+		{
+			Lame::UserOutput::Display("Insufficient memory to create texture", "Texture Load Error");
+			d3dtexture->Release();
+			return nullptr;
+		}
+		texture->texture_ = d3dtexture;
+		texture->width_ = i_width;
+		texture->height_ = i_height;
+		return texture;
+	}
+
 	Texture::~Texture()
 	{
 		if (texture_ != nullptr)
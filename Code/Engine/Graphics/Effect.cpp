@@ -3,6 +3,7 @@
 
 #include <fstream>
 #include <sstream>
+#include <cstring>
 
 #include "../System/UserOutput.h"
 #include "../System/FileLoader.h"
@@ -42,8 +43,13 @@ namespace Lame
 			return nullptr;
 		}
 
+		//the instanced vertex shader is optional, and older effects end after the fragment shader
+		const char* instancedVertex = fragment + strlen(fragment) + 1;
+		if (instancedVertex >= fileData + fileLength || *instancedVertex == '\0')
+			instancedVertex = nullptr;
+
 		//create the effect and cleanup the temporary buffer
-		Effect *effect = Create(i_context, vertex, fragment, renderMask);
+		Effect *effect = Create(i_context, vertex, fragment, renderMask, instancedVertex);
 		delete[] fileData;
 		return effect;
 	}
@@ -5,6 +5,7 @@
 #include <string>
 #include <tuple>
 #include <memory>
+#include <vector>
 
 #include "../Core/Vector3.h"
 #include "../Core/Matrix4x4.h"
@@ -12,6 +13,8 @@
 #include "../Core/EnumMask.h"
 
 #if EAE6320_PLATFORM_D3D
+//materials' float constants are packed into the registers they occupy (OpenGL uniforms have locations instead, so they are set one at a time)
+#define LAME_EFFECT_CONSTANT_BLOCKS
 #include <d3d9.h>
 struct ID3DXConstantTable;		//forward declare the directX constant table
 #elif EAE6320_PLATFORM_GL
@@ -39,7 +42,7 @@ namespace Lame
 	class Effect
 	{
 	public:
-		enum Shader { Vertex, Fragment, };
+		enum Shader { Vertex, Fragment, InstancedVertex, };
 
 #if EAE6320_PLATFORM_D3D
 		//TODO find a way to use D3DXHANDLE here instead of const char* without including more directx headers
@@ -51,14 +54,32 @@ namespace Lame
 #error No typedef for ConstantHandle
 #endif
 
+#if defined( LAME_EFFECT_CONSTANT_BLOCKS )
+		//Float constants of one shader packed into the registers they occupy, so they can all be set together.
+		// Built once with AddToConstantBlock, then uploaded with SetConstantBlock.
+		struct ConstantBlock
+		{
+			struct Run
+			{
+				uint32_t first_register;
+				uint32_t register_count;
+			};
+
+			Shader shader;
+			std::vector<Run> runs;			//registers that follow each other are set with one call
+			std::vector<float> values;		//4 for every register of every run, in order
+		};
+#endif
+
 		static Effect* Create(std::shared_ptr<Context> i_context, const std::string& i_effect_path);
-		static Effect* Create(std::shared_ptr<Context> i_context, const char* i_vertex_path, const char* i_fragment_path, Lame::EnumMask<RenderState> i_renderMask);
+		static Effect* Create(std::shared_ptr<Context> i_context, const char* i_vertex_path, const char* i_fragment_path, Lame::EnumMask<RenderState> i_renderMask, const char* i_instanced_vertex_path = nullptr);
 		~Effect();
 
-		bool Bind();
+		//binds the effect, using the instanced vertex shader when i_instanced is set
+		bool Bind(const bool i_instanced = false);
 
 		//Cache a constant for dynamic setting
-		bool CacheConstant(const Shader &i_shader, const std::string &i_constant, ConstantHandle &o_constantId);
+		bool CacheConstant(const Shader &i_shader, const char *i_constant, ConstantHandle &o_constantId);
 
 		//sets the value of a cache'd constant
 		bool SetConstant(const Shader &i_shader, const ConstantHandle &i_constant, const Lame::Vector3 &i_val);
@@ -71,6 +92,13 @@ namespace Lame
 #endif
 			);
 
+#if defined( LAME_EFFECT_CONSTANT_BLOCKS )
+		//packs the value of a cache'd constant of io_block's shader into the block, fails if the constant can't be part of one
+		bool AddToConstantBlock(const ConstantHandle &i_constant, const float *i_val, const size_t i_val_count, ConstantBlock &io_block);
+		//sets every constant in the block
+		bool SetConstantBlock(const ConstantBlock &i_block);
+#endif
+
 		std::shared_ptr<Context> get_context() { return context; }
 		Lame::EnumMask<RenderState> render_mask() const { return renderMask; }
 
@@ -89,6 +117,13 @@ namespace Lame
 		bool is_wireframe() const { return renderMask.test(RenderState::Wireframe); }
 		void is_wireframe(const bool i_val) { renderMask.set(RenderState::Wireframe, i_val); }
 
+		//does this effect have a vertex shader that reads local_to_world from the instance stream
+#if EAE6320_PLATFORM_D3D
+		bool supports_instancing() const { return instancedVertexShader != nullptr; }
+#else
+		bool supports_instancing() const { return false; }
+#endif
+
 	private:
 		Effect(std::shared_ptr<Context> i_context, Lame::EnumMask<RenderState> i_renderMask) : context(i_context), renderMask(i_renderMask) {}
 
@@ -102,11 +137,21 @@ namespace Lame
 #if EAE6320_PLATFORM_D3D
 		IDirect3DVertexShader9 *vertexShader;
 		IDirect3DPixelShader9 *fragmentShader;
+		IDirect3DVertexShader9 *instancedVertexShader;
 
 		ID3DXConstantTable *vertexConstantTable;
 		ID3DXConstantTable *fragmentConstantTable;
-
-		ID3DXConstantTable* get_constant_table(const Shader &i_shader) { return i_shader == Shader::Vertex ? vertexConstantTable : fragmentConstantTable; }
+		ID3DXConstantTable *instancedVertexConstantTable;
+
+		ID3DXConstantTable* get_constant_table(const Shader &i_shader)
+		{
+			switch (i_shader)
+			{
+			case Shader::Vertex: return vertexConstantTable;
+			case Shader::InstancedVertex: return instancedVertexConstantTable;
+			default: return fragmentConstantTable;
+			}
+		}
 #elif EAE6320_PLATFORM_GL
 		// OpenGL encapsulates a matching vertex shader and fragment shader into what it calls a "program".
 		GLuint programId;
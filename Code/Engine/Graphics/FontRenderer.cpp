@@ -0,0 +1,286 @@
+
+#include "FontRenderer.h"
+
+#include <cmath>
+#include <cstring>
+#include <sstream>
+
+#include "Context.h"
+#include "Sprite.h"
+#include "SpriteBatch.h"
+#include "Texture.h"
+#include "../Core/HashedString.h"
+#include "../System/FileLoader.h"
+#include "../System/UserOutput.h"
+
+namespace
+{
+	//the cache is emptied when it fills up, so text that changes every frame can't grow it forever
+	const size_t MaxCachedLayouts = 256;
+
+	struct LayoutParameters
+	{
+		float left, right, top, bottom;
+		uint32_t align;
+		uint32_t word_wrap;
+	};
+
+	//checks that the counts and sizes in the header fit in the file (without overflowing) and that every glyph is inside the atlas,
+	// and gives the start of the atlas
+	bool ValidateFont(const char* i_data, const size_t i_length, const uint8_t*& o_atlas)
+	{
+		using namespace Lame::Font;
+		if (i_length < sizeof(FileHeader))
+			return false;
+		const FileHeader *header = reinterpret_cast<const FileHeader*>(i_data);
+		const size_t afterHeader = i_length - sizeof(FileHeader);
+
+		//glyphs are looked up by a single byte
+		if (header->first_character > 255 || header->glyph_count > 256 - header->first_character ||
+			header->glyph_count > afterHeader / sizeof(Glyph))
+			return false;
+		const size_t afterGlyphs = afterHeader - header->glyph_count * sizeof(Glyph);
+
+		if (header->atlas_width == 0 || header->atlas_height == 0 ||
+			static_cast<uint64_t>(header->atlas_width) * header->atlas_height > afterGlyphs)
+			return false;
+
+		const Glyph *glyphs = reinterpret_cast<const Glyph*>(header + 1);
+		for (uint32_t x = 0; x < header->glyph_count; x++)
+		{
+			if (static_cast<uint32_t>(glyphs[x].atlas_x) + glyphs[x].width > header->atlas_width ||
+				static_cast<uint32_t>(glyphs[x].atlas_y) + glyphs[x].height > header->atlas_height)
+				return false;
+		}
+
+		o_atlas = reinterpret_cast<const uint8_t*>(glyphs + header->glyph_count);
+		return true;
+	}
+}
+
+namespace Lame
+{
+	FontRenderer* FontRenderer::Create(std::shared_ptr<SpriteBatch> i_sprite_batch, std::shared_ptr<Effect> i_effect, const std::string& i_font_path)
+	{
+		if (!i_sprite_batch || !i_effect)
+			return nullptr;
+
+		size_t fileLength;
+		char *fileData = File::LoadBinary(i_font_path, &fileLength);
+		if (!fileData)
+		{
+			std::stringstream error;
+			error << "Failed to load the font " << i_font_path;
+			Lame::UserOutput::Display(error.str(), "Font Loading Error");
+			return nullptr;
+		}
+
+		const Font::FileHeader *header = reinterpret_cast<const Font::FileHeader*>(fileData);
+		const Font::Glyph *glyphs = reinterpret_cast<const Font::Glyph*>(header + 1);
+		const uint8_t *atlas = nullptr;
+		if (!ValidateFont(fileData, fileLength, atlas))
+		{
+			std::stringstream error;
+			error << "The font " << i_font_path << " is not a valid font binary file";
+			Lame::UserOutput::Display(error.str(), "Font Loading Error");
+			delete[] fileData;
+			return nullptr;
+		}
+
+		std::shared_ptr<Texture> texture(Texture::Create(i_sprite_batch->get_context(), header->atlas_width, header->atlas_height, atlas));
+		Effect::ConstantHandle texture_uniform;
+		if (!texture || !i_effect->CacheConstant(Effect::Fragment, Sprite::BaseTextureUniformName, texture_uniform))
+		{
+			Lame::UserOutput::Display("Unable to create the glyph atlas for FontRenderer", "Font Loading Error");
+			delete[] fileData;
+			return nullptr;
+		}
+
+		FontRenderer *fr = new FontRenderer();
+		if (!fr)
+		{
+			Lame::UserOutput::Display("Insufficient memory to create FontRenderer", "Font Loading Error");
+			delete[] fileData;
+			return nullptr;
+		}
+		fr->sprite_batch_ = i_sprite_batch;
+		fr->effect_ = i_effect;
+		fr->texture_ = texture;
+		fr->texture_uniform_ = texture_uniform;
+		fr->first_character_ = header->first_character;
+		fr->glyphs_.assign(glyphs, glyphs + header->glyph_count);
+		fr->line_height_ = header->line_height;
+		fr->atlas_width_ = header->atlas_width;
+		fr->atlas_height_ = header->atlas_height;
+
+		delete[] fileData;
+		return fr;
+	}
+
+	FontRenderer::~FontRenderer()
+	{
+	}
+
+	std::shared_ptr<Lame::Context> FontRenderer::context() const
+	{
+		return sprite_batch_->get_context();
+	}
+
+	bool FontRenderer::Render(const char* i_str, const Rectangle2D& i_screen_rect, Font::HorizontalAlignment i_align, bool i_word_wrap, const Color32& i_color) const
+	{
+		if (!i_str)
+			return false;
+
+		const Layout& layout = GetLayout(i_str, i_screen_rect, i_align, i_word_wrap);
+		bool success = true;
+		Vertex quad[4];
+		for (size_t x = 0; x < layout.vertices.size(); x += 4)
+		{
+			for (size_t v = 0; v < 4; v++)
+			{
+				quad[v] = layout.vertices[x + v];
+				quad[v].color = i_color;
+			}
+			success = sprite_batch_->Add(effect_.get(), texture_.get(), texture_uniform_, quad) && success;
+		}
+		return success;
+	}
+
+	const FontRenderer::Layout& FontRenderer::GetLayout(const char* i_str, const Rectangle2D& i_screen_rect, Font::HorizontalAlignment i_align, bool i_word_wrap) const
+	{
+		std::shared_ptr<Context> ctx = context();
+		if (ctx->screen_width() != screen_width_ || ctx->screen_height() != screen_height_)
+		{
+			layouts_.clear();
+			screen_width_ = ctx->screen_width();
+			screen_height_ = ctx->screen_height();
+		}
+
+		LayoutParameters parameters;
+		memset(&parameters, 0, sizeof(parameters));
+		parameters.left = i_screen_rect.left();
+		parameters.right = i_screen_rect.right();
+		parameters.top = i_screen_rect.top();
+		parameters.bottom = i_screen_rect.bottom();
+		parameters.align = static_cast<uint32_t>(i_align);
+		parameters.word_wrap = i_word_wrap ? 1 : 0;
+		const uint32_t key = HashedString::Hash(i_str) ^ (HashedString::Hash(&parameters, sizeof(parameters)) * 16777619u);
+
+		//different text can share a hash, so the text and parameters are compared too
+		auto range = layouts_.equal_range(key);
+		for (auto itr = range.first; itr != range.second; ++itr)
+		{
+			const Layout& layout = itr->second;
+			if (layout.align == i_align && layout.word_wrap == i_word_wrap &&
+				layout.screen_rect.left() == parameters.left && layout.screen_rect.right() == parameters.right &&
+				layout.screen_rect.top() == parameters.top && layout.screen_rect.bottom() == parameters.bottom &&
+				layout.text == i_str)
+				return layout;
+		}
+
+		if (layouts_.size() >= MaxCachedLayouts)
+			layouts_.clear();
+
+		Layout& layout = layouts_.emplace(key, Layout())->second;
+		layout.text = i_str;
+		layout.screen_rect = i_screen_rect;
+		layout.align = i_align;
+		layout.word_wrap = i_word_wrap;
+		LayoutText(layout);
+		return layout;
+	}
+
+	void FontRenderer::LayoutText(Layout& io_layout) const
+	{
+		//lay out in pixels with y going up, so every glyph lands on whole pixels
+		const float screenWidth = static_cast<float>(screen_width_);
+		const float screenHeight = static_cast<float>(screen_height_);
+		const float left = std::floor(io_layout.screen_rect.left() * screenWidth);
+		const float right = std::floor(io_layout.screen_rect.right() * screenWidth);
+		const float top = std::floor(io_layout.screen_rect.top() * screenHeight);
+		const float width = right - left;
+#if EAE6320_PLATFORM_D3D
+		//Direct3D 9 puts pixel centers on whole coordinates, so texels line up with pixels half a pixel up and to the left
+		const float pixelOffsetX = -0.5f, pixelOffsetY = 0.5f;
+#else
+		const float pixelOffsetX = 0.0f, pixelOffsetY = 0.0f;
+#endif
+
+		const std::string& text = io_layout.text;
+		const size_t length = text.size();
+		io_layout.vertices.clear();
+		io_layout.vertices.reserve(length * 4);
+		for (size_t lineStart = 0, line = 0; lineStart < length; line++)
+		{
+			//find where this line ends, and how wide it is
+			size_t lineEnd = lineStart;
+			int32_t lineWidth = 0;
+			size_t wrapAt = std::string::npos;
+			int32_t widthAtWrap = 0;
+			while (lineEnd < length && text[lineEnd] != '\n')
+			{
+				const Font::Glyph* glyph = GetGlyph(text[lineEnd]);
+				const int32_t advance = glyph ? glyph->advance : 0;
+				if (io_layout.word_wrap && lineEnd > lineStart && lineWidth + advance > width)
+				{
+					//words that don't fit on a line by themselves are split wherever they run out of room
+					if (wrapAt != std::string::npos)
+					{
+						lineEnd = wrapAt;
+						lineWidth = widthAtWrap;
+					}
+					break;
+				}
+				if (text[lineEnd] == ' ')
+				{
+					wrapAt = lineEnd;
+					widthAtWrap = lineWidth;
+				}
+				lineWidth += advance;
+				lineEnd++;
+			}
+
+			float penX = left;
+			if (io_layout.align == Font::HorizontalAlignment::Center)
+				penX = std::floor(left + (width - lineWidth) / 2.0f);
+			else if (io_layout.align == Font::HorizontalAlignment::Right)
+				penX = right - lineWidth;
+			const float lineTop = top - static_cast<float>(line * line_height_);
+
+			for (size_t x = lineStart; x < lineEnd; x++)
+			{
+				const Font::Glyph* glyph = GetGlyph(text[x]);
+				if (!glyph)
+					continue;
+				if (glyph->width > 0 && glyph->height > 0)
+				{
+					const float x0 = (penX + glyph->offset_x + pixelOffsetX) / screenWidth * 2.0f - 1.0f;
+					const float x1 = (penX + glyph->offset_x + glyph->width + pixelOffsetX) / screenWidth * 2.0f - 1.0f;
+					const float y0 = (lineTop - glyph->offset_y + pixelOffsetY) / screenHeight * 2.0f - 1.0f;
+					const float y1 = (lineTop - glyph->offset_y - glyph->height + pixelOffsetY) / screenHeight * 2.0f - 1.0f;
+					const float u0 = static_cast<float>(glyph->atlas_x) / atlas_width_;
+					const float u1 = static_cast<float>(glyph->atlas_x + glyph->width) / atlas_width_;
+					const float v0 = static_cast<float>(glyph->atlas_y) / atlas_height_;
+					const float v1 = static_cast<float>(glyph->atlas_y + glyph->height) / atlas_height_;
+
+					io_layout.vertices.push_back(Vertex(Vector2(x0, y0), Vector2(u0, v0), Color32::white));
+					io_layout.vertices.push_back(Vertex(Vector2(x1, y0), Vector2(u1, v0), Color32::white));
+					io_layout.vertices.push_back(Vertex(Vector2(x0, y1), Vector2(u0, v1), Color32::white));
+					io_layout.vertices.push_back(Vertex(Vector2(x1, y1), Vector2(u1, v1), Color32::white));
+				}
+				penX += glyph->advance;
+			}
+
+			//the newline or space that ended the line isn't drawn on either line
+			if (lineEnd < length && (text[lineEnd] == '\n' || text[lineEnd] == ' '))
+				lineEnd++;
+			lineStart = lineEnd;
+		}
+	}
+
+	const Font::Glyph* FontRenderer::GetGlyph(const char i_character) const
+	{
+		const uint32_t index = static_cast<uint32_t>(static_cast<unsigned char>(i_character)) - first_character_;
+		return index < glyphs_.size() ? &glyphs_[index] : nullptr;
+	}
+}
@@ -1,49 +1,97 @@
 #ifndef _LAME_FONTRENDERER_H
 #define _LAME_FONTRENDERER_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
+#include <unordered_map>
+#include <vector>
 
+#include "Effect.h"
 #include "../Core/Color.h"
-
-#if EAE6320_PLATFORM_D3D
-#include <d3d9.h>
-#elif EAE6320_PLATFORM_GL
-#include "../../Engine/Windows/Includes.h"
-#include <gl/GL.h>
-#endif
+#include "../Core/Vertex.h"
+#include "../Core/Rectangle2D.h"
 
 namespace Lame
 {
 	class Context;
-	class Rectangle2D;
-	class Vector2;
+	class Texture;
+	class SpriteBatch;
 
 	namespace Font
 	{
-		enum class Pitch { Default, Monospace, };
-		enum class Type { Normal, Bold, Italics, BoldItalics };
 		enum class HorizontalAlignment { Left, Center, Right, };
+
+		//A font binary file (built by FontBuilder) is a FileHeader, then glyph_count Glyphs for the characters
+		// starting at first_character, then the atlas as atlas_width * atlas_height bytes of coverage, top row first.
+		struct FileHeader
+		{
+			uint32_t first_character;
+			uint32_t glyph_count;
+			uint32_t line_height;		//pixels from one line's top to the next
+			uint32_t atlas_width;
+			uint32_t atlas_height;
+		};
+		//all in pixels, with y down from the top of the line
+		struct Glyph
+		{
+			uint16_t atlas_x, atlas_y;
+			uint16_t width, height;
+			int16_t offset_x, offset_y;		//from the pen position to the top left of the bitmap
+			int16_t advance;				//how far the pen moves after this character
+			uint16_t padding;
+		};
 	}
 
+	//Draws text with a baked glyph atlas, by queueing a quad per character in a SpriteBatch.
+	// Laid out text is cached by its contents, so text that doesn't change is never laid out again.
 	class FontRenderer
 	{
 	public:
-		static FontRenderer* Create(std::shared_ptr<Lame::Context> i_context, const Vector2& i_screen_size, Font::Pitch i_pitch, Font::Type i_type, const char* i_font = "");
+		//i_effect is a sprite effect, drawing its base_texture multiplied by the vertex color
+		static FontRenderer* Create(std::shared_ptr<SpriteBatch> i_sprite_batch, std::shared_ptr<Effect> i_effect, const std::string& i_font_path);
 		~FontRenderer();
 
+		//queues i_str inside i_screen_rect (in virtual screen coordinates), which is drawn when the sprite batch is flushed
 		bool Render(const char* i_str, const Rectangle2D& i_screen_rect, Font::HorizontalAlignment  i_align = Font::HorizontalAlignment::Left, bool i_word_wrap = false, const Color32& i_color = Color32::white) const;
 
-		std::shared_ptr<Lame::Context> context() const { return context_; }
+		std::shared_ptr<Lame::Context> context() const;
+		inline size_t line_height() const { return line_height_; }
+		inline size_t cached_layout_count() const { return layouts_.size(); }
 	private:
-		FontRenderer() { }
+		FontRenderer() : first_character_(0), line_height_(0), atlas_width_(0), atlas_height_(0), screen_width_(0), screen_height_(0) { }
+
+		//Do not allow FontRenderers to be managed without pointers
+		FontRenderer(const FontRenderer &i_other);
+		FontRenderer& operator=(const FontRenderer &i_other);
+
+		struct Layout
+		{
+			std::string text;
+			Rectangle2D screen_rect;
+			Font::HorizontalAlignment align;
+			bool word_wrap;
+			std::vector<Vertex> vertices;		//4 white vertices for each visible character, in real screen coordinates
+		};
+
+		//finds the cached layout of the text, or lays it out
+		const Layout& GetLayout(const char* i_str, const Rectangle2D& i_screen_rect, Font::HorizontalAlignment i_align, bool i_word_wrap) const;
+		void LayoutText(Layout& io_layout) const;
+		const Font::Glyph* GetGlyph(const char i_character) const;
+
+		std::shared_ptr<SpriteBatch> sprite_batch_;
+		std::shared_ptr<Effect> effect_;
+		std::shared_ptr<Texture> texture_;
+		Effect::ConstantHandle texture_uniform_;
 
-		std::shared_ptr<Lame::Context> context_;
+		uint32_t first_character_;
+		std::vector<Font::Glyph> glyphs_;
+		size_t line_height_;
+		size_t atlas_width_, atlas_height_;
 
-#if EAE6320_PLATFORM_D3D
-		//hack to get around including d3d headers here.  Required internal casts
-		void* font;
-#endif
+		//the layouts depend on the screen size, so they are thrown away if it changes
+		mutable uint32_t screen_width_, screen_height_;
+		mutable std::unordered_multimap<uint32_t, Layout> layouts_;
 	};
 }
 
@@ -1,17 +1,29 @@
 // Header Files
 //=============
 
+#include <algorithm>
+#include <limits>
+
 #include "Graphics.h"
 #include "Context.h"
 #include "RenderableComponent.h"
 #include "DebugRenderer.h"
 #include "DebugMenu.h"
 #include "Sprite.h"
+#include "SpriteBatch.h"
 #include "FontRenderer.h"
+#include "Assets.h"
+#include "AssetLoader.h"
+#include "ConstantBlocks.h"
 #include "../Component/GameObject.h"
 #include "../Core/Matrix4x4.h"
+#include "../Core/Frustum.h"
+#include "../Core/OcclusionBuffer.h"
+#include "../System/FileLoader.h"
+#include "../System/MappedFile.h"
 #include "../System/Console.h"
 #include "../System/UserOutput.h"
+#include "../System/ThreadPool.h"
 #include "../Core/Rectangle2D.h"
 
 namespace Lame
@@ -30,21 +42,61 @@ namespace Lame
 		if (!cameraGameObject)
 			return false;
 
+		std::shared_ptr<CameraComponent> cam(new CameraComponent(cameraGameObject, i_context));
+		if (!cam)
+			return false;
+
+		std::shared_ptr<Assets> assets(Assets::Create(i_context));
+		if (!assets)
+			return false;
+
+		//without a thread pool the draw packets are recorded on this thread
+		std::shared_ptr<ThreadPool> threadPool(ThreadPool::Create());
+
+		std::shared_ptr<AssetLoader> assetLoader(AssetLoader::Create(assets, threadPool));
+		if (!assetLoader)
+			return false;
+
+		//without an instance buffer every renderable is drawn on its own
+		const size_t instanceCapacity = 4096;
+		std::shared_ptr<InstanceBuffer> instances(InstanceBuffer::Create(i_context, instanceCapacity));
+		if (!instances)
+		{
+			UserOutput::Display("Failed to create the instance buffer, instanced rendering is disabled");
+		}
+
+		const size_t spriteCapacity = 1024;
+		std::shared_ptr<SpriteBatch> spriteBatch(SpriteBatch::Create(i_context, spriteCapacity));
+		if (!spriteBatch)
+		{
+			UserOutput::Display("Failed to create the sprite batch");
+			return false;
+		}
+
 #ifdef ENABLE_DEBUG_MENU
-		std::shared_ptr<Debug::Menu> dm(Debug::Menu::Create(i_context));
+		//the menu's text is drawn through the sprite batch
+		std::shared_ptr<Debug::Menu> dm(Debug::Menu::Create(spriteBatch));
 		if (!dm)
 		{
 			UserOutput::Display("Failed to create Debug menu");
 		}
 #endif
 
-		std::shared_ptr<CameraComponent> cam(new CameraComponent(cameraGameObject, i_context));
-		if (!cam)
-			return false;
+		//the occlusion buffer keeps the screen's aspect ratio at a fraction of its resolution
+		const size_t occlusionWidth = 256;
+		const size_t occlusionHeight = std::max<size_t>(1, occlusionWidth * i_context->screen_height() / std::max<uint32_t>(1, i_context->screen_width()));
+		std::shared_ptr<OcclusionBuffer> occlusion(OcclusionBuffer::Create(occlusionWidth, occlusionHeight));
 
 		context_ = i_context;
+		assets_ = assets;
 		camera_ = cam;
 		camera_gameobject_ = cameraGameObject;
+		instance_buffer_ = instances;
+		sprite_batch_ = spriteBatch;
+		occlusion_buffer_ = occlusion;
+		thread_pool_ = threadPool;
+		asset_loader_ = assetLoader;
+		command_buffers_.resize(thread_pool_ ? thread_pool_->max_slots() : 1);
 #ifdef ENABLE_DEBUG_MENU
 		debug_menu_ = dm;
 #endif
@@ -53,6 +105,10 @@ namespace Lame
 
 	bool Graphics::Render()
 	{
+		//finish a few of the assets loading in the background, whose callbacks may add renderables for this frame
+		const size_t assetCreatesPerFrame = 8;
+		asset_loader_->Update(assetCreatesPerFrame);
+
 		bool success = context()->Clear(true, true, true) && context()->BeginFrame();
 		if (!success)
 			return false;
@@ -60,51 +116,234 @@ namespace Lame
 		Lame::Matrix4x4 worldToView = camera()->WorldToView();
 		Lame::Matrix4x4 viewToScreen = camera()->ViewToScreen();
 
-		std::vector<std::shared_ptr<RenderableComponent>> transparent;
+		//drop the renderables whose gameobjects have been destroyed
+		renderables_.erase(std::remove_if(renderables_.begin(), renderables_.end(),
+			[](const std::shared_ptr<RenderableComponent>& i_renderable) {
+				std::shared_ptr<Lame::GameObject> go = i_renderable->gameObject();
+				return !go || go->IsDestroying();
+			}), renderables_.end());
+
+		RasterizeOccluders(viewToScreen * worldToView);
+
+		//cull and record draw packets on all threads, then merge them into one sorted list
+		Record(worldToView, viewToScreen);
+		frame_commands_.Merge(command_buffers_);
+		const size_t firstTransparent = frame_commands_.FirstTransparent();
+
+		//the camera's matrices are set once, and stay set for everything drawn with them
+		FrameConstants frame;
+		frame.world_to_view = worldToView;
+		frame.view_to_screen = viewToScreen;
+		success = context()->SetFrameConstants(frame) && success;
+
+		//render the opaque ones first
+		success = Submit(0, firstTransparent, worldToView, viewToScreen) && success;
+
+#ifdef ENABLE_DEBUG_RENDERING
+		if (debug_renderer_)
+			success = debug_renderer_->Render() && success;
+#endif
+
+		//render all the transparent objects on top of the opaque ones
+		success = Submit(firstTransparent, frame_commands_.size(), worldToView, viewToScreen) && success;
+
+		//the sprites are drawn together, one draw per texture
+		if (sprite_batch_)
+		{
+			for (auto itr = sprites_.begin(); itr != sprites_.end(); ++itr)
+				success = sprite_batch_->Add(**itr) && success;
+			success = sprite_batch_->Flush() && success;
+		}
+
+#ifdef ENABLE_DEBUG_MENU
+		//flushed separately, so the menu is always on top of the other sprites
+		if (debug_menu_ && sprite_batch_)
+		{
+			success = debug_menu_->RenderAndUpdate() && success;
+			success = sprite_batch_->Flush() && success;
+		}
+#endif
+
+		success = context()->EndFrame() && success;
+		return success;
+	}
+
+	void Graphics::RasterizeOccluders(const Lame::Matrix4x4& i_worldToScreen)
+	{
+		if (!occlusion_buffer_)
+			return;
 
-		//iterate all the renderables, rendering the opaque ones first.
-		for (auto itr = renderables_.begin(); itr != renderables_.end(); /**/)
+		const Frustum frustum(i_worldToScreen);
+		occlusion_buffer_->Clear(i_worldToScreen);
+		for (size_t x = 0; x < occluders_.size(); x++)
 		{
-			std::shared_ptr<Lame::GameObject> go = (*itr)->gameObject();
-			if (go && !go->IsDestroying())
+			const Occluder& occluder = occluders_[x];
+			if (frustum.Intersects(occluder.bounds))
+			{
+				occlusion_buffer_->RasterizeOccluder(occluder.positions.data(), occluder.positions.size(),
+					occluder.indices.data(), occluder.indices.size());
+			}
+		}
+		occlusion_buffer_->BuildHiZ();
+	}
+
+	void Graphics::Record(const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen)
+	{
+		const Frustum frustum(i_viewToScreen * i_worldToView);
+
+		//the occlusion buffer is only read while recording
+		const OcclusionBuffer* occlusion = (occlusion_buffer_ && occlusion_buffer_->occluder_triangle_count() > 0) ? occlusion_buffer_.get() : nullptr;
+
+		//pixels covered by one world unit at a clip space w of 1
+		const float lodPixelScale = 0.5f * static_cast<float>(context()->screen_height()) * i_viewToScreen.Get(1, 1);
+
+		//each slot records into its own command buffer, so the workers never share anything they write
+		auto record = [this, &frustum, occlusion, lodPixelScale, &i_worldToView, &i_viewToScreen](size_t i_begin, size_t i_end, size_t i_slot) {
+			CommandBuffer& commands = command_buffers_[i_slot];
+			for (size_t x = i_begin; x < i_end; x++)
 			{
-				if ((*itr)->material()->effect()->has_transparency())
-					transparent.push_back(*itr);
+				const RenderableComponent* renderable = renderables_[x].get();
+				std::shared_ptr<Lame::GameObject> go = renderable->gameObject();
+				if (!go || !go->enabled() || !renderable->enabled())
+					continue;
+
+				DrawPacket packet;
+				packet.local_to_world = go->transform().LocalToWorld();
+				const Bounds bounds = renderable->mesh()->bounds().Transformed(packet.local_to_world);
+				if (!frustum.Intersects(bounds) || (occlusion && !occlusion->IsVisible(bounds)))
+					continue;
+
+				packet.renderable = renderable;
+				packet.lod = 0;
+				if (renderable->mesh()->lod_count() > 1 && bounds.IsValid())
+				{
+					//w grows with the distance from the camera, and the largest axis scale sizes the mesh's error
+					const Vector3 viewCenter = i_worldToView.Multiply(bounds.center());
+					const float w = i_viewToScreen.Get(3, 0) * viewCenter.x() + i_viewToScreen.Get(3, 1) * viewCenter.y() +
+						i_viewToScreen.Get(3, 2) * viewCenter.z() + i_viewToScreen.Get(3, 3);
+					float scale = 0.0f;
+					for (size_t axis = 0; axis < 3; axis++)
+					{
+						const Vector3 column(packet.local_to_world.Get(0, axis), packet.local_to_world.Get(1, axis), packet.local_to_world.Get(2, axis));
+						scale = std::max(scale, column.magnitude());
+					}
+					const float pixelsPerUnit = w > 0.0f ? lodPixelScale * scale / w : std::numeric_limits<float>::max();
+					packet.lod = static_cast<uint32_t>(renderable->SelectLod(pixelsPerUnit, lod_error_pixels_));
+				}
+
+				if (renderable->material()->effect()->has_transparency())
+				{
+					//the camera looks down -z in view space
+					const Vector3 center = bounds.IsValid() ? bounds.center() : packet.local_to_world.Multiply(Vector3::zero);
+					packet.sort_key = CommandBuffer::TransparentKey(-i_worldToView.Multiply(center).z());
+				}
 				else
 				{
-					success = (*itr)->Render(worldToView, viewToScreen) && success;
+					packet.sort_key = CommandBuffer::OpaqueKey(renderable->material().get(), renderable->mesh().get(), packet.lod);
 				}
-				++itr;
+				commands.Add(packet);
+			}
+			commands.Sort();
+		};
+
+		for (size_t x = 0; x < command_buffers_.size(); x++)
+			command_buffers_[x].Clear();
+
+		if (thread_pool_)
+		{
+			const size_t minRenderablesPerThread = 64;
+			thread_pool_->ParallelFor(renderables_.size(), minRenderablesPerThread, record);
+		}
+		else
+		{
+			record(0, renderables_.size(), 0);
+		}
+	}
+
+	bool Graphics::Submit(const size_t i_first, const size_t i_last, const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen)
+	{
+		bool success = true;
+		for (size_t first = i_first; first < i_last; /**/)
+		{
+			const RenderableComponent* renderable = frame_commands_[first].renderable;
+
+			//find the end of this mesh/material group
+			size_t last = first + 1;
+			while (last < i_last &&
+				frame_commands_[last].renderable->material() == renderable->material() &&
+				frame_commands_[last].renderable->mesh() == renderable->mesh() &&
+				frame_commands_[last].lod == frame_commands_[first].lod)
+			{
+				++last;
+			}
+
+			if (instance_buffer_ && last - first > 1 && renderable->supports_instancing())
+			{
+				success = SubmitInstanced(first, last) && success;
 			}
 			else
 			{
-				itr = renderables_.erase(itr);
+				for (size_t x = first; x < last; x++)
+				{
+					const DrawPacket& packet = frame_commands_[x];
+					success = packet.renderable->Render(packet.local_to_world, i_worldToView, i_viewToScreen, packet.lod) && success;
+				}
 			}
+			first = last;
 		}
+		return success;
+	}
 
-#ifdef ENABLE_DEBUG_RENDERING
-		if (debug_renderer_)
-			success = debug_renderer_->Render(worldToView, viewToScreen) && success;
-#endif
+	bool Graphics::SubmitInstanced(const size_t i_first, const size_t i_last)
+	{
+		bool success = true;
 
-		//render all the transparent objects on top of the opaque ones
-		for (size_t x = 0; x < transparent.size(); x++)
+		//groups larger than the instance buffer are split into multiple draws
+		for (size_t start = i_first; start < i_last; start += instance_buffer_->capacity())
 		{
-			success = transparent[x]->Render(worldToView, viewToScreen) && success;
+			const size_t count = std::min(i_last - start, instance_buffer_->capacity());
+			const RenderableMesh& mesh = *frame_commands_[start].renderable->mesh();
+			const bool decodePositions = mesh.vertex_format() == VertexFormat::Compressed;
+			instances_.resize(count);
+			for (size_t x = 0; x < count; x++)
+			{
+				const Matrix4x4& localToWorld = frame_commands_[start + x].local_to_world;
+				instances_[x].local_to_world = decodePositions ? localToWorld * mesh.position_decode() : localToWorld;
+				instances_[x].color = Color32::white;
+			}
+
+			size_t firstInstance;
+			success = instance_buffer_->Write(instances_.data(), count, firstInstance) &&
+				frame_commands_[start].renderable->RenderInstanced(*instance_buffer_, firstInstance, count, frame_commands_[start].lod) &&
+				success;
 		}
+		return success;
+	}
 
-		for (auto itr = sprites_.begin(); itr != sprites_.end(); ++itr)
+	bool Graphics::AddOccluder(const std::string& i_occluder_path, const Lame::Matrix4x4& i_local_to_world)
+	{
+		std::shared_ptr<File::MappedFile> file(File::MappedFile::Create(i_occluder_path));
+		if (!file)
+			return false;
+		uint32_t vertex_count;
+		uint32_t index_count;
+		const Vector3 *positions;
+		const uint32_t *indices;
+		if (!File::FindMeshData(file->data(), file->size(), vertex_count, index_count, positions, indices))
+			return false;
+
+		//occluders never move, so they are stored in world space
+		Occluder occluder;
+		occluder.positions.reserve(vertex_count);
+		for (uint32_t x = 0; x < vertex_count; x++)
 		{
-			success = (*itr)->Render() && success;
+			occluder.positions.push_back(i_local_to_world.Multiply(positions[x]));
+			occluder.bounds.Encapsulate(occluder.positions.back());
 		}
+		occluder.indices.assign(indices, indices + index_count);
 
-#ifdef ENABLE_DEBUG_MENU
-		if (debug_menu_)
-			success = debug_menu_->RenderAndUpdate() && success;
-#endif
-
-		success = context()->EndFrame() && success;
-		return success;
+		occluders_.push_back(occluder);
+		return true;
 	}
 
 	bool Graphics::MatchesContext(std::shared_ptr<RenderableComponent> i_renderable)
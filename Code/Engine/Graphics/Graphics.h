@@ -12,6 +12,9 @@
 #include "CameraComponent.h"
 #include "DebugRenderer.h"
 #include "DebugMenu.h"
+#include "InstanceBuffer.h"
+#include "CommandBuffer.h"
+#include "../Core/Bounds.h"
 
 namespace Lame
 {
@@ -19,7 +22,12 @@ namespace Lame
 	class RenderableComponent;
 	class Effect;
 	class Sprite;
+	class SpriteBatch;
 	class Rectangle2D;
+	class ThreadPool;
+	class OcclusionBuffer;
+	class Assets;
+	class AssetLoader;
 
 	namespace Shader
 	{
@@ -40,11 +48,26 @@ namespace Lame
 		bool Add(std::shared_ptr<Sprite> i_sprite);
 		bool Remove(std::shared_ptr<Sprite> i_sprite);
 
+		//loads an occluder mesh binary (positions and indices, built by MeshBuilder with the "occluder" argument).
+		// Occluders are static and only used to hide renderables, they are never drawn
+		bool AddOccluder(const std::string& i_occluder_path, const Lame::Matrix4x4& i_local_to_world = Lame::Matrix4x4::identity);
+
 		//does this renderable have the same context as this graphics object
 		bool MatchesContext(std::shared_ptr<RenderableComponent> i_renderable);
 
 		inline std::shared_ptr<Context> context() const { return context_; }
 		inline std::shared_ptr<CameraComponent> camera() const { return camera_; }
+
+		//the effects, textures, meshes and materials shared by everything drawn with this context
+		inline std::shared_ptr<Assets> assets() const { return assets_; }
+		//the workers that record draw packets, which other systems may share.  Null if it couldn't be created.
+		inline std::shared_ptr<ThreadPool> thread_pool() const { return thread_pool_; }
+		//loads assets in the background, finishing a few of them each frame
+		inline std::shared_ptr<AssetLoader> asset_loader() const { return asset_loader_; }
+
+		//how far (in pixels) a mesh LOD may be from the full detail mesh on screen
+		inline float lod_error_pixels() const { return lod_error_pixels_; }
+		inline void lod_error_pixels(const float i_pixels) { lod_error_pixels_ = i_pixels; }
 		
 #ifdef ENABLE_DEBUG_RENDERING
 		bool EnableDebugDrawing(const size_t i_line_count);
@@ -55,11 +78,42 @@ namespace Lame
 		Debug::Menu* debug_menu() const { return debug_menu_.get(); }
 #endif
 	private:
-		Graphics() {}
+		Graphics() : lod_error_pixels_(1.0f) {}
+
+		//rasterizes the occluders in view into the occlusion buffer
+		void RasterizeOccluders(const Lame::Matrix4x4& i_worldToScreen);
+
+		//culls the renderables and records their draw packets into command_buffers_, split across the thread pool
+		void Record(const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen);
+
+		//replays packets [i_first, i_last) of frame_commands_, drawing each run that shares a mesh and material as one instanced draw
+		bool Submit(const size_t i_first, const size_t i_last, const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen);
+		bool SubmitInstanced(const size_t i_first, const size_t i_last);
 
 		std::shared_ptr<Context> context_;
+		std::shared_ptr<Assets> assets_;
 		std::vector<std::shared_ptr<RenderableComponent>> renderables_;
+
+		std::shared_ptr<ThreadPool> thread_pool_;
+		std::shared_ptr<AssetLoader> asset_loader_;		//after the thread pool, so it is destroyed first
+		std::vector<CommandBuffer> command_buffers_;		//one per thread pool slot
+		CommandBuffer frame_commands_;						//all the packets for this frame, in submission order
+
+		struct Occluder
+		{
+			std::vector<Lame::Vector3> positions;		//in world space
+			std::vector<uint32_t> indices;
+			Bounds bounds;
+		};
+		std::vector<Occluder> occluders_;
+		std::shared_ptr<OcclusionBuffer> occlusion_buffer_;
+
+		float lod_error_pixels_;
+
+		std::shared_ptr<InstanceBuffer> instance_buffer_;
+		std::vector<Instance> instances_;		//scratch list of the instance data for one group
 		std::vector<std::shared_ptr<Lame::Sprite>> sprites_;
+		std::shared_ptr<SpriteBatch> sprite_batch_;
 
 #ifdef ENABLE_DEBUG_RENDERING
 		std::shared_ptr<DebugRenderer> debug_renderer_;
@@ -0,0 +1,59 @@
+#ifndef _LAME_INSTANCEBUFFER_H
+#define _LAME_INSTANCEBUFFER_H
+
+#include <cstdint>
+#include <memory>
+
+#include "../Core/Color.h"
+#include "../Core/Matrix4x4.h"
+
+#if EAE6320_PLATFORM_D3D
+#include <d3d9.h>
+#endif
+
+namespace Lame
+{
+	class Context;
+
+	//Per-instance data streamed next to a mesh's vertices when drawing instanced.
+	// Must match the second stream of the instanced vertex format in Context::SetVertexFormat
+	struct Instance
+	{
+		Matrix4x4 local_to_world;
+		Color32 color;				//multiplied with the vertex colors
+	};
+
+	//Dynamic ring buffer of per-instance data, shared by all instanced draws in a frame
+	class InstanceBuffer
+	{
+	public:
+		static InstanceBuffer* Create(std::shared_ptr<Context> i_context, const size_t i_capacity);
+		~InstanceBuffer();
+
+		//appends the instances to the buffer, o_first_instance is the location they were written to
+		bool Write(const Instance* i_instances, const size_t i_count, size_t& o_first_instance);
+
+		//binds the instances starting at i_first_instance as the per-instance stream
+		bool Bind(const size_t i_first_instance) const;
+
+		inline size_t capacity() const { return capacity_; }
+		inline std::shared_ptr<Context> get_context() const { return context; }
+	private:
+		InstanceBuffer(std::shared_ptr<Context> i_context, const size_t i_capacity);
+
+		//Do not allow instance buffers to be managed without pointers
+		InstanceBuffer();
+		InstanceBuffer(const InstanceBuffer &i_other);
+		InstanceBuffer& operator=(const InstanceBuffer &i_other);
+
+		std::shared_ptr<Context> context;
+		size_t capacity_;
+		size_t write_position_;
+
+#if EAE6320_PLATFORM_D3D
+		IDirect3DVertexBuffer9 *vertex_buffer_;
+#endif
+	};
+}
+
+#endif //_LAME_INSTANCEBUFFER_H
@@ -1,123 +1,118 @@
 
+#include <cstring>
 #include <fstream>
 #include <sstream>
 
 #include "Material.h"
 #include "../System/FileLoader.h"
+#include "../System/MappedFile.h"
 #include "../System/UserOutput.h"
 #include "Texture.h"
+#include "Assets.h"
 
 #include "../System/Console.h"
 
 namespace Lame
 {
-	Material* Material::Create(std::shared_ptr<Lame::Context> i_context, std::string i_path)
+	Material* Material::Create(Assets& i_assets, const std::string& i_path)
 	{
-		size_t fileLength;
-		char *fileData = Lame::File::LoadBinary(i_path, &fileLength);
-		if (!fileData)
+		FileData data;
+		if (!Load(i_path, data))
 			return nullptr;
+		return Create(i_assets, data);
+	}
 
-		//load the effect
-		uint8_t *effectStringLength = reinterpret_cast<uint8_t*>(fileData);
-		char *effectLocation = reinterpret_cast<char*>(effectStringLength + 1);
-		std::shared_ptr<Effect> effect = std::shared_ptr<Effect>(Effect::Create(i_context, effectLocation));
-		if (!effect)
+	bool Material::Load(const std::string& i_path, FileData& o_data)
+	{
+		std::shared_ptr<Lame::File::MappedFile> file(Lame::File::MappedFile::Create(i_path));
+		if (!file)
+			return false;
+
+		//checking the header checks every offset in the file, so nothing after this has to
+		const Lame::File::MaterialHeader *header = Lame::File::FindMaterialHeader(file->data(), file->size());
+		if (!header)
 		{
-			delete[] fileData;
-			return nullptr;
+			std::stringstream error;
+			error << "Loaded data for material " << i_path << " is invalid";
+			Lame::UserOutput::Display(error.str(), "Material loading error");
+			return false;
 		}
+		o_data.path = i_path;
+		o_data.file = file;
+		o_data.header = header;
+		o_data.parameters = Lame::File::GetMaterialParameters(file->data(), *header);
+		return true;
+	}
+
+	Material* Material::Create(Assets& i_assets, const FileData& i_data)
+	{
+		const char *fileData = i_data.file->data();
+		const Lame::File::MaterialHeader& header = *i_data.header;
+		std::shared_ptr<Effect> effect = i_assets.effect(HashedString::FromHash(header.effect.hash), Lame::File::GetMaterialString(fileData, header.effect));
+		if (!effect)
+			return nullptr;
 
-		//setup the parameters
-		uint8_t *parameterCount = reinterpret_cast<uint8_t*>(effectLocation + *effectStringLength + 1);
-		Material::Parameter *params = nullptr;
-		char *currentParamName = nullptr;
-		size_t uniform_name_length = 0;
-		if (*parameterCount > 0)
+		//cache each parameter's handle, and share its texture
+		std::vector<std::shared_ptr<Texture>> textures;
+		std::vector<Material::Parameter> params(header.parameter_count);
+		for (size_t x = 0; x < params.size(); x++)
 		{
-			params = reinterpret_cast<Material::Parameter*>(parameterCount + 1);
-			currentParamName = reinterpret_cast<char*>(params + *parameterCount);
+			const Lame::File::MaterialParameter& fileParam = i_data.parameters[x];
+			Material::Parameter& param = params[x];
+			param.texture = nullptr;
+			param.shader_type = static_cast<Effect::Shader>(fileParam.shader);
+			memcpy(param.value, fileParam.value, sizeof(param.value));
+			param.valueCount = static_cast<uint8_t>(fileParam.value_count);
+
+			const char *name = Lame::File::GetMaterialString(fileData, fileParam.name);
+			if (!effect->CacheConstant(param.shader_type, name, param.handle))
+			{
+				std::stringstream error;
+				error << "Failed to cache uniform constant handle \"" << name << "\" in material "
+					<< i_data.path;
+				Lame::UserOutput::Display(error.str(), "Material loading error");
+				return nullptr;
+			}
 
-			//cache each parameter
-			for (size_t x = 0; x < *parameterCount; x++)
+			if (fileParam.texture.length > 0)
 			{
-#if EAE6320_PLATFORM_D3D
-				uniform_name_length = static_cast<size_t>(reinterpret_cast<uintptr_t>(std::get<0>(params[x].handle)));
-#elif EAE6320_PLATFORM_GL
-				uniform_name_length = static_cast<size_t>(params[x].handle);
-#else
-#error Platform must define a conversion from params[x].handle to uniform_name_length
-#endif
-				if (!effect->CacheConstant(params[x].shader_type, currentParamName, params[x].handle))
-				{
-					std::stringstream error;
-					error << "Failed to cache uniform constant handle \"" << currentParamName << "\" in material "
-						<< i_path;
-					Lame::UserOutput::Display(error.str(), "Material loading error");
-					delete[] fileData;
+				std::shared_ptr<Texture> texture = i_assets.texture(HashedString::FromHash(fileParam.texture.hash), Lame::File::GetMaterialString(fileData, fileParam.texture));
+				if (!texture)
 					return nullptr;
-				}
-
-				currentParamName = reinterpret_cast<char*>(currentParamName + uniform_name_length + 1);
-
-				//if we have a texture, then currentParamName now points to the texture name.
-				if (params[x].texture)
-				{
-					uniform_name_length = static_cast<size_t>(reinterpret_cast<uintptr_t>(params[x].texture));
-
-					params[x].texture = Texture::Create(i_context, currentParamName);
-					if (!params[x].texture)
-					{
-						delete[] fileData;
-						return nullptr;
-					}
-
-					//point at the next parameter name
-					currentParamName = reinterpret_cast<char*>(currentParamName + uniform_name_length + 1);
-				}
+				param.texture = texture.get();
+				textures.push_back(texture);
 			}
 		}
 
-		//if our data extends beyond the size of the file, fail
-		if (reinterpret_cast<void*>(parameterCount) > fileData + fileLength || 
-			reinterpret_cast<void*>(currentParamName) > fileData + fileLength)
-		{
-			std::stringstream error;
-			error << "Loaded data for material " << i_path << " is invalid";
-			Lame::UserOutput::Display(error.str(), "Material loading error");
-			delete[] fileData;
-			return nullptr;
-		}
-
 		Material *material = new Material(effect);
 		if (!material)
 		{
 			Lame::UserOutput::Display("Insufficient memory when creating Material", "Material creation error");
-			delete[] fileData;
 			return nullptr;
 		}
 
-		material->parameters_.assign(params, params + *parameterCount);
+		material->parameters_.swap(params);
+		material->textures_.swap(textures);
+		material->BuildConstantBlocks();
 
-		delete[] fileData;
 		return material;
 	}
 
 	Material::~Material()
 	{
-		for (size_t x = 0; x < parameters_.size(); x++)
-		{
-			if (parameters_[x].texture != nullptr)
-			{
-				delete parameters_[x].texture;
-				parameters_[x].texture = nullptr;
-			}
-		}
 	}
 
-	bool Material::Bind() const
+	bool Material::Bind(const bool i_instanced) const
 	{
-		bool success = effect()->Bind();
+		bool success = effect()->Bind(i_instanced);
+
+#if defined( LAME_EFFECT_CONSTANT_BLOCKS )
+		for (size_t x = 0; x < constant_blocks_.size(); x++)
+			success = success && effect()->SetConstantBlock(constant_blocks_[x]);
+		const bool setConstantsOneAtATime = constant_blocks_.empty();
+#else
+		const bool setConstantsOneAtATime = true;
+#endif
 
 		for (size_t x = 0; x < parameters_.size(); x++)
 		{
@@ -130,7 +125,7 @@ namespace Lame
 #endif
 					);
 			}
-			else
+			else if (setConstantsOneAtATime)
 			{
 				success = success && effect()->SetConstant(parameters_[x].shader_type,
 					parameters_[x].handle, parameters_[x].value, parameters_[x].valueCount);
@@ -140,22 +135,38 @@ namespace Lame
 		return success;
 	}
 
+	bool Material::supports_instancing() const
+	{
+		if (!effect()->supports_instancing())
+			return false;
 
-	bool Material::AddParameter(const std::string& i_param_name, const Effect::Shader i_shader_type, Texture* i_texture)
+		//vertex parameters are cached against the regular vertex shader, so they can't be set on the instanced one
+		for (size_t x = 0; x < parameters_.size(); x++)
+		{
+			if (parameters_[x].shader_type == Effect::Shader::Vertex)
+				return false;
+		}
+		return true;
+	}
+
+	bool Material::AddParameter(const std::string& i_param_name, const Effect::Shader i_shader_type, std::shared_ptr<Texture> i_texture)
 	{
 		if (!i_texture)
 			return false;
 
 		Parameter p;
-		p.texture = i_texture;
+		p.texture = i_texture.get();
 		p.shader_type = i_shader_type;
 
-		return AddParameter(i_param_name, p);
+		if (!AddParameter(i_param_name, p))
+			return false;
+		textures_.push_back(i_texture);
+		return true;
 	}
 
 	bool Material::AddParameter(const std::string& i_param_name, const Effect::Shader i_shader_type, const std::string& i_texture_path)
 	{
-		return AddParameter(i_param_name, i_shader_type, Lame::Texture::Create(effect()->get_context(), i_texture_path));
+		return AddParameter(i_param_name, i_shader_type, std::shared_ptr<Texture>(Lame::Texture::Create(effect()->get_context(), i_texture_path)));
 	}
 	
 	bool Material::AddParameter(const std::string& i_param_name, const Effect::Shader i_shader_type, const float* i_vals, const size_t i_vals_count)
@@ -180,7 +191,7 @@ namespace Lame
 
 	bool Material::AddParameter(const std::string& i_param_name, Parameter& i_param)
 	{
-		if (!effect()->CacheConstant(i_param.shader_type, i_param_name, i_param.handle))
+		if (!effect()->CacheConstant(i_param.shader_type, i_param_name.c_str(), i_param.handle))
 		{
 			std::stringstream error;
 			error << "Failed to cache uniform constant handle \"" << i_param_name << "\"";
@@ -200,6 +211,34 @@ namespace Lame
 		}
 
 		parameters_.push_back(i_param);
+		if (!i_param.texture)
+			BuildConstantBlocks();
 		return true;
 	}
+
+	void Material::BuildConstantBlocks()
+	{
+#if defined( LAME_EFFECT_CONSTANT_BLOCKS )
+		constant_blocks_.clear();
+		std::vector<Effect::ConstantBlock> blocks;
+		for (size_t x = 0; x < parameters_.size(); x++)
+		{
+			const Parameter& parameter = parameters_[x];
+			if (parameter.texture)
+				continue;
+
+			size_t block = 0;
+			while (block < blocks.size() && blocks[block].shader != parameter.shader_type)
+				block++;
+			if (block == blocks.size())
+			{
+				blocks.push_back(Effect::ConstantBlock());
+				blocks.back().shader = parameter.shader_type;
+			}
+			if (!effect()->AddToConstantBlock(parameter.handle, parameter.value, parameter.valueCount, blocks[block]))
+				return;
+		}
+		constant_blocks_.swap(blocks);
+#endif
+	}
 }
@@ -3,6 +3,7 @@
 
 #include <vector>
 #include <memory>
+#include <string>
 
 #include "../Core/HashedString.h"
 #include "Effect.h"
@@ -10,27 +11,53 @@
 namespace Lame
 {
 	class Texture;
+	class Assets;
+	namespace File
+	{
+		class MappedFile;
+		struct MaterialHeader;
+		struct MaterialParameter;
+	}
 
 	class Material
 	{
 	public:
 		struct Parameter
 		{
-			Texture *texture;
+			Texture *texture;				//owned by textures_
 			Effect::ConstantHandle handle;
 			float value[4];
 			Effect::Shader shader_type;
 			uint8_t valueCount;				//number of values to set
 		};
 
+		//A material binary file that has been mapped and checked, before its effect and textures are loaded.
+		// The header, parameters and strings are read in place from the file.
+		struct FileData
+		{
+			std::string path;
+			std::shared_ptr<File::MappedFile> file;
+			const File::MaterialHeader *header;
+			const File::MaterialParameter *parameters;
+		};
+
 		Material(const std::shared_ptr<Effect>& i_effect_) : effect_(i_effect_) {}
-		static Material* Create(std::shared_ptr<Lame::Context> i_context, std::string i_path);
+		//loads a material binary file, sharing its effect and textures through i_assets
+		static Material* Create(Assets& i_assets, const std::string& i_path);
+
+		//reads a material binary file without touching the device or i_assets, so it can run on any thread
+		static bool Load(const std::string& i_path, FileData& o_data);
+		//creates the material from a loaded file, on the context's thread
+		static Material* Create(Assets& i_assets, const FileData& i_data);
 
 		~Material();
 
-		bool Bind() const;
+		bool Bind(const bool i_instanced = false) const;
+
+		//can renderables using this material be drawn with the effect's instanced vertex shader
+		bool supports_instancing() const;
 
-		bool AddParameter(const std::string& i_param_name, const Effect::Shader i_shader_type, Texture* i_texture);
+		bool AddParameter(const std::string& i_param_name, const Effect::Shader i_shader_type, std::shared_ptr<Texture> i_texture);
 		bool AddParameter(const std::string& i_param_name, const Effect::Shader i_shader_type, const std::string& i_texture_path);
 		bool AddParameter(const std::string& i_param_name, const Effect::Shader i_shader_type, const float* i_vals, const size_t i_vals_count);
 		bool AddParameter(const std::string& i_param_name, const Effect::Shader i_shader_type, const float i_val);
@@ -40,8 +67,15 @@ namespace Lame
 	private:
 		bool AddParameter(const std::string& i_param_name, Parameter& i_param);
 
+		//packs the float parameters into a block for each shader, or leaves none if the effect can't pack all of them
+		void BuildConstantBlocks();
+
 		std::shared_ptr<Effect> effect_;
 		std::vector<Parameter> parameters_;
+#if defined( LAME_EFFECT_CONSTANT_BLOCKS )
+		std::vector<Effect::ConstantBlock> constant_blocks_;	//when empty, the float parameters are set one at a time
+#endif
+		std::vector<std::shared_ptr<Texture>> textures_;		//keeps the parameters' textures alive
 	};
 }
 
@@ -8,6 +8,7 @@
 #include <gl/GL.h>
 #include <gl/GLU.h>
 
+#include "../ConstantBlocks.h"
 #include "../../System/UserOutput.h"
 #include "../../../External/OpenGlExtensions/OpenGlExtensions.h"
 
@@ -16,6 +17,9 @@ namespace
 {
 	bool CreateRenderingContext(const HWND i_renderingWindow, HDC& o_deviceContext, HGLRC& o_openGlRenderingContext);
 	void CleanupContextData(const HWND i_renderingWindow, HDC i_deviceContext, HGLRC i_openGlRenderingContext);
+	bool CreateConstantsBuffer(const GLuint i_binding, const GLsizeiptr i_size, GLuint& o_buffer);
+	bool UpdateConstantsBuffer(const GLuint i_buffer, const void* i_constants, const GLsizeiptr i_size);
+	void DeleteConstantsBuffer(GLuint& io_buffer);
 }
 
 namespace Lame
@@ -35,7 +39,13 @@ namespace Lame
 				{
 					context->deviceContext = deviceContext;
 					context->openGlRenderingContext = openGlRenderingContext;
-					return context;
+					if (CreateConstantsBuffer(ConstantBinding::Frame, sizeof(FrameConstants), context->frameConstantsBuffer) &&
+						CreateConstantsBuffer(ConstantBinding::Object, sizeof(ObjectConstants), context->objectConstantsBuffer))
+						return context;
+
+					//the context's destructor cleans up everything it was given
+					delete context;
+					return nullptr;
 				}
 				else
 				{
@@ -54,6 +64,8 @@ namespace Lame
 
 	Context::~Context()
 	{
+		DeleteConstantsBuffer(frameConstantsBuffer);
+		DeleteConstantsBuffer(objectConstantsBuffer);
 		CleanupContextData(renderingWindow, deviceContext, openGlRenderingContext);
 	}
 
@@ -82,6 +94,23 @@ namespace Lame
 		return true;
 	}
 
+	bool Context::SupportsVertexFormat(const VertexFormat i_format) const
+	{
+		//compressed vertices are only set up for Direct3D, so they are decompressed when the mesh loads
+		return i_format == VertexFormat::Full;
+	}
+
+	//the buffers stay bound to their binding points, which every effect's blocks are bound to when it is created
+	bool Context::SetFrameConstants(const FrameConstants& i_constants)
+	{
+		return UpdateConstantsBuffer(frameConstantsBuffer, &i_constants, sizeof(i_constants));
+	}
+
+	bool Context::SetObjectConstants(const ObjectConstants& i_constants)
+	{
+		return UpdateConstantsBuffer(objectConstantsBuffer, &i_constants, sizeof(i_constants));
+	}
+
 	bool Context::EndFrame()
 	{
 		// Everything has been drawn to the "back buffer", which is just an image in memory.
@@ -194,4 +223,46 @@ namespace
 			ReleaseDC(i_renderingWindow, i_deviceContext);
 		}
 	}
+
+	bool CreateConstantsBuffer(const GLuint i_binding, const GLsizeiptr i_size, GLuint& o_buffer)
+	{
+		const GLsizei bufferCount = 1;
+		glGenBuffers(bufferCount, &o_buffer);
+		GLenum errorCode = glGetError();
+		if (errorCode == GL_NO_ERROR)
+		{
+			glBindBuffer(GL_UNIFORM_BUFFER, o_buffer);
+			//the data is set before it is drawn with, and changes at least once a frame
+			glBufferData(GL_UNIFORM_BUFFER, i_size, nullptr, GL_DYNAMIC_DRAW);
+			glBindBufferBase(GL_UNIFORM_BUFFER, i_binding, o_buffer);
+			errorCode = glGetError();
+		}
+		if (errorCode != GL_NO_ERROR)
+		{
+			std::stringstream errorMessage;
+			errorMessage << "OpenGL failed to create a uniform buffer for the shared constants: " <<
+				reinterpret_cast<const char*>(gluErrorString(errorCode));
+			Lame::UserOutput::Display(errorMessage.str());
+			return false;
+		}
+		return true;
+	}
+
+	bool UpdateConstantsBuffer(const GLuint i_buffer, const void* i_constants, const GLsizeiptr i_size)
+	{
+		glBindBuffer(GL_UNIFORM_BUFFER, i_buffer);
+		const GLintptr updateFromStart = 0;
+		glBufferSubData(GL_UNIFORM_BUFFER, updateFromStart, i_size, i_constants);
+		return glGetError() == GL_NO_ERROR;
+	}
+
+	void DeleteConstantsBuffer(GLuint& io_buffer)
+	{
+		if (io_buffer != 0)
+		{
+			const GLsizei bufferCount = 1;
+			glDeleteBuffers(bufferCount, &io_buffer);
+			io_buffer = 0;
+		}
+	}
 }
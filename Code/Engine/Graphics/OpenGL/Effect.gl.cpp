@@ -13,6 +13,7 @@
 #include <sstream>
 
 #include "../Texture.h"
+#include "../ConstantBlocks.h"
 #include "../../System/UserOutput.h"
 #include "../../../External/OpenGlExtensions/OpenGlExtensions.h"
 
@@ -22,6 +23,7 @@ namespace
 	bool LoadFragmentShader(std::string i_path, GLuint i_programId);
 	bool LoadVertexShader(std::string i_path, const GLuint i_programId);
 	bool CreateProgram(GLuint &o_programId, std::string i_vertex_path, std::string i_fragment_path);
+	bool BindConstantBlock(const GLuint i_programId, const char* i_block_name, const GLuint i_binding);
 
 	// This helper struct exists to be able to dynamically allocate memory to get "log info"
 	// which will automatically be freed when the struct goes out of scope
@@ -35,7 +37,7 @@ namespace
 
 namespace Lame
 {
-	Effect* Effect::Create(std::shared_ptr<Context> i_context, const char* i_vertex_path, const char* i_fragment_path, Lame::EnumMask<RenderState> i_renderMask, bool requiresLocalToWorld)
+	Effect* Effect::Create(std::shared_ptr<Context> i_context, const char* i_vertex_path, const char* i_fragment_path, Lame::EnumMask<RenderState> i_renderMask, const char* i_instanced_vertex_path)
 	{
 		// A vertex shader is a program that operates on vertices.
 		// Its input comes from a C/C++ "draw call" and is:
@@ -63,15 +65,10 @@ namespace Lame
 		{
 			effect->programId = programId;
 
-			//find the uniform handles
-			if (
-				(requiresLocalToWorld &&
-					!effect->CacheConstant(Shader::Vertex, LocalToWorldUniformName, effect->localToWorldUniformId)) ||
-				!effect->CacheConstant(Shader::Vertex, WorldToViewUniformName, effect->worldToViewUniformId) ||
-				!effect->CacheConstant(Shader::Vertex, ViewToScreenUniformName, effect->viewToScreenUniformId))
-
+			//the shared constants are read from the uniform buffers the context keeps bound (see ConstantBlocks.h)
+			if (!BindConstantBlock(programId, "FrameConstants", ConstantBinding::Frame) ||
+				!BindConstantBlock(programId, "ObjectConstants", ConstantBinding::Object))
 			{
-				Lame::UserOutput::Display("OpenGL failed to find all required uniform constants for effect.");
 				delete effect;
 				return nullptr;
 			}
@@ -83,7 +80,8 @@ namespace Lame
 		return effect;
 	}
 
-	bool Effect::Bind()
+	//there is no instanced vertex shader on OpenGL (see supports_instancing)
+	bool Effect::Bind(const bool i_instanced)
 	{
 		bool success = true;
 
@@ -149,9 +147,9 @@ namespace Lame
 		}
 	}
 
-	bool Effect::CacheConstant(const Shader &i_shader, const std::string &i_constant, ConstantHandle &o_constantId)
+	bool Effect::CacheConstant(const Shader &i_shader, const char *i_constant, ConstantHandle &o_constantId)
 	{
-		o_constantId = glGetUniformLocation(programId, i_constant.c_str());
+		o_constantId = glGetUniformLocation(programId, i_constant);
 		return o_constantId >= 0;
 	}
 
@@ -246,6 +244,25 @@ namespace Lame
 
 namespace
 {
+	//a shader that doesn't use a block has it optimized out, which isn't an error
+	bool BindConstantBlock(const GLuint i_programId, const char* i_block_name, const GLuint i_binding)
+	{
+		const GLuint blockIndex = glGetUniformBlockIndex(i_programId, i_block_name);
+		if (blockIndex != GL_INVALID_INDEX)
+			glUniformBlockBinding(i_programId, blockIndex, i_binding);
+
+		const GLenum errorCode = glGetError();
+		if (errorCode != GL_NO_ERROR)
+		{
+			std::stringstream errorMessage;
+			errorMessage << "OpenGL failed to bind the program's " << i_block_name << " uniform block: " <<
+				reinterpret_cast<const char*>(gluErrorString(errorCode));
+			Lame::UserOutput::Display(errorMessage.str());
+			return false;
+		}
+		return true;
+	}
+
 	bool CreateProgram(GLuint &o_programId, std::string i_vertex_path, std::string i_fragment_path)
 	{
 		// Create a program
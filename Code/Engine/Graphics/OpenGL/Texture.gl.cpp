@@ -6,6 +6,7 @@
 
 #include <sstream>
 #include <algorithm>
+#include <vector>
 #include <cassert>
 #include <gl/GL.h>
 #include <gl/GLU.h>
@@ -47,6 +48,51 @@ namespace Lame
 		}
 	}
 
+	Texture* Texture::Create(std::shared_ptr<Context> i_context, const File::MappedFile&, const std::string& i_path)
+	{
+		//the DDS loader reads the file itself, which is already in memory
+		return Create(i_context, i_path);
+	}
+
+	Texture* Texture::Create(std::shared_ptr<Context> i_context, const size_t i_width, const size_t i_height, const uint8_t* i_alpha)
+	{
+		if (!i_context || !i_alpha || i_width == 0 || i_height == 0)
+			return nullptr;
+
+		std::vector<uint8_t> pixels(i_width * i_height * 4, 255);
+		for (size_t x = 0; x < i_width * i_height; x++)
+			pixels[x * 4 + 3] = i_alpha[x];
+
+		GLuint texture_id;
+		glGenTextures(1, &texture_id);
+		glBindTexture(GL_TEXTURE_2D, texture_id);
+		//there are no MIP maps, so the default minifying filter would leave the texture incomplete
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+		glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA, static_cast<GLsizei>(i_width), static_cast<GLsizei>(i_height), 0, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		const GLenum errorCode = glGetError();
+		if (errorCode != GL_NO_ERROR)
+		{
+			std::stringstream error;
+			error << "OpenGL failed to create a texture: " << reinterpret_cast<const char*>(gluErrorString(errorCode));
+			Lame::UserOutput::Display(error.str(), "OpenGL Texture Load Error");
+			glDeleteTextures(1, &texture_id);
+			return nullptr;
+		}
+
+		Texture *texture = new Texture();
+		if (!texture)
+		{
+			glDeleteTextures(1, &texture_id);
+			Lame::UserOutput::Display("Insufficient memory to create texture", "Texture Load Error");
+			return nullptr;
+		}
+		texture->texture_id_ = texture_id;
+		texture->width_ = i_width;
+		texture->height_ = i_height;
+		return texture;
+	}
+
 	Texture::~Texture()
 	{
 		if(texture_id_ > 0)
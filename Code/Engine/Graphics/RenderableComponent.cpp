@@ -1,42 +1,29 @@
 
 #include "RenderableComponent.h"
 
+#include <algorithm>
+
 #include "Context.h"
+#include "ConstantBlocks.h"
+#include "InstanceBuffer.h"
 #include "../Core/Math.h"
+#include "../Core/Frustum.h"
 #include "../System/UserOutput.h"
 
 namespace Lame
 {
-	char const * const RenderableComponent::LocalToWorldUniformName = "local_to_world";
-	char const * const RenderableComponent::WorldToViewUniformName = "world_to_view";
-	char const * const RenderableComponent::ViewToScreenUniformName = "view_to_screen";
-
 	RenderableComponent* RenderableComponent::Create(std::weak_ptr<Lame::GameObject> go, std::shared_ptr<RenderableMesh> i_mesh, std::shared_ptr<Material> i_material)
 	{
 		if (go.expired() || !i_mesh || !i_material)
 			return nullptr;
 
-		Effect::ConstantHandle localToWorldUniformId;
-		Effect::ConstantHandle worldToViewUniformId;
-		Effect::ConstantHandle viewToScreenUniformId;
-
-		if (!i_material->effect()->CacheConstant(Effect::Shader::Vertex, LocalToWorldUniformName, localToWorldUniformId) ||
-			!i_material->effect()->CacheConstant(Effect::Shader::Vertex, WorldToViewUniformName, worldToViewUniformId) ||
-			!i_material->effect()->CacheConstant(Effect::Shader::Vertex, ViewToScreenUniformName, viewToScreenUniformId) )
-		{
-			Lame::UserOutput::Display("Failed to find all required uniform constants for RenderableComponent.");
-			return nullptr;
-		}
-
+		//the matrices are in the constant blocks every shader shares, so there are no uniforms to look up
 		RenderableComponent* comp = new RenderableComponent(go);
 		if (!comp)
 			return nullptr;
 
 		comp->mesh_ = i_mesh;
 		comp->material_ = i_material;
-		comp->localToWorldUniformId = localToWorldUniformId;
-		comp->worldToViewUniformId = worldToViewUniformId;
-		comp->viewToScreenUniformId = viewToScreenUniformId;
 		return comp;
 	}
 
@@ -49,28 +36,77 @@ namespace Lame
 			if (!go->enabled() || !enabled())
 				return true;
 
-			return material()->Bind() &&							// try to bind the effect
-				SetLocalToWorld(go->transform().LocalToWorld()) &&
-				SetWorldToView(i_worldToView) &&
-				SetViewToScreen(i_viewToScreen) &&
-				mesh()->Draw();									// try to draw the mesh
+			FrameConstants frame;
+			frame.world_to_view = i_worldToView;
+			frame.view_to_screen = i_viewToScreen;
+			return material()->effect()->get_context()->SetFrameConstants(frame) &&
+				Render(go->transform().LocalToWorld(), i_worldToView, i_viewToScreen);
 		}
 		else
 			return false;
 	}
-	
-	bool RenderableComponent::SetLocalToWorld(const Lame::Matrix4x4& i_matrix) const
+
+	bool RenderableComponent::Render(const Lame::Matrix4x4& i_localToWorld, const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen, const size_t i_lod) const
 	{
-		return material()->effect()->SetConstant(Effect::Shader::Vertex, localToWorldUniformId, i_matrix);
+		//compressed meshes decode their positions as part of local_to_world
+		const bool decodePositions = mesh()->vertex_format() == VertexFormat::Compressed;
+		if (!material()->Bind() ||							// try to bind the effect
+			!SetLocalToWorld(decodePositions ? i_localToWorld * mesh()->position_decode() : i_localToWorld))
+			return false;
+
+		//clusters are only built for the full detail triangles
+		if (i_lod > 0 || mesh()->clusters().empty())
+			return mesh()->Draw(0, i_lod);					// try to draw the mesh
+
+		//cull the clusters in local space, so they don't have to be transformed.  A mirroring transform flips which side is the front.
+		const Lame::Matrix4x4 localToView = i_worldToView * i_localToWorld;
+		const Frustum localFrustum(i_viewToScreen * localToView);
+		const Vector3 localEye = localToView.Inverse().Multiply(Vector3::zero);
+		const bool cullBackFaces = material()->effect()->has_face_cull() && i_localToWorld.Determinant() > 0.0f;
+		return mesh()->DrawClusters(localFrustum, localEye, cullBackFaces);
 	}
 
-	bool RenderableComponent::SetWorldToView(const Lame::Matrix4x4& i_matrix) const
+	bool RenderableComponent::RenderInstanced(const InstanceBuffer& i_instances, const size_t i_first_instance, const size_t i_instance_count, const size_t i_lod) const
 	{
-		return material()->effect()->SetConstant(Effect::Shader::Vertex, worldToViewUniformId, i_matrix);
+		if (!supports_instancing())
+			return false;
+
+		return material()->Bind(true) &&
+			mesh()->DrawInstanced(i_instances, i_first_instance, i_instance_count, i_lod);
 	}
 
-	bool RenderableComponent::SetViewToScreen(const Lame::Matrix4x4& i_matrix) const
+	size_t RenderableComponent::SelectLod(const float i_pixels_per_unit, const float i_max_error_pixels) const
+	{
+		//the fraction of the error limit a coarser LOD has to be under before switching to it
+		const float coarserThreshold = 0.75f;
+
+		const RenderableMesh& renderMesh = *mesh();
+		size_t lod = std::min(lod_, renderMesh.lod_count() - 1);
+		while (lod > 0 && renderMesh.lod_error(lod) * i_pixels_per_unit > i_max_error_pixels)
+			--lod;
+		while (lod + 1 < renderMesh.lod_count() && renderMesh.lod_error(lod + 1) * i_pixels_per_unit <= i_max_error_pixels * coarserThreshold)
+			++lod;
+		lod_ = lod;
+		return lod;
+	}
+
+	bool RenderableComponent::supports_instancing() const
+	{
+		return material()->supports_instancing() && mesh()->get_index_count() > 0;
+	}
+
+	Bounds RenderableComponent::world_bounds() const
+	{
+		std::shared_ptr<Lame::GameObject> go = gameObject();
+		if (!go)
+			return Bounds();
+		return mesh()->bounds().Transformed(go->transform().LocalToWorld());
+	}
+	
+	bool RenderableComponent::SetLocalToWorld(const Lame::Matrix4x4& i_matrix) const
 	{
-		return material()->effect()->SetConstant(Effect::Shader::Vertex, viewToScreenUniformId, i_matrix);
+		ObjectConstants object;
+		object.local_to_world = i_matrix;
+		return material()->effect()->get_context()->SetObjectConstants(object);
 	}
 }
@@ -8,34 +8,48 @@
 
 namespace Lame
 {
+	class InstanceBuffer;
+
 	class RenderableComponent : public Lame::IComponent
 	{
 		ADD_TYPEID()
 	public: 		
 		static RenderableComponent* Create(std::weak_ptr<Lame::GameObject> go, std::shared_ptr<RenderableMesh> i_mesh, std::shared_ptr<Material> i_material);
 
+		//sets the frame constants to the camera's matrices and renders
 		bool Render(const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen) const;
+		//renders with the frame constants that are already set, the camera's matrices are only used to cull clusters
+		bool Render(const Lame::Matrix4x4& i_localToWorld, const Lame::Matrix4x4& i_worldToView, const Lame::Matrix4x4& i_viewToScreen, const size_t i_lod = 0) const;
+
+		//Render i_instance_count copies of this component's mesh and material, with their local_to_world read from i_instances.
+		// The frame constants must already be set.
+		bool RenderInstanced(const InstanceBuffer& i_instances, const size_t i_first_instance, const size_t i_instance_count, const size_t i_lod = 0) const;
+
+		//Picks the coarsest LOD of the mesh whose error stays under i_max_error_pixels on screen, where i_pixels_per_unit is
+		// the size of one local unit on screen.  A coarser LOD is only taken once it is comfortably under the limit,
+		// so objects near a switching distance don't flicker between LODs.  Only one thread may update a component at a time.
+		size_t SelectLod(const float i_pixels_per_unit, const float i_max_error_pixels) const;
+		inline size_t lod() const { return lod_; }
 
+		//can this component be drawn in an instanced group
+		bool supports_instancing() const;
+
+		//world space bounds of the mesh, invalid if the mesh has no bounds
+		Bounds world_bounds() const;
+
+		//sets the object constants
 		bool SetLocalToWorld(const Lame::Matrix4x4& i_matrix) const;
-		bool SetWorldToView(const Lame::Matrix4x4& i_matrix) const;
-		bool SetViewToScreen(const Lame::Matrix4x4& i_matrix) const;
 
 		inline std::shared_ptr<RenderableMesh> mesh() const { return mesh_; }
 		inline std::shared_ptr<Material> material() const { return material_; }
 	private:
 		RenderableComponent();
-		RenderableComponent(std::weak_ptr<Lame::GameObject> go) : IComponent(go) { }
+		RenderableComponent(std::weak_ptr<Lame::GameObject> go) : IComponent(go), lod_(0) { }
 
 		std::shared_ptr<RenderableMesh> mesh_;
 		std::shared_ptr<Material> material_;
 
-		Effect::ConstantHandle localToWorldUniformId;
-		Effect::ConstantHandle worldToViewUniformId;
-		Effect::ConstantHandle viewToScreenUniformId;
-
-		static char const * const LocalToWorldUniformName;
-		static char const * const WorldToViewUniformName;
-		static char const * const ViewToScreenUniformName;
+		mutable size_t lod_;		//the LOD drawn last frame
 	};
 }
 
@@ -5,11 +5,14 @@
 #include <fstream>
 #include <functional>
 #include <string>
+#include <algorithm>
 
 #include "RenderableMesh.h"
 #include "../System/UserOutput.h"
 #include "../System/Console.h"
 #include "../System/FileLoader.h"
+#include "../System/MappedFile.h"
+#include "Context.h"
 
 #include "../Core/Vector2.h"
 #include "../Core/Vector3.h"
@@ -27,27 +30,114 @@ namespace Lame
 
 	RenderableMesh* RenderableMesh::Create(const bool i_static, std::shared_ptr<Context> i_context, const std::string& i_mesh_path)
 	{
-		uint32_t vertex_count;
-		uint32_t index_count;
-		Vertex *vertices;
-		uint32_t *indices;
-		char *fileData = File::LoadMeshData(i_mesh_path, vertex_count, index_count, vertices, indices);
-		if (!fileData)
+		FileData data;
+		if (!i_context || !Load(i_mesh_path, !i_context->SupportsVertexFormat(VertexFormat::Compressed), data))
 			return nullptr;
+		return Create(i_static, i_context, data);
+	}
 
-		//create the mesh
-		RenderableMesh *mesh = nullptr;
-#if EAE6320_PLATFORM_D3D
-		mesh = CreateLeftHandedTriList(i_static, i_context, vertices, vertex_count, indices, index_count);
-#elif EAE6320_PLATFORM_GL
-		mesh = CreateRightHandedTriList(i_static, i_context, vertices, *vertex_count, indices, *index_count);
-#else
-#error No Creation function for renderable meshes loaded from file
-#endif
+	bool RenderableMesh::Load(const std::string& i_mesh_path, const bool i_decompress, FileData& o_data)
+	{
+		//the vertices and indices are copied straight from the mapped file into the buffers
+		std::shared_ptr<File::MappedFile> file(File::MappedFile::Create(i_mesh_path));
+		if (!file)
+			return false;
+		const char *fileData = file->data();
 
-		//cleanup the loaded file
-		delete[] fileData;
+		//the header says how the vertices and indices were written, and has already checked that every table fits the data
+		const File::MeshHeader *header = File::FindMeshHeader(fileData, file->size());
+		const bool compressed = header && header->vertex_format == static_cast<uint32_t>(VertexFormat::Compressed);
+		if (!header || header->vertex_size != (compressed ? sizeof(CompressedVertex) : sizeof(Vertex)) ||
+			(!compressed && header->vertex_format != static_cast<uint32_t>(VertexFormat::Full)))
+		{
+			std::stringstream error;
+			error << i_mesh_path << " is not a valid mesh binary file";
+			Lame::UserOutput::Display(error.str());
+			return false;
+		}
+		o_data.path = i_mesh_path;
+		o_data.file = file;
+		o_data.index_size = header->index_size;
+		o_data.vertex_count = header->vertices.count;
+		o_data.index_count = header->indices.count;
+		o_data.vertices = fileData + header->vertices.offset;
+		o_data.indices = fileData + header->indices.offset;
+		o_data.bounds = Bounds(Vector3(header->bounds_min[0], header->bounds_min[1], header->bounds_min[2]),
+			Vector3(header->bounds_max[0], header->bounds_max[1], header->bounds_max[2]));
+
+		//the lower LODs' indices follow the full detail ones, so the index buffer holds all of them
+		o_data.lods.clear();
+		const File::MeshLod *fileLods = File::GetMeshBlock<File::MeshLod>(fileData, header->lods);
+		for (uint32_t x = 0; x < header->lods.count; x++)
+		{
+			Lod lod;
+			lod.first_index = fileLods[x].first_index;
+			lod.index_count = fileLods[x].index_count;
+			lod.error = fileLods[x].error;
+			o_data.lods.push_back(lod);
+		}
+		const MeshCluster *fileClusters = File::GetMeshBlock<MeshCluster>(fileData, header->clusters);
+		o_data.clusters.assign(fileClusters, fileClusters + header->clusters.count);
+		const File::MeshSection *fileSections = File::GetMeshBlock<File::MeshSection>(fileData, header->sections);
+		o_data.sections.clear();
+		for (uint32_t x = 0; x < header->sections.count; x++)
+		{
+			Section section;
+			section.first_index = fileSections[x].first_index;
+			section.index_count = fileSections[x].index_count;
+			section.base_vertex = fileSections[x].base_vertex;
+			section.vertex_count = fileSections[x].vertex_count;
+			o_data.sections.push_back(section);
+		}
+
+		//devices that can't read the compressed layout get the vertices decompressed, without their tangent frames
+		o_data.vertex_format = compressed ? VertexFormat::Compressed : VertexFormat::Full;
+		o_data.position_decode = Matrix4x4::identity;
+		o_data.decompressed.clear();
+		if (compressed)
+		{
+			const Vector3 positionOffset(header->position_offset[0], header->position_offset[1], header->position_offset[2]);
+			const Vector3 positionScale(header->position_scale[0], header->position_scale[1], header->position_scale[2]);
+			if (i_decompress)
+			{
+				o_data.decompressed.resize(o_data.vertex_count);
+				VertexCompression::Decompress(static_cast<const CompressedVertex*>(o_data.vertices), o_data.vertex_count, positionOffset, positionScale, o_data.decompressed.data());
+				o_data.vertex_format = VertexFormat::Full;
+			}
+			else
+			{
+				o_data.position_decode = Matrix4x4::CreateTranslation(positionOffset) * Matrix4x4::CreateScale(positionScale);
+			}
+		}
+		return true;
+	}
 
+	RenderableMesh* RenderableMesh::Create(const bool i_static, std::shared_ptr<Context> i_context, const FileData& i_data)
+	{
+		const void *vertices = i_data.decompressed.empty() ? i_data.vertices : i_data.decompressed.data();
+
+		//the file's indices are already wound the way this platform expects
+		RenderableMesh *mesh = CreateEmpty(i_static, i_context, Mesh::PrimitiveType::TriangleList, i_data.vertex_count, i_data.index_count, i_data.vertex_format, i_data.index_size);
+		if (!mesh)
+			return nullptr;
+
+		const bool copied = (i_data.vertex_format == VertexFormat::Compressed ?
+				mesh->UpdateVertices(static_cast<const CompressedVertex*>(vertices)) :
+				mesh->UpdateVertices(static_cast<const Vertex*>(vertices))) &&
+			(i_data.index_count == 0 || (i_data.index_size == sizeof(uint16_t) ?
+				mesh->UpdateIndices(static_cast<const uint16_t*>(i_data.indices)) :
+				mesh->UpdateIndices(static_cast<const uint32_t*>(i_data.indices))));
+		if (!copied || !mesh->lods(i_data.lods) || !mesh->clusters(i_data.clusters) || !mesh->sections(i_data.sections))
+		{
+			std::stringstream error;
+			error << "Failed to copy the data of " << i_data.path << " to the mesh";
+			Lame::UserOutput::Display(error.str());
+			delete mesh;
+			return nullptr;
+		}
+
+		mesh->position_decode_ = i_data.position_decode;
+		mesh->bounds(i_data.bounds);
 		return mesh;
 	}
 
@@ -62,11 +152,79 @@ namespace Lame
 			delete rm;
 			return nullptr;
 		}
+		rm->bounds(Bounds::Create(i_mesh.vertices_RO().data(), i_mesh.vertices_RO().size()));
 		return rm;
 	}
 
+	size_t RenderableMesh::vertex_size() const
+	{
+		return vertex_format_ == VertexFormat::Compressed ? sizeof(CompressedVertex) : sizeof(Vertex);
+	}
+
 	size_t RenderableMesh::primitive_count() const
 	{
-		return Lame::Mesh::GetPrimitiveCount(primitive_type(), index_count_ > 0 ? index_count_ : vertex_count_);
+		return primitive_count(0);
+	}
+
+	size_t RenderableMesh::primitive_count(const size_t i_lod) const
+	{
+		size_t firstIndex, indexCount;
+		GetLodRange(i_lod, firstIndex, indexCount);
+		return Lame::Mesh::GetPrimitiveCount(primitive_type(), indexCount);
+	}
+
+	bool RenderableMesh::lods(const std::vector<Lod>& i_lods)
+	{
+		for (size_t x = 0; x < i_lods.size(); x++)
+		{
+			if (i_lods[x].first_index + i_lods[x].index_count > index_count_)
+				return false;
+		}
+		lods_ = i_lods;
+		return true;
+	}
+
+	bool RenderableMesh::clusters(const std::vector<MeshCluster>& i_clusters)
+	{
+		size_t firstIndex, indexCount;
+		GetLodRange(0, firstIndex, indexCount);
+		size_t nextIndex = firstIndex;
+		for (size_t x = 0; x < i_clusters.size(); x++)
+		{
+			if (i_clusters[x].first_index < nextIndex || i_clusters[x].first_index + i_clusters[x].index_count > firstIndex + indexCount)
+				return false;
+			nextIndex = i_clusters[x].first_index + i_clusters[x].index_count;
+		}
+		clusters_ = i_clusters;
+		return true;
+	}
+
+	bool RenderableMesh::sections(const std::vector<Section>& i_sections)
+	{
+		size_t nextIndex = 0;
+		for (size_t x = 0; x < i_sections.size(); x++)
+		{
+			if (i_sections[x].first_index < nextIndex || i_sections[x].first_index + i_sections[x].index_count > index_count_ ||
+				i_sections[x].base_vertex + i_sections[x].vertex_count > vertex_count_)
+				return false;
+			nextIndex = i_sections[x].first_index + i_sections[x].index_count;
+		}
+		sections_ = i_sections;
+		return true;
+	}
+
+	void RenderableMesh::GetLodRange(const size_t i_lod, size_t& o_first_index, size_t& o_index_count) const
+	{
+		if (lods_.empty())
+		{
+			o_first_index = 0;
+			o_index_count = index_count_ > 0 ? index_count_ : vertex_count_;
+		}
+		else
+		{
+			const Lod& lod = lods_[i_lod < lods_.size() ? i_lod : lods_.size() - 1];
+			o_first_index = lod.first_index;
+			o_index_count = lod.index_count;
+		}
 	}
 }
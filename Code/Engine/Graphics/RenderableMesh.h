@@ -4,9 +4,15 @@
 #include <cstdint>
 #include <string>
 #include <memory>
+#include <vector>
 
 #include "../Core/Color.h"
 #include "../Core/Mesh.h"
+#include "../Core/Bounds.h"
+#include "../Core/MeshCluster.h"
+#include "../Core/Matrix4x4.h"
+#include "../Core/CompressedVertex.h"
+#include "../Core/Vertex.h"
 
 #if EAE6320_PLATFORM_D3D
 #include <d3d9.h>
@@ -19,17 +25,25 @@ namespace Lame
 {
 	class Vector2;
 	class Vector3;
+	class Frustum;
 }
 
 namespace Lame
 {
-	struct Vertex;
 	class Context;
+	class InstanceBuffer;
+
+	namespace File
+	{
+		class MappedFile;
+	}
 
 	class RenderableMesh
 	{
 	public:
-		static RenderableMesh* CreateEmpty(const bool i_static, std::shared_ptr<Context> i_context, Mesh::PrimitiveType i_prim_type, const size_t i_vertex_count, const size_t i_index_count);
+		//i_index_size is 2 for 16 bit indices, or 4 for 32 bit ones
+		static RenderableMesh* CreateEmpty(const bool i_static, std::shared_ptr<Context> i_context, Mesh::PrimitiveType i_prim_type, const size_t i_vertex_count, const size_t i_index_count,
+			const VertexFormat i_format = VertexFormat::Full, const size_t i_index_size = sizeof(uint32_t));
 
 		//load a mesh with defined data
 		static RenderableMesh* CreateRightHandedTriList(const bool i_static, std::shared_ptr<Context> i_context, Vertex *i_vertices, size_t i_vertex_count, uint32_t *i_indices = nullptr, size_t i_index_count = 0);
@@ -38,21 +52,109 @@ namespace Lame
 		//load a mesh from the mesh binary file
 		static RenderableMesh* Create(const bool i_static, std::shared_ptr<Context> i_context, const std::string& i_mesh_path);
 
+		struct FileData;
+
+		//Reads and checks a mesh binary file without touching the device, so it can run on any thread.  i_decompress is for contexts
+		// that can't read compressed vertices (see Context::SupportsVertexFormat).
+		static bool Load(const std::string& i_mesh_path, const bool i_decompress, FileData& o_data);
+		//creates the mesh from a loaded file, on the context's thread
+		static RenderableMesh* Create(const bool i_static, std::shared_ptr<Context> i_context, const FileData& i_data);
+
 		static RenderableMesh* Create(const bool i_static, std::shared_ptr<Context> i_context, const Mesh& i_mesh);
 
 		~RenderableMesh();
 
+		//A simplified copy of the mesh, drawn from a range of the index buffer.  Every LOD uses the same vertices.
+		struct Lod
+		{
+			size_t first_index;
+			size_t index_count;
+			float error;		//how far (in local units) this LOD's surface may be from the full detail mesh
+		};
+
+		//A run of the index buffer whose indices are relative to base_vertex, so meshes with more vertices than
+		// 16 bit indices can reach can still use them.  LODs and clusters never straddle two sections.
+		struct Section
+		{
+			size_t first_index;
+			size_t index_count;
+			size_t base_vertex;
+			size_t vertex_count;
+		};
+
+		//A mesh binary file that has been loaded, ready to be copied into a mesh's buffers
+		struct FileData
+		{
+			std::string path;
+			std::shared_ptr<File::MappedFile> file;		//the vertices and indices point into it
+			const void *vertices;
+			const void *indices;
+			size_t vertex_count;
+			size_t index_count;
+			size_t index_size;
+			VertexFormat vertex_format;
+			Matrix4x4 position_decode;
+			Bounds bounds;
+			std::vector<Lod> lods;
+			std::vector<MeshCluster> clusters;
+			std::vector<Section> sections;
+			std::vector<Vertex> decompressed;			//the vertices, when they had to be decompressed
+		};
+
 		//Render this mesh, with an optional max number of primitives (0 will render full buffer)
-		bool Draw(const size_t i_max_primitives = 0) const;
+		bool Draw(const size_t i_max_primitives = 0, const size_t i_lod = 0) const;
+
+		//Render i_instance_count copies of this mesh in one draw, reading per-instance data from i_instances
+		// starting at i_first_instance.  Only indexed meshes can be drawn instanced.
+		bool DrawInstanced(const InstanceBuffer& i_instances, const size_t i_first_instance, const size_t i_instance_count, const size_t i_lod = 0) const;
+
+		//Render the full detail mesh one cluster at a time, skipping clusters outside i_local_frustum and (when i_cull_back_faces)
+		// clusters facing away from i_local_eye.  Both are in the mesh's local space.  Neighbouring visible clusters share a draw.
+		bool DrawClusters(const Frustum& i_local_frustum, const Vector3& i_local_eye, const bool i_cull_back_faces) const;
 
 		//copies the vertices/indices to the mesh data (0 amount will copy the full buffer length)
 		bool UpdateVertices(const Vertex* i_vertices, const size_t i_amount = 0);
+		bool UpdateVertices(const CompressedVertex* i_vertices, const size_t i_amount = 0);
 		bool UpdateIndices(const uint32_t* i_indices, const size_t i_amount = 0);
+		bool UpdateIndices(const uint16_t* i_indices, const size_t i_amount = 0);
+
+		//appends vertices to a dynamic mesh behind the ones already written, so the GPU never waits on data it is still drawing.
+		// The buffer is only discarded when it wraps around.  o_first_vertex is where the vertices were written.
+		bool StreamVertices(const Vertex* i_vertices, const size_t i_count, size_t& o_first_vertex);
+
+		//Render i_primitive_count primitives of an unindexed mesh, starting at i_first_vertex
+		bool DrawRange(const size_t i_first_vertex, const size_t i_primitive_count) const;
 
 		inline Mesh::PrimitiveType primitive_type() const { return primitive_type_; }
 		inline void primitive_type(const Mesh::PrimitiveType i_prim) { primitive_type_ = i_prim; }
 		size_t primitive_count() const;
+		size_t primitive_count(const size_t i_lod) const;
+
+		//without any LODs the mesh has a single level, the whole index buffer
+		inline size_t lod_count() const { return lods_.empty() ? 1 : lods_.size(); }
+		inline float lod_error(const size_t i_lod) const { return i_lod < lods_.size() ? lods_[i_lod].error : 0.0f; }
+		inline const std::vector<Lod>& lods() const { return lods_; }
+		bool lods(const std::vector<Lod>& i_lods);
+
+		//clusters of the full detail triangles, which must be in index order within LOD 0's range
+		inline const std::vector<MeshCluster>& clusters() const { return clusters_; }
+		bool clusters(const std::vector<MeshCluster>& i_clusters);
+
+		//without any sections the whole index buffer is relative to the first vertex
+		inline const std::vector<Section>& sections() const { return sections_; }
+		bool sections(const std::vector<Section>& i_sections);
+		inline size_t index_size() const { return index_size_; }
 		
+		//local space bounds of the vertices, invalid (never culled) for meshes that are rewritten every frame
+		inline const Bounds& bounds() const { return bounds_; }
+		inline void bounds(const Bounds& i_bounds) { bounds_ = i_bounds; }
+
+		//compressed meshes hold quantized positions, which this turns back into local positions.  It must be applied to
+		// local_to_world (as local_to_world * position_decode) whenever the mesh is drawn.
+		inline VertexFormat vertex_format() const { return vertex_format_; }
+		inline const Matrix4x4& position_decode() const { return position_decode_; }
+		size_t vertex_size() const;
+
 		inline size_t get_vertex_count() const { return vertex_count_; }
 		inline size_t get_index_count() const { return index_count_; }
 		inline std::shared_ptr<Context> get_context() const { return context; }
@@ -69,17 +171,32 @@ namespace Lame
 		//Swaps the order of indices (between right and left handed-ness) without error checking
 		static void SwapIndexOrder(uint32_t *i_indices, size_t i_index_count);
 
+		//the index range to draw for a LOD
+		void GetLodRange(const size_t i_lod, size_t& o_first_index, size_t& o_index_count) const;
+
+		//draws a range of the index buffer (once per instance) with one draw for each section it covers, once the streams are bound
+		bool DrawIndexRange(const size_t i_first_index, const size_t i_index_count, const size_t i_instance_count = 1) const;
+
 #if EAE6320_PLATFORM_D3D
 		IDirect3DVertexBuffer9 *vertex_buffer_;
 		IDirect3DIndexBuffer9 *index_buffer_;
 		IDirect3DVertexDeclaration9 *vertex_declaration_;
+		IDirect3DVertexDeclaration9 *instanced_vertex_declaration_;
 #elif EAE6320_PLATFORM_GL
 		GLuint vertex_array_id_;
 #endif
 
 		Mesh::PrimitiveType primitive_type_;
+		VertexFormat vertex_format_;
+		Matrix4x4 position_decode_;
+		Bounds bounds_;
+		std::vector<Lod> lods_;
+		std::vector<MeshCluster> clusters_;
+		std::vector<Section> sections_;
 		size_t vertex_count_;		//the number of vertices stored in this mesh
 		size_t index_count_;		//the number of indices stored in this mesh
+		size_t index_size_;			//bytes per index
+		size_t stream_position_;	//where StreamVertices writes next
 	};
 }
 
@@ -11,22 +11,24 @@
 namespace Lame
 {
 	class Texture;
-	class RenderableMesh;
 
+	//A textured screen space quad.  Sprites are drawn together by a SpriteBatch, so they only hold their vertices.
 	class Sprite
 	{
 	public:
 		static Sprite* Create(std::shared_ptr<Effect> i_effect, std::shared_ptr<Lame::Texture> i_texture, const Lame::Vector2& i_screen_pos_normalized, const float i_height_normalized, const Lame::Rectangle2D& i_texture_coords);
 		static Sprite* Create(std::shared_ptr<Effect> i_effect, std::shared_ptr<Lame::Texture> i_texture, const Lame::Rectangle2D& i_screen_coords, const Lame::Rectangle2D& i_texture_coords);
 
-		bool Render();
-
 		inline std::shared_ptr<Effect> effect() const { return effect_; }
 		inline std::shared_ptr<Texture> texture() const { return texture_; }
-		inline std::shared_ptr<RenderableMesh> mesh() const { return mesh_; }
+		inline const Effect::ConstantHandle& texture_uniform() const { return texture_uniform_id; }
+
+		//the 4 corners in real screen coordinates, ordered top left, top right, bottom left, bottom right
+		inline const Lame::Vertex* vertices() const { return vertices_; }
 
+		//the color is multiplied with the texture, through the vertex colors
 		inline Color color() const { return color_; }
-		inline void color(const Color& i_color) { color_ = i_color; }
+		void color(const Color& i_color);
 
 		bool screen_coords(const Lame::Rectangle2D& i_screen_coords);
 		bool texture_coords(const Lame::Rectangle2D& i_texture_coords);
@@ -35,21 +37,19 @@ namespace Lame
 
 		bool SelectFromSheet(const size_t i_horz_count, const size_t i_vert_count, const size_t i_index);
 
+		//the sampler that sprite effects draw their texture from
+		static char const * const BaseTextureUniformName;
+
 	private:
 		Sprite() : color_(Color::white) {}
 
-		Lame::Vertex vertices[4];
+		Lame::Vertex vertices_[4];
 		Color color_;
 
-		Effect::ConstantHandle color_uniform_id;
 		Effect::ConstantHandle texture_uniform_id;
 
 		std::shared_ptr<Effect> effect_;
 		std::shared_ptr<Texture> texture_;
-		std::shared_ptr<RenderableMesh> mesh_;
-
-		static char const * const ColorUniformName;
-		static char const * const BaseTextureUniformName;
 	};
 }
 
@@ -0,0 +1,68 @@
+
+#include "SpriteBatch.h"
+
+#include <algorithm>
+
+#include "Sprite.h"
+#include "Texture.h"
+
+namespace Lame
+{
+	bool SpriteBatch::Add(const Sprite& i_sprite)
+	{
+		return Add(i_sprite.effect().get(), i_sprite.texture().get(), i_sprite.texture_uniform(), i_sprite.vertices());
+	}
+
+	bool SpriteBatch::Add(Effect* i_effect, const Texture* i_texture, const Effect::ConstantHandle& i_texture_uniform, const Vertex* i_quad)
+	{
+		if (!i_effect || !i_texture || !i_quad)
+			return false;
+
+		Quad quad;
+		quad.effect = i_effect;
+		quad.texture = i_texture;
+		quad.texture_uniform = i_texture_uniform;
+		std::copy(i_quad, i_quad + 4, quad.vertices);
+		quads_.push_back(quad);
+		return true;
+	}
+
+	bool SpriteBatch::Flush()
+	{
+		if (quads_.empty())
+			return true;
+
+		bool success = true;
+		Effect* boundEffect = nullptr;
+		for (size_t start = 0; start < quads_.size(); start += capacity_)
+		{
+			const size_t end = std::min(start + capacity_, quads_.size());
+			if (!Upload(start, end))
+			{
+				success = false;
+				break;
+			}
+
+			//one draw for each run of quads with the same effect and texture
+			for (size_t first = start; first < end;)
+			{
+				const Quad& state = quads_[first];
+				size_t last = first + 1;
+				while (last < end && quads_[last].effect == state.effect && quads_[last].texture == state.texture)
+					++last;
+
+				if (state.effect != boundEffect)
+				{
+					boundEffect = state.effect->Bind() ? state.effect : nullptr;
+					success = boundEffect != nullptr && success;
+				}
+				success = boundEffect != nullptr &&
+					state.effect->SetConstant(Effect::Shader::Fragment, state.texture_uniform, state.texture) &&
+					DrawQuads(first - start, last - first) && success;
+				first = last;
+			}
+		}
+		quads_.clear();
+		return success;
+	}
+}
@@ -0,0 +1,75 @@
+#ifndef _LAME_SPRITEBATCH_H
+#define _LAME_SPRITEBATCH_H
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "Effect.h"
+#include "../Core/Vertex.h"
+
+#if EAE6320_PLATFORM_D3D
+#include <d3d9.h>
+#endif
+
+namespace Lame
+{
+	class Context;
+	class Texture;
+	class Sprite;
+
+	//Collects the screen space quads drawn in a frame into one dynamic vertex buffer.
+	// Quads are drawn in the order they were added, since later ones are drawn over earlier ones,
+	// and each run of quads in a row that share an effect and texture costs a single draw.
+	class SpriteBatch
+	{
+	public:
+		static SpriteBatch* Create(std::shared_ptr<Context> i_context, const size_t i_capacity);
+		~SpriteBatch();
+
+		//queues a sprite to be drawn at the next flush
+		bool Add(const Sprite& i_sprite);
+
+		//queues a quad, with vertices in real screen coordinates ordered top left, top right, bottom left, bottom right
+		bool Add(Effect* i_effect, const Texture* i_texture, const Effect::ConstantHandle& i_texture_uniform, const Vertex* i_quad);
+
+		//draws all of the queued quads and empties the batch
+		bool Flush();
+
+		inline size_t capacity() const { return capacity_; }
+		inline size_t quad_count() const { return quads_.size(); }
+		inline std::shared_ptr<Context> get_context() const { return context; }
+	private:
+		SpriteBatch(std::shared_ptr<Context> i_context, const size_t i_capacity);
+
+		//Do not allow sprite batches to be managed without pointers
+		SpriteBatch();
+		SpriteBatch(const SpriteBatch &i_other);
+		SpriteBatch& operator=(const SpriteBatch &i_other);
+
+		struct Quad
+		{
+			Effect* effect;
+			const Texture* texture;
+			Effect::ConstantHandle texture_uniform;
+			Vertex vertices[4];
+		};
+
+		//writes quads [i_first, i_last) to the vertex buffer, replacing whatever it held
+		bool Upload(const size_t i_first, const size_t i_last);
+		//draws i_quad_count quads from the start of the vertex buffer, starting at i_first_quad
+		bool DrawQuads(const size_t i_first_quad, const size_t i_quad_count) const;
+
+		std::shared_ptr<Context> context;
+		size_t capacity_;			//the most quads the vertex buffer holds, bigger batches are drawn in parts
+		std::vector<Quad> quads_;
+
+#if EAE6320_PLATFORM_D3D
+		IDirect3DVertexBuffer9 *vertex_buffer_;
+		IDirect3DIndexBuffer9 *index_buffer_;
+		IDirect3DVertexDeclaration9 *vertex_declaration_;
+#endif
+	};
+}
+
+#endif //_LAME_SPRITEBATCH_H
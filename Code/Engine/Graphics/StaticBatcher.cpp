@@ -0,0 +1,150 @@
+
+#include "StaticBatcher.h"
+
+#include <cmath>
+#include <unordered_map>
+
+#include "RenderableMesh.h"
+#include "Material.h"
+#include "../Core/Mesh.h"
+#include "../Core/MeshCluster.h"
+#include "../Core/CompressedVertex.h"
+#include "../System/FileLoader.h"
+#include "../System/MappedFile.h"
+#include "../System/UserOutput.h"
+
+namespace Lame
+{
+	bool StaticBatcher::Add(const Mesh& i_mesh, const Matrix4x4& i_local_to_world, std::shared_ptr<Material> i_material)
+	{
+		if (i_mesh.primitive_type() != Mesh::PrimitiveType::TriangleList || !i_mesh.has_indices())
+			return false;
+		return Add(i_mesh.vertices_RO().data(), i_mesh.vertices_RO().size(), i_mesh.indices_RO().data(), i_mesh.indices_RO().size(),
+			i_local_to_world, i_material);
+	}
+
+	bool StaticBatcher::Add(const std::string& i_mesh_path, const Matrix4x4& i_local_to_world, std::shared_ptr<Material> i_material)
+	{
+		std::shared_ptr<File::MappedFile> file(File::MappedFile::Create(i_mesh_path));
+		if (!file)
+			return false;
+		const char *fileData = file->data();
+
+		//batched vertices are moved into world space anyway, so compressed ones are decompressed here.
+		// The header is checked once, so a bad file only reports its problem once.
+		uint32_t vertex_count;
+		std::vector<uint32_t> indices;
+		const File::MeshHeader *header = File::FindMeshHeader(fileData, file->size());
+		bool success = false;
+		if (header && header->vertex_format == static_cast<uint32_t>(VertexFormat::Compressed))
+		{
+			const CompressedVertex *compressed;
+			if (File::GetMeshData(fileData, *header, vertex_count, compressed, indices))
+			{
+				std::vector<Vertex> vertices(vertex_count);
+				VertexCompression::Decompress(compressed, vertex_count,
+					Vector3(header->position_offset[0], header->position_offset[1], header->position_offset[2]),
+					Vector3(header->position_scale[0], header->position_scale[1], header->position_scale[2]), vertices.data());
+				success = Add(vertices.data(), vertex_count, indices.data(), indices.size(), i_local_to_world, i_material);
+			}
+		}
+		else if (header)
+		{
+			const Vertex *vertices;
+			if (File::GetMeshData(fileData, *header, vertex_count, vertices, indices))
+				success = Add(vertices, vertex_count, indices.data(), indices.size(), i_local_to_world, i_material);
+		}
+		return success;
+	}
+
+	bool StaticBatcher::Add(const Vertex* i_vertices, const size_t i_vertex_count, const uint32_t* i_indices, const size_t i_index_count,
+		const Matrix4x4& i_local_to_world, std::shared_ptr<Material> i_material)
+	{
+		if (!i_vertices || !i_indices || i_index_count % 3 != 0 || !i_material || chunk_size_ <= 0.0f)
+			return false;
+
+		//move all the vertices into world space once
+		std::vector<Vertex> world(i_vertices, i_vertices + i_vertex_count);
+		for (size_t x = 0; x < world.size(); x++)
+			world[x].position = i_local_to_world.Multiply(world[x].position);
+
+		//a mirroring transform flips the winding of every triangle
+		const bool flipWinding = i_local_to_world.Determinant() < 0.0f;
+
+		//each chunk gets its own copy of the vertices its triangles use
+		std::map<ChunkKey, std::unordered_map<uint32_t, uint32_t>> remaps;
+		for (size_t t = 0; t < i_index_count; t += 3)
+		{
+			uint32_t tri[3] = { i_indices[t], i_indices[t + 1], i_indices[t + 2] };
+			if (tri[0] >= i_vertex_count || tri[1] >= i_vertex_count || tri[2] >= i_vertex_count)
+				return false;
+			if (flipWinding)
+				std::swap(tri[0], tri[2]);
+
+			//triangles belong to the chunk containing their centroid
+			const Vector3 centroid = (world[tri[0]].position + world[tri[1]].position + world[tri[2]].position) * (1.0f / 3.0f);
+			const ChunkKey key(i_material.get(),
+				static_cast<int32_t>(std::floor(centroid.x() / chunk_size_)),
+				static_cast<int32_t>(std::floor(centroid.y() / chunk_size_)),
+				static_cast<int32_t>(std::floor(centroid.z() / chunk_size_)));
+
+			Chunk& chunk = chunks_[key];
+			chunk.material = i_material;
+			std::unordered_map<uint32_t, uint32_t>& remap = remaps[key];
+			for (size_t v = 0; v < 3; v++)
+			{
+				auto found = remap.find(tri[v]);
+				if (found == remap.end())
+				{
+					found = remap.insert(std::make_pair(tri[v], static_cast<uint32_t>(chunk.vertices.size()))).first;
+					chunk.vertices.push_back(world[tri[v]]);
+				}
+				chunk.indices.push_back(found->second);
+			}
+		}
+		return true;
+	}
+
+	bool StaticBatcher::Build(std::shared_ptr<Context> i_context, std::vector<Batch>& o_batches)
+	{
+		bool success = true;
+		for (auto itr = chunks_.begin(); itr != chunks_.end(); ++itr)
+		{
+			Chunk& chunk = itr->second;
+
+			//a chunk with only a couple of clusters is cheaper to draw whole
+			std::vector<MeshCluster> clusters;
+			if (cluster_triangles_ > 0 && chunk.indices.size() / 3 > cluster_triangles_ * 2)
+			{
+#if EAE6320_PLATFORM_D3D
+				const bool leftHanded = true;
+#else
+				const bool leftHanded = false;
+#endif
+				BuildMeshClusters(chunk.vertices.data(), chunk.vertices.size(), chunk.indices.data(), chunk.indices.size(),
+					cluster_triangles_, leftHanded, clusters);
+			}
+
+			//the indices are still in the winding they were loaded with, so create them like RenderableMesh::Create does
+			Batch batch;
+			batch.material = chunk.material;
+#if EAE6320_PLATFORM_D3D
+			batch.mesh = std::shared_ptr<RenderableMesh>(RenderableMesh::CreateLeftHandedTriList(true, i_context,
+				chunk.vertices.data(), chunk.vertices.size(), chunk.indices.data(), chunk.indices.size()));
+#elif EAE6320_PLATFORM_GL
+			batch.mesh = std::shared_ptr<RenderableMesh>(RenderableMesh::CreateRightHandedTriList(true, i_context,
+				chunk.vertices.data(), chunk.vertices.size(), chunk.indices.data(), chunk.indices.size()));
+#endif
+			if (!batch.mesh)
+			{
+				Lame::UserOutput::Display("Failed to create a static batch mesh", "StaticBatcher error");
+				success = false;
+				continue;
+			}
+			batch.mesh->clusters(clusters);
+			o_batches.push_back(batch);
+		}
+		chunks_.clear();
+		return success;
+	}
+}
@@ -0,0 +1,64 @@
+#ifndef _ENGINE_GRAPHICS_STATICBATCHER_H
+#define _ENGINE_GRAPHICS_STATICBATCHER_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <map>
+#include <tuple>
+
+#include "../Core/Vertex.h"
+#include "../Core/Matrix4x4.h"
+
+namespace Lame
+{
+	class Context;
+	class Mesh;
+	class Material;
+	class RenderableMesh;
+
+	//Merges static triangle meshes that share a material into combined world space meshes at load time.
+	// Triangles are split into a grid of cubic chunks, so each combined mesh can still be culled on its own,
+	// and large chunks are split again into clusters that are culled while drawing.
+	class StaticBatcher
+	{
+	public:
+		struct Batch
+		{
+			std::shared_ptr<RenderableMesh> mesh;
+			std::shared_ptr<Material> material;
+		};
+
+		//i_cluster_triangles of 0 leaves the chunks unclustered
+		explicit StaticBatcher(const float i_chunk_size, const size_t i_cluster_triangles = 0) : chunk_size_(i_chunk_size), cluster_triangles_(i_cluster_triangles) {}
+
+		//adds the triangles of a mesh (TriangleList, indices in the platform's winding), placed at i_local_to_world
+		bool Add(const Mesh& i_mesh, const Matrix4x4& i_local_to_world, std::shared_ptr<Material> i_material);
+		bool Add(const Vertex* i_vertices, const size_t i_vertex_count, const uint32_t* i_indices, const size_t i_index_count,
+			const Matrix4x4& i_local_to_world, std::shared_ptr<Material> i_material);
+
+		//loads a mesh binary file and adds it
+		bool Add(const std::string& i_mesh_path, const Matrix4x4& i_local_to_world, std::shared_ptr<Material> i_material);
+
+		//creates one static RenderableMesh per material and chunk, and clears the batcher
+		bool Build(std::shared_ptr<Context> i_context, std::vector<Batch>& o_batches);
+
+		inline float chunk_size() const { return chunk_size_; }
+		inline size_t cluster_triangles() const { return cluster_triangles_; }
+	private:
+		typedef std::tuple<const Material*, int32_t, int32_t, int32_t> ChunkKey;
+		struct Chunk
+		{
+			std::shared_ptr<Material> material;
+			std::vector<Vertex> vertices;
+			std::vector<uint32_t> indices;
+		};
+
+		float chunk_size_;
+		size_t cluster_triangles_;
+		std::map<ChunkKey, Chunk> chunks_;
+	};
+}
+
+#endif //_ENGINE_GRAPHICS_STATICBATCHER_H
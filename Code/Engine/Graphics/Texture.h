@@ -1,6 +1,7 @@
 #ifndef _ENGINE_LAME_TEXTURE_H
 #define _ENGINE_LAME_TEXTURE_H
 
+#include <cstdint>
 #include <memory>
 #include <string>
 
@@ -20,10 +21,19 @@ namespace Lame
 {
 	class Context;
 
+	namespace File
+	{
+		class MappedFile;
+	}
+
 	class Texture
 	{
 	public:
 		static Texture* Create(std::shared_ptr<Context> i_context, const std::string& i_path);
+		//creates a texture from a file that has already been read, i_path is only used to report errors
+		static Texture* Create(std::shared_ptr<Context> i_context, const File::MappedFile& i_file, const std::string& i_path);
+		//creates a white texture with i_width * i_height bytes of alpha, top row first
+		static Texture* Create(std::shared_ptr<Context> i_context, const size_t i_width, const size_t i_height, const uint8_t* i_alpha);
 
 		~Texture();
 
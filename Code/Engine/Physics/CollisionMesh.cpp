@@ -5,6 +5,7 @@
 #include "Collision.h"
 #include "Physics3DComponent.h"
 #include "../System/FileLoader.h"
+#include "../System/MappedFile.h"
 #include "../Core/Vertex.h"
 #include "../Core/Mesh.h"
 
@@ -27,23 +28,22 @@ namespace Lame
 		if (i_go.expired())
 			return nullptr;
 
+		//the mesh copies the vertices straight out of the mapped file
+		std::shared_ptr<File::MappedFile> file(File::MappedFile::Create(i_mesh_file));
+		if (!file)
+			return nullptr;
+
 		uint32_t vertex_count;
-		uint32_t index_count;
-		Vertex *vertices;
-		uint32_t *indices;
-		char *fileData = File::LoadMeshData(i_mesh_file, vertex_count, index_count, vertices, indices);
-		if (!fileData)
+		const Vertex *vertices;
+		std::vector<uint32_t> indices;
+		if (!File::FindMeshData(file->data(), file->size(), vertex_count, vertices, indices))
 			return nullptr;
 
 		CollisionMesh *cm = new CollisionMesh(i_go);
 		if (!cm)
-		{
-			delete[] fileData;
 			return nullptr;
-		}
 
-		cm->mesh_ = Mesh(Mesh::PrimitiveType::TriangleList, static_cast<size_t>(vertex_count), vertices, static_cast<size_t>(index_count), indices);
-		delete[] fileData;
+		cm->mesh_ = Mesh(Mesh::PrimitiveType::TriangleList, static_cast<size_t>(vertex_count), const_cast<Vertex*>(vertices), indices.size(), indices.data());
 		return cm;
 	}
 
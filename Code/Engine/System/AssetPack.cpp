@@ -0,0 +1,193 @@
+
+#include "AssetPack.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <fstream>
+#include <sstream>
+
+#include "MappedFile.h"
+#include "ThreadPool.h"
+#include "UserOutput.h"
+#include "../Core/Compression.h"
+#include "../Core/HashedString.h"
+
+namespace
+{
+	std::vector<std::shared_ptr<Lame::File::AssetPack>> mounted_packs;
+	std::shared_ptr<Lame::ThreadPool> pack_thread_pool;
+
+	//forward slashes and lower case, since Windows paths aren't case sensitive
+	std::string NormalizePath(const std::string& i_path)
+	{
+		std::string path(i_path);
+		for (size_t x = 0; x < path.size(); x++)
+			path[x] = path[x] == '\\' ? '/' : static_cast<char>(std::tolower(static_cast<unsigned char>(path[x])));
+		return path;
+	}
+
+	inline bool EntryKeyLess(const Lame::File::PackEntry& i_entry, const uint32_t i_key) { return i_entry.key < i_key; }
+}
+
+namespace Lame
+{
+	namespace File
+	{
+		uint32_t GetPackKey(const std::string& i_relative_path)
+		{
+			const std::string path = NormalizePath(i_relative_path);
+			return HashedString::Hash(path.data(), path.size());
+		}
+
+		AssetPack* AssetPack::Create(const std::string& i_pack_path)
+		{
+			std::shared_ptr<MappedFile> file(MappedFile::Create(i_pack_path));
+			if (!file)
+				return nullptr;
+
+			//the table is checked once here, so lookups can trust it
+			const PackHeader *header = reinterpret_cast<const PackHeader*>(file->data());
+			const PackEntry *entries = reinterpret_cast<const PackEntry*>(header + 1);
+			bool valid = file->size() >= sizeof(PackHeader) && header->magic == PackMagic && header->version == PackVersion &&
+				header->file_size >= sizeof(PackHeader) && header->file_size <= file->size() &&
+				header->entry_count <= (header->file_size - sizeof(PackHeader)) / sizeof(PackEntry) &&
+				header->path_offset >= sizeof(PackHeader) + static_cast<uint64_t>(header->entry_count) * sizeof(PackEntry) &&
+				static_cast<uint64_t>(header->path_offset) + header->path_size <= header->file_size;
+			for (uint32_t x = 0; valid && x < header->entry_count; x++)
+			{
+				valid = static_cast<uint64_t>(entries[x].offset) + entries[x].stored_size <= header->file_size &&
+					entries[x].stored_size <= entries[x].size &&
+					entries[x].offset % PackAlignment == 0 &&
+					entries[x].path_offset >= header->path_offset &&
+					static_cast<uint64_t>(entries[x].path_offset) + entries[x].path_length <= static_cast<uint64_t>(header->path_offset) + header->path_size &&
+					(x == 0 || entries[x - 1].key < entries[x].key);
+			}
+			if (!valid)
+			{
+				std::stringstream error;
+				error << i_pack_path << " is not a valid asset pack, and needs to be rebuilt";
+				Lame::UserOutput::Display(error.str());
+				return nullptr;
+			}
+
+			AssetPack *pack = new AssetPack();
+			pack->file_ = file;
+			pack->entries_ = entries;
+			pack->entry_count_ = header->entry_count;
+			const std::string path = NormalizePath(i_pack_path);
+			const size_t slash = path.find_last_of('/');
+			if (slash != std::string::npos)
+				pack->directory_ = path.substr(0, slash + 1);
+			return pack;
+		}
+
+		const PackEntry* AssetPack::Find(const std::string& i_path) const
+		{
+			const std::string path = NormalizePath(i_path);
+			if (path.compare(0, directory_.size(), directory_) != 0)
+				return nullptr;
+
+			const std::string relative = path.substr(directory_.size());
+			const uint32_t key = HashedString::Hash(relative.data(), relative.size());
+			const PackEntry *entry = std::lower_bound(entries_, entries_ + entry_count_, key, EntryKeyLess);
+			if (entry == entries_ + entry_count_ || entry->key != key)
+				return nullptr;
+
+			//a different path with the same key is a loose file that isn't in the pack
+			if (entry->path_length != relative.size() || relative.compare(0, relative.size(), file_->data() + entry->path_offset, entry->path_length) != 0)
+				return nullptr;
+			return entry;
+		}
+
+		const char* AssetPack::data(const PackEntry& i_entry) const
+		{
+			return file_->data() + i_entry.offset;
+		}
+
+		bool AssetPack::Read(const PackEntry& i_entry, char* o_data) const
+		{
+			const char *stored = data(i_entry);
+			if (!IsCompressed(i_entry))
+			{
+				std::copy(stored, stored + i_entry.size, o_data);
+				return true;
+			}
+
+			//find where each block starts from the table of their sizes
+			const size_t blockCount = (static_cast<size_t>(i_entry.size) + PackBlockSize - 1) / PackBlockSize;
+			const uint32_t *blockSizes = reinterpret_cast<const uint32_t*>(stored);
+			bool valid = blockCount * sizeof(uint32_t) <= i_entry.stored_size;
+			std::vector<size_t> blockOffsets(blockCount);
+			size_t offset = blockCount * sizeof(uint32_t);
+			for (size_t x = 0; valid && x < blockCount; x++)
+			{
+				blockOffsets[x] = offset;
+				offset += blockSizes[x];
+				valid = offset <= i_entry.stored_size;
+			}
+			if (!valid)
+				return false;
+
+			//every block is decompressed straight into its place in o_data
+			std::atomic<bool> corrupt(false);
+			const std::function<void(size_t, size_t, size_t)> decompressBlocks = [&](size_t i_begin, size_t i_end, size_t)
+			{
+				for (size_t x = i_begin; x < i_end; x++)
+				{
+					const size_t first = x * PackBlockSize;
+					const size_t size = std::min<size_t>(PackBlockSize, i_entry.size - first);
+					if (blockSizes[x] == size)
+						std::copy(stored + blockOffsets[x], stored + blockOffsets[x] + size, o_data + first);
+					else if (!Compression::Decompress(stored + blockOffsets[x], blockSizes[x], o_data + first, size))
+						corrupt = true;
+				}
+			};
+			const size_t minBlocksPerJob = 2;
+			if (pack_thread_pool && blockCount > minBlocksPerJob)
+				pack_thread_pool->ParallelFor(blockCount, minBlocksPerJob, decompressBlocks);
+			else
+				decompressBlocks(0, blockCount, 0);
+			return !corrupt;
+		}
+
+		bool MountPack(const std::string& i_pack_path)
+		{
+			//a missing pack isn't an error, the loose files are used instead
+			if (!std::ifstream(i_pack_path, std::ifstream::binary))
+				return false;
+
+			std::shared_ptr<AssetPack> pack(AssetPack::Create(i_pack_path));
+			if (!pack)
+				return false;
+			mounted_packs.push_back(pack);
+			return true;
+		}
+
+		void UnmountPacks()
+		{
+			mounted_packs.clear();
+			pack_thread_pool.reset();
+		}
+
+		void SetPackThreadPool(std::shared_ptr<ThreadPool> i_thread_pool)
+		{
+			pack_thread_pool = i_thread_pool;
+		}
+
+		bool FindPackedFile(const std::string& i_path, std::shared_ptr<AssetPack>& o_pack, const PackEntry*& o_entry)
+		{
+			//the most recently mounted pack wins
+			for (size_t x = mounted_packs.size(); x > 0; x--)
+			{
+				o_entry = mounted_packs[x - 1]->Find(i_path);
+				if (o_entry)
+				{
+					o_pack = mounted_packs[x - 1];
+					return true;
+				}
+			}
+			return false;
+		}
+	}
+}
@@ -0,0 +1,99 @@
+#ifndef _ENGINE_SYSTEM_ASSETPACK_H
+#define _ENGINE_SYSTEM_ASSETPACK_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+namespace Lame
+{
+	class ThreadPool;
+
+	namespace File
+	{
+		class MappedFile;
+
+		//An asset pack is every built asset in one file: a PackHeader, a table of PackEntry sorted by key, a table of the assets' paths,
+		// and then each asset's data, starting on a PackAlignment boundary so assets keep the alignment they were built with (see MeshAlignment).
+		// Keys are only hashes, so a lookup also compares the path, and a loose file whose path happens to share a key isn't served another asset.
+		// A compressed asset is split into blocks of PackBlockSize bytes that are compressed on their own (see Compression), so they can be
+		// decompressed in parallel.  Its data is a table with the stored size of each block, followed by the blocks.  Blocks that didn't
+		// compress are stored as they are, with their stored size equal to their size.
+		const uint32_t PackMagic = 0x4B41504C;		//"LPAK"
+		const uint32_t PackVersion = 3;			//version 2 had no path table
+		const uint32_t PackAlignment = 16;
+		const uint32_t PackBlockSize = 64 * 1024;
+
+		struct PackHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t entry_count;
+			uint32_t file_size;
+			uint32_t path_offset;	//the path table, which every entry's path lies inside
+			uint32_t path_size;
+		};
+
+		struct PackEntry
+		{
+			uint32_t key;			//GetPackKey of the asset's path
+			uint32_t offset;		//from the start of the pack
+			uint32_t size;
+			uint32_t stored_size;	//the bytes in the pack, which is less than size when the asset is compressed
+			uint32_t path_offset;	//the asset's normalized relative path (without a null) starting path_offset bytes from the start of the pack
+			uint32_t path_length;
+		};
+
+		inline bool IsCompressed(const PackEntry& i_entry) { return i_entry.stored_size != i_entry.size; }
+
+		//the key an asset is stored under, a HashedString of its path relative to the pack's directory with forward slashes
+		uint32_t GetPackKey(const std::string& i_relative_path);
+
+		//A mapped pack file that finds assets by their path
+		class AssetPack
+		{
+		public:
+			//asset paths are looked up relative to the directory i_pack_path is in, returns nullptr (and displays why) if it isn't a valid pack
+			static AssetPack* Create(const std::string& i_pack_path);
+
+			//finds an asset by the path it would have as a loose file, or returns null
+			const PackEntry* Find(const std::string& i_path) const;
+
+			//copies an asset, or decompresses it, into the i_entry.size bytes of o_data.  Returns false if the asset is corrupt.
+			bool Read(const PackEntry& i_entry, char* o_data) const;
+
+			//where an asset that isn't compressed is in the pack's file
+			const char* data(const PackEntry& i_entry) const;
+
+			inline std::shared_ptr<MappedFile> file() const { return file_; }
+
+		private:
+			AssetPack() : entries_(nullptr), entry_count_(0) {}
+
+			//Do not allow AssetPacks to be managed without pointers
+			AssetPack(const AssetPack &i_other);
+			AssetPack& operator=(const AssetPack &i_other);
+
+			std::shared_ptr<MappedFile> file_;
+			std::string directory_;				//with a trailing slash, or empty
+			const PackEntry *entries_;
+			uint32_t entry_count_;
+		};
+
+		//Once a pack is mounted, MappedFile and LoadBinary serve anything in it from the pack instead of opening the loose file.
+		// Returns false if there is no valid pack at i_pack_path, in which case assets keep loading from loose files.
+		// Packs should be mounted before loading starts.
+		bool MountPack(const std::string& i_pack_path);
+		//also stops using the thread pool given to SetPackThreadPool
+		void UnmountPacks();
+
+		//compressed assets larger than a block are decompressed in parallel on i_thread_pool, without one they are decompressed on the loading thread
+		void SetPackThreadPool(std::shared_ptr<ThreadPool> i_thread_pool);
+
+		//looks for i_path in the mounted packs
+		bool FindPackedFile(const std::string& i_path, std::shared_ptr<AssetPack>& o_pack, const PackEntry*& o_entry);
+	}
+}
+
+#endif //_ENGINE_SYSTEM_ASSETPACK_H
@@ -1,10 +1,14 @@
 
 #include "FileLoader.h"
 
+#include <algorithm>
 #include <fstream>
 #include <sstream>
 
+#include "AssetPack.h"
+#include "MappedFile.h"
 #include "UserOutput.h"
+#include "../Core/MeshCluster.h"
 
 namespace Lame
 {
@@ -12,6 +16,27 @@ namespace Lame
 	{
 		char* LoadBinary(const std::string& i_file_name, size_t* o_fileLength)
 		{
+			//files in a mounted pack are copied (or decompressed) straight out of it
+			{
+				std::shared_ptr<AssetPack> pack;
+				const PackEntry *entry;
+				if (FindPackedFile(i_file_name, pack, entry))
+				{
+					char *fileData = new char[entry->size];
+					if (!pack->Read(*entry, fileData))
+					{
+						std::stringstream error;
+						error << "Failed to decompress " << i_file_name << " from its asset pack, which needs to be rebuilt";
+						Lame::UserOutput::Display(error.str());
+						delete[] fileData;
+						return nullptr;
+					}
+					if (o_fileLength)
+						*o_fileLength = entry->size;
+					return fileData;
+				}
+			}
+
 			//open the file
 			std::ifstream in(i_file_name, std::ifstream::binary);
 			if (!in)
@@ -48,5 +73,142 @@ namespace Lame
 
 			return fileData;
 		}
+
+		const MeshHeader* FindMeshHeader(const char* i_file_data, const size_t i_file_length)
+		{
+			if (!i_file_data || i_file_length < sizeof(MeshHeader) || reinterpret_cast<uintptr_t>(i_file_data) % alignof(MeshHeader) != 0)
+				return nullptr;
+
+			const MeshHeader *header = reinterpret_cast<const MeshHeader*>(i_file_data);
+			const char *problem = nullptr;
+			if (header->magic != MeshMagic)
+				problem = "is not a mesh binary file";
+			else if (header->version != MeshVersion || header->header_size != sizeof(MeshHeader))
+				problem = "was built for a different version of the engine, and needs to be rebuilt";
+			else if (header->file_size > i_file_length)
+				problem = "is truncated";
+			else if ((header->index_size != sizeof(uint16_t) && header->index_size != sizeof(uint32_t)) || header->vertex_size == 0)
+				problem = "has an unknown vertex or index layout";
+			else
+			{
+				//every block has to be aligned and fit inside the file (in 64 bits, so huge counts can't wrap around)
+				const MeshBlock *blocks[] = { &header->vertices, &header->indices, &header->sections, &header->lods, &header->clusters };
+				const size_t elementSizes[] = { header->vertex_size, header->index_size, sizeof(MeshSection), sizeof(MeshLod), sizeof(MeshCluster) };
+				for (size_t x = 0; x < sizeof(blocks) / sizeof(blocks[0]) && !problem; x++)
+				{
+					const uint64_t end = static_cast<uint64_t>(blocks[x]->offset) + static_cast<uint64_t>(blocks[x]->count) * elementSizes[x];
+					if (blocks[x]->count > 0 && (blocks[x]->offset % MeshAlignment != 0 || blocks[x]->offset < sizeof(MeshHeader) || end > header->file_size))
+						problem = "has a block outside of the file";
+				}
+			}
+
+			//the tables' ranges are checked here once, so nothing that reads them has to
+			if (!problem)
+			{
+				const MeshLod *lods = GetMeshBlock<MeshLod>(i_file_data, header->lods);
+				for (uint32_t x = 0; x < header->lods.count && !problem; x++)
+				{
+					if (static_cast<uint64_t>(lods[x].first_index) + lods[x].index_count > header->indices.count || (x == 0 && lods[x].first_index != 0))
+						problem = "has an invalid LOD table";
+				}
+				const MeshSection *sections = GetMeshBlock<MeshSection>(i_file_data, header->sections);
+				for (uint32_t x = 0; x < header->sections.count && !problem; x++)
+				{
+					if (static_cast<uint64_t>(sections[x].first_index) + sections[x].index_count > header->indices.count ||
+						static_cast<uint64_t>(sections[x].base_vertex) + sections[x].vertex_count > header->vertices.count ||
+						(x > 0 && sections[x].first_index < sections[x - 1].first_index + sections[x - 1].index_count))
+						problem = "has an invalid section table";
+				}
+				const uint32_t fullDetailCount = GetFullDetailIndexCount(i_file_data, *header);
+				const MeshCluster *clusters = GetMeshBlock<MeshCluster>(i_file_data, header->clusters);
+				for (uint32_t x = 0; x < header->clusters.count && !problem; x++)
+				{
+					if (static_cast<uint64_t>(clusters[x].first_index) + clusters[x].index_count > fullDetailCount)
+						problem = "has an invalid cluster table";
+				}
+			}
+
+			if (problem)
+			{
+				std::stringstream error;
+				error << "The mesh binary file " << problem;
+				Lame::UserOutput::Display(error.str());
+				return nullptr;
+			}
+			return header;
+		}
+
+		uint32_t GetFullDetailIndexCount(const char* i_file_data, const MeshHeader& i_header)
+		{
+			const MeshLod *lods = GetMeshBlock<MeshLod>(i_file_data, i_header.lods);
+			return lods ? lods[0].index_count : i_header.indices.count;
+		}
+
+		const MaterialHeader* FindMaterialHeader(const char* i_file_data, const size_t i_file_length)
+		{
+			if (!i_file_data || i_file_length < sizeof(MaterialHeader) || reinterpret_cast<uintptr_t>(i_file_data) % alignof(MaterialHeader) != 0)
+				return nullptr;
+
+			const MaterialHeader *header = reinterpret_cast<const MaterialHeader*>(i_file_data);
+			const char *problem = nullptr;
+			if (header->magic != MaterialMagic)
+				problem = "is not a material binary file";
+			else if (header->version != MaterialVersion || header->header_size != sizeof(MaterialHeader))
+				problem = "was built for a different version of the engine, and needs to be rebuilt";
+			else if (header->file_size > i_file_length)
+				problem = "is truncated";
+			else if (header->parameter_offset % alignof(MaterialParameter) != 0 || header->parameter_offset < sizeof(MaterialHeader) ||
+				static_cast<uint64_t>(header->parameter_offset) + static_cast<uint64_t>(header->parameter_count) * sizeof(MaterialParameter) > header->file_size ||
+				header->string_offset < sizeof(MaterialHeader) || static_cast<uint64_t>(header->string_offset) + header->string_size > header->file_size)
+				problem = "has a table outside of the file";
+			else
+			{
+				//one pass over the parameters, with every check of a parameter folded together so it is cheap and doesn't branch on each field
+				const uint64_t stringBegin = header->string_offset;
+				const uint64_t stringEnd = stringBegin + header->string_size;
+				auto stringValid = [i_file_data, stringBegin, stringEnd](const MaterialString& i_string)
+				{
+					const uint64_t end = static_cast<uint64_t>(i_string.offset) + i_string.length;
+					return (i_string.offset >= stringBegin) & (end < stringEnd) && i_file_data[end] == '\0';
+				};
+				bool valid = stringValid(header->effect) & (header->effect.length > 0);
+				const MaterialParameter *parameters = GetMaterialParameters(i_file_data, *header);
+				for (uint32_t x = 0; x < header->parameter_count; x++)
+				{
+					const MaterialParameter& parameter = parameters[x];
+					const bool isTexture = parameter.texture.length > 0;
+					//the builder only writes vertex (0) and fragment (1) parameters
+					valid &= stringValid(parameter.name) & (parameter.name.length > 0) & (!isTexture || stringValid(parameter.texture)) &
+						(parameter.shader <= 1) & (isTexture || (parameter.value_count >= 1 && parameter.value_count <= 4));
+				}
+				if (!valid)
+					problem = "has an invalid parameter or string";
+			}
+
+			if (problem)
+			{
+				std::stringstream error;
+				error << "The material binary file " << problem;
+				Lame::UserOutput::Display(error.str());
+				return nullptr;
+			}
+			return header;
+		}
+
+		void WidenMeshIndices(const char* i_file_data, const MeshHeader& i_header, const uint16_t* i_indices, const size_t i_first_index, const size_t i_index_count,
+			std::vector<uint32_t>& o_indices)
+		{
+			const uint32_t sectionCount = i_header.sections.count;
+			const MeshSection *sections = GetMeshBlock<MeshSection>(i_file_data, i_header.sections);
+			o_indices.reserve(o_indices.size() + i_index_count);
+			size_t section = 0;
+			for (size_t x = i_first_index; x < i_first_index + i_index_count; x++)
+			{
+				while (section < sectionCount && x >= sections[section].first_index + sections[section].index_count)
+					section++;
+				const uint32_t baseVertex = section < sectionCount && x >= sections[section].first_index ? sections[section].base_vertex : 0;
+				o_indices.push_back(baseVertex + i_indices[x]);
+			}
+		}
 	}
 }
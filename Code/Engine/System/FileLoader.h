@@ -1,7 +1,9 @@
 #ifndef _ENGINE_SYSTEM_FILELOADER_H
 #define _ENGINE_SYSTEM_FILELOADER_H
 
+#include <cstdint>
 #include <string>
+#include <vector>
 
 namespace Lame
 {
@@ -13,6 +15,148 @@ namespace Lame
 		//Loads a binary mesh file and separates the data out (buffer must be manually deleted after call, to dispose of data in buffer)
 		template<typename CountType, typename VertexType, typename IndexType>
 		char* LoadMeshData(const std::string& i_mesh_binary_file, CountType& o_vertex_count, CountType& o_index_count, VertexType*& o_vertices, IndexType*& o_indices, size_t* o_file_length = nullptr);
+
+		//A mesh binary file starts with a MeshHeader, which says where everything else in the file is.
+		// Every block starts on a MeshAlignment boundary, so a loaded (or mapped) file is used in place,
+		// and checking the header once is all it takes before the blocks can be read directly.
+		const uint32_t MeshMagic = 0x48534D4C;		//"LMSH"
+		const uint32_t MeshVersion = 2;				//version 1 was a vertex and index count followed by the data, with tables at the end
+		const uint32_t MeshAlignment = 16;
+
+		//count elements starting offset bytes from the start of the file
+		struct MeshBlock
+		{
+			uint32_t offset;
+			uint32_t count;
+		};
+
+		struct MeshHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t header_size;			//sizeof(MeshHeader)
+			uint32_t file_size;
+
+			//the vertex layout
+			uint32_t vertex_format;			//a Lame::VertexFormat
+			uint32_t vertex_size;			//so readers expecting a different layout can refuse the file
+			uint32_t index_size;			//2 or 4 bytes
+			float position_offset[3];		//compressed positions are decoded with position * position_scale + position_offset
+			float position_scale[3];
+
+			float bounds_min[3];			//of the decoded positions
+			float bounds_max[3];
+
+			MeshBlock vertices;
+			MeshBlock indices;				//every LOD's indices, the full detail ones first
+			MeshBlock sections;			//MeshSection, the submeshes
+			MeshBlock lods;				//MeshLod
+			MeshBlock clusters;			//Lame::MeshCluster
+		};
+
+		//A level of detail in a mesh binary file.  The index data of every LOD follows the first one's,
+		// so readers that don't know about LODs load the full detail mesh.
+		struct MeshLod
+		{
+			uint32_t first_index;		//from the start of the index data
+			uint32_t index_count;
+			float error;				//how far (in mesh units) this LOD's surface may be from the original
+		};
+
+		//A run of a mesh's indices that are relative to base_vertex.  Meshes with too many vertices for 16 bit indices
+		// are split into sections, with every LOD and cluster starting on a section boundary.
+		// Without a table of sections the whole mesh is a single section at vertex 0.
+		struct MeshSection
+		{
+			uint32_t first_index;		//from the start of the index data
+			uint32_t index_count;
+			uint32_t base_vertex;
+			uint32_t vertex_count;		//how many vertices from base_vertex the section's indices use
+		};
+
+		//the largest number of vertices 16 bit indices can address
+		const size_t MaxVerticesPer16BitIndices = 65536;
+
+		//checks the header of a loaded mesh binary file and that every block and table entry lies inside the file,
+		// returns nullptr (and displays why) if it doesn't
+		const MeshHeader* FindMeshHeader(const char* i_file_data, const size_t i_file_length);
+
+		//a block of a mesh binary file whose header has been checked
+		template<typename T>
+		inline const T* GetMeshBlock(const char* i_file_data, const MeshBlock& i_block) { return i_block.count > 0 ? reinterpret_cast<const T*>(i_file_data + i_block.offset) : nullptr; }
+
+		//the number of indices of the full detail mesh, which start at the first index
+		uint32_t GetFullDetailIndexCount(const char* i_file_data, const MeshHeader& i_header);
+
+		//the LOD table of a mesh binary file whose header has been checked, nullptr if it has none
+		inline const MeshLod* GetMeshLods(const char* i_file_data, const MeshHeader& i_header, uint32_t& o_lod_count) { o_lod_count = i_header.lods.count; return GetMeshBlock<MeshLod>(i_file_data, i_header.lods); }
+
+		//the sections of a mesh binary file whose header has been checked, nullptr if it is a single section
+		inline const MeshSection* GetMeshSections(const char* i_file_data, const MeshHeader& i_header, uint32_t& o_section_count) { o_section_count = i_header.sections.count; return GetMeshBlock<MeshSection>(i_file_data, i_header.sections); }
+
+		//separates out the data of a loaded mesh binary file, fails if the data doesn't fit in the file or the file's vertices and indices aren't VertexType and IndexType
+		template<typename CountType, typename VertexType, typename IndexType>
+		bool FindMeshData(const char* i_file_data, const size_t i_file_length, CountType& o_vertex_count, CountType& o_index_count, const VertexType*& o_vertices, const IndexType*& o_indices);
+
+		//separates out the data of a loaded mesh binary file, with every index widened to 32 bits from the start of the vertices
+		// whichever width and sections they were written with.  This is for code that reads meshes on the CPU.
+		template<typename CountType, typename VertexType>
+		bool FindMeshData(const char* i_file_data, const size_t i_file_length, CountType& o_vertex_count, const VertexType*& o_vertices, std::vector<uint32_t>& o_indices);
+
+		//the same as FindMeshData, for a file whose header has already been checked (so a bad file is only reported once)
+		template<typename CountType, typename VertexType, typename IndexType>
+		bool GetMeshData(const char* i_file_data, const MeshHeader& i_header, CountType& o_vertex_count, CountType& o_index_count, const VertexType*& o_vertices, const IndexType*& o_indices);
+		template<typename CountType, typename VertexType>
+		bool GetMeshData(const char* i_file_data, const MeshHeader& i_header, CountType& o_vertex_count, const VertexType*& o_vertices, std::vector<uint32_t>& o_indices);
+
+		//adds each section's base vertex to the 16 bit indices from i_first_index on
+		void WidenMeshIndices(const char* i_file_data, const MeshHeader& i_header, const uint16_t* i_indices, const size_t i_first_index, const size_t i_index_count,
+			std::vector<uint32_t>& o_indices);
+
+		//A material binary file is a MaterialHeader, a table of MaterialParameters and a table of null terminated strings.
+		// Everything refers to the strings by offset, and each string carries its HashedString hash, so a loaded (or mapped) file is used in place
+		// without walking or copying its strings, and its paths are looked up in the asset caches without hashing them again.
+		const uint32_t MaterialMagic = 0x54414D4C;	//"LMAT"
+		const uint32_t MaterialVersion = 2;			//version 1 had no header, and stored its string lengths in the runtime's Material::Parameters
+
+		//length characters (followed by a null) starting offset bytes from the start of the file
+		struct MaterialString
+		{
+			uint32_t offset;
+			uint32_t length;
+			uint32_t hash;				//HashedString::Hash of the string
+		};
+
+		struct MaterialHeader
+		{
+			uint32_t magic;
+			uint32_t version;
+			uint32_t header_size;		//sizeof(MaterialHeader)
+			uint32_t file_size;
+
+			MaterialString effect;		//the effect's path
+			uint32_t parameter_offset;	//MaterialParameter, 4 byte aligned
+			uint32_t parameter_count;
+			uint32_t string_offset;		//the string table, which every MaterialString lies inside
+			uint32_t string_size;
+		};
+
+		struct MaterialParameter
+		{
+			MaterialString name;		//the uniform's name
+			MaterialString texture;		//the texture's path, with a length of 0 for parameters that set values instead
+			float value[4];
+			uint32_t value_count;		//1 to 4 for parameters that set values
+			uint32_t shader;			//a Lame::Effect::Shader
+		};
+
+		//checks the header of a loaded material binary file, and that its parameter table and every string lies inside the file,
+		// returns nullptr (and displays why) if it doesn't
+		const MaterialHeader* FindMaterialHeader(const char* i_file_data, const size_t i_file_length);
+
+		//the parameters and strings of a material binary file whose header has been checked
+		inline const MaterialParameter* GetMaterialParameters(const char* i_file_data, const MaterialHeader& i_header) { return reinterpret_cast<const MaterialParameter*>(i_file_data + i_header.parameter_offset); }
+		inline const char* GetMaterialString(const char* i_file_data, const MaterialString& i_string) { return i_file_data + i_string.offset; }
 	}
 
 	namespace File
@@ -25,26 +169,69 @@ namespace Lame
 			if (!fileData)
 				return nullptr;
 
-			//find the actual location of our data
-			CountType *vertex_count = reinterpret_cast<CountType*>(fileData);
-			CountType *index_count = vertex_count + 1;
-			o_vertices = reinterpret_cast<VertexType*>(index_count + 1);
-			o_indices = reinterpret_cast<IndexType*>(o_vertices + *vertex_count);
-
-			//if the end of indices is beyond the end of the file
-			if (reinterpret_cast<void*>(o_indices + *index_count) > fileData + fileLength)
+			const VertexType *vertices;
+			const IndexType *indices;
+			if (!FindMeshData(fileData, fileLength, o_vertex_count, o_index_count, vertices, indices))
 			{
 				delete[] fileData;
 				return nullptr;
 			}
-
-			o_vertex_count = *vertex_count;
-			o_index_count = *index_count;
+			o_vertices = const_cast<VertexType*>(vertices);
+			o_indices = const_cast<IndexType*>(indices);
 
 			if (o_file_length)
 				*o_file_length = fileLength;
 			return fileData;
 		}
+
+		template<typename CountType, typename VertexType, typename IndexType>
+		bool FindMeshData(const char* i_file_data, const size_t i_file_length, CountType& o_vertex_count, CountType& o_index_count, const VertexType*& o_vertices, const IndexType*& o_indices)
+		{
+			const MeshHeader *header = FindMeshHeader(i_file_data, i_file_length);
+			return header && GetMeshData(i_file_data, *header, o_vertex_count, o_index_count, o_vertices, o_indices);
+		}
+
+		template<typename CountType, typename VertexType>
+		bool FindMeshData(const char* i_file_data, const size_t i_file_length, CountType& o_vertex_count, const VertexType*& o_vertices, std::vector<uint32_t>& o_indices)
+		{
+			const MeshHeader *header = FindMeshHeader(i_file_data, i_file_length);
+			return header && GetMeshData(i_file_data, *header, o_vertex_count, o_vertices, o_indices);
+		}
+
+		template<typename CountType, typename VertexType, typename IndexType>
+		bool GetMeshData(const char* i_file_data, const MeshHeader& i_header, CountType& o_vertex_count, CountType& o_index_count, const VertexType*& o_vertices, const IndexType*& o_indices)
+		{
+			if (i_header.vertex_size != sizeof(VertexType) || i_header.index_size != sizeof(IndexType))
+				return false;
+
+			o_vertices = GetMeshBlock<VertexType>(i_file_data, i_header.vertices);
+			o_indices = GetMeshBlock<IndexType>(i_file_data, i_header.indices);
+			o_vertex_count = static_cast<CountType>(i_header.vertices.count);
+			o_index_count = static_cast<CountType>(GetFullDetailIndexCount(i_file_data, i_header));
+			return true;
+		}
+
+		template<typename CountType, typename VertexType>
+		bool GetMeshData(const char* i_file_data, const MeshHeader& i_header, CountType& o_vertex_count, const VertexType*& o_vertices, std::vector<uint32_t>& o_indices)
+		{
+			CountType index_count;
+			if (i_header.index_size == sizeof(uint16_t))
+			{
+				const uint16_t *indices;
+				if (!GetMeshData(i_file_data, i_header, o_vertex_count, index_count, o_vertices, indices))
+					return false;
+				o_indices.clear();
+				WidenMeshIndices(i_file_data, i_header, indices, 0, index_count, o_indices);
+			}
+			else
+			{
+				const uint32_t *indices;
+				if (!GetMeshData(i_file_data, i_header, o_vertex_count, index_count, o_vertices, indices))
+					return false;
+				o_indices.assign(indices, indices + index_count);
+			}
+			return true;
+		}
 	}
 }
 
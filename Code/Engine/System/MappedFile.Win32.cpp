@@ -0,0 +1,100 @@
+
+#include "MappedFile.h"
+
+#include <cstdint>
+#include <sstream>
+
+#include "../Windows/Includes.h"
+#include "AssetPack.h"
+#include "UserOutput.h"
+
+namespace Lame
+{
+	namespace File
+	{
+		MappedFile* MappedFile::Create(const std::string& i_file_name)
+		{
+			//files in a mounted pack don't need to be opened at all
+			{
+				std::shared_ptr<AssetPack> pack;
+				const PackEntry *entry;
+				if (FindPackedFile(i_file_name, pack, entry))
+				{
+					MappedFile *packed = new MappedFile();
+					packed->size_ = entry->size;
+					if (!IsCompressed(*entry))
+					{
+						packed->pack_file_ = pack->file();
+						packed->data_ = pack->data(*entry);
+						return packed;
+					}
+
+					//compressed files are decompressed once, into the memory the loaders read in place
+					packed->decompressed_.reset(new char[entry->size]);
+					packed->data_ = packed->decompressed_.get();
+					if (!pack->Read(*entry, packed->decompressed_.get()))
+					{
+						std::stringstream error;
+						error << "Failed to decompress " << i_file_name << " from its asset pack, which needs to be rebuilt";
+						Lame::UserOutput::Display(error.str());
+						delete packed;
+						return nullptr;
+					}
+					return packed;
+				}
+			}
+
+			HANDLE file = CreateFileA(i_file_name.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+			if (file == INVALID_HANDLE_VALUE)
+			{
+				std::stringstream error;
+				error << "Failed to open " << i_file_name << " binary file";
+				Lame::UserOutput::Display(error.str());
+				return nullptr;
+			}
+
+			LARGE_INTEGER fileSize;
+			if (GetFileSizeEx(file, &fileSize) == FALSE || static_cast<uint64_t>(fileSize.QuadPart) > SIZE_MAX)
+			{
+				std::stringstream error;
+				error << "Failed to find the size of " << i_file_name;
+				Lame::UserOutput::Display(error.str());
+				CloseHandle(file);
+				return nullptr;
+			}
+
+			MappedFile *mapped = new MappedFile();
+			mapped->file_ = file;
+			mapped->size_ = static_cast<size_t>(fileSize.QuadPart);
+
+			//Windows can't map an empty file, and there is nothing to read from one anyway
+			if (mapped->size_ == 0)
+				return mapped;
+
+			mapped->mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+			if (mapped->mapping_)
+				mapped->data_ = static_cast<const char*>(MapViewOfFile(mapped->mapping_, FILE_MAP_READ, 0, 0, 0));
+			if (!mapped->data_)
+			{
+				std::stringstream error;
+				error << "Failed to map " << i_file_name << " into memory";
+				Lame::UserOutput::Display(error.str());
+				delete mapped;
+				return nullptr;
+			}
+			return mapped;
+		}
+
+		MappedFile::~MappedFile()
+		{
+			if (pack_file_ || decompressed_)
+				return;
+			if (data_)
+				UnmapViewOfFile(data_);
+			if (mapping_)
+				CloseHandle(mapping_);
+			if (file_)
+				CloseHandle(file_);
+		}
+	}
+}
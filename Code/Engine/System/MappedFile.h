@@ -0,0 +1,52 @@
+#ifndef _ENGINE_SYSTEM_MAPPEDFILE_H
+#define _ENGINE_SYSTEM_MAPPEDFILE_H
+
+#include <cstddef>
+#include <memory>
+#include <string>
+
+namespace Lame
+{
+	namespace File
+	{
+		//A whole file mapped read-only into memory.  Nothing is copied out of the file, and pages are only read
+		// from disk the first time they are touched, so loaders that only need part of a file only pay for that part.
+		// Pointers into data() are valid for as long as the MappedFile is.
+		// Files in a mounted asset pack (see AssetPack) are a view of the pack instead, or are decompressed into memory
+		// when the pack stores them compressed.
+		class MappedFile
+		{
+		public:
+			//returns nullptr (and displays why) if the file can't be opened
+			static MappedFile* Create(const std::string& i_file_name);
+			~MappedFile();
+
+			inline const char* data() const { return data_; }
+			inline size_t size() const { return size_; }
+			inline const char* begin() const { return data_; }
+			inline const char* end() const { return data_ + size_; }
+			inline bool empty() const { return size_ == 0; }
+
+		private:
+			MappedFile() : data_(nullptr), size_(0), file_(nullptr), mapping_(nullptr) {}
+
+			//Do not allow MappedFiles to be managed without pointers
+			MappedFile(const MappedFile &i_other);
+			MappedFile& operator=(const MappedFile &i_other);
+
+			const char *data_;
+			size_t size_;
+
+			//the platform's handles, empty files have none
+			void *file_;
+			void *mapping_;
+
+			//keeps the pack mapped for files that are served out of one
+			std::shared_ptr<MappedFile> pack_file_;
+			//the data of a file that was compressed in its pack
+			std::unique_ptr<char[]> decompressed_;
+		};
+	}
+}
+
+#endif //_ENGINE_SYSTEM_MAPPEDFILE_H
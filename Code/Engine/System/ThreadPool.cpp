@@ -0,0 +1,132 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+
+namespace
+{
+	//the ranges of one ParallelFor call
+	struct ParallelForState
+	{
+		explicit ParallelForState(const size_t i_range_count) : next_range(0), remaining(i_range_count) {}
+
+		std::atomic<size_t> next_range;
+		size_t remaining;	//the ranges that haven't finished, only changed while holding mutex
+		std::mutex mutex;
+		std::condition_variable done;
+	};
+}
+
+namespace Lame
+{
+	ThreadPool* ThreadPool::Create(size_t i_thread_count)
+	{
+		if (i_thread_count == 0)
+		{
+			const size_t hardwareThreads = static_cast<size_t>(std::thread::hardware_concurrency());
+			i_thread_count = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+		}
+
+		ThreadPool *pool = new ThreadPool();
+		if (!pool)
+			return nullptr;
+
+		for (size_t x = 0; x < i_thread_count; x++)
+			pool->threads_.push_back(std::thread(&ThreadPool::WorkerLoop, pool));
+		return pool;
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			shutting_down_ = true;
+		}
+		job_available_.notify_all();
+		for (size_t x = 0; x < threads_.size(); x++)
+		{
+			if (threads_[x].joinable())
+				threads_[x].join();
+		}
+	}
+
+	void ThreadPool::Enqueue(Job i_job)
+	{
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			jobs_.push_back(std::move(i_job));
+		}
+		job_available_.notify_one();
+	}
+
+	bool ThreadPool::RunPendingJob()
+	{
+		Job job;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (jobs_.empty())
+				return false;
+			job = std::move(jobs_.front());
+			jobs_.pop_front();
+		}
+		job();
+		return true;
+	}
+
+	void ThreadPool::ParallelFor(const size_t i_count, const size_t i_min_range_size, const std::function<void(size_t, size_t, size_t)>& i_job)
+	{
+		if (i_count == 0)
+			return;
+
+		const size_t minRange = std::max<size_t>(i_min_range_size, 1);
+		const size_t rangeCount = std::min(max_slots(), (i_count + minRange - 1) / minRange);
+		const size_t rangeSize = (i_count + rangeCount - 1) / rangeCount;
+
+		//the queued jobs can run after this returns (once every range has been taken), so what they share is kept alive by them
+		std::shared_ptr<ParallelForState> state(new ParallelForState(rangeCount));
+		const std::function<void(size_t, size_t, size_t)>* job = &i_job;
+		const Job runRanges = [state, job, rangeCount, rangeSize, i_count]()
+		{
+			//i_job is only used for a range that was taken before every range finished, which is while the caller is still waiting
+			for (size_t range = state->next_range++; range < rangeCount; range = state->next_range++)
+			{
+				const size_t begin = range * rangeSize;
+				const size_t end = std::min(begin + rangeSize, i_count);
+				if (begin < end)
+					(*job)(begin, end, range);
+
+				std::lock_guard<std::mutex> lock(state->mutex);
+				if (--state->remaining == 0)
+					state->done.notify_all();
+			}
+		};
+
+		for (size_t x = 1; x < rangeCount; x++)
+			Enqueue(runRanges);
+
+		//the calling thread takes ranges too, but never runs other queued jobs, so a long job (like reading a file)
+		// can't stall it.  This also keeps ParallelFor from waiting forever when it is called from a worker.
+		runRanges();
+
+		std::unique_lock<std::mutex> lock(state->mutex);
+		state->done.wait(lock, [&state]() { return state->remaining == 0; });
+	}
+
+	void ThreadPool::WorkerLoop()
+	{
+		while (true)
+		{
+			Job job;
+			{
+				std::unique_lock<std::mutex> lock(mutex_);
+				job_available_.wait(lock, [this]() { return shutting_down_ || !jobs_.empty(); });
+				if (shutting_down_ && jobs_.empty())
+					return;
+				job = std::move(jobs_.front());
+				jobs_.pop_front();
+			}
+			job();
+		}
+	}
+}
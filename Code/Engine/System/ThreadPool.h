@@ -0,0 +1,57 @@
+#ifndef _ENGINE_SYSTEM_THREADPOOL_H
+#define _ENGINE_SYSTEM_THREADPOOL_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace Lame
+{
+	//Fixed set of worker threads that run queued jobs
+	class ThreadPool
+	{
+	public:
+		typedef std::function<void()> Job;
+
+		//i_thread_count of 0 uses one worker per hardware thread, minus the calling thread
+		static ThreadPool* Create(size_t i_thread_count = 0);
+		~ThreadPool();
+
+		void Enqueue(Job i_job);
+
+		//Splits [0, i_count) into at most max_slots() ranges of at least i_min_range_size, and runs i_job(begin, end, slot)
+		// for each of them on the workers and the calling thread.  Each range gets its own slot index, so
+		// jobs can write to per-slot data without locking.  Returns once every range has finished.
+		// The calling thread only runs ranges of this call, never other queued jobs.
+		void ParallelFor(const size_t i_count, const size_t i_min_range_size, const std::function<void(size_t, size_t, size_t)>& i_job);
+
+		//pops and runs one queued job on the calling thread, returns false if the queue was empty
+		bool RunPendingJob();
+
+		inline size_t thread_count() const { return threads_.size(); }
+
+		//the number of ranges ParallelFor can split into (the workers and the calling thread)
+		inline size_t max_slots() const { return threads_.size() + 1; }
+
+	private:
+		ThreadPool() : shutting_down_(false) {}
+
+		//Do not allow ThreadPools to be managed without pointers
+		ThreadPool(const ThreadPool &i_other);
+		ThreadPool& operator=(const ThreadPool &i_other);
+
+		void WorkerLoop();
+
+		std::vector<std::thread> threads_;
+		std::deque<Job> jobs_;
+		std::mutex mutex_;
+		std::condition_variable job_available_;
+		bool shutting_down_;
+	};
+}
+
+#endif //_ENGINE_SYSTEM_THREADPOOL_H
@@ -51,6 +51,10 @@ PFNGLUNIFORMMATRIX4FVPROC glUniformMatrix4fv = NULL;
 PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer = NULL;
 PFNGLCOMPRESSEDTEXIMAGE2DPROC glCompressedTexImage2D = NULL;
 PFNGLUNIFORM1IPROC glUniform1i = NULL;
+PFNGLBINDBUFFERBASEPROC glBindBufferBase = NULL;
+PFNGLBUFFERSUBDATAPROC glBufferSubData = NULL;
+PFNGLGETUNIFORMBLOCKINDEXPROC glGetUniformBlockIndex = NULL;
+PFNGLUNIFORMBLOCKBINDINGPROC glUniformBlockBinding = NULL;
 
 // Initialization
 //---------------
@@ -106,6 +110,10 @@ bool eae6320::OpenGlExtensions::Load( std::string* o_errorMessage )
 	EAE6320_LOADGLFUNCTION( glVertexAttribPointer, PFNGLVERTEXATTRIBPOINTERPROC );
 	EAE6320_LOADGLFUNCTION( glCompressedTexImage2D, PFNGLCOMPRESSEDTEXIMAGE2DPROC );
 	EAE6320_LOADGLFUNCTION( glUniform1i, PFNGLUNIFORM1IPROC );
+	EAE6320_LOADGLFUNCTION( glBindBufferBase, PFNGLBINDBUFFERBASEPROC );
+	EAE6320_LOADGLFUNCTION( glBufferSubData, PFNGLBUFFERSUBDATAPROC );
+	EAE6320_LOADGLFUNCTION( glGetUniformBlockIndex, PFNGLGETUNIFORMBLOCKINDEXPROC );
+	EAE6320_LOADGLFUNCTION( glUniformBlockBinding, PFNGLUNIFORMBLOCKBINDINGPROC );
 	
 #undef EAE6320_LOADGLFUNCTION
 
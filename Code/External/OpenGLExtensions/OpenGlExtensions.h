@@ -55,6 +55,10 @@ extern PFNGLUSEPROGRAMPROC glUseProgram;
 extern PFNGLVERTEXATTRIBPOINTERPROC glVertexAttribPointer;
 extern PFNGLCOMPRESSEDTEXIMAGE2DPROC glCompressedTexImage2D;
 extern PFNGLUNIFORM1IPROC glUniform1i;
+extern PFNGLBINDBUFFERBASEPROC glBindBufferBase;
+extern PFNGLBUFFERSUBDATAPROC glBufferSubData;
+extern PFNGLGETUNIFORMBLOCKINDEXPROC glGetUniformBlockIndex;
+extern PFNGLUNIFORMBLOCKBINDINGPROC glUniformBlockBinding;
 
 // Initialization
 //---------------
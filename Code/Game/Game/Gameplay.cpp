@@ -11,6 +11,8 @@
 #include "../../Engine/Graphics/Graphics.h"
 #include "../../Engine/Graphics/Sprite.h"
 #include "../../Engine/Graphics/Texture.h"
+#include "../../Engine/Graphics/Assets.h"
+#include "../../Engine/Graphics/AssetLoader.h"
 #include "../../Engine/Core/Color.h"
 #include "../../Engine/Core/Singleton.h"
 #include "../../Engine/System/eae6320/Time.h"
@@ -18,9 +20,11 @@
 #include "../../Engine/Component/Transform.h"
 #include "../../Engine/Component/GameObject.h"
 #include "../../Engine/Graphics/RenderableComponent.h"
+#include "../../Engine/Graphics/StaticBatcher.h"
 #include "../../Engine/System/UserInput.h"
 #include "../../Engine/System/Console.h"
 #include "../../Engine/System/UserOutput.h"
+#include "../../Engine/System/AssetPack.h"
 #include "../../Engine/Core/Math.h"
 #include "../../Engine/Core/Vector3.h"
 #include "../../Engine/Core/Random.h"
@@ -49,6 +53,8 @@ namespace
 	uint8_t GetNumberKeyPressed();
 
 	char frames_per_second[50];
+	char draw_calls[50];
+	char triangles[50];
 
 	bool flyCamMode = false;
 }
@@ -57,6 +63,9 @@ namespace Gameplay
 {
 	bool Initialize(HWND i_window)
 	{
+		//assets are read out of the pack the asset build makes, anything that isn't in it is still loaded from its loose file
+		Lame::File::MountPack("data/assets.pack");
+
 		{
 			if (!LameWorld::Get().Setup() || 
 				!LameGraphics::Get().Setup(i_window) ||
@@ -67,6 +76,9 @@ namespace Gameplay
 				return false;
 			}
 
+			//large compressed assets in the pack are decompressed on the graphics workers
+			Lame::File::SetPackThreadPool(LameGraphics::Get().thread_pool());
+
 #ifdef ENABLE_DEBUG_RENDERING
 			//enable debug drawing for graphics
 			if (!LameGraphics::Get().EnableDebugDrawing(10000))
@@ -78,6 +90,8 @@ namespace Gameplay
 
 #ifdef ENABLE_DEBUG_MENU
 			LameGraphics::Get().debug_menu()->CreateText("FPS", frames_per_second);
+			LameGraphics::Get().debug_menu()->CreateText("Draw Calls", draw_calls);
+			LameGraphics::Get().debug_menu()->CreateText("Triangles", triangles);
 #endif
 
 			std::string error;
@@ -93,18 +107,47 @@ namespace Gameplay
 		LameGraphics::Get().camera()->near_clip_plane(1.0f);
 		LameGraphics::Get().camera()->far_clip_plane(5000.0f);
 
-		if (
-			!CreateRenderableObject(nullptr, CreateRenderableMesh("data/ceiling_mesh.mesh.bin"), CreateMaterial("data/cement_wall.material.bin")) ||
-			!CreateRenderableObject(nullptr, CreateRenderableMesh("data/cement_mesh.mesh.bin"), CreateMaterial("data/cement_wall.material.bin")) ||
-			!CreateRenderableObject(nullptr, CreateRenderableMesh("data/floor_mesh.mesh.bin"), CreateMaterial("data/floor.material.bin")) ||
-			!CreateRenderableObject(nullptr, CreateRenderableMesh("data/metal_mesh.mesh.bin"), CreateMaterial("data/metal_brace.material.bin")) ||
-			!CreateRenderableObject(nullptr, CreateRenderableMesh("data/railing_mesh.mesh.bin"), CreateMaterial("data/railing.material.bin")) ||
-			!CreateRenderableObject(nullptr, CreateRenderableMesh("data/walls_mesh.mesh.bin"), CreateMaterial("data/wall.material.bin")) ||
-			!CreateRenderableObject(nullptr, CreateRenderableMesh("data/lambert_objects_mesh.mesh.bin"), CreateMaterial("data/white.material.bin"))
-			)
+		//merge the static level geometry by material, split into chunks so the parts behind the camera are culled
 		{
-			Shutdown();
-			return false;
+			const float levelChunkSize = 1000.0f;
+			const size_t levelClusterTriangles = 128;
+			Lame::StaticBatcher batcher(levelChunkSize, levelClusterTriangles);
+			std::vector<Lame::StaticBatcher::Batch> batches;
+
+			//the level's materials and their textures are read in parallel on the workers, instead of one after another
+			{
+				const char *levelMaterials[] = { "data/cement_wall.material.bin", "data/floor.material.bin", "data/metal_brace.material.bin",
+					"data/railing.material.bin", "data/wall.material.bin", "data/white.material.bin" };
+				std::shared_ptr<Lame::AssetLoader> loader = LameGraphics::Get().asset_loader();
+				for (size_t x = 0; x < sizeof(levelMaterials) / sizeof(levelMaterials[0]); x++)
+					loader->material(levelMaterials[x], Lame::AssetLoader::High);
+				loader->Flush();
+			}
+
+			std::shared_ptr<Lame::Material> cementWall = CreateMaterial("data/cement_wall.material.bin");
+			bool success = cementWall &&
+				batcher.Add("data/ceiling_mesh.mesh.bin", Lame::Matrix4x4::identity, cementWall) &&
+				batcher.Add("data/cement_mesh.mesh.bin", Lame::Matrix4x4::identity, cementWall) &&
+				batcher.Add("data/floor_mesh.mesh.bin", Lame::Matrix4x4::identity, CreateMaterial("data/floor.material.bin")) &&
+				batcher.Add("data/metal_mesh.mesh.bin", Lame::Matrix4x4::identity, CreateMaterial("data/metal_brace.material.bin")) &&
+				batcher.Add("data/railing_mesh.mesh.bin", Lame::Matrix4x4::identity, CreateMaterial("data/railing.material.bin")) &&
+				batcher.Add("data/walls_mesh.mesh.bin", Lame::Matrix4x4::identity, CreateMaterial("data/wall.material.bin")) &&
+				batcher.Add("data/lambert_objects_mesh.mesh.bin", Lame::Matrix4x4::identity, CreateMaterial("data/white.material.bin")) &&
+				batcher.Build(LameGraphics::Get().context(), batches);
+
+			for (size_t x = 0; success && x < batches.size(); x++)
+				success = CreateRenderableObject(nullptr, batches[x].mesh, batches[x].material) != nullptr;
+
+			//the walls and ceiling hide most of the level from any one spot
+			success = success &&
+				LameGraphics::Get().AddOccluder("data/walls_occluder.mesh.bin") &&
+				LameGraphics::Get().AddOccluder("data/ceiling_occluder.mesh.bin");
+
+			if (!success)
+			{
+				Shutdown();
+				return false;
+			}
 		}
 
 		//add the player physics and controls
@@ -137,7 +180,7 @@ namespace Gameplay
 			}
 		}
 
-		sprite_effect = std::shared_ptr<Lame::Effect>(Lame::Effect::Create(LameGraphics::Get().context(), "data/sprite.effect.bin"));
+		sprite_effect = LameGraphics::Get().assets()->effect("data/sprite.effect.bin");
 		if (!sprite_effect)
 		{
 			Shutdown();
@@ -152,6 +195,8 @@ namespace Gameplay
 		float deltaTime = eae6320::Time::GetSecondsElapsedThisFrame();
 		LameInput::Get().Tick(deltaTime);
 		_itoa_s(static_cast<int>(1.0f / deltaTime), frames_per_second, 10);
+		_itoa_s(static_cast<int>(LameGraphics::Get().context()->draw_call_count()), draw_calls, 10);
+		_itoa_s(static_cast<int>(LameGraphics::Get().context()->primitive_count()), triangles, 10);
 		
 		HandleInput(deltaTime);
 
@@ -186,6 +231,7 @@ namespace Gameplay
 		LameGraphics::Release();
 		LameWorld::Release();
 		LameInput::Release();
+		Lame::File::UnmountPacks();
 		return true;
 	}
 }
@@ -239,7 +285,7 @@ namespace
 		using namespace Lame;
 		if (!LameGraphics::Exists())
 			return nullptr;
-		return std::shared_ptr<Material>(Material::Create(LameGraphics::Get().context(), i_material));
+		return LameGraphics::Get().assets()->material(i_material);
 	}
 
 	std::shared_ptr<Lame::RenderableMesh> CreateRenderableMesh(const std::string& i_mesh)
@@ -247,7 +293,7 @@ namespace
 		using namespace Lame;
 		if (!LameGraphics::Exists())
 			return nullptr;
-		return std::shared_ptr<RenderableMesh>(RenderableMesh::Create(true, LameGraphics::Get().context(), i_mesh));
+		return LameGraphics::Get().assets()->mesh(i_mesh);
 	}
 
 	std::shared_ptr<Lame::CollisionMesh> CreateCollisionMesh(const std::string& i_mesh)
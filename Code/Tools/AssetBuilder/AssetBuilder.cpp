@@ -5,6 +5,9 @@
 
 #include <iostream>
 #include <string>
+#include <vector>
+#include "BuildJobs.h"
+#include "ContentHash.h"
 #include "../BuilderHelper/UtilityFunctions.h"
 #include "../../Engine/Windows/Functions.h"
 #include "../../External/Lua/Includes.h"
@@ -15,6 +18,7 @@
 namespace
 {
 	lua_State* s_luaState = NULL;
+	size_t s_maxConcurrentJobs = 1;
 }
 
 // Helper Function Declarations
@@ -35,15 +39,19 @@ namespace
 	int luaCreateDirectoryIfNecessary( lua_State* io_luaState );
 	int luaDoesFileExist( lua_State* io_luaState );
 	int luaGetEnvironmentVariable( lua_State* io_luaState );
+	int luaGetFileHash( lua_State* io_luaState );
 	int luaGetLastWriteTime( lua_State* io_luaState );
+	int luaGetStringHash( lua_State* io_luaState );
 	int luaOutputErrorMessage( lua_State* io_luaState );
+	int luaRunBuildJobs( lua_State* io_luaState );
 }
 
 // Interface
 //==========
 
-bool eae6320::AssetBuilder::BuildAssets()
+bool eae6320::AssetBuilder::BuildAssets( const size_t i_maxConcurrentJobs )
 {
+	s_maxConcurrentJobs = i_maxConcurrentJobs;
 	bool wereThereErrors = false;
 	std::string scriptDir;
 
@@ -147,8 +155,11 @@ namespace
 			lua_register( s_luaState, "CreateDirectoryIfNecessary", luaCreateDirectoryIfNecessary );
 			lua_register( s_luaState, "DoesFileExist", luaDoesFileExist );
 			lua_register( s_luaState, "GetEnvironmentVariable", luaGetEnvironmentVariable );
+			lua_register( s_luaState, "GetFileHash", luaGetFileHash );
 			lua_register( s_luaState, "GetLastWriteTime", luaGetLastWriteTime );
+			lua_register( s_luaState, "GetStringHash", luaGetStringHash );
 			lua_register( s_luaState, "OutputErrorMessage", luaOutputErrorMessage );
+			lua_register( s_luaState, "RunBuildJobs", luaRunBuildJobs );
 		}
 
 		return true;
@@ -326,6 +337,39 @@ namespace
 		}
 	}
 
+	int luaGetFileHash( lua_State* io_luaState )
+	{
+		// Argument #1: The path
+		const char* i_path;
+		if ( lua_isstring( io_luaState, 1 ) )
+		{
+			i_path = lua_tostring( io_luaState, 1 );
+		}
+		else
+		{
+			return luaL_error( io_luaState,
+				"Argument #1 must be a string (instead of a %s)",
+				luaL_typename( io_luaState, 1 ) );
+		}
+
+		// Hash the file's contents
+		std::string hash;
+		std::string errorMessage;
+		if ( eae6320::AssetBuilder::GetFileContentHash( i_path, hash, &errorMessage ) )
+		{
+			lua_pushstring( io_luaState, hash.c_str() );
+			const int returnValueCount = 1;
+			return returnValueCount;
+		}
+		else
+		{
+			lua_pushboolean( io_luaState, false );
+			lua_pushstring( io_luaState, errorMessage.c_str() );
+			const int returnValueCount = 2;
+			return returnValueCount;
+		}
+	}
+
 	int luaGetLastWriteTime( lua_State* io_luaState )
 	{
 		// Argument #1: The path
@@ -356,6 +400,28 @@ namespace
 		}
 	}
 
+	int luaGetStringHash( lua_State* io_luaState )
+	{
+		// Argument #1: The string
+		const char* i_string;
+		size_t i_length;
+		if ( lua_isstring( io_luaState, 1 ) )
+		{
+			i_string = lua_tolstring( io_luaState, 1, &i_length );
+		}
+		else
+		{
+			return luaL_error( io_luaState,
+				"Argument #1 must be a string (instead of a %s)",
+				luaL_typename( io_luaState, 1 ) );
+		}
+
+		const std::string hash = eae6320::AssetBuilder::GetContentHash( i_string, i_length );
+		lua_pushstring( io_luaState, hash.c_str() );
+		const int returnValueCount = 1;
+		return returnValueCount;
+	}
+
 	int luaOutputErrorMessage( lua_State* io_luaState )
 	{
 		// Argument #1: The error message
@@ -392,4 +458,50 @@ namespace
 		const int returnValueCount = 0;
 		return returnValueCount;
 	}
+
+	int luaRunBuildJobs( lua_State* io_luaState )
+	{
+		// Argument #1: An array of jobs, each a table with a builder, arguments, source and target
+		if ( !lua_istable( io_luaState, 1 ) )
+		{
+			return luaL_error( io_luaState,
+				"Argument #1 must be a table (instead of a %s)",
+				luaL_typename( io_luaState, 1 ) );
+		}
+		std::vector<eae6320::AssetBuilder::BuildJob> jobs( luaL_len( io_luaState, 1 ) );
+		for ( size_t i = 0; i < jobs.size(); ++i )
+		{
+			lua_rawgeti( io_luaState, 1, static_cast<lua_Integer>( i + 1 ) );
+			if ( !lua_istable( io_luaState, -1 ) )
+			{
+				return luaL_error( io_luaState, "Job #%d must be a table", static_cast<int>( i + 1 ) );
+			}
+			const char* const keys[] = { "builder", "arguments", "source", "target" };
+			std::string* const values[] = { &jobs[i].path_builder, &jobs[i].arguments, &jobs[i].path_source, &jobs[i].path_target };
+			for ( size_t j = 0; j < 4; ++j )
+			{
+				lua_getfield( io_luaState, -1, keys[j] );
+				if ( !lua_isstring( io_luaState, -1 ) )
+				{
+					return luaL_error( io_luaState, "Job #%d's %s must be a string", static_cast<int>( i + 1 ), keys[j] );
+				}
+				*values[j] = lua_tostring( io_luaState, -1 );
+				lua_pop( io_luaState, 1 );
+			}
+			lua_pop( io_luaState, 1 );
+		}
+
+		std::vector<eae6320::AssetBuilder::BuildJobResult> results;
+		eae6320::AssetBuilder::RunBuildJobs( jobs, s_maxConcurrentJobs, results );
+
+		// Return whether each job succeeded, in the same order
+		lua_createtable( io_luaState, static_cast<int>( results.size() ), 0 );
+		for ( size_t i = 0; i < results.size(); ++i )
+		{
+			lua_pushboolean( io_luaState, results[i].succeeded );
+			lua_rawseti( io_luaState, -2, static_cast<lua_Integer>( i + 1 ) );
+		}
+		const int returnValueCount = 1;
+		return returnValueCount;
+	}
 }
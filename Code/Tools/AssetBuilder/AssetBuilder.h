@@ -5,6 +5,11 @@
 #ifndef EAE6320_ASSETBUILDER_HELPERFUNCTIONS_H
 #define EAE6320_ASSETBUILDER_HELPERFUNCTIONS_H
 
+// Header Files
+//=============
+
+#include <cstddef>
+
 // Interface
 //==========
 
@@ -12,7 +17,8 @@ namespace eae6320
 {
 	namespace AssetBuilder
 	{
-		bool BuildAssets();
+		// Runs at most i_maxConcurrentJobs builders at once
+		bool BuildAssets( const size_t i_maxConcurrentJobs );
 	}
 }
 
@@ -0,0 +1,362 @@
+// Header Files
+//=============
+
+#include "BuildJobs.h"
+
+#include <algorithm>
+#include <cctype>
+#include <condition_variable>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include "../BuilderHelper/cbBuilder.h"
+#include "../../Engine/Windows/Functions.h"
+
+// Helper Class Declaration
+//=========================
+
+namespace
+{
+	// A builder that was started with WorkerArgument, which builds one request after another
+	struct Worker
+	{
+		std::string path_builder;
+		HANDLE process;
+		// The builder's standard input
+		HANDLE requests;
+		// The builder's standard output and error
+		HANDLE output;
+	};
+}
+
+// Static Data Initialization
+//===========================
+
+namespace
+{
+	// Builders are only started one at a time, so the inheritable ends of one builder's pipes
+	// can't leak into another builder (which would keep the pipes open until that other builder exits)
+	std::mutex s_createProcessMutex;
+	// So that each job's output is written out in one piece
+	std::mutex s_outputMutex;
+
+	const size_t s_noJob = static_cast<size_t>( -1 );
+}
+
+// Helper Function Declarations
+//=============================
+
+namespace
+{
+	bool StartWorker( const std::string& i_path_builder, Worker& o_worker, std::string& o_errorMessage );
+	// Returns false if the worker can't build any more requests
+	bool BuildRequest( Worker& io_worker, const std::string& i_arguments, std::string& o_output, bool& o_wasBuildSuccessful, std::string& o_errorMessage );
+	void StopWorker( Worker& io_worker );
+	std::string GetTargetKey( const std::string& i_path );
+}
+
+// Interface
+//==========
+
+void eae6320::AssetBuilder::RunBuildJobs( const std::vector<BuildJob>& i_jobs, const size_t i_maxConcurrentJobs, std::vector<BuildJobResult>& o_results )
+{
+	BuildJobResult notRun = { false };
+	o_results.assign( i_jobs.size(), notRun );
+	if ( i_jobs.empty() )
+	{
+		return;
+	}
+
+	// A job can only start once the job before it that builds the same target has finished
+	std::vector<size_t> previousJobs( i_jobs.size(), s_noJob );
+	{
+		std::map<std::string, size_t> lastJobs;
+		for ( size_t i = 0; i < i_jobs.size(); ++i )
+		{
+			const std::string key = GetTargetKey( i_jobs[i].path_target );
+			std::map<std::string, size_t>::iterator lastJob = lastJobs.find( key );
+			if ( lastJob != lastJobs.end() )
+			{
+				previousJobs[i] = lastJob->second;
+			}
+			lastJobs[key] = i;
+		}
+	}
+
+	std::mutex mutex;
+	std::condition_variable jobFinished;
+	std::vector<bool> haveJobsStarted( i_jobs.size(), false );
+	std::vector<bool> haveJobsFinished( i_jobs.size(), false );
+	size_t startedJobCount = 0;
+	// Workers that have finished their last job, ready for another one from the same builder
+	std::vector<std::unique_ptr<Worker>> idleWorkers;
+
+	const auto RunJobs = [&]()
+	{
+		for ( ;; )
+		{
+			// Take the first job that is ready to run, and a worker to run it
+			size_t job = s_noJob;
+			std::unique_ptr<Worker> worker;
+			{
+				std::unique_lock<std::mutex> lock( mutex );
+				for ( ;; )
+				{
+					if ( startedJobCount == i_jobs.size() )
+					{
+						return;
+					}
+					for ( size_t i = 0; i < i_jobs.size() && job == s_noJob; ++i )
+					{
+						if ( !haveJobsStarted[i] && ( previousJobs[i] == s_noJob || haveJobsFinished[previousJobs[i]] ) )
+						{
+							job = i;
+						}
+					}
+					if ( job != s_noJob )
+					{
+						break;
+					}
+					jobFinished.wait( lock );
+				}
+				haveJobsStarted[job] = true;
+				++startedJobCount;
+
+				for ( size_t i = 0; i < idleWorkers.size(); ++i )
+				{
+					if ( idleWorkers[i]->path_builder == i_jobs[job].path_builder )
+					{
+						worker = std::move( idleWorkers[i] );
+						idleWorkers.erase( idleWorkers.begin() + i );
+						break;
+					}
+				}
+			}
+
+			{
+				std::lock_guard<std::mutex> lock( s_outputMutex );
+				std::cout << "Build Started: " << i_jobs[job].path_source << "\n";
+			}
+
+			BuildJobResult& result = o_results[job];
+			std::string output;
+			if ( !worker )
+			{
+				worker.reset( new Worker() );
+				if ( !StartWorker( i_jobs[job].path_builder, *worker, result.errorMessage ) )
+				{
+					worker.reset();
+				}
+			}
+			if ( worker )
+			{
+				if ( !BuildRequest( *worker, i_jobs[job].arguments, output, result.succeeded, result.errorMessage ) )
+				{
+					StopWorker( *worker );
+					worker.reset();
+				}
+			}
+
+			{
+				std::lock_guard<std::mutex> lock( s_outputMutex );
+				std::cout << output;
+				std::cout.flush();
+				if ( result.succeeded )
+				{
+					std::cout << "Build Completed: " << i_jobs[job].path_source << "\n";
+				}
+				else
+				{
+					// The builder should already have output a descriptive error message,
+					// but this makes sure a failed build is never silent
+					std::ostringstream errorMessage;
+					errorMessage << "\"" << i_jobs[job].path_builder << "\" " << i_jobs[job].arguments << " failed";
+					if ( !result.errorMessage.empty() )
+					{
+						errorMessage << ": " << result.errorMessage;
+					}
+					eae6320::OutputErrorMessage( errorMessage.str().c_str(), i_jobs[job].path_source.c_str() );
+				}
+			}
+
+			{
+				std::lock_guard<std::mutex> lock( mutex );
+				haveJobsFinished[job] = true;
+				if ( worker )
+				{
+					idleWorkers.push_back( std::move( worker ) );
+				}
+			}
+			jobFinished.notify_all();
+		}
+	};
+
+	// The builders do the real work in their own processes,
+	// so each of these threads only sends one job at a time to a worker and waits for it
+	const size_t threadCount = std::min( std::max( i_maxConcurrentJobs, static_cast<size_t>( 1 ) ), i_jobs.size() );
+	std::vector<std::thread> threads;
+	for ( size_t i = 1; i < threadCount; ++i )
+	{
+		threads.push_back( std::thread( RunJobs ) );
+	}
+	RunJobs();
+	for ( size_t i = 0; i < threads.size(); ++i )
+	{
+		threads[i].join();
+	}
+
+	for ( size_t i = 0; i < idleWorkers.size(); ++i )
+	{
+		StopWorker( *idleWorkers[i] );
+	}
+}
+
+// Helper Function Definitions
+//============================
+
+namespace
+{
+	bool StartWorker( const std::string& i_path_builder, Worker& o_worker, std::string& o_errorMessage )
+	{
+		// CreateProcess() may modify the command line, so it needs a non-const copy
+		std::string commandLine = "\"" + i_path_builder + "\" " + eae6320::WorkerArgument;
+		std::vector<char> commandLineBuffer( commandLine.begin(), commandLine.end() );
+		commandLineBuffer.push_back( '\0' );
+
+		std::lock_guard<std::mutex> lock( s_createProcessMutex );
+
+		// One pipe sends the builder requests, and the other collects both its standard output and error
+		SECURITY_ATTRIBUTES inheritable = { 0 };
+		{
+			inheritable.nLength = sizeof( inheritable );
+			inheritable.bInheritHandle = TRUE;
+		}
+		HANDLE requests_read = NULL, requests_write = NULL;
+		HANDLE output_read = NULL, output_write = NULL;
+		if ( CreatePipe( &requests_read, &requests_write, &inheritable, 0 ) == FALSE )
+		{
+			o_errorMessage = "Windows failed to create a pipe for the builder's requests: " + eae6320::GetLastWindowsError();
+			return false;
+		}
+		if ( CreatePipe( &output_read, &output_write, &inheritable, 0 ) == FALSE )
+		{
+			o_errorMessage = "Windows failed to create a pipe for the builder's output: " + eae6320::GetLastWindowsError();
+			CloseHandle( requests_read );
+			CloseHandle( requests_write );
+			return false;
+		}
+		// Only the builder's ends of the pipes are inherited
+		SetHandleInformation( requests_write, HANDLE_FLAG_INHERIT, 0 );
+		SetHandleInformation( output_read, HANDLE_FLAG_INHERIT, 0 );
+
+		STARTUPINFO startupInfo = { 0 };
+		{
+			startupInfo.cb = sizeof( startupInfo );
+			startupInfo.dwFlags = STARTF_USESTDHANDLES;
+			startupInfo.hStdInput = requests_read;
+			startupInfo.hStdOutput = output_write;
+			startupInfo.hStdError = output_write;
+		}
+		PROCESS_INFORMATION processInformation = { 0 };
+		const BOOL inheritHandles = TRUE;
+		const DWORD createDefaultProcess = 0;
+		const bool wasProcessCreated = CreateProcess( NULL, commandLineBuffer.data(), NULL, NULL,
+			inheritHandles, createDefaultProcess, NULL, NULL, &startupInfo, &processInformation ) != FALSE;
+		if ( !wasProcessCreated )
+		{
+			o_errorMessage = "The builder couldn't be started: " + eae6320::GetLastWindowsError();
+		}
+		// The builder has its own copies now, so once it exits reading its output will stop
+		CloseHandle( requests_read );
+		CloseHandle( output_write );
+		if ( !wasProcessCreated )
+		{
+			CloseHandle( requests_write );
+			CloseHandle( output_read );
+			return false;
+		}
+		CloseHandle( processInformation.hThread );
+
+		o_worker.path_builder = i_path_builder;
+		o_worker.process = processInformation.hProcess;
+		o_worker.requests = requests_write;
+		o_worker.output = output_read;
+		return true;
+	}
+
+	bool BuildRequest( Worker& io_worker, const std::string& i_arguments, std::string& o_output, bool& o_wasBuildSuccessful, std::string& o_errorMessage )
+	{
+		o_wasBuildSuccessful = false;
+
+		// Send the request
+		{
+			const std::string request = i_arguments + "\n";
+			DWORD writtenCount;
+			if ( ( WriteFile( io_worker.requests, request.data(), static_cast<DWORD>( request.size() ), &writtenCount, NULL ) == FALSE ) ||
+				( writtenCount != request.size() ) )
+			{
+				o_errorMessage = "Windows failed to send the request to the builder: " + eae6320::GetLastWindowsError();
+				return false;
+			}
+		}
+
+		// Collect everything the builder writes until the line with the request's result
+		const std::string resultPrefix = eae6320::WorkerResultPrefix;
+		std::string output;
+		size_t lineStart = 0;
+		char buffer[4096];
+		DWORD readCount;
+		while ( ( ReadFile( io_worker.output, buffer, sizeof( buffer ), &readCount, NULL ) != FALSE ) && ( readCount > 0 ) )
+		{
+			output.append( buffer, readCount );
+			for ( size_t lineEnd = output.find( '\n', lineStart ); lineEnd != std::string::npos; lineEnd = output.find( '\n', lineStart ) )
+			{
+				if ( output.compare( lineStart, resultPrefix.size(), resultPrefix ) == 0 )
+				{
+					o_wasBuildSuccessful = output[lineStart + resultPrefix.size()] == '1';
+					o_output = output.substr( 0, lineStart );
+					return true;
+				}
+				lineStart = lineEnd + 1;
+			}
+		}
+
+		// The builder exited (or crashed) without finishing the request
+		o_output = output;
+		DWORD exitCode = 0;
+		WaitForSingleObject( io_worker.process, INFINITE );
+		GetExitCodeProcess( io_worker.process, &exitCode );
+		std::ostringstream errorMessage;
+		errorMessage << "The builder exited with code " << exitCode << " before finishing";
+		o_errorMessage = errorMessage.str();
+		return false;
+	}
+
+	void StopWorker( Worker& io_worker )
+	{
+		// Closing its requests tells the builder that there won't be any more
+		CloseHandle( io_worker.requests );
+		{
+			char buffer[4096];
+			DWORD readCount;
+			while ( ( ReadFile( io_worker.output, buffer, sizeof( buffer ), &readCount, NULL ) != FALSE ) && ( readCount > 0 ) ) {}
+		}
+		CloseHandle( io_worker.output );
+		WaitForSingleObject( io_worker.process, INFINITE );
+		CloseHandle( io_worker.process );
+	}
+
+	// Windows paths aren't case sensitive, and can use either slash
+	std::string GetTargetKey( const std::string& i_path )
+	{
+		std::string key( i_path );
+		for ( size_t i = 0; i < key.size(); ++i )
+		{
+			key[i] = ( key[i] == '/' ) ? '\\' : static_cast<char>( tolower( static_cast<unsigned char>( key[i] ) ) );
+		}
+		return key;
+	}
+}
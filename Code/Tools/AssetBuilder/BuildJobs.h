@@ -0,0 +1,49 @@
+/*
+	These functions run builders as separate worker processes (see cbBuilder::ServeBuildRequests()),
+	as many of them at once as the machine (or the -j command line argument) allows
+*/
+
+#ifndef EAE6320_ASSETBUILDER_BUILDJOBS_H
+#define EAE6320_ASSETBUILDER_BUILDJOBS_H
+
+// Header Files
+//=============
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// Interface
+//==========
+
+namespace eae6320
+{
+	namespace AssetBuilder
+	{
+		// A builder, the arguments to build an asset with (quoted as they would be on its command line), and the asset
+		struct BuildJob
+		{
+			std::string path_builder;
+			std::string arguments;
+			std::string path_source;
+			std::string path_target;
+		};
+
+		struct BuildJobResult
+		{
+			bool succeeded;
+			// Why the builder couldn't be run or stopped partway through, if it did
+			std::string errorMessage;
+		};
+
+		// Runs the jobs with at most i_maxConcurrentJobs of them at once, and returns after they have all finished.
+		// Jobs that build the same target run one after another in the order they were given,
+		// every other job is independent and can run at the same time as any other.
+		// Builders run as workers that build one job after another, so a builder is only started as many times
+		// as it has jobs running at once rather than once per job.
+		// Each job's output is written out in one piece when it finishes, so the messages of different jobs don't interleave.
+		void RunBuildJobs( const std::vector<BuildJob>& i_jobs, const size_t i_maxConcurrentJobs, std::vector<BuildJobResult>& o_results );
+	}
+}
+
+#endif	// EAE6320_ASSETBUILDER_BUILDJOBS_H
@@ -0,0 +1,195 @@
+// Header Files
+//=============
+
+#include "ContentHash.h"
+
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <vector>
+
+// Helper Class Declaration
+//=========================
+
+namespace
+{
+	// SHA-256 (FIPS 180-4), fed the data a piece at a time
+	class Sha256
+	{
+	public:
+		Sha256();
+
+		void Update( const uint8_t* i_data, size_t i_size );
+		std::string Finish();
+
+	private:
+		void ProcessBlock( const uint8_t* const i_block );
+
+		uint32_t m_state[8];
+		uint8_t m_block[64];
+		size_t m_blockSize;
+		uint64_t m_totalSize;
+	};
+}
+
+// Interface
+//==========
+
+std::string eae6320::AssetBuilder::GetContentHash( const void* const i_data, const size_t i_size )
+{
+	Sha256 hash;
+	hash.Update( static_cast<const uint8_t*>( i_data ), i_size );
+	return hash.Finish();
+}
+
+bool eae6320::AssetBuilder::GetFileContentHash( const char* const i_path, std::string& o_hash, std::string* o_errorMessage )
+{
+	std::ifstream file( i_path, std::ifstream::binary );
+	if ( !file )
+	{
+		if ( o_errorMessage )
+		{
+			std::ostringstream errorMessage;
+			errorMessage << "Failed to open \"" << i_path << "\" to hash its contents";
+			*o_errorMessage = errorMessage.str();
+		}
+		return false;
+	}
+
+	Sha256 hash;
+	std::vector<char> buffer( 64 * 1024 );
+	while ( file )
+	{
+		file.read( buffer.data(), buffer.size() );
+		hash.Update( reinterpret_cast<const uint8_t*>( buffer.data() ), static_cast<size_t>( file.gcount() ) );
+	}
+	if ( !file.eof() )
+	{
+		if ( o_errorMessage )
+		{
+			std::ostringstream errorMessage;
+			errorMessage << "Failed to read \"" << i_path << "\" to hash its contents";
+			*o_errorMessage = errorMessage.str();
+		}
+		return false;
+	}
+	o_hash = hash.Finish();
+	return true;
+}
+
+// Helper Class Definition
+//========================
+
+namespace
+{
+	const uint32_t s_roundConstants[64] =
+	{
+		0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+		0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+		0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+		0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+		0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+		0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+		0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+		0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2,
+	};
+
+	inline uint32_t RotateRight( const uint32_t i_value, const unsigned int i_count )
+	{
+		return ( i_value >> i_count ) | ( i_value << ( 32 - i_count ) );
+	}
+
+	Sha256::Sha256()
+		: m_blockSize( 0 ), m_totalSize( 0 )
+	{
+		const uint32_t initialState[8] = { 0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19 };
+		memcpy( m_state, initialState, sizeof( m_state ) );
+	}
+
+	void Sha256::Update( const uint8_t* i_data, size_t i_size )
+	{
+		m_totalSize += i_size;
+		while ( i_size > 0 )
+		{
+			const size_t copySize = ( sizeof( m_block ) - m_blockSize < i_size ) ? ( sizeof( m_block ) - m_blockSize ) : i_size;
+			memcpy( m_block + m_blockSize, i_data, copySize );
+			m_blockSize += copySize;
+			i_data += copySize;
+			i_size -= copySize;
+			if ( m_blockSize == sizeof( m_block ) )
+			{
+				ProcessBlock( m_block );
+				m_blockSize = 0;
+			}
+		}
+	}
+
+	std::string Sha256::Finish()
+	{
+		// The data is padded with a 1 bit, then zeros up to the last 8 bytes of a block, which hold the data's length in bits
+		const uint64_t bitCount = m_totalSize * 8;
+		const uint8_t one = 0x80;
+		Update( &one, 1 );
+		const uint8_t zero = 0;
+		while ( m_blockSize != sizeof( m_block ) - 8 )
+		{
+			Update( &zero, 1 );
+		}
+		uint8_t length[8];
+		for ( size_t i = 0; i < 8; ++i )
+		{
+			length[i] = static_cast<uint8_t>( bitCount >> ( 56 - 8 * i ) );
+		}
+		Update( length, sizeof( length ) );
+
+		const char* const digits = "0123456789abcdef";
+		std::string hash;
+		for ( size_t i = 0; i < 8; ++i )
+		{
+			for ( int shift = 28; shift >= 0; shift -= 4 )
+			{
+				hash += digits[( m_state[i] >> shift ) & 0xf];
+			}
+		}
+		return hash;
+	}
+
+	void Sha256::ProcessBlock( const uint8_t* const i_block )
+	{
+		uint32_t w[64];
+		for ( size_t i = 0; i < 16; ++i )
+		{
+			w[i] = ( static_cast<uint32_t>( i_block[i * 4] ) << 24 ) | ( static_cast<uint32_t>( i_block[i * 4 + 1] ) << 16 ) |
+				( static_cast<uint32_t>( i_block[i * 4 + 2] ) << 8 ) | static_cast<uint32_t>( i_block[i * 4 + 3] );
+		}
+		for ( size_t i = 16; i < 64; ++i )
+		{
+			const uint32_t s0 = RotateRight( w[i - 15], 7 ) ^ RotateRight( w[i - 15], 18 ) ^ ( w[i - 15] >> 3 );
+			const uint32_t s1 = RotateRight( w[i - 2], 17 ) ^ RotateRight( w[i - 2], 19 ) ^ ( w[i - 2] >> 10 );
+			w[i] = w[i - 16] + s0 + w[i - 7] + s1;
+		}
+
+		uint32_t a = m_state[0], b = m_state[1], c = m_state[2], d = m_state[3];
+		uint32_t e = m_state[4], f = m_state[5], g = m_state[6], h = m_state[7];
+		for ( size_t i = 0; i < 64; ++i )
+		{
+			const uint32_t s1 = RotateRight( e, 6 ) ^ RotateRight( e, 11 ) ^ RotateRight( e, 25 );
+			const uint32_t choice = ( e & f ) ^ ( ~e & g );
+			const uint32_t temp1 = h + s1 + choice + s_roundConstants[i] + w[i];
+			const uint32_t s0 = RotateRight( a, 2 ) ^ RotateRight( a, 13 ) ^ RotateRight( a, 22 );
+			const uint32_t majority = ( a & b ) ^ ( a & c ) ^ ( b & c );
+			const uint32_t temp2 = s0 + majority;
+			h = g;
+			g = f;
+			f = e;
+			e = d + temp1;
+			d = c;
+			c = b;
+			b = a;
+			a = temp1 + temp2;
+		}
+		m_state[0] += a; m_state[1] += b; m_state[2] += c; m_state[3] += d;
+		m_state[4] += e; m_state[5] += f; m_state[6] += g; m_state[7] += h;
+	}
+}
@@ -0,0 +1,28 @@
+/*
+	These functions hash the contents of the files that assets are built from,
+	so that a target is only rebuilt when what it is built from actually changes
+*/
+
+#ifndef EAE6320_ASSETBUILDER_CONTENTHASH_H
+#define EAE6320_ASSETBUILDER_CONTENTHASH_H
+
+// Header Files
+//=============
+
+#include <cstddef>
+#include <string>
+
+// Interface
+//==========
+
+namespace eae6320
+{
+	namespace AssetBuilder
+	{
+		// The SHA-256 of the data, as 64 lowercase hexadecimal digits
+		std::string GetContentHash( const void* const i_data, const size_t i_size );
+		bool GetFileContentHash( const char* const i_path, std::string& o_hash, std::string* o_errorMessage = NULL );
+	}
+}
+
+#endif	// EAE6320_ASSETBUILDER_CONTENTHASH_H
@@ -7,13 +7,31 @@
 
 #include "AssetBuilder.h"
 #include <cstdlib>
+#include <cstring>
+#include <thread>
 
 // Entry Point
 //============
 
 int main( int i_argumentCount, char** i_arguments )
 {
-	if ( eae6320::AssetBuilder::BuildAssets() )
+	// By default as many builders run at once as there are cores,
+	// "-j N" (or "-jN") limits it to N
+	size_t maxConcurrentJobs = std::thread::hardware_concurrency();
+	for ( int i = 1; i < i_argumentCount; ++i )
+	{
+		if ( strncmp( i_arguments[i], "-j", 2 ) == 0 )
+		{
+			const char* const count = ( i_arguments[i][2] != '\0' ) ? ( i_arguments[i] + 2 ) : ( ( i + 1 < i_argumentCount ) ? i_arguments[++i] : "" );
+			maxConcurrentJobs = static_cast<size_t>( strtoul( count, NULL, 10 ) );
+		}
+	}
+	if ( maxConcurrentJobs == 0 )
+	{
+		maxConcurrentJobs = 1;
+	}
+
+	if ( eae6320::AssetBuilder::BuildAssets( maxConcurrentJobs ) )
 	{
 		return EXIT_SUCCESS;
 	}
@@ -3,8 +3,20 @@
 
 #include "cbBuilder.h"
 
+#include <algorithm>
+#include <fstream>
+#include <iostream>
 #include <sstream>
 
+// Helper Function Declarations
+//=============================
+
+namespace
+{
+	// Splits a line of arguments at spaces that aren't inside double quotes, and removes the quotes
+	void SplitArguments( const std::string& i_line, std::vector<std::string>& o_arguments );
+}
+
 // Interface
 //==========
 
@@ -14,19 +26,65 @@
 bool eae6320::cbBuilder::ParseCommandArgumentsAndBuild( char** i_arguments, const unsigned int i_argumentCount )
 {
 	const unsigned int commandCount = 1;
-	const unsigned int actualArgumentCount = i_argumentCount - commandCount;
-	const unsigned int requiredArgumentCount = 2;
+	std::vector<std::string> arguments;
+	for ( unsigned int i = commandCount; i < i_argumentCount; ++i )
+	{
+		arguments.push_back( i_arguments[i] );
+	}
+	return BuildWithArguments( arguments );
+}
+
+bool eae6320::cbBuilder::ServeBuildRequests()
+{
+	std::string request;
+	while ( std::getline( std::cin, request ) )
+	{
+		std::vector<std::string> arguments;
+		SplitArguments( request, arguments );
+		const bool wasBuildSuccessful = BuildWithArguments( arguments );
+
+		// Everything the build output has to come before its result
+		std::cerr.flush();
+		std::cout << WorkerResultPrefix << ( wasBuildSuccessful ? 1 : 0 ) << std::endl;
+	}
+	return true;
+}
+
+// Implementation
+//===============
+
+bool eae6320::cbBuilder::BuildWithArguments( const std::vector<std::string>& i_arguments )
+{
+	const size_t actualArgumentCount = i_arguments.size();
+	const size_t requiredArgumentCount = 2;
 	if ( actualArgumentCount >= requiredArgumentCount )
 	{
-		m_path_source = i_arguments[commandCount + 0];
-		m_path_target = i_arguments[commandCount + 1];
+		m_arguments = i_arguments;
+		m_path_source = m_arguments[0].c_str();
+		m_path_target = m_arguments[1].c_str();
+		m_dependencies.clear();
+		m_references.clear();
 
+		// The dependency file is for AssetBuilder rather than the specific builder
+		std::string path_dependencyFile;
 		std::vector<std::string> optionalArguments;
-		for ( unsigned int i = ( commandCount + requiredArgumentCount ); i < i_argumentCount; ++i )
+		for ( size_t i = requiredArgumentCount; i < m_arguments.size(); ++i )
 		{
-			optionalArguments.push_back( i_arguments[i] );
+			if ( ( m_arguments[i] == DependencyFileArgument ) && ( ( i + 1 ) < m_arguments.size() ) )
+			{
+				path_dependencyFile = m_arguments[++i];
+			}
+			else
+			{
+				optionalArguments.push_back( m_arguments[i] );
+			}
 		}
-		return Build( optionalArguments );
+
+		if ( !Build( optionalArguments ) )
+		{
+			return false;
+		}
+		return path_dependencyFile.empty() || WriteDependencyFile( path_dependencyFile );
 	}
 	else
 	{
@@ -50,6 +108,47 @@ bool eae6320::cbBuilder::ParseCommandArgumentsAndBuild( char** i_arguments, cons
 	}
 }
 
+bool eae6320::cbBuilder::WriteDependencyFile( const std::string& i_path ) const
+{
+	std::ofstream file( i_path.c_str() );
+	for ( size_t i = 0; i < m_dependencies.size(); ++i )
+	{
+		file << "dependency " << m_dependencies[i] << "\n";
+	}
+	for ( size_t i = 0; i < m_references.size(); ++i )
+	{
+		file << "reference " << m_references[i] << "\n";
+	}
+	file.close();
+	if ( !file )
+	{
+		eae6320::OutputErrorMessage( "Failed to write the dependency file", i_path.c_str() );
+		return false;
+	}
+	return true;
+}
+
+// Inheritable Interface
+//======================
+
+bool eae6320::cbBuilder::AddDependency( const std::string& i_path )
+{
+	if ( std::find( m_dependencies.begin(), m_dependencies.end(), i_path ) != m_dependencies.end() )
+	{
+		return false;
+	}
+	m_dependencies.push_back( i_path );
+	return true;
+}
+
+void eae6320::cbBuilder::AddReference( const std::string& i_path )
+{
+	if ( std::find( m_references.begin(), m_references.end(), i_path ) == m_references.end() )
+	{
+		m_references.push_back( i_path );
+	}
+}
+
 // Initialization / Shut Down
 //---------------------------
 
@@ -58,3 +157,43 @@ eae6320::cbBuilder::cbBuilder() :
 {
 
 }
+
+// Helper Function Definitions
+//============================
+
+namespace
+{
+	void SplitArguments( const std::string& i_line, std::vector<std::string>& o_arguments )
+	{
+		std::string argument;
+		bool isArgumentStarted = false;
+		bool isInsideQuotes = false;
+		for ( size_t i = 0; i < i_line.size(); ++i )
+		{
+			const char character = i_line[i];
+			if ( character == '"' )
+			{
+				isInsideQuotes = !isInsideQuotes;
+				isArgumentStarted = true;
+			}
+			else if ( ( ( character == ' ' ) || ( character == '\t' ) || ( character == '\r' ) ) && !isInsideQuotes )
+			{
+				if ( isArgumentStarted )
+				{
+					o_arguments.push_back( argument );
+					argument.clear();
+					isArgumentStarted = false;
+				}
+			}
+			else
+			{
+				argument += character;
+				isArgumentStarted = true;
+			}
+		}
+		if ( isArgumentStarted )
+		{
+			o_arguments.push_back( argument );
+		}
+	}
+}
@@ -11,6 +11,7 @@
 //=============
 
 #include <cstdlib>
+#include <cstring>
 #include <string>
 #include <vector>
 
@@ -23,6 +24,14 @@
 
 namespace eae6320
 {
+	// A builder called with only this argument is a worker (see cbBuilder::ServeBuildRequests())
+	const char* const WorkerArgument = "-worker";
+	// Workers finish the output of each request with a line starting with this,
+	// followed by 1 if the build succeeded or 0 if it failed
+	const char* const WorkerResultPrefix = "#eae6320 build result: ";
+	// An optional argument followed by the path to write the target's dependency file to (see cbBuilder::AddDependency())
+	const char* const DependencyFileArgument = "-dependencies";
+
 	// This only thing a specific builder project's main() entry point should do
 	// is to call the following function with the derived builder class
 	// as the template argument:
@@ -30,6 +39,10 @@ namespace eae6320
 	int Build( char** i_arguments, const unsigned int i_argumentCount )
 	{
 		builder_t builder;
+		if ( ( i_argumentCount == 2 ) && ( strcmp( i_arguments[1], WorkerArgument ) == 0 ) )
+		{
+			return builder.ServeBuildRequests() ? EXIT_SUCCESS : EXIT_FAILURE;
+		}
 		return builder.ParseCommandArgumentsAndBuild( i_arguments, i_argumentCount ) ?
 			EXIT_SUCCESS : EXIT_FAILURE;
 	}
@@ -47,14 +60,22 @@ namespace eae6320
 		// The following function will be called from the Build<> templated function above
 		// with the command line arguments directly from the main() entry point:
 		bool ParseCommandArgumentsAndBuild( char** i_arguments, const unsigned int i_argumentCount );
-		// And that function will extract the source and target paths
+		// And that function will extract the source and target paths (and the dependency file path, if there is one)
 		// and then call this function in the derived class with any remaining (optional) arguments:
 		virtual bool Build( const std::vector<std::string>& i_optionalArguments ) = 0;
 
+		// Instead of building one asset and exiting, a worker builds one asset for each line of standard input until it is closed.
+		// Each line holds the arguments that would otherwise be on the command line (quoted the same way),
+		// and every request is built by the same builder, so anything it keeps between builds
+		// (a Direct3D device, for example) only has to be created once.
+		// AssetBuilder runs the builders this way so that starting them doesn't cost more than building small assets.
+		bool ServeBuildRequests();
+
 		// Initialization / Shut Down
 		//---------------------------
 
 		cbBuilder();
+		virtual ~cbBuilder() {}
 
 		// Inheritable Data
 		//=================
@@ -63,6 +84,33 @@ namespace eae6320
 
 		const char* m_path_source;
 		const char* m_path_target;
+
+		// A builder calls these while it builds so that AssetBuilder knows when the target is out-of-date.
+		// Every file other than the source that the target is built from (an #included file, for example) is a dependency,
+		// and it is rebuilt whenever one of them changes.
+		// Every built asset that the target refers to by its path relative to the built asset directory
+		// (the effect and textures of a material, for example) is a reference,
+		// and the target is only complete when all of them are built too.
+		// If the builder was given a DependencyFileArgument they are written to that file after a successful build,
+		// one "dependency <path>" or "reference <path>" per line.
+		// AddDependency() returns false if the file was already a dependency.
+		bool AddDependency( const std::string& i_path );
+		void AddReference( const std::string& i_path );
+
+		// Implementation
+		//===============
+
+	private:
+
+		// Builds with the source path, target path and then any optional arguments
+		bool BuildWithArguments( const std::vector<std::string>& i_arguments );
+		bool WriteDependencyFile( const std::string& i_path ) const;
+
+		// The paths point into these
+		std::vector<std::string> m_arguments;
+		// What the current build has found
+		std::vector<std::string> m_dependencies;
+		std::vector<std::string> m_references;
 	};
 }
 
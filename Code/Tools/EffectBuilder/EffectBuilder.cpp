@@ -16,7 +16,7 @@ bool EffectBuilder::Build(const std::vector<std::string>&)
 	////////////////////////////////////////////
 	//Data we need
 	////////////////////////////////////////////
-	std::string vertex, fragment;
+	std::string vertex, fragment, instancedVertex;
 	Lame::EnumMask<Lame::RenderState> renderMask;
 
 	////////////////////////////////////////////
@@ -43,6 +43,7 @@ bool EffectBuilder::Build(const std::vector<std::string>&)
 
 		vertex = strs["vertex"];
 		fragment = strs["fragment"];
+		instancedVertex = strs["instanced_vertex"];		//optional
 		renderMask.set(Lame::RenderState::Transparency, flags["transparency"]);
 		renderMask.set(Lame::RenderState::DepthTest, flags["depth_test"]);
 		renderMask.set(Lame::RenderState::DepthWrite, flags["depth_write"]);
@@ -63,8 +64,16 @@ bool EffectBuilder::Build(const std::vector<std::string>&)
 			eae6320::OutputErrorMessage(error.str().c_str());
 			return false;
 		}
+		//the effect only works if the shaders it names are built too
+		AddReference(vertex);
+		AddReference(fragment);
+		if (!instancedVertex.empty())
+			AddReference(instancedVertex);
+
 		vertex = relativeFolder + vertex;
 		fragment = relativeFolder + fragment;
+		if (!instancedVertex.empty())
+			instancedVertex = relativeFolder + instancedVertex;
 	}
 
 	////////////////////////////////////////////
@@ -96,6 +105,7 @@ bool EffectBuilder::Build(const std::vector<std::string>&)
 		out.write(reinterpret_cast<char*>(&vertexStringLength), sizeof(vertexStringLength));
 		out.write(vertex.c_str(), vertexStringLength + 1);
 		out.write(fragment.c_str(), fragment.length() + 1);
+		out.write(instancedVertex.c_str(), instancedVertex.length() + 1);
 
 		out.close();
 	}
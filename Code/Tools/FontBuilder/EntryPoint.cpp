@@ -0,0 +1,7 @@
+
+#include "FontBuilder.h"
+
+int main( int i_argumentCount, char** i_arguments )
+{
+	return eae6320::Build<FontBuilder>( i_arguments, i_argumentCount );
+}
@@ -0,0 +1,269 @@
+
+#include "FontBuilder.h"
+
+#include <sstream>
+#include <fstream>
+#include <algorithm>
+#include <unordered_map>
+
+#include "../BuilderHelper/UtilityFunctions.h"
+#include "../../Engine/Windows/Includes.h"
+#include "../../Engine/Graphics/FontRenderer.h"
+
+#include "../../External/Lua/LuaHelper.h"
+
+namespace
+{
+	const uint32_t FirstCharacter = 32;		//space
+	const uint32_t LastCharacter = 126;		//tilde
+	const uint32_t AtlasWidth = 256;
+	const uint32_t MaxAtlasHeight = 4096;	//the largest texture every Direct3D 9 card can create
+	const uint32_t GlyphPadding = 1;		//keeps filtering from bleeding neighboring glyphs in
+
+	//FontRenderer looks glyphs up by a single byte
+	static_assert(LastCharacter < 256, "Font binaries only hold characters that fit in a byte");
+
+	struct GlyphBitmap
+	{
+		Lame::Font::Glyph glyph;
+		std::vector<uint8_t> coverage;		//width * height, top row first
+	};
+
+	//renders every character with GDI, and measures the font
+	bool RenderGlyphs(const std::string& i_face, const int i_height, const bool i_bold, const bool i_italic,
+		std::vector<GlyphBitmap>& o_glyphs, uint32_t& o_line_height, std::string& o_error);
+
+	//places every glyph in a fixed width atlas, one shelf of glyphs after another, and gives its height.
+	// Returns false if a glyph is too wide for the atlas, or the glyphs don't fit in MaxAtlasHeight.
+	bool PackGlyphs(std::vector<GlyphBitmap>& io_glyphs, uint32_t& o_height);
+
+	inline uint32_t NextPowerOfTwo(uint32_t i_value)
+	{
+		uint32_t power = 1;
+		while (power < i_value)
+			power <<= 1;
+		return power;
+	}
+}
+
+bool FontBuilder::Build(const std::vector<std::string>&)
+{
+	////////////////////////////////////////////
+	//Load data from Lua
+	////////////////////////////////////////////
+	std::string face;
+	int height;
+	bool bold, italic;
+	{
+		LuaHelper::LuaStack *stack = LuaHelper::LuaStack::Create(m_path_source);
+		if (!stack)
+		{
+			eae6320::OutputErrorMessage("Failed to open the file and create lua state.", m_path_source);
+			return false;
+		}
+		std::unordered_map<std::string, std::string> strs;
+		std::unordered_map<std::string, lua_Integer> ints;
+		std::unordered_map<std::string, bool> flags;
+		bool dataReadInSuccessfully = stack->PeekDictionary(strs) && stack->PeekDictionary(ints) && stack->PeekDictionary(flags);
+		delete stack;
+
+		if (!dataReadInSuccessfully)
+		{
+			eae6320::OutputErrorMessage("Failed to read lua data from file.", m_path_source);
+			return false;
+		}
+
+		face = strs["face"];
+		height = static_cast<int>(ints["height"]);
+		bold = flags["bold"];
+		italic = flags["italic"];
+		if (face.empty() || height <= 0)
+		{
+			eae6320::OutputErrorMessage("A font needs a face and a positive height in pixels.", m_path_source);
+			return false;
+		}
+	}
+
+	////////////////////////////////////////////
+	//Bake the atlas
+	////////////////////////////////////////////
+	std::vector<GlyphBitmap> glyphs;
+	Lame::Font::FileHeader header;
+	std::vector<uint8_t> atlas;
+	{
+		std::string error;
+		if (!RenderGlyphs(face, height, bold, italic, glyphs, header.line_height, error))
+		{
+			eae6320::OutputErrorMessage(error.c_str(), m_path_source);
+			return false;
+		}
+
+		header.first_character = FirstCharacter;
+		header.glyph_count = static_cast<uint32_t>(glyphs.size());
+		header.atlas_width = AtlasWidth;
+		uint32_t usedHeight;
+		if (!PackGlyphs(glyphs, usedHeight))
+		{
+			std::stringstream error;
+			error << "The font is too big to fit in a " << AtlasWidth << "x" << MaxAtlasHeight << " glyph atlas.";
+			eae6320::OutputErrorMessage(error.str().c_str(), m_path_source);
+			return false;
+		}
+		header.atlas_height = NextPowerOfTwo(usedHeight);
+
+		atlas.resize(header.atlas_width * header.atlas_height, 0);
+		for (size_t x = 0; x < glyphs.size(); x++)
+		{
+			const Lame::Font::Glyph& glyph = glyphs[x].glyph;
+			for (size_t row = 0; row < glyph.height; row++)
+			{
+				std::copy(glyphs[x].coverage.begin() + row * glyph.width, glyphs[x].coverage.begin() + (row + 1) * glyph.width,
+					atlas.begin() + (glyph.atlas_y + row) * header.atlas_width + glyph.atlas_x);
+			}
+		}
+	}
+
+	////////////////////////////////////////////
+	//Write data to binary
+	////////////////////////////////////////////
+	{
+		std::ofstream out(m_path_target, std::ofstream::binary);
+		if (!out)
+		{
+			eae6320::OutputErrorMessage("Failed to open the output file for writing", m_path_target);
+			return false;
+		}
+
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+		for (size_t x = 0; x < glyphs.size(); x++)
+			out.write(reinterpret_cast<const char*>(&glyphs[x].glyph), sizeof(glyphs[x].glyph));
+		out.write(reinterpret_cast<const char*>(atlas.data()), atlas.size());
+
+		out.close();
+	}
+
+	return true;
+}
+
+namespace
+{
+	bool RenderGlyphs(const std::string& i_face, const int i_height, const bool i_bold, const bool i_italic,
+		std::vector<GlyphBitmap>& o_glyphs, uint32_t& o_line_height, std::string& o_error)
+	{
+		HDC dc = CreateCompatibleDC(NULL);
+		if (!dc)
+		{
+			o_error = "Windows failed to create a device context to render the font with";
+			return false;
+		}
+		//a negative height asks for the character height, rather than the cell height
+		HFONT font = CreateFontA(-i_height, 0, 0, 0, i_bold ? FW_BOLD : FW_NORMAL, i_italic, FALSE, FALSE, DEFAULT_CHARSET,
+			OUT_TT_PRECIS, CLIP_DEFAULT_PRECIS, ANTIALIASED_QUALITY, DEFAULT_PITCH | FF_DONTCARE, i_face.c_str());
+		if (!font)
+		{
+			o_error = "Windows failed to create the font " + i_face;
+			DeleteDC(dc);
+			return false;
+		}
+		HGDIOBJ previousFont = SelectObject(dc, font);
+
+		bool success = true;
+		TEXTMETRICA metrics;
+		if (GetTextMetricsA(dc, &metrics))
+		{
+			o_line_height = static_cast<uint32_t>(metrics.tmHeight + metrics.tmExternalLeading);
+
+			const MAT2 identity = { { 0, 1 }, { 0, 0 }, { 0, 0 }, { 0, 1 } };
+			std::vector<uint8_t> buffer;
+			o_glyphs.resize(LastCharacter - FirstCharacter + 1);
+			for (uint32_t character = FirstCharacter; character <= LastCharacter && success; character++)
+			{
+				GlyphBitmap& bitmap = o_glyphs[character - FirstCharacter];
+				GLYPHMETRICS glyphMetrics;
+				const DWORD size = GetGlyphOutlineA(dc, character, GGO_GRAY8_BITMAP, &glyphMetrics, 0, nullptr, &identity);
+				if (size == GDI_ERROR)
+				{
+					std::stringstream error;
+					error << "Windows failed to measure the character '" << static_cast<char>(character) << "'";
+					o_error = error.str();
+					success = false;
+					break;
+				}
+
+				bitmap.glyph = Lame::Font::Glyph();
+				bitmap.glyph.advance = static_cast<int16_t>(glyphMetrics.gmCellIncX);
+				//blank characters have no bitmap, even though their black box is never empty
+				if (size == 0)
+					continue;
+
+				buffer.resize(size);
+				if (GetGlyphOutlineA(dc, character, GGO_GRAY8_BITMAP, &glyphMetrics, size, buffer.data(), &identity) == GDI_ERROR)
+				{
+					o_error = "Windows failed to render a character";
+					success = false;
+					break;
+				}
+
+				bitmap.glyph.width = static_cast<uint16_t>(glyphMetrics.gmBlackBoxX);
+				bitmap.glyph.height = static_cast<uint16_t>(glyphMetrics.gmBlackBoxY);
+				bitmap.glyph.offset_x = static_cast<int16_t>(glyphMetrics.gmptGlyphOrigin.x);
+				bitmap.glyph.offset_y = static_cast<int16_t>(metrics.tmAscent - glyphMetrics.gmptGlyphOrigin.y);
+
+				//the rows are DWORD aligned, and the coverage goes from 0 to 64
+				const size_t pitch = (bitmap.glyph.width + 3) & ~3;
+				bitmap.coverage.resize(bitmap.glyph.width * bitmap.glyph.height);
+				for (size_t y = 0; y < bitmap.glyph.height; y++)
+				{
+					for (size_t x = 0; x < bitmap.glyph.width; x++)
+						bitmap.coverage[y * bitmap.glyph.width + x] = static_cast<uint8_t>(std::min(buffer[y * pitch + x] * 255 / 64, 255));
+				}
+			}
+		}
+		else
+		{
+			o_error = "Windows failed to measure the font " + i_face;
+			success = false;
+		}
+
+		SelectObject(dc, previousFont);
+		DeleteObject(font);
+		DeleteDC(dc);
+		return success;
+	}
+
+	bool PackGlyphs(std::vector<GlyphBitmap>& io_glyphs, uint32_t& o_height)
+	{
+		//placing the tallest glyphs first wastes the least space on each shelf
+		std::vector<size_t> order(io_glyphs.size());
+		for (size_t x = 0; x < order.size(); x++)
+			order[x] = x;
+		std::stable_sort(order.begin(), order.end(), [&io_glyphs](const size_t i_lhs, const size_t i_rhs) {
+			return io_glyphs[i_lhs].glyph.height > io_glyphs[i_rhs].glyph.height;
+		});
+
+		uint32_t x = GlyphPadding, y = GlyphPadding, shelfHeight = 0;
+		for (size_t i = 0; i < order.size(); i++)
+		{
+			Lame::Font::Glyph& glyph = io_glyphs[order[i]].glyph;
+			if (glyph.width == 0 || glyph.height == 0)
+				continue;
+			if (glyph.width + GlyphPadding * 2 > AtlasWidth)
+				return false;
+
+			if (x + glyph.width + GlyphPadding > AtlasWidth)
+			{
+				x = GlyphPadding;
+				y += shelfHeight + GlyphPadding;
+				shelfHeight = 0;
+			}
+			if (y + glyph.height + GlyphPadding > MaxAtlasHeight)
+				return false;
+			glyph.atlas_x = static_cast<uint16_t>(x);
+			glyph.atlas_y = static_cast<uint16_t>(y);
+			x += glyph.width + GlyphPadding;
+			shelfHeight = std::max<uint32_t>(shelfHeight, glyph.height);
+		}
+		o_height = y + shelfHeight + GlyphPadding;
+		return true;
+	}
+}
@@ -0,0 +1,13 @@
+#ifndef _TOOLS_FONTBUILDER_FONTBUILDER_H
+#define _TOOLS_FONTBUILDER_FONTBUILDER_H
+
+#include "../BuilderHelper/cbBuilder.h"
+
+//Bakes the printable ASCII characters of a Windows font into a glyph atlas that FontRenderer can draw from
+class FontBuilder : public eae6320::cbBuilder
+{
+public:
+	virtual bool Build(const std::vector<std::string>& i_arguments);
+};
+
+#endif //_TOOLS_FONTBUILDER_FONTBUILDER_H
@@ -13,12 +13,29 @@
 #include "../../Engine/Windows/Functions.h"
 #include "../../External/Lua/Includes.h"
 
-#include "../../Engine/Graphics/Material.h"
+#include "../../Engine/Core/HashedString.h"
+#include "../../Engine/Graphics/Effect.h"
+#include "../../Engine/System/FileLoader.h"
 #include "../../External/Lua/LuaHelper.h"
 
 namespace
 {
 	void ToLower(std::string &io_str);
+
+	//The string table of a material binary file, where strings that are used more than once are only stored once
+	class StringTable
+	{
+	public:
+		StringTable(const uint32_t i_offset) : offset_(i_offset) {}
+
+		Lame::File::MaterialString Add(const std::string& i_string);
+
+		inline const std::vector<char>& data() const { return data_; }
+	private:
+		uint32_t offset_;
+		std::vector<char> data_;
+		std::map<std::string, Lame::File::MaterialString> added_;
+	};
 }
 
 bool MaterialBuilder::Build(const std::vector<std::string>&)
@@ -28,7 +45,7 @@ bool MaterialBuilder::Build(const std::vector<std::string>&)
 	////////////////////////////////////////////
 	std::string effectLocation;
 	std::vector<std::string> uniform_names;
-	std::vector<Lame::Material::Parameter> uniforms;
+	std::vector<Lame::File::MaterialParameter> uniforms;
 	std::vector<std::string> uniform_texture_names;
 
 	////////////////////////////////////////////
@@ -59,7 +76,7 @@ bool MaterialBuilder::Build(const std::vector<std::string>&)
 			for (size_t x = 0; x < uniformCount; x++)
 			{
 				//individual uniform
-				Lame::Material::Parameter param;
+				Lame::File::MaterialParameter param = {};
 				stack->Push(static_cast<lua_Unsigned>(x + 1));
 				if (stack->SwapTableKey() && stack->IsTable())
 				{
@@ -84,9 +101,17 @@ bool MaterialBuilder::Build(const std::vector<std::string>&)
 						{
 							ToLower(strs[shader]);
 							if (strs[shader] == "fragment")
-								param.shader_type = Lame::Effect::Shader::Fragment;
+								param.shader = Lame::Effect::Shader::Fragment;
 							else if (strs[shader] == "vertex")
-								param.shader_type = Lame::Effect::Shader::Vertex;
+								param.shader = Lame::Effect::Shader::Vertex;
+							else
+							{
+								std::stringstream error;
+								error << "Uniform " << x << " has an unknown \"shader\" attribute (" << strs[shader] << "), it must be \"vertex\" or \"fragment\"";
+								eae6320::OutputErrorMessage(error.str().c_str(), m_path_source);
+								delete stack;
+								return false;
+							}
 						}
 						else
 						{
@@ -138,7 +163,7 @@ bool MaterialBuilder::Build(const std::vector<std::string>&)
 						{
 							for (size_t x = 0; x < values.size(); x++)
 								param.value[x] = static_cast<float>(values[x]);
-							param.valueCount = static_cast<uint8_t>(values.size());
+							param.value_count = static_cast<uint32_t>(values.size());
 						}
 						else
 						{
@@ -198,48 +223,29 @@ bool MaterialBuilder::Build(const std::vector<std::string>&)
 			eae6320::OutputErrorMessage(error.str().c_str());
 			return false;
 		}
+		//the material only works if the effect and textures it names are built too
+		AddReference(effectLocation);
 		effectLocation = relativeFolder + effectLocation;
 
-#if EAE6320_PLATFORM_D3D
-		const size_t maxHandleStringLength = std::numeric_limits<uintptr_t>::max();
-#elif EAE6320_PLATFORM_GL
-		const size_t maxHandleStringLength = static_cast<size_t>(std::numeric_limits<Lame::Effect::ConstantHandle>::max());
-#else
-#error Platform must define a max length for the ConstantHandle
-#endif
-		//update the handles to contain the length of the parameter's name
 		for (size_t x = 0; x < uniforms.size(); x++)
 		{
 			//append the relative built assets folder
 			if (uniform_texture_names[x].size() > 0)
 			{
+				AddReference(uniform_texture_names[x]);
 				uniform_texture_names[x] = relativeFolder + uniform_texture_names[x];
-
-				//fill the texture slot with the texture name length
-				uniforms[x].texture = reinterpret_cast<Lame::Texture*>(static_cast<uintptr_t>(uniform_texture_names[x].size()));
-			}
-			else
-			{
-				uniforms[x].texture = nullptr;
 			}
 
-			//fill the handle slot with the parameter name length
-#if EAE6320_PLATFORM_D3D
-			uniforms[x].handle = std::make_tuple(reinterpret_cast<char*>(static_cast<uintptr_t>(uniform_names[x].size())), static_cast<DWORD>(0));
-#elif EAE6320_PLATFORM_GL
-			uniforms[x].handle = static_cast<Lame::Effect::ConstantHandle>(uniform_names[x].size());
-#else
-#error Platform undefined for setting the uniform handle size
-#endif
-			//warn about parameter name string length being too long
-			if (uniform_names[x].size() > maxHandleStringLength)
+			//the runtime can't cache two parameters for the same uniform
+			for (size_t y = 0; y < x; y++)
 			{
-				std::stringstream error;
-				error << "Length of parameter name (" << uniform_names[x] << ") for material "
-					<< m_path_source << " is greater than " << maxHandleStringLength 
-					<< " (actual value=" << uniform_names[x].size() << ")";
-				eae6320::OutputErrorMessage(error.str().c_str(), m_path_source);
-				return false;
+				if (Lame::HashedString::Hash(uniform_names[x].c_str()) == Lame::HashedString::Hash(uniform_names[y].c_str()))
+				{
+					std::stringstream error;
+					error << "Uniform " << x << " (" << uniform_names[x] << ") has the same name as uniform " << y << " (" << uniform_names[y] << ")";
+					eae6320::OutputErrorMessage(error.str().c_str(), m_path_source);
+					return false;
+				}
 			}
 		}
 	}
@@ -255,45 +261,39 @@ bool MaterialBuilder::Build(const std::vector<std::string>&)
 			return false;
 		}
 
-		//effect length and string
-		uint8_t effectStringLength = static_cast<uint8_t>(effectLocation.size());
-		//warn about effect string length being too long
-		if (effectLocation.length() > std::numeric_limits<uint8_t>::max())
+		//the header, then the parameters, then the strings they all refer to
+		Lame::File::MaterialHeader header = {};
+		header.magic = Lame::File::MaterialMagic;
+		header.version = Lame::File::MaterialVersion;
+		header.header_size = sizeof(header);
+		header.parameter_offset = sizeof(header);
+		header.parameter_count = static_cast<uint32_t>(uniforms.size());
+		header.string_offset = static_cast<uint32_t>(header.parameter_offset + sizeof(Lame::File::MaterialParameter) * uniforms.size());
+
+		StringTable strings(header.string_offset);
+		header.effect = strings.Add(effectLocation);
+		for (size_t x = 0; x < uniforms.size(); x++)
 		{
-			std::stringstream error;
-			error << "Length of effect path for material " << m_path_source << " is greater than "
-				<< sizeof(effectStringLength) << " (actual value=" << effectLocation.length() << ")";
-			eae6320::OutputErrorMessage(error.str().c_str(), m_path_source);
-			return false;
+			uniforms[x].name = strings.Add(uniform_names[x]);
+			if (uniform_texture_names[x].size() > 0)
+				uniforms[x].texture = strings.Add(uniform_texture_names[x]);
 		}
-
-		out.write(reinterpret_cast<char*>(&effectStringLength), sizeof(effectStringLength));
-		out.write(effectLocation.c_str(), effectLocation.size() + 1);
-
-		//warn about parameter count being too big
-		if (uniforms.size() > std::numeric_limits<uint8_t>::max())
+		if (static_cast<uint64_t>(header.string_offset) + strings.data().size() > UINT32_MAX)
 		{
-			std::stringstream error;
-			error << "Number of parameters for material " << m_path_source << " is greater than "
-				<< std::numeric_limits<uint8_t>::max() << " (actual value=" << uniforms.size() << ")";
-			eae6320::OutputErrorMessage(error.str().c_str(), m_path_source);
+			eae6320::OutputErrorMessage("The material is too large to fit in a material binary file", m_path_source);
 			return false;
 		}
-		uint8_t paramCount = static_cast<uint8_t>(uniforms.size());
-		out.write(reinterpret_cast<char*>(&paramCount), sizeof(paramCount));
+		header.string_size = static_cast<uint32_t>(strings.data().size());
+		header.file_size = header.string_offset + header.string_size;
 
+		out.write(reinterpret_cast<const char*>(&header), sizeof(header));
 		if (uniforms.size() > 0)
+			out.write(reinterpret_cast<const char*>(uniforms.data()), sizeof(uniforms[0]) * uniforms.size());
+		out.write(strings.data().data(), strings.data().size());
+		if (!out)
 		{
-			//parameter values
-			out.write(reinterpret_cast<char*>(uniforms.data()), sizeof(uniforms.data()[0]) * uniforms.size());
-
-			//parameter names and texture names
-			for (size_t x = 0; x < uniforms.size(); x++)
-			{
-				out.write(uniform_names[x].c_str(), uniform_names[x].size() + 1);
-				if (uniforms[x].texture)
-					out.write(uniform_texture_names[x].c_str(), uniform_texture_names[x].size() + 1);
-			}
+			eae6320::OutputErrorMessage("Failed to write the material binary file", m_path_target);
+			return false;
 		}
 
 		out.close();
@@ -308,4 +308,19 @@ namespace
 		for (size_t x = 0; x < io_str.size(); x++)
 			io_str[x] = tolower(io_str[x]);
 	}
+
+	Lame::File::MaterialString StringTable::Add(const std::string& i_string)
+	{
+		auto itr = added_.find(i_string);
+		if (itr != added_.end())
+			return itr->second;
+
+		Lame::File::MaterialString string;
+		string.offset = offset_ + static_cast<uint32_t>(data_.size());
+		string.length = static_cast<uint32_t>(i_string.size());
+		string.hash = Lame::HashedString::Hash(i_string.c_str());
+		data_.insert(data_.end(), i_string.c_str(), i_string.c_str() + i_string.size() + 1);
+		added_[i_string] = string;
+		return string;
+	}
 }
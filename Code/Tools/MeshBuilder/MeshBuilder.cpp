@@ -6,28 +6,73 @@
 #include <sstream>
 #include <cassert>
 #include <fstream>
+#include <iostream>
+#include <map>
+#include <tuple>
+#include <cstdlib>
+#include <algorithm>
+#include <unordered_map>
 
 #include "../../Engine/Windows/Functions.h"
 
 #include "../../External/Lua/Includes.h"
 #include "../../Engine/Core/Vertex.h"
+#include "../../Engine/Core/MeshCluster.h"
+#include "../../Engine/Core/CompressedVertex.h"
+#include "../../Engine/Core/Bounds.h"
 
 #include "../../External/Lua/LuaHelper.h"
+#include "../../Engine/System/FileLoader.h"
+
+#include "MeshOptimizer.h"
+#include "MeshSimplifier.h"
+#include "MeshSource.h"
 
 namespace
 {
-	bool LoadMesh(const std::string& i_source, std::vector<Lame::Vertex>& o_vertices, std::vector<uint32_t>& o_indices);
+	using MeshSource::TangentFrame;
+
+	bool LoadMesh(const std::string& i_source, std::vector<Lame::Vertex>& o_vertices, std::vector<TangentFrame>& o_frames, std::vector<uint32_t>& o_indices);
+
+	//reads the 3 numbers at i_key of the table on top of the stack, returns false if it is missing
+	bool PeekVector3(LuaHelper::LuaStack* i_stack, const char* i_key, Lame::Vector3& o_vector);
+
+	//strips a mesh down to welded positions and simplifies it to at most i_max_triangles, for occlusion culling.
+	// Returns false if it can't get that low without moving the surface further than the occluder error allows.
+	bool BuildOccluder(const std::vector<Lame::Vertex>& i_vertices, const std::vector<uint32_t>& i_indices, const size_t i_max_triangles,
+		std::vector<Lame::Vector3>& o_positions, std::vector<uint32_t>& o_indices);
+
+	//simplifies the mesh once per error (relative to the mesh's radius), appending each new LOD's indices to io_indices
+	void BuildLods(const std::vector<Lame::Vertex>& i_vertices, std::vector<uint32_t>& io_indices, const std::vector<float>& i_relative_errors,
+		std::vector<Lame::File::MeshLod>& o_lods);
+
+	//splits the index buffer into sections that each use at most MaxVerticesPer16BitIndices vertices, giving every section
+	// its own copy of the vertices it uses and making its indices relative to them.  Each LOD starts a new section,
+	// and clusters are never split between two.
+	void BuildSections(std::vector<Lame::Vertex>& io_vertices, std::vector<TangentFrame>& io_frames, std::vector<uint32_t>& io_indices,
+		const std::vector<Lame::File::MeshLod>& i_lods, const std::vector<Lame::MeshCluster>& i_clusters, std::vector<Lame::File::MeshSection>& o_sections);
 
-	template<typename CountType, typename VertexType, typename IndexType>
-	bool WriteMeshBinary(const std::string& i_target, const std::vector<VertexType>& i_vertices, const std::vector<IndexType>& i_indices);
+	//a header for vertices of i_format inside i_bounds, with positions that need no decoding
+	Lame::File::MeshHeader CreateMeshHeader(const Lame::VertexFormat i_format, const Lame::Bounds& i_bounds);
+
+	//gives o_block the next i_count * i_element_size bytes from io_offset, and moves io_offset to the next aligned offset after them
+	void PlaceMeshBlock(Lame::File::MeshBlock& o_block, const size_t i_count, const size_t i_element_size, uint32_t& io_offset);
+
+	//writes i_header (which has its layout, position decode and bounds filled in) followed by each block of the mesh
+	template<typename VertexType, typename IndexType>
+	bool WriteMeshBinary(const std::string& i_target, Lame::File::MeshHeader i_header, const std::vector<VertexType>& i_vertices, const std::vector<IndexType>& i_indices,
+		const std::vector<Lame::File::MeshLod>& i_lods = std::vector<Lame::File::MeshLod>(),
+		const std::vector<Lame::MeshCluster>& i_clusters = std::vector<Lame::MeshCluster>(),
+		const std::vector<Lame::File::MeshSection>& i_sections = std::vector<Lame::File::MeshSection>());
 }
 
 bool eae6320::MeshBuilder::Build( const std::vector<std::string>& i_arguments )
 {
 	std::vector<Lame::Vertex> vertices;
+	std::vector<TangentFrame> frames;
 	std::vector<uint32_t> indices;
 
-	if (!LoadMesh(m_path_source, vertices, indices))
+	if (!LoadMesh(m_path_source, vertices, frames, indices))
 		return false;
 
 	//loaded indices are right-handed
@@ -40,13 +85,249 @@ bool eae6320::MeshBuilder::Build( const std::vector<std::string>& i_arguments )
 	//the indices are already in order.
 #endif
 
-	return WriteMeshBinary<uint32_t>(m_path_target, vertices, indices);
+	std::vector<float> lodErrors;
+	size_t clusterTriangles = 0;
+	bool compress = false;
+	bool stats = false;
+	float overdrawThreshold = 0.0f;
+	for (size_t x = 0; x < i_arguments.size(); x++)
+	{
+		//"compress" stores quantized vertices along with their tangent frames (see Lame::CompressedVertex)
+		if (i_arguments[x] == "compress")
+			compress = true;
+
+		//"stats" prints how well the vertex cache is used (ACMR, transformed vertices per triangle) before and after optimizing
+		if (i_arguments[x] == "stats")
+			stats = true;
+
+		//"occluder [triangles]" writes only the positions, which is all the software occlusion buffer needs,
+		// simplified to at most that many triangles (256 by default) since the occlusion buffer rasterizes them every frame
+		if (i_arguments[x] == "occluder")
+		{
+			size_t occluderTriangles = 256;
+			if (x + 1 < i_arguments.size())
+			{
+				char *end;
+				const long triangles = strtol(i_arguments[x + 1].c_str(), &end, 10);
+				if (end != i_arguments[x + 1].c_str() && *end == '\0')
+				{
+					if (triangles <= 0)
+					{
+						eae6320::OutputErrorMessage("Occluders must hold at least one triangle", m_path_source);
+						return false;
+					}
+					occluderTriangles = static_cast<size_t>(triangles);
+				}
+			}
+
+			std::vector<Lame::Vector3> positions;
+			std::vector<uint32_t> occluderIndices;
+			if (!BuildOccluder(vertices, indices, occluderTriangles, positions, occluderIndices))
+			{
+				std::stringstream error;
+				error << "The mesh can't be simplified to " << occluderTriangles << " triangles without changing its shape too much to be an occluder. "
+					"Use a simpler mesh, or allow more triangles with \"occluder <triangles>\"";
+				eae6320::OutputErrorMessage(error.str().c_str(), m_path_source);
+				return false;
+			}
+			Lame::Bounds bounds;
+			for (size_t p = 0; p < positions.size(); p++)
+				bounds.Encapsulate(positions[p]);
+			return WriteMeshBinary(m_path_target, CreateMeshHeader(Lame::VertexFormat::Position, bounds), positions, occluderIndices);
+		}
+
+		//"lod 0.01 0.05 ..." adds a level of detail for each error, as a fraction of the mesh's radius
+		if (i_arguments[x] == "lod")
+		{
+			while (x + 1 < i_arguments.size())
+			{
+				char *end;
+				const float error = strtof(i_arguments[x + 1].c_str(), &end);
+				if (end == i_arguments[x + 1].c_str() || *end != '\0')
+					break;
+				if (error <= 0.0f || (!lodErrors.empty() && error <= lodErrors.back()))
+				{
+					eae6320::OutputErrorMessage("LOD errors must be positive and increasing", m_path_source);
+					return false;
+				}
+				lodErrors.push_back(error);
+				++x;
+			}
+		}
+
+		//"clusters [triangles]" splits the full detail mesh into clusters the renderer can cull, 128 triangles each by default
+		if (i_arguments[x] == "clusters")
+		{
+			clusterTriangles = 128;
+			if (x + 1 < i_arguments.size())
+			{
+				char *end;
+				const long triangles = strtol(i_arguments[x + 1].c_str(), &end, 10);
+				if (end != i_arguments[x + 1].c_str() && *end == '\0')
+				{
+					if (triangles <= 0)
+					{
+						eae6320::OutputErrorMessage("Clusters must hold at least one triangle", m_path_source);
+						return false;
+					}
+					clusterTriangles = static_cast<size_t>(triangles);
+					++x;
+				}
+			}
+		}
+
+		//"overdraw [threshold]" also orders triangles so the ones likely to hide others are drawn first,
+		// letting the vertex cache do up to threshold times worse than it could (1.05 by default)
+		if (i_arguments[x] == "overdraw")
+		{
+			overdrawThreshold = 1.05f;
+			if (x + 1 < i_arguments.size())
+			{
+				char *end;
+				const float threshold = strtof(i_arguments[x + 1].c_str(), &end);
+				if (end != i_arguments[x + 1].c_str() && *end == '\0')
+				{
+					if (threshold < 1.0f)
+					{
+						eae6320::OutputErrorMessage("The overdraw threshold can't be less than 1", m_path_source);
+						return false;
+					}
+					overdrawThreshold = threshold;
+					++x;
+				}
+			}
+		}
+	}
+
+#if EAE6320_PLATFORM_D3D
+	const bool leftHanded = true;
+#elif EAE6320_PLATFORM_GL
+	const bool leftHanded = false;
+#endif
+	const float acmrBefore = stats ? MeshOptimizer::GetAcmr(indices.data(), indices.size(), vertices.size()) : 0.0f;
+
+	//clustering reorders the full detail triangles, so it has to happen before they are simplified
+	std::vector<Lame::MeshCluster> clusters;
+	if (clusterTriangles > 0)
+	{
+		if (!Lame::BuildMeshClusters(vertices.data(), vertices.size(), indices.data(), indices.size(), clusterTriangles, leftHanded, clusters))
+		{
+			eae6320::OutputErrorMessage("Failed to split the mesh into clusters", m_path_source);
+			return false;
+		}
+	}
+
+	//the triangles of each cluster are reordered among themselves, so the clusters stay intact
+	if (clusters.empty())
+	{
+		MeshOptimizer::OptimizeVertexCache(indices.data(), indices.size(), vertices.size());
+		if (overdrawThreshold > 0.0f)
+			MeshOptimizer::OptimizeOverdraw(vertices.data(), vertices.size(), indices.data(), indices.size(), leftHanded, overdrawThreshold);
+	}
+	else
+	{
+		for (size_t x = 0; x < clusters.size(); x++)
+			MeshOptimizer::OptimizeVertexCache(indices.data() + clusters[x].first_index, clusters[x].index_count, vertices.size());
+		if (overdrawThreshold > 0.0f)
+			MeshOptimizer::OptimizeClusterOverdraw(vertices.data(), vertices.size(), indices.data(), clusters);
+	}
+
+	std::vector<Lame::File::MeshLod> lods;
+	if (!lodErrors.empty())
+	{
+		BuildLods(vertices, indices, lodErrors, lods);
+		for (size_t x = 1; x < lods.size(); x++)
+			MeshOptimizer::OptimizeVertexCache(indices.data() + lods[x].first_index, lods[x].index_count, vertices.size());
+	}
+
+	//vertices are stored in the order the indices first use them, which also drops any that no triangle uses
+	{
+		std::vector<uint32_t> remap;
+		const size_t usedVertices = MeshOptimizer::OptimizeVertexFetch(indices.data(), indices.size(), vertices.size(), remap);
+		std::vector<Lame::Vertex> fetchVertices(usedVertices);
+		std::vector<TangentFrame> fetchFrames(usedVertices);
+		for (size_t x = 0; x < remap.size(); x++)
+		{
+			if (remap[x] == MeshOptimizer::UnusedVertex)
+				continue;
+			fetchVertices[remap[x]] = vertices[x];
+			fetchFrames[remap[x]] = frames[x];
+		}
+		vertices.swap(fetchVertices);
+		frames.swap(fetchFrames);
+	}
+	if (stats)
+	{
+		//only the full detail triangles, the same ones that were measured before
+		const size_t fullDetailCount = lods.empty() ? indices.size() : lods[0].index_count;
+		const float acmrAfter = MeshOptimizer::GetAcmr(indices.data(), fullDetailCount, vertices.size());
+		std::cout << m_path_source << ": ACMR " << acmrBefore << " -> " << acmrAfter << "\n";
+	}
+
+	//16 bit indices are used whenever they are smaller, which for meshes with too many vertices means
+	// splitting them into sections that each need copies of the vertices they share with the others
+	const size_t vertexSize = compress ? sizeof(Lame::CompressedVertex) : sizeof(Lame::Vertex);
+	bool use16BitIndices = vertices.size() <= Lame::File::MaxVerticesPer16BitIndices;
+	std::vector<Lame::File::MeshSection> sections;
+	if (!use16BitIndices)
+	{
+		std::vector<Lame::Vertex> sectionVertices(vertices);
+		std::vector<TangentFrame> sectionFrames(frames);
+		std::vector<uint32_t> sectionIndices(indices);
+		BuildSections(sectionVertices, sectionFrames, sectionIndices, lods, clusters, sections);
+		if (sectionIndices.size() * sizeof(uint16_t) + sectionVertices.size() * vertexSize < indices.size() * sizeof(uint32_t) + vertices.size() * vertexSize)
+		{
+			use16BitIndices = true;
+			vertices.swap(sectionVertices);
+			frames.swap(sectionFrames);
+			indices.swap(sectionIndices);
+		}
+		else
+		{
+			sections.clear();
+		}
+	}
+
+	Lame::File::MeshHeader header = CreateMeshHeader(Lame::VertexFormat::Full, Lame::Bounds::Create(vertices.data(), vertices.size()));
+	std::vector<Lame::CompressedVertex> compressed;
+	if (compress)
+	{
+		Lame::Vector3 offset, scale;
+		Lame::VertexCompression::GetPositionDecode(Lame::Bounds::Create(vertices.data(), vertices.size()), offset, scale);
+		header.vertex_format = static_cast<uint32_t>(Lame::VertexFormat::Compressed);
+		header.position_offset[0] = offset.x();
+		header.position_offset[1] = offset.y();
+		header.position_offset[2] = offset.z();
+		header.position_scale[0] = scale.x();
+		header.position_scale[1] = scale.y();
+		header.position_scale[2] = scale.z();
+
+		compressed.resize(vertices.size());
+		for (size_t x = 0; x < vertices.size(); x++)
+			compressed[x] = Lame::VertexCompression::Compress(vertices[x], frames[x].normal, frames[x].tangent, frames[x].bitangent, offset, scale);
+	}
+
+	if (use16BitIndices)
+	{
+		const std::vector<uint16_t> indices16(indices.begin(), indices.end());
+		return compress ?
+			WriteMeshBinary(m_path_target, header, compressed, indices16, lods, clusters, sections) :
+			WriteMeshBinary(m_path_target, header, vertices, indices16, lods, clusters, sections);
+	}
+	return compress ?
+		WriteMeshBinary(m_path_target, header, compressed, indices, lods, clusters, sections) :
+		WriteMeshBinary(m_path_target, header, vertices, indices, lods, clusters, sections);
 }
 
 namespace
 {
-	bool LoadMesh(const std::string& i_source, std::vector<Lame::Vertex>& o_vertices, std::vector<uint32_t>& o_indices)
+	bool LoadMesh(const std::string& i_source, std::vector<Lame::Vertex>& o_vertices, std::vector<TangentFrame>& o_frames, std::vector<uint32_t>& o_indices)
 	{
+		//meshes from the exporter are read without Lua, which takes milliseconds instead of seconds for big ones.
+		// Anything it doesn't understand is loaded with Lua, which also reports what is wrong with broken files.
+		if (MeshSource::Parse(i_source, o_vertices, o_frames, o_indices))
+			return true;
+
 		LuaHelper::LuaStack *stack = LuaHelper::LuaStack::Create(i_source);
 		if (!stack)
 		{
@@ -62,22 +343,17 @@ namespace
 			for (size_t x = 0; x < vertexCount; x++)
 			{
 				Lame::Vertex vert;
+				TangentFrame frame;
 				//a single vertex's table
 				stack->Push(static_cast<lua_Unsigned>(x + 1));
 				if (stack->SwapTableKey() && stack->IsTable())
 				{
+					std::vector<double> position, texcoords, color;
+
 					//vertex position
 					{
-						std::vector<double> position;
 						stack->Push("pos");
-						if (stack->SwapTableKey() && stack->PeekArray(position) && position.size() == 3)
-						{
-							vert.position = Lame::Vector3(
-								static_cast<float>(position[0]),
-								static_cast<float>(position[1]),
-								static_cast<float>(position[2]));
-						}
-						else
+						if (!(stack->SwapTableKey() && stack->PeekArray(position) && position.size() == 3))
 						{
 							std::stringstream error;
 							error << "Invalid position table in vertex " << x;
@@ -90,14 +366,8 @@ namespace
 
 					//vertex texture coordinates
 					{
-						std::vector<double> texcoords;
 						stack->Push("texcoord");
-						if (stack->SwapTableKey() && stack->PeekArray(texcoords) && texcoords.size() == 2)
-						{
-							vert.texcoord.x(static_cast<float>(texcoords[0]));
-							vert.texcoord.y(1.0f - static_cast<float>(texcoords[1]));
-						}
-						else
+						if (!(stack->SwapTableKey() && stack->PeekArray(texcoords) && texcoords.size() == 2))
 						{
 							std::stringstream error;
 							error << "Invalid texcoord table in vertex " << x;
@@ -110,16 +380,8 @@ namespace
 
 					//vertex color
 					{
-						std::vector<double> color;
 						stack->Push("color");
-						if (stack->SwapTableKey() && stack->PeekArray(color) && color.size() == 4)
-						{
-							vert.color.r(static_cast<uint8_t>(color[0] * 255.0));
-							vert.color.g(static_cast<uint8_t>(color[1] * 255.0));
-							vert.color.b(static_cast<uint8_t>(color[2] * 255.0));
-							vert.color.a(static_cast<uint8_t>(color[3] * 255.0));
-						}
-						else
+						if (!(stack->SwapTableKey() && stack->PeekArray(color) && color.size() == 4))
 						{
 							std::stringstream error;
 							error << "Invalid color table in vertex " << x;
@@ -129,6 +391,16 @@ namespace
 						}
 						stack->Pop();
 					}
+
+					vert = MeshSource::MakeVertex(position.data(), texcoords.data(), color.data());
+
+					//vertex tangent frame, which older meshes don't have
+					if (!PeekVector3(stack, "normal", frame.normal) ||
+						!PeekVector3(stack, "tangent", frame.tangent) ||
+						!PeekVector3(stack, "bitangent", frame.bitangent))
+					{
+						frame = MeshSource::DefaultFrame();
+					}
 				}
 				else
 				{
@@ -141,6 +413,7 @@ namespace
 				stack->Pop();
 
 				o_vertices.push_back(vert);
+				o_frames.push_back(frame);
 			}
 		}
 		else
@@ -191,11 +464,237 @@ namespace
 		return true;
 	}
 
-	template<typename CountType, typename VertexType, typename IndexType>
-	bool WriteMeshBinary(const std::string& i_target, const std::vector<VertexType>& i_vertices, const std::vector<IndexType>& i_indices)
+	bool PeekVector3(LuaHelper::LuaStack* i_stack, const char* i_key, Lame::Vector3& o_vector)
+	{
+		std::vector<double> values;
+		i_stack->Push(i_key);
+		const bool found = i_stack->SwapTableKey() && i_stack->PeekArray(values) && values.size() == 3;
+		i_stack->Pop();
+		if (found)
+			o_vector.set(static_cast<float>(values[0]), static_cast<float>(values[1]), static_cast<float>(values[2]));
+		return found;
+	}
+
+	bool BuildOccluder(const std::vector<Lame::Vertex>& i_vertices, const std::vector<uint32_t>& i_indices, const size_t i_max_triangles,
+		std::vector<Lame::Vector3>& o_positions, std::vector<uint32_t>& o_indices)
+	{
+		//vertices that were only split for their texcoords or colors share a position again,
+		// and with nothing but positions left the simplifier doesn't have to keep any seams
+		typedef std::tuple<float, float, float> PositionKey;
+		std::map<PositionKey, uint32_t> welded;
+		std::vector<uint32_t> remap(i_vertices.size());
+		std::vector<Lame::Vertex> positionVertices;
+		for (size_t x = 0; x < i_vertices.size(); x++)
+		{
+			const Lame::Vector3& position = i_vertices[x].position;
+			const PositionKey key(position.x(), position.y(), position.z());
+			auto itr = welded.find(key);
+			if (itr == welded.end())
+			{
+				itr = welded.insert(std::make_pair(key, static_cast<uint32_t>(positionVertices.size()))).first;
+				positionVertices.push_back(Lame::Vertex(position, Lame::Vector2(0.0f, 0.0f), Lame::Color32(255, 255, 255)));
+			}
+			remap[x] = itr->second;
+		}
+
+		std::vector<uint32_t> weldedIndices;
+		for (size_t t = 0; t + 2 < i_indices.size(); t += 3)
+		{
+			const uint32_t a = remap[i_indices[t]], b = remap[i_indices[t + 1]], c = remap[i_indices[t + 2]];
+			if (a == b || b == c || c == a)
+				continue;
+			weldedIndices.push_back(a);
+			weldedIndices.push_back(b);
+			weldedIndices.push_back(c);
+		}
+
+		//the error is raised a step at a time, so the occluder keeps as much of its shape as its budget allows.
+		// An occluder that has moved too far would hide things that are really visible.
+		const float firstRelativeError = 0.005f;
+		const float maxRelativeError = 0.05f;
+		std::vector<uint32_t> simplifiedIndices(weldedIndices);
+		if (simplifiedIndices.size() > i_max_triangles * 3)
+		{
+			MeshSimplifier simplifier(positionVertices, weldedIndices);
+			for (float relativeError = firstRelativeError; simplifiedIndices.size() > i_max_triangles * 3; relativeError *= 1.5f)
+			{
+				if (relativeError > maxRelativeError)
+					return false;
+				simplifier.Simplify(relativeError * simplifier.radius(), simplifiedIndices);
+			}
+		}
+
+		//only the positions the simplified triangles still use are kept
+		std::vector<uint32_t> used(positionVertices.size(), UINT32_MAX);
+		for (size_t x = 0; x < simplifiedIndices.size(); x++)
+		{
+			uint32_t& position = used[simplifiedIndices[x]];
+			if (position == UINT32_MAX)
+			{
+				position = static_cast<uint32_t>(o_positions.size());
+				o_positions.push_back(positionVertices[simplifiedIndices[x]].position);
+			}
+			o_indices.push_back(position);
+		}
+		return true;
+	}
+
+	void BuildLods(const std::vector<Lame::Vertex>& i_vertices, std::vector<uint32_t>& io_indices, const std::vector<float>& i_relative_errors,
+		std::vector<Lame::File::MeshLod>& o_lods)
 	{
-		CountType vertexCount32 = static_cast<CountType>(i_vertices.size());
-		CountType indexCount32 = static_cast<CountType>(i_indices.size());
+		Lame::File::MeshLod full;
+		full.first_index = 0;
+		full.index_count = static_cast<uint32_t>(io_indices.size());
+		full.error = 0.0f;
+		o_lods.push_back(full);
+
+		MeshSimplifier simplifier(i_vertices, io_indices);
+		std::vector<uint32_t> lodIndices;
+		for (size_t x = 0; x < i_relative_errors.size(); x++)
+		{
+			const float error = simplifier.Simplify(i_relative_errors[x] * simplifier.radius(), lodIndices);
+
+			//a level that removed almost nothing would only cost memory
+			if (lodIndices.empty() || lodIndices.size() * 10 > o_lods.back().index_count * 9)
+				continue;
+
+			Lame::File::MeshLod lod;
+			lod.first_index = static_cast<uint32_t>(io_indices.size());
+			lod.index_count = static_cast<uint32_t>(lodIndices.size());
+			lod.error = error;
+			o_lods.push_back(lod);
+			io_indices.insert(io_indices.end(), lodIndices.begin(), lodIndices.end());
+		}
+
+		if (o_lods.size() == 1)
+			o_lods.clear();
+	}
+
+	void BuildSections(std::vector<Lame::Vertex>& io_vertices, std::vector<TangentFrame>& io_frames, std::vector<uint32_t>& io_indices,
+		const std::vector<Lame::File::MeshLod>& i_lods, const std::vector<Lame::MeshCluster>& i_clusters, std::vector<Lame::File::MeshSection>& o_sections)
+	{
+		//the runs of indices that have to stay in one section: clusters in the full detail mesh, and single triangles everywhere else
+		std::vector<size_t> runStarts;
+		std::vector<bool> lodStarts;
+		{
+			std::vector<Lame::File::MeshLod> lods(i_lods);
+			if (lods.empty())
+			{
+				Lame::File::MeshLod full;
+				full.first_index = 0;
+				full.index_count = static_cast<uint32_t>(io_indices.size());
+				lods.push_back(full);
+			}
+			size_t cluster = 0;
+			for (size_t l = 0; l < lods.size(); l++)
+			{
+				const size_t end = lods[l].first_index + lods[l].index_count;
+				for (size_t x = lods[l].first_index; x < end; )
+				{
+					while (cluster < i_clusters.size() && i_clusters[cluster].first_index < x)
+						cluster++;
+					const bool isCluster = l == 0 && cluster < i_clusters.size() && i_clusters[cluster].first_index == x;
+					runStarts.push_back(x);
+					lodStarts.push_back(x == lods[l].first_index);
+					x += isCluster ? i_clusters[cluster].index_count : 3;
+				}
+			}
+			runStarts.push_back(io_indices.size());
+		}
+
+		std::vector<Lame::Vertex> vertices;
+		std::vector<TangentFrame> frames;
+		std::unordered_map<uint32_t, uint32_t> local;
+		Lame::File::MeshSection section = { 0, 0, 0, 0 };
+		for (size_t r = 0; r + 1 < runStarts.size(); r++)
+		{
+			//count the vertices this run would add, to see if it still fits
+			std::vector<uint32_t> added;
+			for (size_t x = runStarts[r]; x < runStarts[r + 1]; x++)
+			{
+				if (local.find(io_indices[x]) == local.end() && std::find(added.begin(), added.end(), io_indices[x]) == added.end())
+					added.push_back(io_indices[x]);
+			}
+			if (runStarts[r] > section.first_index && (lodStarts[r] || local.size() + added.size() > Lame::File::MaxVerticesPer16BitIndices))
+			{
+				section.index_count = static_cast<uint32_t>(runStarts[r] - section.first_index);
+				section.vertex_count = static_cast<uint32_t>(local.size());
+				o_sections.push_back(section);
+				section.first_index = static_cast<uint32_t>(runStarts[r]);
+				section.base_vertex = static_cast<uint32_t>(vertices.size());
+				local.clear();
+			}
+
+			for (size_t x = runStarts[r]; x < runStarts[r + 1]; x++)
+			{
+				auto itr = local.find(io_indices[x]);
+				if (itr == local.end())
+				{
+					itr = local.insert(std::make_pair(io_indices[x], static_cast<uint32_t>(local.size()))).first;
+					vertices.push_back(io_vertices[io_indices[x]]);
+					frames.push_back(io_frames[io_indices[x]]);
+				}
+				io_indices[x] = itr->second;
+			}
+		}
+		section.index_count = static_cast<uint32_t>(io_indices.size() - section.first_index);
+		section.vertex_count = static_cast<uint32_t>(local.size());
+		if (section.index_count > 0)
+			o_sections.push_back(section);
+
+		io_vertices.swap(vertices);
+		io_frames.swap(frames);
+	}
+
+	Lame::File::MeshHeader CreateMeshHeader(const Lame::VertexFormat i_format, const Lame::Bounds& i_bounds)
+	{
+		Lame::File::MeshHeader header = {};
+		header.magic = Lame::File::MeshMagic;
+		header.version = Lame::File::MeshVersion;
+		header.header_size = sizeof(header);
+		header.vertex_format = static_cast<uint32_t>(i_format);
+		for (size_t x = 0; x < 3; x++)
+		{
+			header.position_offset[x] = 0.0f;
+			header.position_scale[x] = 1.0f;
+		}
+		//meshes without any vertices get empty bounds at the origin
+		const Lame::Vector3 boundsMin = i_bounds.IsValid() ? i_bounds.min() : Lame::Vector3::zero;
+		const Lame::Vector3 boundsMax = i_bounds.IsValid() ? i_bounds.max() : Lame::Vector3::zero;
+		header.bounds_min[0] = boundsMin.x();
+		header.bounds_min[1] = boundsMin.y();
+		header.bounds_min[2] = boundsMin.z();
+		header.bounds_max[0] = boundsMax.x();
+		header.bounds_max[1] = boundsMax.y();
+		header.bounds_max[2] = boundsMax.z();
+		return header;
+	}
+
+	void PlaceMeshBlock(Lame::File::MeshBlock& o_block, const size_t i_count, const size_t i_element_size, uint32_t& io_offset)
+	{
+		o_block.offset = i_count > 0 ? io_offset : 0;
+		o_block.count = static_cast<uint32_t>(i_count);
+		const size_t end = io_offset + i_count * i_element_size;
+		io_offset = static_cast<uint32_t>((end + Lame::File::MeshAlignment - 1) / Lame::File::MeshAlignment * Lame::File::MeshAlignment);
+	}
+
+	template<typename VertexType, typename IndexType>
+	bool WriteMeshBinary(const std::string& i_target, Lame::File::MeshHeader i_header, const std::vector<VertexType>& i_vertices, const std::vector<IndexType>& i_indices,
+		const std::vector<Lame::File::MeshLod>& i_lods, const std::vector<Lame::MeshCluster>& i_clusters, const std::vector<Lame::File::MeshSection>& i_sections)
+	{
+		//lay out the blocks after the header, each starting on an aligned offset
+		i_header.vertex_size = sizeof(VertexType);
+		i_header.index_size = sizeof(IndexType);
+		uint32_t offset = 0;
+		Lame::File::MeshBlock headerBlock;
+		PlaceMeshBlock(headerBlock, 1, sizeof(i_header), offset);
+		PlaceMeshBlock(i_header.vertices, i_vertices.size(), sizeof(VertexType), offset);
+		PlaceMeshBlock(i_header.indices, i_indices.size(), sizeof(IndexType), offset);
+		PlaceMeshBlock(i_header.sections, i_sections.size(), sizeof(Lame::File::MeshSection), offset);
+		PlaceMeshBlock(i_header.lods, i_lods.size(), sizeof(Lame::File::MeshLod), offset);
+		PlaceMeshBlock(i_header.clusters, i_clusters.size(), sizeof(Lame::MeshCluster), offset);
+		i_header.file_size = offset;
+
 		std::ofstream out(i_target, std::ofstream::binary);
 		if (!out)
 		{
@@ -203,12 +702,38 @@ namespace
 			return false;
 		}
 
-		//write the data
-		out.write(reinterpret_cast<char*>(&vertexCount32), sizeof(vertexCount32));
-		out.write(reinterpret_cast<char*>(&indexCount32), sizeof(indexCount32));
-		out.write(reinterpret_cast<const char*>(i_vertices.data()), sizeof(*i_vertices.data()) * i_vertices.size());
-		out.write(reinterpret_cast<const char*>(i_indices.data()), sizeof(*i_indices.data()) * i_indices.size());
+		//write each block at its offset, padding the gaps between them with zeros
+		const char padding[Lame::File::MeshAlignment] = {};
+		size_t written = 0;
+		struct Block
+		{
+			uint32_t offset;
+			const void *data;
+			size_t size;
+		};
+		const Block blocks[] = {
+			{ 0, &i_header, sizeof(i_header) },
+			{ i_header.vertices.offset, i_vertices.data(), sizeof(VertexType) * i_vertices.size() },
+			{ i_header.indices.offset, i_indices.data(), sizeof(IndexType) * i_indices.size() },
+			{ i_header.sections.offset, i_sections.data(), sizeof(Lame::File::MeshSection) * i_sections.size() },
+			{ i_header.lods.offset, i_lods.data(), sizeof(Lame::File::MeshLod) * i_lods.size() },
+			{ i_header.clusters.offset, i_clusters.data(), sizeof(Lame::MeshCluster) * i_clusters.size() },
+		};
+		for (size_t x = 0; x < sizeof(blocks) / sizeof(blocks[0]); x++)
+		{
+			if (blocks[x].size == 0)
+				continue;
+			out.write(padding, blocks[x].offset - written);
+			out.write(static_cast<const char*>(blocks[x].data), blocks[x].size);
+			written = blocks[x].offset + blocks[x].size;
+		}
+		out.write(padding, i_header.file_size - written);
 
+		if (!out)
+		{
+			eae6320::OutputErrorMessage("Failed to write the mesh binary file", i_target.c_str());
+			return false;
+		}
 		out.close();
 		return true;
 	}
@@ -0,0 +1,361 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "../../Engine/Core/Bounds.h"
+
+namespace
+{
+	//Forsyth's scoring, tuned for an LRU cache a little larger than the hardware's FIFO one
+	const size_t ScoringCacheSize = 32;
+	const float CacheDecayPower = 1.5f;
+	const float LastTriangleScore = 0.75f;
+	const float ValenceBoostScale = 2.0f;
+	const float ValenceBoostPower = 0.5f;
+
+	float GetVertexScore(const int i_cache_position, const uint32_t i_remaining_triangles)
+	{
+		//vertices with nothing left to draw don't make any triangle more attractive
+		if (i_remaining_triangles == 0)
+			return -1.0f;
+
+		float score = 0.0f;
+		if (i_cache_position >= 0)
+		{
+			//the last triangle's vertices get a fixed score, so the next triangle doesn't just reuse its edge and strip along
+			if (i_cache_position < 3)
+				score = LastTriangleScore;
+			else
+				score = std::pow(1.0f - static_cast<float>(i_cache_position - 3) / (ScoringCacheSize - 3), CacheDecayPower);
+		}
+
+		//vertices with few triangles left are finished off first, so they don't have to come back into the cache later
+		return score + ValenceBoostScale * std::pow(static_cast<float>(i_remaining_triangles), -ValenceBoostPower);
+	}
+
+	//the direction a triangle faces, scaled by twice its area
+	Lame::Vector3 GetAreaNormal(const Lame::Vertex* i_vertices, const uint32_t* i_triangle, const bool i_left_handed)
+	{
+		const Lame::Vector3& a = i_vertices[i_triangle[0]].position;
+		const Lame::Vector3& b = i_vertices[i_triangle[1]].position;
+		const Lame::Vector3& c = i_vertices[i_triangle[2]].position;
+		const Lame::Vector3 normal = (b - a).cross(c - a);
+		return i_left_handed ? -normal : normal;
+	}
+
+	//runs facing out from the center are likely to be in front of the rest of the mesh
+	float GetOcclusionKey(const Lame::Vector3& i_centroid, const Lame::Vector3& i_normal, const Lame::Vector3& i_mesh_center)
+	{
+		const float length = i_normal.magnitude();
+		return length > 0.0f ? (i_centroid - i_mesh_center).dot(i_normal / length) : 0.0f;
+	}
+
+	struct Run
+	{
+		size_t first_index;
+		size_t index_count;
+		float key;
+	};
+
+	//draws the runs from the most to the least likely to hide the others
+	void SortRuns(std::vector<Run>& io_runs, uint32_t* io_indices)
+	{
+		std::stable_sort(io_runs.begin(), io_runs.end(), [](const Run& i_lhs, const Run& i_rhs) { return i_lhs.key > i_rhs.key; });
+
+		const size_t firstIndex = io_runs.empty() ? 0 : std::min_element(io_runs.begin(), io_runs.end(),
+			[](const Run& i_lhs, const Run& i_rhs) { return i_lhs.first_index < i_rhs.first_index; })->first_index;
+		std::vector<uint32_t> sorted;
+		for (size_t r = 0; r < io_runs.size(); r++)
+			sorted.insert(sorted.end(), io_indices + io_runs[r].first_index, io_indices + io_runs[r].first_index + io_runs[r].index_count);
+		std::copy(sorted.begin(), sorted.end(), io_indices + firstIndex);
+	}
+}
+
+namespace MeshOptimizer
+{
+	float GetAcmr(const uint32_t* i_indices, const size_t i_index_count, const size_t i_vertex_count, const size_t i_cache_size)
+	{
+		if (i_index_count < 3)
+			return 0.0f;
+
+		//a vertex is still in the cache if fewer than i_cache_size misses have happened since it was last loaded
+		std::vector<size_t> loadedAt(i_vertex_count, 0);
+		size_t misses = 0;
+		for (size_t x = 0; x < i_index_count; x++)
+		{
+			const uint32_t vertex = i_indices[x];
+			if (vertex >= i_vertex_count)
+				continue;
+			if (loadedAt[vertex] == 0 || misses - loadedAt[vertex] >= i_cache_size)
+			{
+				misses++;
+				loadedAt[vertex] = misses;
+			}
+		}
+		return static_cast<float>(misses) / (i_index_count / 3);
+	}
+
+	void OptimizeVertexCache(uint32_t* io_indices, const size_t i_index_count, const size_t i_vertex_count)
+	{
+		const size_t triangleCount = i_index_count / 3;
+		if (triangleCount < 2)
+			return;
+		for (size_t x = 0; x < triangleCount * 3; x++)
+		{
+			if (io_indices[x] >= i_vertex_count)
+				return;
+		}
+
+		//the triangles that use each vertex, with the ones already drawn swapped past the end of each vertex's range
+		std::vector<uint32_t> remaining(i_vertex_count, 0);
+		for (size_t x = 0; x < triangleCount * 3; x++)
+			remaining[io_indices[x]]++;
+		std::vector<size_t> firstTriangle(i_vertex_count + 1, 0);
+		for (size_t v = 0; v < i_vertex_count; v++)
+			firstTriangle[v + 1] = firstTriangle[v] + remaining[v];
+		std::vector<uint32_t> vertexTriangles(triangleCount * 3);
+		{
+			std::vector<size_t> filled(firstTriangle.begin(), firstTriangle.end() - 1);
+			for (size_t x = 0; x < triangleCount * 3; x++)
+				vertexTriangles[filled[io_indices[x]]++] = static_cast<uint32_t>(x / 3);
+		}
+
+		std::vector<int> cachePosition(i_vertex_count, -1);
+		std::vector<float> vertexScores(i_vertex_count);
+		for (size_t v = 0; v < i_vertex_count; v++)
+			vertexScores[v] = GetVertexScore(-1, remaining[v]);
+
+		std::vector<float> triangleScores(triangleCount);
+		std::vector<bool> drawn(triangleCount, false);
+		size_t bestTriangle = 0;
+		for (size_t t = 0; t < triangleCount; t++)
+		{
+			const uint32_t* tri = io_indices + t * 3;
+			triangleScores[t] = vertexScores[tri[0]] + vertexScores[tri[1]] + vertexScores[tri[2]];
+			if (triangleScores[t] > triangleScores[bestTriangle])
+				bestTriangle = t;
+		}
+
+		std::vector<uint32_t> sorted;
+		sorted.reserve(triangleCount * 3);
+		std::vector<uint32_t> cache, newCache;
+		cache.reserve(ScoringCacheSize + 3);
+		newCache.reserve(ScoringCacheSize + 3);
+		size_t nextUndrawn = 0;
+		while (sorted.size() < triangleCount * 3)
+		{
+			//when nothing in the cache has triangles left, carry on from the first triangle that hasn't been drawn
+			if (bestTriangle == triangleCount)
+			{
+				while (drawn[nextUndrawn])
+					nextUndrawn++;
+				bestTriangle = nextUndrawn;
+			}
+
+			const uint32_t* tri = io_indices + bestTriangle * 3;
+			sorted.insert(sorted.end(), tri, tri + 3);
+			drawn[bestTriangle] = true;
+
+			//the triangle's vertices move to the front of the cache
+			newCache.assign(tri, tri + 3);
+			for (size_t c = 0; c < cache.size(); c++)
+			{
+				if (cache[c] != tri[0] && cache[c] != tri[1] && cache[c] != tri[2])
+					newCache.push_back(cache[c]);
+			}
+			for (size_t v = 0; v < 3; v++)
+			{
+				const uint32_t vertex = tri[v];
+				uint32_t* triangles = vertexTriangles.data() + firstTriangle[vertex];
+				for (uint32_t r = 0; r < remaining[vertex]; r++)
+				{
+					if (triangles[r] == bestTriangle)
+					{
+						std::swap(triangles[r], triangles[remaining[vertex] - 1]);
+						break;
+					}
+				}
+				remaining[vertex]--;
+			}
+
+			for (size_t c = 0; c < newCache.size(); c++)
+			{
+				const uint32_t vertex = newCache[c];
+				cachePosition[vertex] = c < ScoringCacheSize ? static_cast<int>(c) : -1;
+				vertexScores[vertex] = GetVertexScore(cachePosition[vertex], remaining[vertex]);
+			}
+
+			//only the triangles around the cached vertices changed score, and the best of them is drawn next
+			bestTriangle = triangleCount;
+			float bestScore = -1.0f;
+			for (size_t c = 0; c < newCache.size(); c++)
+			{
+				const uint32_t vertex = newCache[c];
+				const uint32_t* triangles = vertexTriangles.data() + firstTriangle[vertex];
+				for (uint32_t r = 0; r < remaining[vertex]; r++)
+				{
+					const uint32_t t = triangles[r];
+					const uint32_t* other = io_indices + t * 3;
+					triangleScores[t] = vertexScores[other[0]] + vertexScores[other[1]] + vertexScores[other[2]];
+					if (c < ScoringCacheSize && triangleScores[t] > bestScore)
+					{
+						bestScore = triangleScores[t];
+						bestTriangle = t;
+					}
+				}
+			}
+
+			if (newCache.size() > ScoringCacheSize)
+				newCache.resize(ScoringCacheSize);
+			cache.swap(newCache);
+		}
+		std::copy(sorted.begin(), sorted.end(), io_indices);
+	}
+
+	void OptimizeOverdraw(const Lame::Vertex* i_vertices, const size_t i_vertex_count, uint32_t* io_indices, const size_t i_index_count,
+		const bool i_left_handed, const float i_threshold)
+	{
+		const size_t triangleCount = i_index_count / 3;
+		if (triangleCount < 2)
+			return;
+		for (size_t x = 0; x < triangleCount * 3; x++)
+		{
+			if (io_indices[x] >= i_vertex_count)
+				return;
+		}
+
+		//hard boundaries are where the cache starts over anyway, at triangles whose vertices all miss
+		std::vector<size_t> hardStarts;
+		{
+			std::vector<size_t> loadedAt(i_vertex_count, 0);
+			size_t misses = 0;
+			for (size_t t = 0; t < triangleCount; t++)
+			{
+				size_t triangleMisses = 0;
+				for (size_t v = 0; v < 3; v++)
+				{
+					const uint32_t vertex = io_indices[t * 3 + v];
+					if (loadedAt[vertex] == 0 || misses - loadedAt[vertex] >= CacheSize)
+					{
+						misses++;
+						triangleMisses++;
+						loadedAt[vertex] = misses;
+					}
+				}
+				if (t == 0 || triangleMisses == 3)
+					hardStarts.push_back(t);
+			}
+			hardStarts.push_back(triangleCount);
+		}
+
+		//each hard run is split again wherever the triangles so far are already about as cache friendly as the whole run,
+		// since starting over there costs little
+		std::vector<Run> runs;
+		std::vector<size_t> loadedAt(i_vertex_count, 0);
+		for (size_t h = 0; h + 1 < hardStarts.size(); h++)
+		{
+			const size_t begin = hardStarts[h], end = hardStarts[h + 1];
+			const float maxAcmr = GetAcmr(io_indices + begin * 3, (end - begin) * 3, i_vertex_count) * i_threshold;
+
+			size_t runStart = begin, misses = 0, clock = 0;
+			std::fill(loadedAt.begin(), loadedAt.end(), 0);
+			for (size_t t = begin; t < end; t++)
+			{
+				for (size_t v = 0; v < 3; v++)
+				{
+					const uint32_t vertex = io_indices[t * 3 + v];
+					if (loadedAt[vertex] == 0 || clock - loadedAt[vertex] >= CacheSize)
+					{
+						misses++;
+						clock++;
+						loadedAt[vertex] = clock;
+					}
+				}
+
+				const size_t runTriangles = t + 1 - runStart;
+				if (t + 1 == end || static_cast<float>(misses) / runTriangles <= maxAcmr)
+				{
+					Run run;
+					run.first_index = runStart * 3;
+					run.index_count = runTriangles * 3;
+					run.key = 0.0f;
+					runs.push_back(run);
+
+					runStart = t + 1;
+					misses = 0;
+					//the cache starts empty again, so later runs are measured the same way however they end up ordered
+					clock += CacheSize;
+				}
+			}
+		}
+		if (runs.size() < 2)
+			return;
+
+		const Lame::Vector3 meshCenter = Lame::Bounds::Create(i_vertices, i_vertex_count).center();
+		for (size_t r = 0; r < runs.size(); r++)
+		{
+			Lame::Vector3 centroid = Lame::Vector3::zero, normal = Lame::Vector3::zero;
+			float area = 0.0f;
+			for (size_t x = runs[r].first_index; x < runs[r].first_index + runs[r].index_count; x += 3)
+			{
+				const uint32_t* tri = io_indices + x;
+				const Lame::Vector3 areaNormal = GetAreaNormal(i_vertices, tri, i_left_handed);
+				const float triangleArea = areaNormal.magnitude();
+				centroid += (i_vertices[tri[0]].position + i_vertices[tri[1]].position + i_vertices[tri[2]].position) * (triangleArea / 3.0f);
+				normal += areaNormal;
+				area += triangleArea;
+			}
+			runs[r].key = area > 0.0f ? GetOcclusionKey(centroid / area, normal, meshCenter) : 0.0f;
+		}
+		SortRuns(runs, io_indices);
+	}
+
+	void OptimizeClusterOverdraw(const Lame::Vertex* i_vertices, const size_t i_vertex_count, uint32_t* io_indices, std::vector<Lame::MeshCluster>& io_clusters)
+	{
+		if (io_clusters.size() < 2)
+			return;
+
+		const Lame::Vector3 meshCenter = Lame::Bounds::Create(i_vertices, i_vertex_count).center();
+		std::vector<Run> runs(io_clusters.size());
+		std::vector<size_t> order(io_clusters.size());
+		for (size_t c = 0; c < io_clusters.size(); c++)
+		{
+			const Lame::MeshCluster& cluster = io_clusters[c];
+			runs[c].first_index = cluster.first_index;
+			runs[c].index_count = cluster.index_count;
+			runs[c].key = GetOcclusionKey(cluster.bounds().center(),
+				Lame::Vector3(cluster.cone_axis[0], cluster.cone_axis[1], cluster.cone_axis[2]), meshCenter);
+			order[c] = c;
+		}
+		std::stable_sort(order.begin(), order.end(), [&runs](const size_t i_lhs, const size_t i_rhs) { return runs[i_lhs].key > runs[i_rhs].key; });
+		SortRuns(runs, io_indices);
+
+		//the clusters follow their indices
+		std::vector<Lame::MeshCluster> sorted(io_clusters.size());
+		uint32_t firstIndex = io_clusters.front().first_index;
+		for (size_t c = 0; c < order.size(); c++)
+		{
+			sorted[c] = io_clusters[order[c]];
+			sorted[c].first_index = firstIndex;
+			firstIndex += sorted[c].index_count;
+		}
+		io_clusters.swap(sorted);
+	}
+
+	size_t OptimizeVertexFetch(uint32_t* io_indices, const size_t i_index_count, const size_t i_vertex_count, std::vector<uint32_t>& o_remap)
+	{
+		o_remap.assign(i_vertex_count, UnusedVertex);
+		uint32_t next = 0;
+		for (size_t x = 0; x < i_index_count; x++)
+		{
+			const uint32_t vertex = io_indices[x];
+			if (vertex >= i_vertex_count)
+				continue;
+			if (o_remap[vertex] == UnusedVertex)
+				o_remap[vertex] = next++;
+			io_indices[x] = o_remap[vertex];
+		}
+		return next;
+	}
+}
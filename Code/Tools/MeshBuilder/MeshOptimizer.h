@@ -0,0 +1,40 @@
+#ifndef _TOOLS_MESHBUILDER_MESHOPTIMIZER_H
+#define _TOOLS_MESHBUILDER_MESHOPTIMIZER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "../../Engine/Core/Vertex.h"
+#include "../../Engine/Core/MeshCluster.h"
+
+//Reorders triangle lists and their vertices so the GPU shades and fetches fewer vertices.
+// None of these change what is drawn, only the order it is drawn in.
+namespace MeshOptimizer
+{
+	//the size of the FIFO post-transform cache that ACMR is measured with
+	const size_t CacheSize = 16;
+
+	//the average number of vertices shaded per triangle (average cache miss ratio) when i_indices go through a FIFO cache of i_cache_size vertices
+	float GetAcmr(const uint32_t* i_indices, const size_t i_index_count, const size_t i_vertex_count, const size_t i_cache_size = CacheSize);
+
+	//reorders the triangles of a triangle list so they reuse recently shaded vertices, with Tom Forsyth's linear-speed vertex cache optimization.
+	// Each triangle keeps its winding.
+	void OptimizeVertexCache(uint32_t* io_indices, const size_t i_index_count, const size_t i_vertex_count);
+
+	//splits vertex cache optimized triangles into runs whose ACMR is at most i_threshold times the original's, then draws the runs
+	// that face out from the mesh's center first, so they hide the ones behind them (Sander, Nehab and Barczak).
+	// i_left_handed is the winding of io_indices.
+	void OptimizeOverdraw(const Lame::Vertex* i_vertices, const size_t i_vertex_count, uint32_t* io_indices, const size_t i_index_count,
+		const bool i_left_handed, const float i_threshold);
+
+	//the same ordering for the clusters of a mesh, which moves each cluster's indices along with it
+	void OptimizeClusterOverdraw(const Lame::Vertex* i_vertices, const size_t i_vertex_count, uint32_t* io_indices, std::vector<Lame::MeshCluster>& io_clusters);
+
+	//renumbers the vertices in the order i_index_count indices first use them, so vertex fetches walk forward through memory.
+	// o_remap holds each old vertex's new index, or UnusedVertex for vertices nothing uses.  Returns the number of vertices used.
+	const uint32_t UnusedVertex = ~0u;
+	size_t OptimizeVertexFetch(uint32_t* io_indices, const size_t i_index_count, const size_t i_vertex_count, std::vector<uint32_t>& o_remap);
+}
+
+#endif //_TOOLS_MESHBUILDER_MESHOPTIMIZER_H
@@ -0,0 +1,353 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+#include <map>
+#include <tuple>
+
+namespace
+{
+	typedef std::tuple<float, float, float> PositionKey;
+	typedef std::tuple<float, float, float, float, float, uint8_t, uint8_t, uint8_t, uint8_t> VertexKey;
+
+	//boundary planes are weighted heavily so open edges keep their shape
+	const double BoundaryWeight = 1000.0;
+}
+
+MeshSimplifier::MeshSimplifier(const std::vector<Lame::Vertex>& i_vertices, const std::vector<uint32_t>& i_indices)
+	: radius_(0.0f), max_error_so_far_(0.0f)
+{
+	//vertices that are exact copies are treated as one,
+	//and a position with more than one distinct vertex is on a texture or color seam
+	std::map<VertexKey, uint32_t> uniqueVertices;
+	std::map<PositionKey, uint32_t> uniquePositions;
+	std::vector<uint32_t> canonicalVertex(i_vertices.size());
+	std::vector<uint32_t> vertexPosition(i_vertices.size());
+	std::vector<uint32_t> positionVertex;
+	std::vector<bool> seam;
+	for (size_t i = 0; i < i_vertices.size(); ++i)
+	{
+		const Lame::Vertex& vertex = i_vertices[i];
+		const VertexKey vertexKey(vertex.position.x(), vertex.position.y(), vertex.position.z(), vertex.texcoord.x(), vertex.texcoord.y(),
+			vertex.color.r(), vertex.color.g(), vertex.color.b(), vertex.color.a());
+		canonicalVertex[i] = uniqueVertices.insert(std::make_pair(vertexKey, static_cast<uint32_t>(i))).first->second;
+
+		const PositionKey positionKey(vertex.position.x(), vertex.position.y(), vertex.position.z());
+		auto inserted = uniquePositions.insert(std::make_pair(positionKey, static_cast<uint32_t>(positions_.size())));
+		if (inserted.second)
+		{
+			const Position position = { vertex.position.x(), vertex.position.y(), vertex.position.z() };
+			positions_.push_back(position);
+			positionVertex.push_back(canonicalVertex[i]);
+			seam.push_back(false);
+		}
+		else if (positionVertex[inserted.first->second] != canonicalVertex[i])
+		{
+			seam[inserted.first->second] = true;
+		}
+		vertexPosition[i] = inserted.first->second;
+	}
+
+	const size_t positionCount = positions_.size();
+	quadrics_.resize(positionCount, Quadric());
+	position_triangles_.resize(positionCount);
+	locked_ = seam;
+	removed_.resize(positionCount, false);
+	stamps_.resize(positionCount, 0);
+
+	//the bounding box gives a scale for the error thresholds
+	if (positionCount > 0)
+	{
+		Position minimum = positions_[0], maximum = positions_[0];
+		for (size_t p = 1; p < positionCount; ++p)
+		{
+			minimum.x = std::min(minimum.x, positions_[p].x); maximum.x = std::max(maximum.x, positions_[p].x);
+			minimum.y = std::min(minimum.y, positions_[p].y); maximum.y = std::max(maximum.y, positions_[p].y);
+			minimum.z = std::min(minimum.z, positions_[p].z); maximum.z = std::max(maximum.z, positions_[p].z);
+		}
+		const double dx = maximum.x - minimum.x, dy = maximum.y - minimum.y, dz = maximum.z - minimum.z;
+		radius_ = static_cast<float>(0.5 * std::sqrt(dx * dx + dy * dy + dz * dz));
+	}
+
+	//every position starts with the planes of the triangles around it
+	std::map<std::pair<uint32_t, uint32_t>, std::vector<uint32_t>> edgeTriangles;
+	for (size_t t = 0; t + 2 < i_indices.size(); t += 3)
+	{
+		Triangle triangle;
+		triangle.removed = false;
+		for (size_t c = 0; c < 3; ++c)
+		{
+			triangle.vertices[c] = canonicalVertex[i_indices[t + c]];
+			triangle.positions[c] = vertexPosition[i_indices[t + c]];
+		}
+		if (triangle.positions[0] == triangle.positions[1] || triangle.positions[1] == triangle.positions[2] || triangle.positions[2] == triangle.positions[0])
+			continue;
+
+		const Position& p0 = positions_[triangle.positions[0]];
+		const Position& p1 = positions_[triangle.positions[1]];
+		const Position& p2 = positions_[triangle.positions[2]];
+		const Position e1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+		const Position e2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+		Position normal = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+		const double length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+		if (length <= 0.0)
+			continue;
+		normal.x /= length; normal.y /= length; normal.z /= length;
+		const double d = -(normal.x * p0.x + normal.y * p0.y + normal.z * p0.z);
+
+		const uint32_t triangleIndex = static_cast<uint32_t>(triangles_.size());
+		triangles_.push_back(triangle);
+		for (size_t c = 0; c < 3; ++c)
+		{
+			AddPlane(quadrics_[triangle.positions[c]], normal, d, 1.0);
+			position_triangles_[triangle.positions[c]].push_back(triangleIndex);
+
+			const uint32_t a = triangle.positions[c], b = triangle.positions[(c + 1) % 3];
+			edgeTriangles[std::make_pair(std::min(a, b), std::max(a, b))].push_back(triangleIndex);
+		}
+	}
+
+	//open and non-manifold edges are locked, and open edges add a plane through the edge along the triangle's normal
+	for (auto itr = edgeTriangles.begin(); itr != edgeTriangles.end(); ++itr)
+	{
+		if (itr->second.size() == 2)
+			continue;
+		const uint32_t a = itr->first.first, b = itr->first.second;
+		locked_[a] = true;
+		locked_[b] = true;
+		if (itr->second.size() == 1)
+		{
+			const Triangle& triangle = triangles_[itr->second[0]];
+			const Position& p0 = positions_[triangle.positions[0]];
+			const Position& p1 = positions_[triangle.positions[1]];
+			const Position& p2 = positions_[triangle.positions[2]];
+			const Position e1 = { p1.x - p0.x, p1.y - p0.y, p1.z - p0.z };
+			const Position e2 = { p2.x - p0.x, p2.y - p0.y, p2.z - p0.z };
+			const Position faceNormal = { e1.y * e2.z - e1.z * e2.y, e1.z * e2.x - e1.x * e2.z, e1.x * e2.y - e1.y * e2.x };
+			const Position edge = { positions_[b].x - positions_[a].x, positions_[b].y - positions_[a].y, positions_[b].z - positions_[a].z };
+			Position normal = { edge.y * faceNormal.z - edge.z * faceNormal.y, edge.z * faceNormal.x - edge.x * faceNormal.z, edge.x * faceNormal.y - edge.y * faceNormal.x };
+			const double length = std::sqrt(normal.x * normal.x + normal.y * normal.y + normal.z * normal.z);
+			if (length > 0.0)
+			{
+				normal.x /= length; normal.y /= length; normal.z /= length;
+				const double d = -(normal.x * positions_[a].x + normal.y * positions_[a].y + normal.z * positions_[a].z);
+				AddPlane(quadrics_[a], normal, d, BoundaryWeight);
+				AddPlane(quadrics_[b], normal, d, BoundaryWeight);
+			}
+		}
+	}
+
+	for (uint32_t p = 0; p < positionCount; ++p)
+		PushCollapses(p);
+}
+
+float MeshSimplifier::Simplify(const float i_max_error, std::vector<uint32_t>& o_indices)
+{
+	const double maxCost = static_cast<double>(i_max_error) * static_cast<double>(i_max_error);
+	while (!collapses_.empty())
+	{
+		const Collapse collapse = collapses_.top();
+		if (collapse.cost > maxCost)
+			break;
+		collapses_.pop();
+
+		//skip anything queued before either end last changed
+		if (removed_[collapse.from] || removed_[collapse.to] ||
+			stamps_[collapse.from] != collapse.fromStamp || stamps_[collapse.to] != collapse.toStamp)
+			continue;
+		if (!CanCollapse(collapse.from, collapse.to))
+			continue;
+
+		DoCollapse(collapse.from, collapse.to);
+		max_error_so_far_ = std::max(max_error_so_far_, static_cast<float>(std::sqrt(collapse.cost)));
+	}
+
+	o_indices.clear();
+	for (size_t t = 0; t < triangles_.size(); ++t)
+	{
+		const Triangle& triangle = triangles_[t];
+		if (triangle.removed)
+			continue;
+		o_indices.push_back(triangle.vertices[0]);
+		o_indices.push_back(triangle.vertices[1]);
+		o_indices.push_back(triangle.vertices[2]);
+	}
+	return max_error_so_far_;
+}
+
+double MeshSimplifier::Evaluate(const Quadric& i_quadric, const Position& i_position) const
+{
+	const double x = i_position.x, y = i_position.y, z = i_position.z;
+	const double cost = i_quadric.a2 * x * x + 2.0 * i_quadric.ab * x * y + 2.0 * i_quadric.ac * x * z + 2.0 * i_quadric.ad * x
+		+ i_quadric.b2 * y * y + 2.0 * i_quadric.bc * y * z + 2.0 * i_quadric.bd * y
+		+ i_quadric.c2 * z * z + 2.0 * i_quadric.cd * z
+		+ i_quadric.d2;
+	//rounding can push the cost of a point on every plane slightly below zero
+	return std::max(cost, 0.0);
+}
+
+void MeshSimplifier::AddPlane(Quadric& io_quadric, const Position& i_normal, const double i_d, const double i_weight) const
+{
+	const double a = i_normal.x, b = i_normal.y, c = i_normal.z, d = i_d;
+	io_quadric.a2 += i_weight * a * a; io_quadric.ab += i_weight * a * b; io_quadric.ac += i_weight * a * c; io_quadric.ad += i_weight * a * d;
+	io_quadric.b2 += i_weight * b * b; io_quadric.bc += i_weight * b * c; io_quadric.bd += i_weight * b * d;
+	io_quadric.c2 += i_weight * c * c; io_quadric.cd += i_weight * c * d;
+	io_quadric.d2 += i_weight * d * d;
+}
+
+void MeshSimplifier::GetNeighbors(const uint32_t i_position, std::vector<uint32_t>& o_neighbors) const
+{
+	o_neighbors.clear();
+	const std::vector<uint32_t>& triangles = position_triangles_[i_position];
+	for (size_t t = 0; t < triangles.size(); ++t)
+	{
+		const Triangle& triangle = triangles_[triangles[t]];
+		if (triangle.removed)
+			continue;
+		for (size_t c = 0; c < 3; ++c)
+		{
+			if (triangle.positions[c] != i_position)
+				o_neighbors.push_back(triangle.positions[c]);
+		}
+	}
+	std::sort(o_neighbors.begin(), o_neighbors.end());
+	o_neighbors.erase(std::unique(o_neighbors.begin(), o_neighbors.end()), o_neighbors.end());
+}
+
+void MeshSimplifier::PushCollapses(const uint32_t i_position)
+{
+	std::vector<uint32_t> neighbors;
+	GetNeighbors(i_position, neighbors);
+	for (size_t n = 0; n < neighbors.size(); ++n)
+	{
+		PushCollapse(i_position, neighbors[n]);
+		PushCollapse(neighbors[n], i_position);
+	}
+}
+
+void MeshSimplifier::PushCollapse(const uint32_t i_from, const uint32_t i_to)
+{
+	if (locked_[i_from])
+		return;
+	Quadric combined = quadrics_[i_from];
+	const Quadric& other = quadrics_[i_to];
+	combined.a2 += other.a2; combined.ab += other.ab; combined.ac += other.ac; combined.ad += other.ad;
+	combined.b2 += other.b2; combined.bc += other.bc; combined.bd += other.bd;
+	combined.c2 += other.c2; combined.cd += other.cd;
+	combined.d2 += other.d2;
+
+	Collapse collapse;
+	collapse.cost = Evaluate(combined, positions_[i_to]);
+	collapse.from = i_from;
+	collapse.to = i_to;
+	collapse.fromStamp = stamps_[i_from];
+	collapse.toStamp = stamps_[i_to];
+	collapses_.push(collapse);
+}
+
+bool MeshSimplifier::CanCollapse(const uint32_t i_from, const uint32_t i_to) const
+{
+	//the two ends may only share the neighbors opposite the edge, or the surface would fold onto itself
+	std::vector<uint32_t> fromNeighbors, toNeighbors, shared;
+	GetNeighbors(i_from, fromNeighbors);
+	GetNeighbors(i_to, toNeighbors);
+	std::set_intersection(fromNeighbors.begin(), fromNeighbors.end(), toNeighbors.begin(), toNeighbors.end(), std::back_inserter(shared));
+
+	size_t edgeTriangleCount = 0;
+	const std::vector<uint32_t>& triangles = position_triangles_[i_from];
+	for (size_t t = 0; t < triangles.size(); ++t)
+	{
+		const Triangle& triangle = triangles_[triangles[t]];
+		if (triangle.removed)
+			continue;
+		if (triangle.positions[0] == i_to || triangle.positions[1] == i_to || triangle.positions[2] == i_to)
+		{
+			++edgeTriangleCount;
+			continue;
+		}
+
+		//none of the remaining triangles may flip over or collapse to nothing
+		Position before[3], after[3];
+		for (size_t c = 0; c < 3; ++c)
+		{
+			before[c] = positions_[triangle.positions[c]];
+			after[c] = triangle.positions[c] == i_from ? positions_[i_to] : before[c];
+		}
+		const Position b1 = { before[1].x - before[0].x, before[1].y - before[0].y, before[1].z - before[0].z };
+		const Position b2 = { before[2].x - before[0].x, before[2].y - before[0].y, before[2].z - before[0].z };
+		const Position a1 = { after[1].x - after[0].x, after[1].y - after[0].y, after[1].z - after[0].z };
+		const Position a2 = { after[2].x - after[0].x, after[2].y - after[0].y, after[2].z - after[0].z };
+		const Position nb = { b1.y * b2.z - b1.z * b2.y, b1.z * b2.x - b1.x * b2.z, b1.x * b2.y - b1.y * b2.x };
+		const Position na = { a1.y * a2.z - a1.z * a2.y, a1.z * a2.x - a1.x * a2.z, a1.x * a2.y - a1.y * a2.x };
+		const double dot = nb.x * na.x + nb.y * na.y + nb.z * na.z;
+		const double lengthB = std::sqrt(nb.x * nb.x + nb.y * nb.y + nb.z * nb.z);
+		const double lengthA = std::sqrt(na.x * na.x + na.y * na.y + na.z * na.z);
+		if (lengthA <= 0.0 || dot < 0.2 * lengthA * lengthB)
+			return false;
+	}
+	return edgeTriangleCount > 0 && shared.size() == edgeTriangleCount;
+}
+
+void MeshSimplifier::DoCollapse(const uint32_t i_from, const uint32_t i_to)
+{
+	//i_from is never on a seam, so all its triangles are on the same side of any seam through i_to.
+	//the triangles along the edge tell which of i_to's vertices that side uses
+	uint32_t toVertex = 0;
+	const std::vector<uint32_t>& triangles = position_triangles_[i_from];
+	for (size_t t = 0; t < triangles.size(); ++t)
+	{
+		const Triangle& triangle = triangles_[triangles[t]];
+		if (triangle.removed)
+			continue;
+		for (size_t c = 0; c < 3; ++c)
+		{
+			if (triangle.positions[c] == i_to)
+				toVertex = triangle.vertices[c];
+		}
+	}
+
+	for (size_t t = 0; t < triangles.size(); ++t)
+	{
+		Triangle& triangle = triangles_[triangles[t]];
+		if (triangle.removed)
+			continue;
+		if (triangle.positions[0] == i_to || triangle.positions[1] == i_to || triangle.positions[2] == i_to)
+		{
+			triangle.removed = true;
+			continue;
+		}
+		for (size_t c = 0; c < 3; ++c)
+		{
+			if (triangle.positions[c] == i_from)
+			{
+				triangle.positions[c] = i_to;
+				triangle.vertices[c] = toVertex;
+			}
+		}
+		position_triangles_[i_to].push_back(triangles[t]);
+	}
+
+	Quadric& quadric = quadrics_[i_to];
+	const Quadric& other = quadrics_[i_from];
+	quadric.a2 += other.a2; quadric.ab += other.ab; quadric.ac += other.ac; quadric.ad += other.ad;
+	quadric.b2 += other.b2; quadric.bc += other.bc; quadric.bd += other.bd;
+	quadric.c2 += other.c2; quadric.cd += other.cd;
+	quadric.d2 += other.d2;
+
+	removed_[i_from] = true;
+	position_triangles_[i_from].clear();
+
+	//drop the dead triangles from i_to's list, then requeue every edge whose cost or validity may have changed
+	std::vector<uint32_t>& toTriangles = position_triangles_[i_to];
+	toTriangles.erase(std::remove_if(toTriangles.begin(), toTriangles.end(),
+		[this](const uint32_t i_triangle) { return triangles_[i_triangle].removed; }), toTriangles.end());
+
+	std::vector<uint32_t> neighbors;
+	GetNeighbors(i_to, neighbors);
+	++stamps_[i_to];
+	for (size_t n = 0; n < neighbors.size(); ++n)
+		++stamps_[neighbors[n]];
+	for (size_t n = 0; n < neighbors.size(); ++n)
+		PushCollapses(neighbors[n]);
+}
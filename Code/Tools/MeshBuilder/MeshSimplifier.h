@@ -0,0 +1,69 @@
+#ifndef _TOOLS_MESHBUILDER_MESHSIMPLIFIER_H
+#define _TOOLS_MESHBUILDER_MESHSIMPLIFIER_H
+
+#include <cstdint>
+#include <functional>
+#include <queue>
+#include <vector>
+
+#include "../../Engine/Core/Vertex.h"
+
+//Simplifies a triangle list with quadric error metrics (Garland and Heckbert).
+// Edges are collapsed onto one of their own ends, so every level of detail indexes
+// into the original vertex list and they can all share one vertex buffer.
+class MeshSimplifier
+{
+public:
+	MeshSimplifier(const std::vector<Lame::Vertex>& i_vertices, const std::vector<uint32_t>& i_indices);
+
+	//collapses edges until the next one would move the surface further than i_max_error, then writes the triangles that are left.
+	// Calling it again with a larger error continues from there.  Returns the largest error of any collapse so far
+	float Simplify(const float i_max_error, std::vector<uint32_t>& o_indices);
+
+	//half the diagonal of the mesh's bounding box
+	float radius() const { return radius_; }
+
+private:
+	struct Quadric
+	{
+		double a2, ab, ac, ad, b2, bc, bd, c2, cd, d2;
+	};
+	struct Position
+	{
+		double x, y, z;
+	};
+	struct Triangle
+	{
+		uint32_t vertices[3];
+		uint32_t positions[3];
+		bool removed;
+	};
+	struct Collapse
+	{
+		double cost;
+		uint32_t from, to;
+		uint32_t fromStamp, toStamp;
+		bool operator>(const Collapse& i_other) const { return cost > i_other.cost; }
+	};
+
+	double Evaluate(const Quadric& i_quadric, const Position& i_position) const;
+	void AddPlane(Quadric& io_quadric, const Position& i_normal, const double i_d, const double i_weight) const;
+	void GetNeighbors(const uint32_t i_position, std::vector<uint32_t>& o_neighbors) const;
+	void PushCollapses(const uint32_t i_position);
+	void PushCollapse(const uint32_t i_from, const uint32_t i_to);
+	bool CanCollapse(const uint32_t i_from, const uint32_t i_to) const;
+	void DoCollapse(const uint32_t i_from, const uint32_t i_to);
+
+	std::vector<Position> positions_;
+	std::vector<Quadric> quadrics_;
+	std::vector<std::vector<uint32_t>> position_triangles_;
+	std::vector<bool> locked_;		//seams and open edges never move
+	std::vector<bool> removed_;
+	std::vector<uint32_t> stamps_;	//bumped whenever a position's neighborhood changes, to invalidate queued collapses
+	std::vector<Triangle> triangles_;
+	std::priority_queue<Collapse, std::vector<Collapse>, std::greater<Collapse>> collapses_;
+	float radius_;
+	float max_error_so_far_;
+};
+
+#endif //_TOOLS_MESHBUILDER_MESHSIMPLIFIER_H
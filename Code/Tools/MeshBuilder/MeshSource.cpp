@@ -0,0 +1,366 @@
+#include "MeshSource.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+
+namespace
+{
+	//the most numbers any one vertex attribute has
+	const size_t MaxAttributeSize = 4;
+
+	//every power of 10 that a double holds exactly
+	const double PowersOf10[] = {
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22,
+	};
+
+	//the character classes of Lua's lexer, which (unlike the ones in <cctype>) don't depend on the locale
+	inline bool IsDigit(const char i_character) { return i_character >= '0' && i_character <= '9'; }
+	inline bool IsSpace(const char i_character) { return i_character == ' ' || (i_character >= '\t' && i_character <= '\r'); }
+	inline bool IsNameStart(const char i_character) { return (i_character >= 'a' && i_character <= 'z') || (i_character >= 'A' && i_character <= 'Z') || i_character == '_'; }
+	inline bool IsNameCharacter(const char i_character) { return IsNameStart(i_character) || IsDigit(i_character); }
+
+	//a vertex attribute that has been read, or still needs to be
+	struct Attribute
+	{
+		const char *name;
+		size_t size;
+		double values[MaxAttributeSize];
+		bool found;
+	};
+
+	//reads the tokens of the source text one at a time, skipping whitespace and comments in front of each.
+	// Every read returns false when the next token isn't the one asked for.
+	class Reader
+	{
+	public:
+		//i_text has to be null terminated
+		explicit Reader(const char* i_text) : cursor_(i_text) {}
+
+		bool Consume(const char i_character)
+		{
+			if (!SkipSpace() || *cursor_ != i_character)
+				return false;
+			++cursor_;
+			return true;
+		}
+
+		bool Peek(const char i_character) { return SkipSpace() && *cursor_ == i_character; }
+
+		//reads a name and checks that it is i_name
+		bool ConsumeName(const char* i_name)
+		{
+			const char *name;
+			size_t length;
+			return ReadName(name, length) && IsName(name, length, i_name);
+		}
+
+		bool ReadName(const char*& o_name, size_t& o_length)
+		{
+			if (!SkipSpace() || !IsNameStart(*cursor_))
+				return false;
+			o_name = cursor_;
+			while (IsNameCharacter(*cursor_))
+				++cursor_;
+			o_length = static_cast<size_t>(cursor_ - o_name);
+			return true;
+		}
+
+		//reads "{ 1, 2.5, -3e-05 }" with up to i_max numbers
+		bool ReadNumbers(double* o_numbers, const size_t i_max, size_t& o_count)
+		{
+			if (!Consume('{'))
+				return false;
+			o_count = 0;
+			while (!Consume('}'))
+			{
+				if (o_count == i_max || !ReadNumber(o_numbers[o_count]) || !EndField())
+					return false;
+				++o_count;
+			}
+			return true;
+		}
+
+		//reads "{ 1, 2, 3 }" as a triangle's indices
+		bool ReadTriangle(uint32_t o_indices[3])
+		{
+			if (!Consume('{'))
+				return false;
+			size_t count = 0;
+			while (!Consume('}'))
+			{
+				if (count == 3 || !ReadIndex(o_indices[count]) || !EndField())
+					return false;
+				++count;
+			}
+			return count == 3;
+		}
+
+		//table fields are separated by commas or semicolons, which are optional after the last one
+		bool EndField()
+		{
+			if (!SkipSpace())
+				return false;
+			if (*cursor_ == ',' || *cursor_ == ';')
+			{
+				++cursor_;
+				return true;
+			}
+			return *cursor_ == '}';
+		}
+
+		bool AtEnd() { return SkipSpace() && *cursor_ == '\0'; }
+
+		//the numbers are converted to the same doubles Lua converts them to, so both ways of loading a mesh build the same vertices
+		bool ReadNumber(double& o_number)
+		{
+			if (!SkipSpace())
+				return false;
+			const bool negative = *cursor_ == '-';
+			const char *text = cursor_ + (negative ? 1 : 0);
+			if (!IsDigit(*text) && *text != '.')
+				return false;
+
+			//the exporter only writes short decimals, which are converted exactly without strtod (Clinger's fast path):
+			// up to 15 significant digits fit in a double as they are, and so does 10 to the power of up to 22,
+			// so one multiply or divide rounds the result correctly
+			uint64_t mantissa = 0;
+			int significantDigits = 0, digits = 0, exponent = 0;
+			for (bool fraction = false; ; ++text)
+			{
+				if (*text == '.' && !fraction)
+				{
+					fraction = true;
+					continue;
+				}
+				if (!IsDigit(*text))
+					break;
+				++digits;
+				if (fraction)
+					--exponent;
+				if (mantissa == 0 && *text == '0')
+					continue;
+				if (++significantDigits <= 15)
+					mantissa = mantissa * 10 + static_cast<uint64_t>(*text - '0');
+			}
+			if ((*text == 'e' || *text == 'E') && digits > 0)
+			{
+				const char *exponentText = text + 1;
+				const bool negativeExponent = *exponentText == '-';
+				if (*exponentText == '-' || *exponentText == '+')
+					++exponentText;
+				int value = 0;
+				for (; IsDigit(*exponentText) && value < 1000; ++exponentText)
+					value = value * 10 + (*exponentText - '0');
+				if (exponentText != text + 1)
+				{
+					exponent += negativeExponent ? -value : value;
+					text = exponentText;
+				}
+			}
+
+			const bool isFast = digits > 0 && significantDigits <= 15 && exponent >= -22 && exponent <= 22 &&
+				!IsNameCharacter(*text) && *text != '.';
+			if (isFast)
+			{
+				o_number = exponent < 0 ? static_cast<double>(mantissa) / PowersOf10[-exponent] : static_cast<double>(mantissa) * PowersOf10[exponent];
+				if (negative)
+					o_number = -o_number;
+				cursor_ = text;
+				return true;
+			}
+
+			//anything else, like hexadecimal or long numbers, goes through strtod
+			char *end;
+			o_number = strtod(cursor_, &end);
+			if (end == cursor_)
+				return false;
+			cursor_ = end;
+			return true;
+		}
+
+		static bool IsName(const char* i_name, const size_t i_length, const char* i_expected)
+		{
+			return strlen(i_expected) == i_length && strncmp(i_name, i_expected, i_length) == 0;
+		}
+
+	private:
+		//returns false at a long comment, which this doesn't read
+		bool SkipSpace()
+		{
+			for (;;)
+			{
+				while (IsSpace(*cursor_))
+					++cursor_;
+				if (cursor_[0] != '-' || cursor_[1] != '-')
+					return true;
+				if (cursor_[2] == '[')
+					return false;
+				while (*cursor_ != '\0' && *cursor_ != '\n')
+					++cursor_;
+			}
+		}
+
+		bool ReadIndex(uint32_t& o_index)
+		{
+			if (!SkipSpace() || !IsDigit(*cursor_))
+				return false;
+			uint64_t index = 0;
+			while (IsDigit(*cursor_))
+			{
+				index = index * 10 + static_cast<uint64_t>(*cursor_ - '0');
+				if (index > UINT32_MAX)
+					return false;
+				++cursor_;
+			}
+			o_index = static_cast<uint32_t>(index);
+			return true;
+		}
+
+		const char *cursor_;
+	};
+
+	bool ReadVertices(Reader& io_reader, std::vector<Lame::Vertex>& o_vertices, std::vector<MeshSource::TangentFrame>& o_frames)
+	{
+		while (!io_reader.Consume('}'))
+		{
+			Attribute attributes[] = {
+				{ "pos", 3 }, { "texcoord", 2 }, { "color", 4 }, { "normal", 3 }, { "tangent", 3 }, { "bitangent", 3 },
+			};
+			const size_t attributeCount = sizeof(attributes) / sizeof(attributes[0]);
+
+			if (!io_reader.Consume('{'))
+				return false;
+			while (!io_reader.Consume('}'))
+			{
+				const char *name;
+				size_t length;
+				double values[MaxAttributeSize];
+				size_t count = 0;
+				if (!io_reader.ReadName(name, length) || !io_reader.Consume('='))
+					return false;
+				//the exporter also writes single numbers, like the shading group
+				const bool isTable = io_reader.Peek('{');
+				if (!(isTable ? io_reader.ReadNumbers(values, MaxAttributeSize, count) : io_reader.ReadNumber(values[0])) || !io_reader.EndField())
+					return false;
+
+				//attributes the builder doesn't use are skipped
+				for (size_t x = 0; x < attributeCount; x++)
+				{
+					if (!Reader::IsName(name, length, attributes[x].name))
+						continue;
+					if (attributes[x].found || !isTable || count != attributes[x].size)
+						return false;
+					memcpy(attributes[x].values, values, sizeof(values));
+					attributes[x].found = true;
+				}
+			}
+			if (!io_reader.EndField())
+				return false;
+
+			if (!attributes[0].found || !attributes[1].found || !attributes[2].found)
+				return false;
+			o_vertices.push_back(MeshSource::MakeVertex(attributes[0].values, attributes[1].values, attributes[2].values));
+
+			//older meshes don't have tangent frames
+			MeshSource::TangentFrame frame = MeshSource::DefaultFrame();
+			if (attributes[3].found && attributes[4].found && attributes[5].found)
+			{
+				frame.normal.set(static_cast<float>(attributes[3].values[0]), static_cast<float>(attributes[3].values[1]), static_cast<float>(attributes[3].values[2]));
+				frame.tangent.set(static_cast<float>(attributes[4].values[0]), static_cast<float>(attributes[4].values[1]), static_cast<float>(attributes[4].values[2]));
+				frame.bitangent.set(static_cast<float>(attributes[5].values[0]), static_cast<float>(attributes[5].values[1]), static_cast<float>(attributes[5].values[2]));
+			}
+			o_frames.push_back(frame);
+		}
+		return true;
+	}
+
+	bool ReadIndices(Reader& io_reader, std::vector<uint32_t>& o_indices)
+	{
+		while (!io_reader.Consume('}'))
+		{
+			uint32_t triangle[3];
+			if (!io_reader.ReadTriangle(triangle) || !io_reader.EndField())
+				return false;
+			o_indices.insert(o_indices.end(), triangle, triangle + 3);
+		}
+		return true;
+	}
+}
+
+MeshSource::TangentFrame MeshSource::DefaultFrame()
+{
+	TangentFrame frame;
+	frame.normal = Lame::Vector3::back;
+	frame.tangent = Lame::Vector3::right;
+	frame.bitangent = Lame::Vector3::up;
+	return frame;
+}
+
+Lame::Vertex MeshSource::MakeVertex(const double i_position[3], const double i_texcoord[2], const double i_color[4])
+{
+	Lame::Vertex vertex;
+	vertex.position = Lame::Vector3(static_cast<float>(i_position[0]), static_cast<float>(i_position[1]), static_cast<float>(i_position[2]));
+	vertex.texcoord.x(static_cast<float>(i_texcoord[0]));
+	vertex.texcoord.y(1.0f - static_cast<float>(i_texcoord[1]));
+	vertex.color.r(static_cast<uint8_t>(i_color[0] * 255.0));
+	vertex.color.g(static_cast<uint8_t>(i_color[1] * 255.0));
+	vertex.color.b(static_cast<uint8_t>(i_color[2] * 255.0));
+	vertex.color.a(static_cast<uint8_t>(i_color[3] * 255.0));
+	return vertex;
+}
+
+bool MeshSource::Parse(const std::string& i_path, std::vector<Lame::Vertex>& o_vertices, std::vector<TangentFrame>& o_frames, std::vector<uint32_t>& o_indices)
+{
+	std::ifstream in(i_path, std::ifstream::binary | std::ifstream::ate);
+	if (!in)
+		return false;
+	std::vector<char> text(static_cast<size_t>(in.tellg()) + 1, '\0');
+	in.seekg(0);
+	if (!in.read(text.data(), text.size() - 1))
+		return false;
+	//a null inside the file would end it early
+	if (strlen(text.data()) + 1 != text.size())
+		return false;
+
+	std::vector<Lame::Vertex> vertices;
+	std::vector<TangentFrame> frames;
+	std::vector<uint32_t> indices;
+	Reader reader(text.data());
+	if (!reader.ConsumeName("return") || !reader.Consume('{'))
+		return false;
+	bool readVertices = false, readIndices = false;
+	while (!reader.Consume('}'))
+	{
+		const char *name;
+		size_t length;
+		if (!reader.ReadName(name, length) || !reader.Consume('=') || !reader.Consume('{'))
+			return false;
+		if (!readVertices && Reader::IsName(name, length, "vertex"))
+		{
+			if (!ReadVertices(reader, vertices, frames))
+				return false;
+			readVertices = true;
+		}
+		else if (!readIndices && Reader::IsName(name, length, "index"))
+		{
+			if (!ReadIndices(reader, indices))
+				return false;
+			readIndices = true;
+		}
+		else
+		{
+			return false;
+		}
+		if (!reader.EndField())
+			return false;
+	}
+	if (!reader.AtEnd() || !readVertices || !readIndices)
+		return false;
+
+	o_vertices.swap(vertices);
+	o_frames.swap(frames);
+	o_indices.swap(indices);
+	return true;
+}
@@ -0,0 +1,35 @@
+#ifndef _TOOLS_MESHBUILDER_MESHSOURCE_H
+#define _TOOLS_MESHBUILDER_MESHSOURCE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "../../Engine/Core/Vertex.h"
+
+//Reads mesh source files, the Lua tables that MayaMeshExporter writes:
+// return { vertex = { { pos = {...}, texcoord = {...}, color = {...}, normal = {...}, ... }, ... }, index = { { a, b, c }, ... } }
+namespace MeshSource
+{
+	//the tangent frame of a vertex, which only compressed meshes keep
+	struct TangentFrame
+	{
+		Lame::Vector3 normal;
+		Lame::Vector3 tangent;
+		Lame::Vector3 bitangent;
+	};
+
+	//the frame of vertices that don't have one, facing the camera
+	TangentFrame DefaultFrame();
+
+	//a vertex from the numbers in its source table.  Source texcoords start at the bottom of the texture and colors go from 0 to 1.
+	Lame::Vertex MakeVertex(const double i_position[3], const double i_texcoord[2], const double i_color[4]);
+
+	//reads the file in a single pass over its text, converting the numbers straight into the vertices and indices without going through Lua.
+	// This only understands the tables as the exporter writes them (any order of keys, -- comments, optional trailing commas), and
+	// returns false without any output for anything else, so hand written meshes that use more of Lua (and broken files) need to be loaded
+	// with Lua instead, which also reports what is wrong with them.
+	bool Parse(const std::string& i_path, std::vector<Lame::Vertex>& o_vertices, std::vector<TangentFrame>& o_frames, std::vector<uint32_t>& o_indices);
+}
+
+#endif //_TOOLS_MESHBUILDER_MESHSOURCE_H
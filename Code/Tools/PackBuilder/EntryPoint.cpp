@@ -0,0 +1,7 @@
+
+#include "PackBuilder.h"
+
+int main( int i_argumentCount, char** i_arguments )
+{
+	return eae6320::Build<PackBuilder>( i_arguments, i_argumentCount );
+}
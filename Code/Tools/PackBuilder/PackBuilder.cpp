@@ -0,0 +1,188 @@
+
+#include "PackBuilder.h"
+
+#include <cstdint>
+#include <sstream>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <algorithm>
+#include <map>
+#include <cctype>
+
+#include "../BuilderHelper/UtilityFunctions.h"
+#include "../../Engine/System/AssetPack.h"
+#include "../../Engine/Core/Compression.h"
+
+namespace
+{
+	struct PackedAsset
+	{
+		Lame::File::PackEntry entry;
+		std::string path;			//normalized, the same as the runtime compares lookups with
+		std::vector<char> data;		//what is written to the pack, which is compressed when entry.stored_size is less than entry.size
+	};
+
+	//the same path the runtime looks assets up with
+	std::string NormalizePath(const std::string& i_path)
+	{
+		std::string path(i_path);
+		for (size_t x = 0; x < path.size(); x++)
+			path[x] = path[x] == '\\' ? '/' : static_cast<char>(tolower(static_cast<unsigned char>(path[x])));
+		return path;
+	}
+
+	inline bool KeyLess(const PackedAsset& i_left, const PackedAsset& i_right) { return i_left.entry.key < i_right.entry.key; }
+
+	inline size_t AlignOffset(const size_t i_offset)
+	{
+		return (i_offset + Lame::File::PackAlignment - 1) / Lame::File::PackAlignment * Lame::File::PackAlignment;
+	}
+
+	//compresses each block on its own, and keeps the blocks that don't get any smaller as they are
+	std::vector<char> CompressBlocks(const std::vector<char>& i_data)
+	{
+		const size_t blockSize = Lame::File::PackBlockSize;
+		const size_t blockCount = (i_data.size() + blockSize - 1) / blockSize;
+		std::vector<uint32_t> blockSizes(blockCount);
+		std::vector<char> blocks;
+		std::vector<char> compressed(Lame::Compression::GetMaxCompressedSize(blockSize));
+		for (size_t x = 0; x < blockCount; x++)
+		{
+			const char *block = i_data.data() + x * blockSize;
+			const size_t size = std::min(blockSize, i_data.size() - x * blockSize);
+			const size_t compressedSize = Lame::Compression::Compress(block, size, compressed.data());
+			if (compressedSize < size)
+				blocks.insert(blocks.end(), compressed.data(), compressed.data() + compressedSize);
+			else
+				blocks.insert(blocks.end(), block, block + size);
+			blockSizes[x] = static_cast<uint32_t>(std::min(compressedSize, size));
+		}
+
+		std::vector<char> stored(reinterpret_cast<const char*>(blockSizes.data()), reinterpret_cast<const char*>(blockSizes.data() + blockCount));
+		stored.insert(stored.end(), blocks.begin(), blocks.end());
+		return stored;
+	}
+}
+
+bool PackBuilder::Build(const std::vector<std::string>& i_arguments)
+{
+	//with "compress" the assets that compress well are stored block compressed
+	const bool compress = std::find(i_arguments.begin(), i_arguments.end(), "compress") != i_arguments.end();
+
+	std::ifstream list(m_path_source);
+	if (!list)
+	{
+		eae6320::OutputErrorMessage("Failed to open the list of assets to pack", m_path_source);
+		return false;
+	}
+	const std::string source(m_path_source);
+	const size_t slash = source.find_last_of("/\\");
+	const std::string directory = slash == std::string::npos ? std::string() : source.substr(0, slash + 1);
+
+	//read every listed asset, skipping ones that are listed twice
+	std::vector<PackedAsset> assets;
+	std::map<uint32_t, std::string> keys;
+	std::string line;
+	while (std::getline(list, line))
+	{
+		line.erase(line.find_last_not_of(" \t\r") + 1);
+		if (line.empty() || line[0] == '#')
+			continue;
+
+		PackedAsset asset;
+		asset.entry.key = Lame::File::GetPackKey(line);
+		asset.path = NormalizePath(line);
+		const std::pair<std::map<uint32_t, std::string>::iterator, bool> added = keys.insert(std::make_pair(asset.entry.key, asset.path));
+		if (!added.second)
+		{
+			if (added.first->second == asset.path)
+				continue;
+			std::stringstream error;
+			error << "\"" << line << "\" has the same key as \"" << added.first->second << "\", one of them needs to be renamed";
+			eae6320::OutputErrorMessage(error.str().c_str(), m_path_source);
+			return false;
+		}
+
+		std::ifstream in(directory + line, std::ifstream::binary);
+		if (!in)
+		{
+			eae6320::OutputErrorMessage("Failed to open an asset to pack", (directory + line).c_str());
+			return false;
+		}
+		asset.data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+		asset.entry.size = static_cast<uint32_t>(asset.data.size());
+		asset.entry.stored_size = asset.entry.size;
+
+		//decompressing costs load time too, so assets are only compressed when it saves a worthwhile amount of reading
+		if (compress)
+		{
+			std::vector<char> stored = CompressBlocks(asset.data);
+			if (stored.size() < asset.data.size() - asset.data.size() / 8)
+			{
+				asset.data.swap(stored);
+				asset.entry.stored_size = static_cast<uint32_t>(asset.data.size());
+			}
+		}
+		assets.push_back(asset);
+	}
+
+	//the table is sorted by key so the runtime can binary search it, and the paths and then the assets follow it in the same order
+	std::sort(assets.begin(), assets.end(), KeyLess);
+	Lame::File::PackHeader header;
+	header.magic = Lame::File::PackMagic;
+	header.version = Lame::File::PackVersion;
+	header.entry_count = static_cast<uint32_t>(assets.size());
+	header.path_offset = static_cast<uint32_t>(sizeof(header) + sizeof(Lame::File::PackEntry) * assets.size());
+	std::string paths;
+	for (size_t x = 0; x < assets.size(); x++)
+	{
+		assets[x].entry.path_offset = static_cast<uint32_t>(header.path_offset + paths.size());
+		assets[x].entry.path_length = static_cast<uint32_t>(assets[x].path.size());
+		paths += assets[x].path;
+	}
+	header.path_size = static_cast<uint32_t>(paths.size());
+	size_t offset = AlignOffset(header.path_offset + paths.size());
+	for (size_t x = 0; x < assets.size(); x++)
+	{
+		assets[x].entry.offset = static_cast<uint32_t>(offset);
+		offset = AlignOffset(offset + assets[x].data.size());
+	}
+	if (offset > UINT32_MAX)
+	{
+		eae6320::OutputErrorMessage("The assets are too large to fit in one pack", m_path_target);
+		return false;
+	}
+	header.file_size = static_cast<uint32_t>(offset);
+
+	std::ofstream out(m_path_target, std::ofstream::binary);
+	if (!out)
+	{
+		eae6320::OutputErrorMessage("Failed to open the output file for writing", m_path_target);
+		return false;
+	}
+	out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+	for (size_t x = 0; x < assets.size(); x++)
+		out.write(reinterpret_cast<const char*>(&assets[x].entry), sizeof(assets[x].entry));
+	out.write(paths.data(), paths.size());
+	const char padding[Lame::File::PackAlignment] = {};
+	size_t written = header.path_offset + paths.size();
+	for (size_t x = 0; x < assets.size(); x++)
+	{
+		out.write(padding, assets[x].entry.offset - written);
+		out.write(assets[x].data.data(), assets[x].data.size());
+		written = assets[x].entry.offset + assets[x].data.size();
+	}
+	out.write(padding, header.file_size - written);
+	if (!out)
+	{
+		eae6320::OutputErrorMessage("Failed to write the asset pack", m_path_target);
+		return false;
+	}
+
+	size_t assetSize = 0;
+	for (size_t x = 0; x < assets.size(); x++)
+		assetSize += assets[x].entry.size;
+	std::cout << "Packed " << assets.size() << " assets (" << assetSize << " bytes) into " << header.file_size << " bytes in " << m_path_target << "\n";
+	return true;
+}
@@ -0,0 +1,14 @@
+#ifndef _TOOLS_PACKBUILDER_PACKBUILDER_H
+#define _TOOLS_PACKBUILDER_PACKBUILDER_H
+
+#include "../BuilderHelper/cbBuilder.h"
+
+//Packs built assets into one Lame::File::AssetPack.  The source is a list of the assets' paths, one per line,
+// relative to the directory the list is in.
+class PackBuilder : public eae6320::cbBuilder
+{
+public:
+	virtual bool Build(const std::vector<std::string>& i_arguments);
+};
+
+#endif //_TOOLS_PACKBUILDER_PACKBUILDER_H
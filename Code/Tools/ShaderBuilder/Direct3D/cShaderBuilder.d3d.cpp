@@ -42,6 +42,8 @@ bool eae6320::cShaderBuilder::Build( const std::vector<std::string>& i_arguments
 			return false;
 		}
 	}
+	// The compiled shader has to be rebuilt when any file it #includes changes
+	AddIncludedFiles( m_path_source );
 	// Get the path to the shader compiler
 	std::string path_fxc;
 	{
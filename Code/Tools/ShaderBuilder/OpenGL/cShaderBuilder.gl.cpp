@@ -30,6 +30,8 @@ namespace
 
 bool eae6320::cShaderBuilder::Build( const std::vector<std::string>& i_arguments )
 {
+	// The pre-processed shader has to be rebuilt when any file it #includes changes
+	AddIncludedFiles( m_path_source );
 	std::string shaderSource_preProcessed;
 	if ( !PreProcessShaderSource( m_path_source, shaderSource_preProcessed ) )
 	{
@@ -0,0 +1,61 @@
+// Header Files
+//=============
+
+#include "cShaderBuilder.h"
+
+#include <fstream>
+
+// Implementation
+//===============
+
+void eae6320::cShaderBuilder::AddIncludedFiles( const std::string& i_path_shader )
+{
+	std::ifstream shader( i_path_shader.c_str() );
+	if ( !shader )
+	{
+		// The compiler will report a file that it can't open
+		return;
+	}
+	// Both fxc and mcpp look for an #included file relative to the file that #includes it first
+	const size_t lastSlash = i_path_shader.find_last_of( "/\\" );
+	const std::string directory = ( lastSlash != std::string::npos ) ? i_path_shader.substr( 0, lastSlash + 1 ) : "";
+
+	// Every #include is followed, even ones the preprocessor would skip,
+	// so a shader is sometimes rebuilt when it doesn't have to be but never left out-of-date
+	std::string line;
+	while ( std::getline( shader, line ) )
+	{
+		size_t position = line.find_first_not_of( " \t" );
+		if ( ( position == std::string::npos ) || ( line[position] != '#' ) )
+		{
+			continue;
+		}
+		position = line.find_first_not_of( " \t", position + 1 );
+		if ( ( position == std::string::npos ) || ( line.compare( position, 7, "include" ) != 0 ) )
+		{
+			continue;
+		}
+		position = line.find_first_of( "\"<", position + 7 );
+		if ( position == std::string::npos )
+		{
+			continue;
+		}
+		const size_t end = line.find( ( line[position] == '"' ) ? '"' : '>', position + 1 );
+		if ( end == std::string::npos )
+		{
+			continue;
+		}
+		const std::string path_included = directory + line.substr( position + 1, end - position - 1 );
+		if ( !std::ifstream( path_included.c_str() ) )
+		{
+			// The compiler will report an #included file that it can't find
+			continue;
+		}
+
+		// A file that has already been added has already been followed, which also stops files that #include each other
+		if ( AddDependency( path_included ) )
+		{
+			AddIncludedFiles( path_included );
+		}
+	}
+}
@@ -26,6 +26,14 @@ namespace eae6320
 		//------
 
 		virtual bool Build( const std::vector<std::string>& i_arguments );
+
+		// Implementation
+		//===============
+
+	private:
+
+		// Adds every file that i_path_shader #includes, and every file that those #include, as dependencies
+		void AddIncludedFiles( const std::string& i_path_shader );
 	};
 }
 
@@ -23,12 +23,21 @@ namespace
 namespace
 {
 	bool Initialize( const char* i_path_source );
+	void ReleaseTexture();
 	bool ShutDown();
 }
 
 // Interface
 //==========
 
+// Initialization / Shut Down
+//---------------------------
+
+eae6320::cTextureBuilder::~cTextureBuilder()
+{
+	ShutDown();
+}
+
 // Build
 //------
 
@@ -172,10 +181,8 @@ bool eae6320::cTextureBuilder::Build( const std::vector<std::string>& )
 
 OnExit:
 
-	if ( !ShutDown() )
-	{
-		wereThereErrors = true;
-	}
+	// The device is kept for the next texture, when this builder is a worker
+	ReleaseTexture();
 
 	return !wereThereErrors;
 }
@@ -187,7 +194,14 @@ namespace
 {
 	bool Initialize( const char* i_path_source )
 	{
+		// Every texture that this builder builds uses the same device
+		if ( s_direct3dDevice )
+		{
+			return true;
+		}
+
 		// Create the D3D9 interface
+		if ( !s_direct3dInterface )
 		{
 			s_direct3dInterface = Direct3DCreate9( D3D_SDK_VERSION );
 			if ( !s_direct3dInterface )
@@ -232,15 +246,20 @@ namespace
 		return true;
 	}
 
-	bool ShutDown()
+	void ReleaseTexture()
 	{
-		bool wereThereErrors = false;
-
 		if ( s_texture )
 		{
 			s_texture->Release();
 			s_texture = NULL;
 		}
+	}
+
+	bool ShutDown()
+	{
+		bool wereThereErrors = false;
+
+		ReleaseTexture();
 
 		if ( s_direct3dInterface )
 		{
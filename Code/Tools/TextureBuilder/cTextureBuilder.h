@@ -22,6 +22,12 @@ namespace eae6320
 
 	public:
 
+		// Initialization / Shut Down
+		//---------------------------
+
+		// Releases the Direct3D device that every texture is built with
+		~cTextureBuilder();
+
 		// Build
 		//------
 
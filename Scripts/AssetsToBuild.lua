@@ -10,14 +10,17 @@ return
 		tool = "MeshBuilder.exe",
 		files = 
 		{
-			{ source = "EAE 6330/ceiling_mesh.mesh", target = "ceiling_mesh.mesh.bin" },
-			{ source = "EAE 6330/cement_mesh.mesh", target = "cement_mesh.mesh.bin" },
-			{ source = "EAE 6330/floor_mesh.mesh", target = "floor_mesh.mesh.bin" },
-			{ source = "EAE 6330/lambert_objects_mesh.mesh", target = "lambert_objects_mesh.mesh.bin" },
-			{ source = "EAE 6330/metal_mesh.mesh", target = "metal_mesh.mesh.bin" },
-			{ source = "EAE 6330/railing_mesh.mesh", target = "railing_mesh.mesh.bin" },
-			{ source = "EAE 6330/walls_mesh.mesh", target = "walls_mesh.mesh.bin" },
+			{ source = "EAE 6330/ceiling_mesh.mesh", target = "ceiling_mesh.mesh.bin", arguments = "compress" },
+			{ source = "EAE 6330/cement_mesh.mesh", target = "cement_mesh.mesh.bin", arguments = "compress" },
+			{ source = "EAE 6330/floor_mesh.mesh", target = "floor_mesh.mesh.bin", arguments = "compress" },
+			{ source = "EAE 6330/lambert_objects_mesh.mesh", target = "lambert_objects_mesh.mesh.bin", arguments = "compress" },
+			{ source = "EAE 6330/metal_mesh.mesh", target = "metal_mesh.mesh.bin", arguments = "compress" },
+			{ source = "EAE 6330/railing_mesh.mesh", target = "railing_mesh.mesh.bin", arguments = "compress" },
+			{ source = "EAE 6330/walls_mesh.mesh", target = "walls_mesh.mesh.bin", arguments = "compress" },
 			{ source = "EAE 6330/level_collision.mesh", target = "level_collision.mesh.bin" },
+			{ source = "EAE 6330/walls_mesh.mesh", target = "walls_occluder.mesh.bin", arguments = "occluder 2048" },
+			{ source = "EAE 6330/ceiling_mesh.mesh", target = "ceiling_occluder.mesh.bin", arguments = "occluder" },
+			{ source = "asteroid.mesh", target = "asteroid.mesh.bin", arguments = "clusters overdraw lod 0.005 0.02 0.06 compress stats" },
 		}
 	},
     {
@@ -28,10 +31,16 @@ return
             { source = "transparent.effect", target = "transparent.effect.bin" },
             { source = "sprite.effect", target = "sprite.effect.bin" },
         }
+    },
+    {
+        tool = "FontBuilder.exe",
+        files = 
+        {
+            { source = "debug/consolas.font", target = "debug/consolas.font.bin" },
+        }
     },
 	{
 		tool = "ShaderBuilder.exe",
-        dependencies = { "shaders.inc" },
 		files = 
 		{
 			{ source = "debug/shape_vertex.shader", target = "debug/shape_vertex.shader.bin", arguments = "vertex" },
@@ -41,6 +50,7 @@ return
 			{ source = "sprite_fragment.shader", target = "sprite_fragment.shader.bin", arguments = "fragment" },
 			{ source = "debug/line_fragment.shader", target = "debug/line_fragment.shader.bin", arguments = "fragment" },
             { source = "vertex.shader", target = "vertex.shader.bin", arguments = "vertex" },
+            { source = "instanced_vertex.shader", target = "instanced_vertex.shader.bin", arguments = "vertex" },
 			{ source = "opaque_fragment.shader", target = "opaque_fragment.shader.bin", arguments = "fragment" },
 			{ source = "transparent_fragment.shader", target = "transparent_fragment.shader.bin", arguments = "fragment" },
 		}
@@ -71,4 +81,6 @@ return
             { source = "numbers.png", target = "numbers.DDS" },
         }
     },
+    -- Every built asset is also packed into assets.pack, "compress" stores the ones that compress well block compressed
+    pack = { arguments = "compress" },
 }
@@ -5,7 +5,7 @@
 -- Static Data Initialization
 --===========================
 
-local s_AuthoredAssetDir, s_BuiltAssetDir, s_BinDir
+local s_AuthoredAssetDir, s_BuiltAssetDir, s_BinDir, s_TempDir, s_AssetCacheDir
 do
 	-- AuthoredAssetDir
 	do
@@ -35,11 +35,267 @@ do
 			error( errorMessage )
 		end
 	end
+	-- TempDir
+	do
+		local key = "TempDir"
+		local errorMessage
+		s_TempDir, errorMessage = GetEnvironmentVariable( key )
+		if not s_TempDir then
+			error( errorMessage )
+		end
+	end
+	-- AssetCacheDir
+	do
+		local key = "AssetCacheDir"
+		local errorMessage
+		s_AssetCacheDir, errorMessage = GetEnvironmentVariable( key )
+		if not s_AssetCacheDir then
+			error( errorMessage )
+		end
+	end
 end
 
+-- The build database records the key of everything each target was built from (see GetBuildKey()) and the hash of what was built,
+-- along with the dependencies that its builder found (and their hashes) and the built assets it refers to.
+-- A target is up-to-date when its key and the contents of its dependencies haven't changed, which unlike comparing file times
+-- isn't fooled by checkouts and branch switches that touch files without changing them
+local s_path_buildDatabase = s_TempDir .. "AssetBuildDatabase.lua"
+local s_buildDatabase = {}
+do
+	if DoesFileExist( s_path_buildDatabase ) then
+		local result, buildDatabase = pcall( dofile, s_path_buildDatabase )
+		if result and type( buildDatabase ) == "table" then
+			s_buildDatabase = buildDatabase
+		else
+			-- Every target will be built again (or restored from the cache)
+			print( "The build database couldn't be read and will be replaced: " .. tostring( buildDatabase ) )
+		end
+	end
+end
+
+-- Builders and authored files don't change during a build, so each one is only hashed once
+local s_inputHashes = {}
+
+-- Builders write the files that a target depends on and refers to here (see cbBuilder::AddDependency())
+local s_DependencyDir = s_TempDir .. "AssetDependencies/"
+
+-- The pack of every built asset, which the game mounts when it starts (see BuildPack())
+local s_PackPath = s_BuiltAssetDir .. "assets.pack"
+
 -- Function Definitions
 --=====================
 
+local function GetInputHash( i_path )
+	local hash = s_inputHashes[i_path]
+	if not hash then
+		local errorMessage
+		hash, errorMessage = GetFileHash( i_path )
+		if not hash then
+			OutputErrorMessage( errorMessage, i_path )
+			return nil
+		end
+		s_inputHashes[i_path] = hash
+	end
+	return hash
+end
+
+-- The key of everything a target is built from: the contents of its builder, source and dependencies, and its arguments.
+-- Each input is labelled so that, for example, moving a file from the dependencies to the source changes the key
+local function GetBuildKey( i_path_builder, i_path_source, i_arguments, i_dependencies )
+	local builderHash = GetInputHash( i_path_builder )
+	local sourceHash = GetInputHash( i_path_source )
+	if not builderHash or not sourceHash then
+		return nil
+	end
+	local inputs = { "builder " .. builderHash, "source " .. sourceHash, "arguments " .. ( i_arguments or "" ) }
+	for index, file in ipairs( i_dependencies ) do
+		local dependencyHash = GetInputHash( s_AuthoredAssetDir .. file )
+		if not dependencyHash then
+			return nil
+		end
+		table.insert( inputs, "dependency " .. file .. " " .. dependencyHash )
+	end
+	return GetStringHash( table.concat( inputs, "\n" ) )
+end
+
+-- Returns the dependencies and references in a dependency file, or nil if it can't be read
+local function ReadDependencyFile( i_path )
+	local file = io.open( i_path, "r" )
+	if not file then
+		return nil
+	end
+	local dependencies, references = {}, {}
+	for line in file:lines() do
+		local kind, path = line:match( "^(%a+) (.-)\r?$" )
+		if kind == "dependency" then
+			table.insert( dependencies, path )
+		elseif kind == "reference" then
+			table.insert( references, path )
+		end
+	end
+	file:close()
+	return dependencies, references
+end
+
+-- Returns the path and current hash of each dependency, or nil if any of them no longer exist
+local function HashDependencies( i_dependencies )
+	local dependencies = {}
+	for i, path in ipairs( i_dependencies ) do
+		local hash = DoesFileExist( path ) and GetInputHash( path )
+		if not hash then
+			return nil
+		end
+		dependencies[i] = { path = path, hash = hash }
+	end
+	return dependencies
+end
+
+local function IsTargetUpToDate( i_path_target, i_buildKey )
+	local entry = s_buildDatabase[i_path_target]
+	if not entry or entry.key ~= i_buildKey or not DoesFileExist( i_path_target ) then
+		return false
+	end
+	-- The files that the builder found it depends on are only known once it has built the target,
+	-- but the same files are found again until the source or one of them changes
+	for i, dependency in ipairs( entry.dependencies or {} ) do
+		if not DoesFileExist( dependency.path ) or GetInputHash( dependency.path ) ~= dependency.hash then
+			return false
+		end
+	end
+	-- The target itself may have been changed or replaced since it was built
+	return GetFileHash( i_path_target ) == entry.hash
+end
+
+local function RecordBuiltTarget( i_path_target, i_buildKey, i_dependencies, i_references )
+	local hash, errorMessage = GetFileHash( i_path_target )
+	if not hash then
+		OutputErrorMessage( errorMessage, i_path_target )
+		return false
+	end
+	s_buildDatabase[i_path_target] = { key = i_buildKey, hash = hash, dependencies = i_dependencies, references = i_references }
+	return true
+end
+
+-- The asset cache holds a copy of every target that has been built, named by its build key,
+-- so a target whose inputs return to an earlier state (e.g. after switching branches) is copied instead of built again.
+-- A target with dependencies is named by its build key and their hashes instead,
+-- and the dependency file that its builder wrote is kept next to the build key so that they can be found before it is restored
+local function GetCachePath( i_key )
+	return s_AssetCacheDir .. i_key:sub( 1, 2 ) .. "/" .. i_key
+end
+
+local function GetCachedDependencyFilePath( i_buildKey )
+	return GetCachePath( i_buildKey ) .. ".dependencies"
+end
+
+local function GetCacheKey( i_buildKey, i_dependencies )
+	if #i_dependencies == 0 then
+		return i_buildKey
+	end
+	local inputs = { i_buildKey }
+	for i, dependency in ipairs( i_dependencies ) do
+		table.insert( inputs, "dependency " .. dependency.path .. " " .. dependency.hash )
+	end
+	return GetStringHash( table.concat( inputs, "\n" ) )
+end
+
+local function RestoreTargetFromCache( i_path_target, i_buildKey )
+	local dependencies, references = {}, {}
+	do
+		local path_dependencyFile = GetCachedDependencyFilePath( i_buildKey )
+		if DoesFileExist( path_dependencyFile ) then
+			local paths
+			paths, references = ReadDependencyFile( path_dependencyFile )
+			dependencies = paths and HashDependencies( paths )
+			if not dependencies then
+				return false
+			end
+		end
+	end
+	local path_cached = GetCachePath( GetCacheKey( i_buildKey, dependencies ) )
+	if not DoesFileExist( path_cached ) then
+		return false
+	end
+	CreateDirectoryIfNecessary( i_path_target )
+	local result, errorMessage = CopyFile( path_cached, i_path_target )
+	if not result then
+		OutputErrorMessage( "Failed to restore the target from the asset cache: " .. errorMessage, i_path_target )
+		return false
+	end
+	return RecordBuiltTarget( i_path_target, i_buildKey, dependencies, references )
+end
+
+-- Files are copied under a temporary name first, so an interrupted copy never looks like a cached file
+local function CopyFileToCache( i_path, i_path_cached )
+	CreateDirectoryIfNecessary( i_path_cached )
+	local path_temporary = i_path_cached .. ".tmp"
+	local result, errorMessage = CopyFile( i_path, path_temporary )
+	if result then
+		if DoesFileExist( i_path_cached ) then
+			os.remove( i_path_cached )
+		end
+		result, errorMessage = os.rename( path_temporary, i_path_cached )
+	end
+	if not result then
+		os.remove( path_temporary )
+	end
+	return result, errorMessage
+end
+
+local function StoreTargetInCache( i_path_target, i_buildKey, i_path_dependencyFile )
+	local result, errorMessage = true
+	if i_path_dependencyFile then
+		result, errorMessage = CopyFileToCache( i_path_dependencyFile, GetCachedDependencyFilePath( i_buildKey ) )
+	end
+	if result then
+		local dependencies = s_buildDatabase[i_path_target].dependencies
+		result, errorMessage = CopyFileToCache( i_path_target, GetCachePath( GetCacheKey( i_buildKey, dependencies ) ) )
+	end
+	if not result then
+		-- A target that isn't cached will just be built again when it is needed
+		print( "Failed to add " .. i_path_target .. " to the asset cache: " .. tostring( errorMessage ) )
+	end
+end
+
+local function SaveBuildDatabase()
+	-- The targets are sorted so that the file only changes where the build did
+	local targets = {}
+	for path_target in pairs( s_buildDatabase ) do
+		table.insert( targets, path_target )
+	end
+	table.sort( targets )
+	local lines = { "return", "{" }
+	for i, path_target in ipairs( targets ) do
+		local entry = s_buildDatabase[path_target]
+		local fields = { string.format( "key = %q", entry.key ), string.format( "hash = %q", entry.hash ) }
+		if entry.dependencies and #entry.dependencies > 0 then
+			local dependencies = {}
+			for j, dependency in ipairs( entry.dependencies ) do
+				table.insert( dependencies, string.format( "{ path = %q, hash = %q }", dependency.path, dependency.hash ) )
+			end
+			table.insert( fields, "dependencies = { " .. table.concat( dependencies, ", " ) .. " }" )
+		end
+		if entry.references and #entry.references > 0 then
+			local references = {}
+			for j, reference in ipairs( entry.references ) do
+				table.insert( references, string.format( "%q", reference ) )
+			end
+			table.insert( fields, "references = { " .. table.concat( references, ", " ) .. " }" )
+		end
+		table.insert( lines, string.format( "\t[%q] = { %s },", path_target, table.concat( fields, ", " ) ) )
+	end
+	table.insert( lines, "}" )
+
+	local file = io.open( s_path_buildDatabase, "w" )
+	if not file then
+		OutputErrorMessage( "Failed to write the build database", s_path_buildDatabase )
+		return false
+	end
+	file:write( table.concat( lines, "\n" ) .. "\n" )
+	file:close()
+	return true
+end
+
 --EAE6320_TODO: I have shown the simplest parameters to BuildAsset() that are possible.
 --You should definitely feel free to change these
 local function BuildAsset( i_builderFileName, i_dependencies, i_sourceRelativePath, i_destinationRelativePath, i_optionalArguments )
@@ -49,6 +305,7 @@ local function BuildAsset( i_builderFileName, i_dependencies, i_sourceRelativePa
 	--then you will need to update this part
 	local path_source = s_AuthoredAssetDir .. i_sourceRelativePath
 	local path_target = s_BuiltAssetDir .. i_destinationRelativePath
+	local path_dependencyFile = s_DependencyDir .. i_destinationRelativePath .. ".dependencies"
 
 	-- If the source file doesn't exist then it can't be built
 	do
@@ -74,117 +331,226 @@ local function BuildAsset( i_builderFileName, i_dependencies, i_sourceRelativePa
 	end
 
 	-- Decide if the target needs to be built
-	local shouldTargetBeBuilt
+	local buildKey = GetBuildKey( path_builder, path_source, i_optionalArguments, i_dependencies )
+	if not buildKey then
+		return false
+	end
+	if IsTargetUpToDate( path_target, buildKey ) then
+		return true
+	end
+	if RestoreTargetFromCache( path_target, buildKey ) then
+		print( "Restored From Cache: " .. path_source )
+		return true
+	end
+	-- Until it has been built again the target is out-of-date, even if its build fails
+	s_buildDatabase[path_target] = nil
+
+	-- Queue the target to be built
 	do
-		-- The simplest reason a target should be built is if it doesn't exist
-		local doesTargetExist = DoesFileExist( path_target )
-		if doesTargetExist then
-			-- Even if the target exists it may be out-of-date.
-			-- If the source has been modified more recently than the target
-			-- then the target should be re-built.
-			local lastWriteTime_source = GetLastWriteTime( path_source )
-			local lastWriteTime_target = GetLastWriteTime( path_target )
-			shouldTargetBeBuilt = lastWriteTime_source > lastWriteTime_target
-			if not shouldTargetBeBuilt then
-				-- Even if the target was built from the current source
-				-- then the builder may have changed which could cause different output
-				local lastWriteTime_builder = GetLastWriteTime( path_builder )
-				shouldTargetBeBuilt = lastWriteTime_builder > lastWriteTime_target
-			    if not shouldTargetBeBuilt then
-				    -- Even if the target was built from the current source
-				    -- then one of the depencies may have changed which could cause different output
-                    for index, file in ipairs(i_dependencies) do
-				        local lastWriteTime_dependency = GetLastWriteTime( s_AuthoredAssetDir .. file )
-				        shouldTargetBeBuilt = lastWriteTime_dependency > lastWriteTime_target
-                        if shouldTargetBeBuild then break end
-                    end
-                end
-			end
-		else
-			shouldTargetBeBuilt = true;
+		-- Create the target directory if necessary
+		CreateDirectoryIfNecessary( path_target )
+		-- A dependency file left by an earlier build would be mistaken for this one's
+		CreateDirectoryIfNecessary( path_dependencyFile )
+		if DoesFileExist( path_dependencyFile ) then
+			os.remove( path_dependencyFile )
 		end
+		-- The source and target path must always be passed in
+		local arguments = "\"" .. path_source .. "\" \"" .. path_target .. "\""
+		-- The builder writes what it finds the target depends on to the dependency file
+		arguments = arguments .. " -dependencies \"" .. path_dependencyFile .. "\""
+		-- The optional arguments
+		if i_optionalArguments ~= nil then
+			arguments = arguments .. " " .. i_optionalArguments
+		end
+		-- IMPORTANT NOTE:
+		-- If you need to debug a builder you can put print statements here to
+		-- find out what the exact command line should be.
+		-- "path_builder" should go in Debugging->Command
+		-- "arguments" should go in Debugging->Command Arguments
+		-- (AssetBuilder sends the same arguments to a builder that is running as a worker,
+		-- but run this way the builder builds just the one asset and exits)
+		return true, { builder = path_builder, arguments = arguments, source = path_source, target = path_target, buildKey = buildKey,
+			dependencyFile = path_dependencyFile }
 	end
+end
 
-	-- Build the target if necessary
-	if shouldTargetBeBuilt then
-        print( "Build Started: " .. path_source )
+-- A target that refers to other built assets (a material to its effect and textures, for example)
+-- only works if they are built too, so each reference has to be to another target that is up-to-date
+local function AreReferencesBuilt( i_assetsToBuild )
+	-- Built assets are compared the way the game looks them up
+	local function NormalizePath( i_path )
+		return ( i_path:gsub( "\\", "/" ) ):lower()
+	end
+	local listedTargets, builtTargets = {}, {}
+	for i, assetBuildTable in ipairs( i_assetsToBuild ) do
+		for fileNum, fileData in ipairs( assetBuildTable.files ) do
+			listedTargets[NormalizePath( fileData.target )] = true
+			if s_buildDatabase[s_BuiltAssetDir .. fileData.target] then
+				builtTargets[NormalizePath( fileData.target )] = true
+			end
+		end
+	end
 
-		-- Create the target directory if necessary
-		CreateDirectoryIfNecessary( path_target )
-		-- Build
-		do
-			-- The command starts with the builder
-			local command = "\"" .. path_builder .. "\""
-			-- The source and target path must always be passed in
-			local arguments = "\"" .. path_source .. "\" \"" .. path_target .. "\""
-            -- The optional arguments
-            if i_optionalArguments ~= nil then
-                arguments = arguments .. " " .. i_optionalArguments
-            end
-			-- IMPORTANT NOTE:
-			-- If you need to debug a builder you can put print statements here to
-			-- find out what the exact command line should be.
-			-- "command" should go in Debugging->Command
-			-- "arguments" should go in Debugging->Command Arguments
-
-			-- Surround the entire command line in quotes
-			local commandLine = "\"" .. command .. " " .. arguments .. "\""
-			local result, terminationType, exitCode = os.execute( commandLine )
-			if result then
-				-- Display a message for each asset
-				print( "Build Completed: " .. path_source )
-				-- Return the exit code for informational purposes since we have it
-				return true, exitCode
-			else
-				-- The builder should already output a descriptive error message if there was an error
-				-- (remember that you write the builder code,
-				-- and so if the build process failed it means that _your_ code has returned an error code)
-				-- but it can be helpful to still return an additional vague error message here
-				-- in case there is a bug in the specific builder that doesn't output an error message
-				do
-					local errorMessage = "The command " .. tostring( commandLine )
-					if terminationType ~= "signal" then
-						errorMessage = errorMessage .. " exited with code "
-					else
-						errorMessage = errorMessage .. " was terminated by the signal "
-					end
-					errorMessage = errorMessage .. tostring( exitCode )
-					OutputErrorMessage( errorMessage, path_source )
-				end
-				-- There's a chance that the builder already created the target file,
-				-- in which case it will have a new time stamp and wouldn't get built again
-				-- even though the process failed
-				if DoesFileExist( path_target ) then
-					local result, errorMessage = os.remove( path_target )
-					if not result then
-						OutputErrorMessage( "Failed to delete the incorrectly-built target: " .. errorMessage, path_target )
-					end
+	local areReferencesBuilt = true
+	for i, assetBuildTable in ipairs( i_assetsToBuild ) do
+		for fileNum, fileData in ipairs( assetBuildTable.files ) do
+			local entry = s_buildDatabase[s_BuiltAssetDir .. fileData.target]
+			for j, reference in ipairs( ( entry and entry.references ) or {} ) do
+				if not builtTargets[NormalizePath( reference )] then
+					local problem = listedTargets[NormalizePath( reference )] and "which failed to build" or "which isn't in the list of assets to build"
+					OutputErrorMessage( "The target refers to \"" .. reference .. "\", " .. problem, s_AuthoredAssetDir .. fileData.source )
+					areReferencesBuilt = false
 				end
-
-				return false, exitCode
 			end
 		end
-	else
+	end
+	return areReferencesBuilt
+end
+
+-- The game looks in a mounted pack before the loose files,
+-- so a pack that isn't up to date has to be removed or it would hide every asset that was rebuilt since
+local function RemovePack( i_path_pack )
+	s_buildDatabase[i_path_pack] = nil
+	if DoesFileExist( i_path_pack ) then
+		local result, errorMessage = os.remove( i_path_pack )
+		if not result then
+			OutputErrorMessage( "Failed to delete the out-of-date pack: " .. errorMessage, i_path_pack )
+			return false
+		end
+	end
+	return true
+end
+
+-- Packs every built asset into one file (see Lame::File::AssetPack), which the game maps once instead of opening each asset
+local function BuildPack( i_assetsToBuild )
+	local path_builder = s_BinDir .. "PackBuilder.exe"
+	local path_list = s_BuiltAssetDir .. "assets.packlist"
+	local path_pack = s_PackPath
+	local arguments = ( i_assetsToBuild.pack and i_assetsToBuild.pack.arguments ) or ""
+
+	-- The list of assets to pack, relative to the list.
+	-- The pack's build key comes from the builder, its arguments and the hash of every asset in the list,
+	-- which are all in the build database by now
+	local builderHash = GetInputHash( path_builder )
+	if not builderHash then
+		return false
+	end
+	local list = ""
+	local inputs = { "builder " .. builderHash, "arguments " .. arguments }
+	for i, assetBuildTable in ipairs( i_assetsToBuild ) do
+		for fileNum, fileData in ipairs( assetBuildTable.files ) do
+			list = list .. fileData.target .. "\n"
+			local entry = s_buildDatabase[s_BuiltAssetDir .. fileData.target]
+			table.insert( inputs, "asset " .. fileData.target .. " " .. ( entry and entry.hash or "" ) )
+		end
+	end
+	local buildKey = GetStringHash( table.concat( inputs, "\n" ) )
+
+	-- Decide if the pack needs to be built
+	if IsTargetUpToDate( path_pack, buildKey ) then
+		return true
+	end
+	if RestoreTargetFromCache( path_pack, buildKey ) then
+		print( "Restored From Cache: " .. path_pack )
 		return true
 	end
+	s_buildDatabase[path_pack] = nil
+
+	do
+		local file = io.open( path_list, "w" )
+		if not file then
+			OutputErrorMessage( "Failed to write the list of assets to pack", path_list )
+			return false
+		end
+		file:write( list )
+		file:close()
+	end
+	local packArguments = "\"" .. path_list .. "\" \"" .. path_pack .. "\" " .. arguments
+	local results = RunBuildJobs( { { builder = path_builder, arguments = packArguments, source = path_list, target = path_pack } } )
+	if not results[1] then
+		-- A partly written pack would be used instead of the loose assets
+		RemovePack( path_pack )
+		return false
+	end
+	if not RecordBuiltTarget( path_pack, buildKey, {}, {} ) then
+		return false
+	end
+	StoreTargetInCache( path_pack, buildKey )
+	return true
 end
 
 local function BuildAssets( i_assetsToBuild )
 	local wereThereErrors = false
+	local jobs = {}
 
 	for i, assetBuildTable in ipairs( i_assetsToBuild ) do
 		local tool = assetBuildTable.tool
+        -- Builders find what they depend on themselves (see cbBuilder::AddDependency()),
+        -- but files that they can't see can still be listed as dependencies of every asset a tool builds
         local dependencies = assetBuildTable.dependencies
         if dependencies == nil then
             dependencies = {}
         end
 		for fileNum, fileData in ipairs(assetBuildTable.files) do
-			if not BuildAsset(tool, dependencies, fileData.source, fileData.target, fileData.arguments) then
+			local result, job = BuildAsset(tool, dependencies, fileData.source, fileData.target, fileData.arguments)
+			if not result then
 				-- If there's an error then the asset build should fail,
 				-- but we can still try to build any remaining assets
 				wereThereErrors = true
+			elseif job then
+				table.insert( jobs, job )
+			end
+		end
+	end
+
+	-- Every asset is built from authored files into its own target, so AssetBuilder runs their builders at the same time
+	-- (as many at once as its -j argument allows) and prints each one's output when it finishes
+	if #jobs > 0 then
+		local results = RunBuildJobs( jobs )
+		local failedCount = 0
+		for i, job in ipairs( jobs ) do
+			if results[i] then
+				local paths, references = ReadDependencyFile( job.dependencyFile )
+				local dependencies = paths and HashDependencies( paths )
+				if not dependencies then
+					OutputErrorMessage( "The builder didn't write a readable dependency file for the target", job.dependencyFile )
+					wereThereErrors = true
+				elseif RecordBuiltTarget( job.target, job.buildKey, dependencies, references ) then
+					StoreTargetInCache( job.target, job.buildKey, job.dependencyFile )
+				else
+					wereThereErrors = true
+				end
+			else
+				wereThereErrors = true
+				failedCount = failedCount + 1
+				-- There's a chance that the builder already created the target file,
+				-- which the game shouldn't load even though it will be built again next time
+				if DoesFileExist( job.target ) then
+					local result, errorMessage = os.remove( job.target )
+					if not result then
+						OutputErrorMessage( "Failed to delete the incorrectly-built target: " .. errorMessage, job.target )
+					end
+				end
 			end
 		end
+		print( "Built " .. ( #jobs - failedCount ) .. " of " .. #jobs .. " out-of-date assets" .. ( failedCount > 0 and ( ", " .. failedCount .. " failed" ) or "" ) )
+	end
+
+	if not AreReferencesBuilt( i_assetsToBuild ) then
+		wereThereErrors = true
+	end
+
+	-- The pack is only built from a complete set of assets,
+	-- otherwise the old one is removed so that the game loads the loose assets that did build
+	if wereThereErrors then
+		RemovePack( s_PackPath )
+	elseif not BuildPack( i_assetsToBuild ) then
+		wereThereErrors = true
+	end
+
+	-- Targets that failed aren't in the database, so they will be built again next time
+	if not SaveBuildDatabase() then
+		wereThereErrors = true
 	end
 
 	return not wereThereErrors